@@ -16,6 +16,23 @@ class AppConfig {
     defaultValue: '',
   );
 
+  /// Let the Windows runner own the transcription socket and stream system
+  /// audio to it directly (no per-frame platform channel round trips).
+  /// `--dart-define=HEARNOW_NATIVE_UPLINK=true`
+  static const bool useNativeAudioUplink = bool.fromEnvironment(
+    'HEARNOW_NATIVE_UPLINK',
+    defaultValue: false,
+  );
+
+  /// Send on-device OCR of the selected screen target with AI questions
+  /// instead of a screenshot, when enough text is recognized (screens of
+  /// code or documents). Falls back to the image otherwise.
+  /// `--dart-define=HEARNOW_SCREEN_TEXT=true`
+  static const bool sendScreenText = bool.fromEnvironment(
+    'HEARNOW_SCREEN_TEXT',
+    defaultValue: false,
+  );
+
   static String get serverHttpBaseUrl {
     if (serverHttpBaseUrlOverride.trim().isNotEmpty) {
       return serverHttpBaseUrlOverride.trim();
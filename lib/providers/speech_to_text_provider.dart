@@ -8,6 +8,7 @@ import '../services/transcription_service.dart';
 import '../services/audio_capture_service.dart';
 import '../services/windows_audio_service.dart';
 import '../services/ai_service.dart';
+import '../services/native_audio_uplink.dart';
 import '../models/transcript_bubble.dart';
 import '../models/ai_response_entry.dart';
 
@@ -25,6 +26,8 @@ class SpeechToTextProvider extends ChangeNotifier {
   // System-audio watchdog (Windows loopback can stall on device changes)
   DateTime? _lastSystemAudioFrameAt;
   bool _hadSystemAudioFramesThisRun = false;
+  // Native uplink mode: last seen systemBytes + gapSamples from getStats.
+  int _lastNativeSystemProgress = -1;
   bool _systemAudioRestartInProgress = false;
   DateTime? _lastSystemAudioRestartAt;
   int _systemAudioRestartAttempts = 0;
@@ -567,6 +570,8 @@ class SpeechToTextProvider extends ChangeNotifier {
     String? systemPrompt, 
     String? model, 
     List<Uint8List>? imagesPngBytes,
+    List<int>? imageIds,
+    String? screenText,
     List<AiResponseEntry>? previousResponses,
   }) async {
     final ai = _aiService;
@@ -581,6 +586,8 @@ class SpeechToTextProvider extends ChangeNotifier {
     final turns = _buildAiTurns();
     final validImages = imagesPngBytes?.where((b) => b.isNotEmpty).toList() ?? [];
     final hasImages = validImages.isNotEmpty;
+    final trimmedScreenText = screenText?.trim() ?? '';
+    final hasScreenText = trimmedScreenText.isNotEmpty;
     
     // If no custom question provided, try to use the last mic turn as question
     String? finalQuestion = trimmedQuestion.isNotEmpty ? trimmedQuestion : _defaultQuestionFromLastMicTurn();
@@ -590,10 +597,12 @@ class SpeechToTextProvider extends ChangeNotifier {
     if (finalQuestion == null && hasImages) {
       final imageWord = validImages.length == 1 ? 'screenshot' : 'screenshots';
       finalQuestion = 'Analyze the attached $imageWord and the conversation so far. Tell me what I should say next. Be concise.';
+    } else if (finalQuestion == null && hasScreenText) {
+      finalQuestion = 'Analyze the screen text and the conversation so far. Tell me what I should say next. Be concise.';
     }
     
     // Require transcript only if no question is provided (neither custom nor from transcript)
-    if (turns.isEmpty && finalQuestion == null && !hasImages) {
+    if (turns.isEmpty && finalQuestion == null && !hasImages && !hasScreenText) {
       _aiErrorMessage = 'No transcript yet';
       notifyListeners();
       return;
@@ -616,6 +625,10 @@ class SpeechToTextProvider extends ChangeNotifier {
     } else {
       questionToSend = finalQuestion;
     }
+    // On-device OCR of the screen, sent in place of a screenshot.
+    if (hasScreenText) {
+      questionToSend = 'Text on my screen (OCR, may contain recognition errors):\n```\n$trimmedScreenText\n```\n\n${questionToSend ?? ''}';
+    }
 
     _isAiLoading = true;
     _aiErrorMessage = '';
@@ -650,6 +663,7 @@ class SpeechToTextProvider extends ChangeNotifier {
           systemPrompt: systemPrompt,
           model: model,
           imagesPngBytes: validImages.isNotEmpty ? validImages : null,
+          imageIds: imageIds != null && imageIds.length == imagesPngBytes?.length ? imageIds : null,
           previousAiResponses: previousResponsesForApi,
         );
         _currentAiResponse = text;
@@ -982,8 +996,13 @@ class SpeechToTextProvider extends ChangeNotifier {
       _systemAudioRecoveryTimer?.cancel();
       _systemAudioRecoveryTimer = null;
 
-      // IMPORTANT: poll at real-time (~50ms chunks at 20Hz)
       _systemAudioPollTimer?.cancel();
+      if (_transcriptionService?.usesNativeUplink == true) {
+        _startNativeUplinkWatchdog();
+        return true;
+      }
+
+      // IMPORTANT: poll at real-time (~50ms chunks at 20Hz)
       const pollInterval = Duration(milliseconds: 50);
       _systemAudioPollTimer = Timer.periodic(
         pollInterval,
@@ -991,15 +1010,26 @@ class SpeechToTextProvider extends ChangeNotifier {
           if (!_isRecording || _isStopping || _transcriptionService == null) return;
           if (!_isSystemAudioCapturing) return;
 
-          WindowsAudioService.getSystemAudioFrame(lengthBytes: 1600).then((frame) {
+          // Gaps are drained right after the frame (channel calls run in
+          // order) and sent before it, so every gap that precedes this audio
+          // is ahead of it. A gap may run ahead of the audio, since it
+          // carries its absolute startSample, but never behind it.
+          final frameRequest = WindowsAudioService.getSystemAudioFrame(lengthBytes: 1600);
+          final gapsRequest = WindowsAudioService.getSystemAudioGaps();
+          frameRequest.then((frame) async {
+            final gaps = await gapsRequest;
             if (!_isRecording || _isStopping || _transcriptionService == null) return;
             final now = DateTime.now();
-            if (frame.isEmpty) {
+            if (frame.isEmpty && gaps.isEmpty) {
               _maybeRestartSystemAudioCapture(now: now);
               return;
             }
+            // Silence is compacted natively; forwarded gaps also prove the
+            // loopback endpoint is still alive.
             _lastSystemAudioFrameAt = now;
             _hadSystemAudioFramesThisRun = true;
+            _forwardSystemAudioGaps(gaps);
+            if (frame.isEmpty) return;
             try {
               _transcriptionService?.sendAudio(frame, source: 'system');
             } catch (e) {
@@ -1018,6 +1048,36 @@ class SpeechToTextProvider extends ChangeNotifier {
     }
   }
 
+  /// The native uplink drains system audio itself; only watch its progress so
+  /// the device-change recovery below still kicks in.
+  void _startNativeUplinkWatchdog() {
+    _lastNativeSystemProgress = -1;
+    _systemAudioPollTimer = Timer.periodic(const Duration(milliseconds: 500), (_) {
+      if (!_isRecording || _isStopping || _transcriptionService == null) return;
+      if (!_isSystemAudioCapturing) return;
+
+      NativeAudioUplink.getStats().then((stats) {
+        if (stats == null || !_isRecording || _isStopping) return;
+        final now = DateTime.now();
+        final progress = stats.systemBytes + stats.gapSamples;
+        if (progress != _lastNativeSystemProgress && _lastNativeSystemProgress >= 0) {
+          _lastSystemAudioFrameAt = now;
+          _hadSystemAudioFramesThisRun = true;
+        } else if (_lastNativeSystemProgress >= 0 && !stats.stalled) {
+          // A stalled socket stops draining the ring; that isn't a dead device.
+          _maybeRestartSystemAudioCapture(now: now);
+        }
+        _lastNativeSystemProgress = progress;
+      });
+    });
+  }
+
+  void _forwardSystemAudioGaps(List<SystemAudioGap> gaps) {
+    for (final gap in gaps) {
+      _transcriptionService?.sendAudioGap(startSample: gap.startSample, samples: gap.length, source: 'system');
+    }
+  }
+
   Future<void> _stopSystemAudioCaptureAndPolling() async {
     try {
       _systemAudioPollTimer?.cancel();
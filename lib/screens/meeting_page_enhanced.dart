@@ -23,6 +23,10 @@ import '../services/meeting_question_service.dart';
 import '../services/meeting_mode_service.dart';
 import '../services/ai_service.dart';
 import '../services/billing_service.dart';
+import '../services/native_ocr.dart';
+import '../services/native_screen_snapshot.dart';
+import '../services/native_screen_stream.dart';
+import '../services/native_thumbnails.dart';
 import '../providers/shortcuts_provider.dart';
 import '../utils/error_message_helper.dart';
 import 'manage_mode_page.dart';
@@ -166,6 +170,9 @@ class _MeetingPageEnhancedState extends State<MeetingPageEnhanced> {
   final TextEditingController _askAiController = TextEditingController();
   int _lastAiHistoryCount = 0;
   static const MethodChannel _windowChannel = MethodChannel('com.finalround/window');
+  // Runners that implement monitor/window listing and capture (the Linux
+  // one through X11).
+  static bool get _hasScreenCapture => Platform.isWindows || Platform.isLinux;
   int _lastBubbleCount = 0;
   String _lastTailSignature = '';
   String _suggestedQuestions = '';
@@ -498,7 +505,7 @@ class _MeetingPageEnhancedState extends State<MeetingPageEnhanced> {
   }
 
   Future<void> _showScreenCapturePicker() async {
-    if (!Platform.isWindows) return;
+    if (!_hasScreenCapture) return;
     final result = await showDialog<dynamic>(
       context: context,
       barrierDismissible: true,
@@ -552,44 +559,34 @@ class _MeetingPageEnhancedState extends State<MeetingPageEnhanced> {
     });
   }
 
+  // Region-selector preview size; crops come from the full-size snapshot.
+  static const int _regionPreviewMaxWidth = 2560;
+  static const int _regionPreviewMaxHeight = 1440;
+
   Future<_RegionBounds?> _launchRegionSelector(_MonitorInfo monitor) async {
     if (!mounted) return null;
     
-    // Get virtual screen bounds
-    final screenBounds = await _windowChannel.invokeMethod<dynamic>('getVirtualScreenBounds');
-    if (screenBounds is! Map) {
+    // One frozen capture of the whole virtual screen; the dialog only needs
+    // a scaled preview of it.
+    final snapshot = await NativeScreenSnapshot.create(
+      previewMaxWidth: _regionPreviewMaxWidth,
+      previewMaxHeight: _regionPreviewMaxHeight,
+    );
+    if (snapshot == null) return null;
+    final preview = snapshot.preview;
+    if (snapshot.width <= 0 || snapshot.height <= 0 || preview == null) {
+      await NativeScreenSnapshot.release(snapshot.id);
       return null;
     }
-    
-    final screenX = (screenBounds['x'] as num?)?.toInt() ?? 0;
-    final screenY = (screenBounds['y'] as num?)?.toInt() ?? 0;
-    final screenWidth = (screenBounds['width'] as num?)?.toInt() ?? 0;
-    final screenHeight = (screenBounds['height'] as num?)?.toInt() ?? 0;
-    
-    if (screenWidth <= 0 || screenHeight <= 0) return null;
-    
-    // Capture screenshot of entire virtual screen for selection preview
-    final screenshotPixels = await _windowChannel.invokeMethod<dynamic>(
-      'captureRectPixels',
-      <String, dynamic>{
-        'x': screenX,
-        'y': screenY,
-        'width': screenWidth,
-        'height': screenHeight,
-      },
-    );
-    
-    if (screenshotPixels is! Map) return null;
-    
-    final imgWidth = (screenshotPixels['width'] as num?)?.toInt() ?? 0;
-    final imgHeight = (screenshotPixels['height'] as num?)?.toInt() ?? 0;
-    final imgBytes = screenshotPixels['bytes'];
-    
-    if (imgWidth <= 0 || imgHeight <= 0 || imgBytes is! Uint8List) return null;
-    
+
     // Decode the screenshot
-    final screenshot = await _decodeBgraToImage(imgBytes, imgWidth, imgHeight);
-    
+    final screenshot = await _decodeBgraToImage(preview, snapshot.previewWidth, snapshot.previewHeight);
+    if (!mounted) {
+      screenshot.dispose();
+      await NativeScreenSnapshot.release(snapshot.id);
+      return null;
+    }
+
     // Show region selector dialog with the screenshot
     final region = await showDialog<_RegionBounds>(
       context: context,
@@ -598,14 +595,15 @@ class _MeetingPageEnhancedState extends State<MeetingPageEnhanced> {
       builder: (context) => _RegionSelectorDialog(
         monitor: monitor,
         screenshot: screenshot,
-        screenOffsetX: screenX,
-        screenOffsetY: screenY,
-        screenWidth: screenWidth,
-        screenHeight: screenHeight,
+        screenOffsetX: snapshot.x,
+        screenOffsetY: snapshot.y,
+        screenWidth: snapshot.width,
+        screenHeight: snapshot.height,
       ),
     );
-    
+
     screenshot.dispose();
+    await NativeScreenSnapshot.release(snapshot.id);
     return region;
   }
 
@@ -613,65 +611,35 @@ class _MeetingPageEnhancedState extends State<MeetingPageEnhanced> {
   Future<void> _launchScreenshotTool() async {
     if (!mounted || !Platform.isWindows) return;
 
+    int? snapshotId;
     try {
       // 1. Make our window undetectable first (won't appear in screenshot)
       await _windowChannel.invokeMethod<void>('setUndetectable', true);
       
-      // 2. Get screen bounds
-      final screenBounds = await _windowChannel.invokeMethod<dynamic>('getVirtualScreenBounds');
-      if (screenBounds is! Map) {
+      // 2. Freeze the whole virtual screen once (our window won't appear
+      // because it's undetectable); the selected crop is copied natively
+      // from these same pixels.
+      final snapshot = await NativeScreenSnapshot.create(fullPreview: true);
+      snapshotId = snapshot?.id;
+      final imgBytes = snapshot?.preview;
+      if (snapshot == null || imgBytes == null || snapshot.previewWidth <= 0 || snapshot.previewHeight <= 0) {
         await _windowChannel.invokeMethod<void>('setUndetectable', false);
         return;
       }
-      
-      final screenX = (screenBounds['x'] as num?)?.toInt() ?? 0;
-      final screenY = (screenBounds['y'] as num?)?.toInt() ?? 0;
-      final screenWidth = (screenBounds['width'] as num?)?.toInt() ?? 0;
-      final screenHeight = (screenBounds['height'] as num?)?.toInt() ?? 0;
-      
-      if (screenWidth <= 0 || screenHeight <= 0) {
-        await _windowChannel.invokeMethod<void>('setUndetectable', false);
-        return;
-      }
-      
-      // 3. Capture screenshot (our window won't appear because it's undetectable)
-      final screenshotPixels = await _windowChannel.invokeMethod<dynamic>(
-        'captureRectPixels',
-        <String, dynamic>{
-          'x': screenX,
-          'y': screenY,
-          'width': screenWidth,
-          'height': screenHeight,
-        },
-      );
-      
-      if (screenshotPixels is! Map) {
-        await _windowChannel.invokeMethod<void>('setUndetectable', false);
-        return;
-      }
-      
-      final imgWidth = (screenshotPixels['width'] as num?)?.toInt() ?? 0;
-      final imgHeight = (screenshotPixels['height'] as num?)?.toInt() ?? 0;
-      final imgBytes = screenshotPixels['bytes'];
-      
-      if (imgWidth <= 0 || imgHeight <= 0 || imgBytes is! Uint8List) {
-        await _windowChannel.invokeMethod<void>('setUndetectable', false);
-        return;
-      }
-      
-      // 4. Decode the screenshot while still in normal mode
-      final screenshot = await _decodeBgraToImage(imgBytes, imgWidth, imgHeight);
-      
+
+      // 3. Decode the screenshot while still in normal mode
+      final screenshot = await _decodeBgraToImage(imgBytes, snapshot.previewWidth, snapshot.previewHeight);
+
       if (!mounted) {
         screenshot.dispose();
         await _windowChannel.invokeMethod<void>('setUndetectable', false);
         return;
       }
-      
-      // 5. Enter fullscreen mode for region selection (instant transition)
+
+      // 4. Enter fullscreen mode for region selection (instant transition)
       await _windowChannel.invokeMethod<void>('enterRegionSelectorMode');
       
-      // 6. Show fullscreen screenshot selector overlay (no transition for instant feel)
+      // 5. Show fullscreen screenshot selector overlay (no transition for instant feel)
       // Note: The overlay will dispose the screenshot when it's removed from the tree
       final selectedRegion = await Navigator.of(context).push<Rect>(
         PageRouteBuilder<Rect>(
@@ -679,21 +647,21 @@ class _MeetingPageEnhancedState extends State<MeetingPageEnhanced> {
           barrierColor: Colors.transparent,
           pageBuilder: (context, animation, secondaryAnimation) => _ScreenshotToolOverlay(
             screenshot: screenshot,
-            screenshotBytes: imgBytes,
-            screenOffsetX: screenX,
-            screenOffsetY: screenY,
-            screenWidth: screenWidth,
-            screenHeight: screenHeight,
+            snapshotId: snapshot.id,
+            screenOffsetX: snapshot.x,
+            screenOffsetY: snapshot.y,
+            screenWidth: snapshot.width,
+            screenHeight: snapshot.height,
           ),
           transitionDuration: Duration.zero,
           reverseTransitionDuration: Duration.zero,
         ),
       );
       
-      // 7. Exit region selector mode and restore window
+      // 6. Exit region selector mode and restore window
       await _windowChannel.invokeMethod<void>('exitRegionSelectorMode');
       
-      // 8. If a region was selected, it's already been copied to clipboard by the overlay
+      // 7. If a region was selected, it's already been copied to clipboard by the overlay
       if (selectedRegion != null && mounted) {
         ScaffoldMessenger.of(context).showSnackBar(
           const SnackBar(
@@ -717,6 +685,8 @@ class _MeetingPageEnhancedState extends State<MeetingPageEnhanced> {
           ),
         );
       }
+    } finally {
+      if (snapshotId != null) await NativeScreenSnapshot.release(snapshotId);
     }
   }
 
@@ -814,6 +784,7 @@ class _MeetingPageEnhancedState extends State<MeetingPageEnhanced> {
       MeetingModeService.customModesVersion.removeListener(listener);
     }
     _recordingTimer?.cancel();
+    _stopScreenStream();
     _transcriptScrollController.dispose();
     _aiResponseScrollController.dispose();
     _askAiController.dispose();
@@ -1619,15 +1590,20 @@ class _MeetingPageEnhancedState extends State<MeetingPageEnhanced> {
   Future<void> _askAiWithPrompt(String? question, {String? displayQuestion, List<Uint8List>? imagesPngBytes}) async {
     if (_speechProvider == null || _speechProvider!.isAiLoading) return;
     final systemPrompt = await _getRealTimePrompt();
-    final wantsScreen = _autoAskUseScreen && Platform.isWindows;
+    final wantsScreen = _autoAskUseScreen && _hasScreenCapture;
 
     List<Uint8List>? pngBytesList = imagesPngBytes;
+    List<int>? imageIds;
+    String? screenText;
     if ((pngBytesList == null || pngBytesList.isEmpty) && wantsScreen && !_screenCaptureInFlight) {
       _screenCaptureInFlight = true;
       try {
-        final screenCapture = await _tryCaptureSelectedTargetPngBytes();
+        screenText = await _tryRecognizeSelectedTargetText();
+        final screenCapture = screenText == null ? await _tryCaptureSelectedTargetPngBytes() : null;
         if (screenCapture != null) {
           pngBytesList = [screenCapture];
+          final imageId = _lastCaptureImageId;
+          if (imageId != null) imageIds = [imageId];
         }
       } finally {
         _screenCaptureInFlight = false;
@@ -1643,6 +1619,8 @@ class _MeetingPageEnhancedState extends State<MeetingPageEnhanced> {
       systemPrompt: systemPrompt,
       model: _selectedAiModel,
       imagesPngBytes: pngBytesList,
+      imageIds: imageIds,
+      screenText: screenText,
       previousResponses: previousResponses,
     );
   }
@@ -1722,7 +1700,7 @@ class _MeetingPageEnhancedState extends State<MeetingPageEnhanced> {
   }
 
   Widget _buildUseScreenCheckboxInline() {
-    if (!Platform.isWindows) return const SizedBox.shrink();
+    if (!_hasScreenCapture) return const SizedBox.shrink();
 
     final labelStyle = TextStyle(
       fontSize: 13,
@@ -1758,7 +1736,7 @@ class _MeetingPageEnhancedState extends State<MeetingPageEnhanced> {
     required ButtonStyle style,
   }) {
     final model = _buildModelMenuButton(disabled: disabled, style: style);
-    if (!Platform.isWindows) return model;
+    if (!_hasScreenCapture) return model;
 
     return Column(
       mainAxisSize: MainAxisSize.min,
@@ -2063,7 +2041,7 @@ class _MeetingPageEnhancedState extends State<MeetingPageEnhanced> {
   }
 
   Widget _buildCaptureTargetPickerPill() {
-    if (!Platform.isWindows) return const SizedBox.shrink();
+    if (!_hasScreenCapture) return const SizedBox.shrink();
 
     String pillLabel;
     IconData pillIcon;
@@ -2139,7 +2117,30 @@ class _MeetingPageEnhancedState extends State<MeetingPageEnhanced> {
     );
   }
 
+  // Longest edge and encoded-size budget for screenshots sent to the AI.
+  static const int _uploadMaxDimension = 1600;
+  static const int _uploadMaxBytes = 3 * 1024 * 1024;
+
+  // Recent native uploads by imageId, least recent first, so a "same as
+  // image N" reply from captureForUpload's perceptual dedupe resolves
+  // without re-encoding.
+  static const int _maxUploadedImages = 8;
+  final Map<int, Uint8List> _uploadedImages = <int, Uint8List>{};
+  // imageId of the last _tryCaptureSelectedTargetPngBytes result, if any.
+  int? _lastCaptureImageId;
+
   Future<Uint8List?> _tryCaptureSelectedTargetPngBytes() async {
+    _lastCaptureImageId = null;
+    // Preferred path: capture, downscale and PNG-encode natively so only the
+    // compressed image crosses the channel.
+    try {
+      final native = await _tryCaptureForUpload();
+      if (native != null) return native;
+    } on PlatformException {
+      // Target is gone; the raw-pixel path would fail the same way.
+      return null;
+    }
+
     try {
       dynamic pixels;
       if (_screenCaptureTarget == ScreenCaptureTarget.region) {
@@ -2222,6 +2223,177 @@ class _MeetingPageEnhancedState extends State<MeetingPageEnhanced> {
     }
   }
 
+  // Native screen stream for the current capture target, started by the
+  // first capture so later AI requests attach its latest frame instantly.
+  static const double _screenStreamFps = 2;
+  static const Duration _screenStreamMaxAge = Duration(seconds: 3);
+  int? _screenStreamId;
+  String? _screenStreamKey;
+
+  Future<void> _stopScreenStream() async {
+    final id = _screenStreamId;
+    _screenStreamId = null;
+    _screenStreamKey = null;
+    if (id != null) await NativeScreenStream.stop(id);
+  }
+
+  /// Latest streamed frame for [target], or null (after starting a stream
+  /// for it) when none is ready.
+  Future<Uint8List?> _screenStreamFrame(Map<String, dynamic> target) async {
+    final key = jsonEncode(target);
+    final id = _screenStreamId;
+    if (id != null && _screenStreamKey == key) {
+      final frame = await NativeScreenStream.latestFrame(id);
+      if (frame != null && frame.mimeType == 'image/png' && frame.bytes.isNotEmpty && frame.age <= _screenStreamMaxAge) {
+        return frame.bytes;
+      }
+      if (frame != null) return null;
+    }
+    // No stream, another target, or the stream ended: (re)start it.
+    await _stopScreenStream();
+    final started = await NativeScreenStream.start(
+      target,
+      fps: _screenStreamFps,
+      maxDimension: _uploadMaxDimension,
+      maxBytes: _uploadMaxBytes,
+    );
+    if (started != null && mounted) {
+      _screenStreamId = started;
+      _screenStreamKey = key;
+    } else if (started != null) {
+      await NativeScreenStream.stop(started);
+    }
+    return null;
+  }
+
+  /// `captureForUpload` / `recognizeText` target args for the selected
+  /// capture target. Null for a region that hasn't been drawn yet and for
+  /// all screens, which has no single native target.
+  Map<String, dynamic>? _selectedTargetArgs() {
+    if (_screenCaptureTarget == ScreenCaptureTarget.region) {
+      final region = _screenCaptureRegion;
+      if (region == null) return null;
+      return <String, dynamic>{
+        'target': 'rect',
+        'x': region.x,
+        'y': region.y,
+        'width': region.width,
+        'height': region.height,
+      };
+    } else if (_screenCaptureTarget == ScreenCaptureTarget.screen) {
+      final monitorId = _screenCaptureMonitorId;
+      if (monitorId == null) return null;
+      return <String, dynamic>{'target': 'monitor', 'monitorId': monitorId};
+    } else if (_screenCaptureWindowHwnd != null) {
+      return <String, dynamic>{'target': 'window', 'hwnd': _screenCaptureWindowHwnd};
+    }
+    return <String, dynamic>{'target': 'active'};
+  }
+
+  // Below this much recognized text the screen is probably not text-heavy,
+  // and a screenshot tells the model more.
+  static const int _minScreenTextChars = 40;
+
+  /// On-device OCR of the selected target for [AppConfig.sendScreenText];
+  /// null when there isn't enough text, so the caller sends an image.
+  Future<String?> _tryRecognizeSelectedTargetText() async {
+    if (!AppConfig.sendScreenText) return null;
+    final args = _selectedTargetArgs();
+    if (args == null) return null;
+    try {
+      final result = await NativeOcr.recognize(args);
+      final text = result?.text.trim() ?? '';
+      return text.length >= _minScreenTextChars ? text : null;
+    } on PlatformException {
+      return null;
+    }
+  }
+
+  /// Returns null when the runner lacks `captureForUpload` or the capture
+  /// failed, so the caller can fall back to the raw-pixel path. Throws when
+  /// the target itself is missing.
+  Future<Uint8List?> _tryCaptureForUpload() async {
+    // All screens: one composite of every monitor, each captured and
+    // downscaled in parallel natively.
+    if (_screenCaptureTarget == ScreenCaptureTarget.screen && _screenCaptureMonitorId == null) {
+      return _tryCaptureAllMonitorsForUpload();
+    }
+    final args = _selectedTargetArgs();
+    if (args == null) return null;
+
+    if (args['target'] != 'active') {
+      final streamed = await _screenStreamFrame(Map<String, dynamic>.of(args));
+      if (streamed != null) return streamed;
+    }
+    args.addAll(<String, dynamic>{
+      'format': 'png',
+      'maxDimension': _uploadMaxDimension,
+      'maxBytes': _uploadMaxBytes,
+      // Large screens are cropped to their text/detail before the
+      // downscale, so small text stays readable.
+      'smartCrop': true,
+      'perceptualDedupe': true,
+      'knownImageIds': _uploadedImages.keys.toList(),
+    });
+
+    try {
+      var result = await _windowChannel.invokeMethod<dynamic>('captureForUpload', args);
+      if (result is! Map) return null;
+      final sameAs = result['sameAs'];
+      if (sameAs is int) {
+        final cached = _uploadedImages.remove(sameAs);
+        if (cached != null) {
+          _uploadedImages[sameAs] = cached;
+          _lastCaptureImageId = sameAs;
+          return cached;
+        }
+        // Evicted here since the call was made; ask for the pixels.
+        args['perceptualDedupe'] = false;
+        result = await _windowChannel.invokeMethod<dynamic>('captureForUpload', args);
+        if (result is! Map) return null;
+      }
+      final bytes = result['bytes'];
+      if (bytes is! Uint8List || bytes.isEmpty) return null;
+      if (result['mimeType'] != 'image/png') return null;
+      final imageId = result['imageId'];
+      if (imageId is int) {
+        _uploadedImages[imageId] = bytes;
+        while (_uploadedImages.length > _maxUploadedImages) {
+          _uploadedImages.remove(_uploadedImages.keys.first);
+        }
+        _lastCaptureImageId = imageId;
+      }
+      return bytes;
+    } on MissingPluginException {
+      return null;
+    } on PlatformException catch (e) {
+      if (e.code == 'NO_TARGET' || e.code == 'NO_WINDOW' || e.code == 'BAD_TARGET') rethrow;
+      return null;
+    } catch (_) {
+      return null;
+    }
+  }
+
+  Future<Uint8List?> _tryCaptureAllMonitorsForUpload() async {
+    try {
+      final result = await _windowChannel.invokeMethod<dynamic>('captureMonitorsForUpload', <String, dynamic>{
+        'layout': 'composite',
+        'format': 'png',
+        'maxDimension': _uploadMaxDimension,
+        'maxBytes': _uploadMaxBytes,
+      });
+      if (result is! Map) return null;
+      final bytes = result['bytes'];
+      if (bytes is! Uint8List || bytes.isEmpty) return null;
+      if (result['mimeType'] != 'image/png') return null;
+      return bytes;
+    } on MissingPluginException {
+      return null;
+    } on PlatformException {
+      return null;
+    }
+  }
+
   Future<ui.Image> _decodeBgraToImage(Uint8List bgraBytes, int width, int height) {
     final completer = Completer<ui.Image>();
     ui.decodeImageFromPixels(
@@ -2642,7 +2814,7 @@ class _MeetingPageEnhancedState extends State<MeetingPageEnhanced> {
                             Shadow(color: Colors.black, blurRadius: 6, offset: const Offset(-1, -1)),
                           ],
                         )),
-                        if (Platform.isWindows) ...[
+                        if (_hasScreenCapture) ...[
                           const SizedBox(width: 12),
                           _buildCaptureTargetPickerPill(),
                         ],
@@ -3982,8 +4154,20 @@ class _ScreenCapturePickerDialogState extends State<_ScreenCapturePickerDialog>
   _RegionBounds? _selectedRegion;
   Future<Map<String, dynamic>>? _dataFuture;
   final Map<String, ui.Image> _previews = {};
+  // Batched tiles shown from native external textures: no pixel transfer or
+  // decode on the Dart side. Keyed like [_previews].
+  final Map<String, ThumbnailTile> _texturePreviews = {};
   final Set<String> _previewLoading = {};
 
+  // Tags this dialog's thumbnail captures so closing it cancels them natively.
+  static const String _previewRequestId = 'capture-picker';
+  // Batched native thumbnails; false once the runner can't batch, after which
+  // monitor tiles fall back to one captureMonitorThumbnailPixels per tile.
+  bool _batchThumbnails = true;
+  // Set by Refresh so every cached tile is recaptured, not just stale ones.
+  bool _revalidateThumbnails = false;
+  final List<StreamSubscription<ThumbnailTile>> _thumbnailSubs = [];
+
   @override
   void initState() {
     super.initState();
@@ -4001,20 +4185,123 @@ class _ScreenCapturePickerDialogState extends State<_ScreenCapturePickerDialog>
     ]);
     final monitors = (results[0] as List<_MonitorInfo>?) ?? const <_MonitorInfo>[];
     final windows = (results[1] as List<_ShareableWindowInfo>?) ?? const <_ShareableWindowInfo>[];
+    if (mounted) _requestThumbnails(monitors, windows);
     return {'monitors': monitors, 'windows': windows};
   }
 
+  void _requestThumbnails(List<_MonitorInfo> monitors, List<_ShareableWindowInfo> windows) {
+    if (!_batchThumbnails) return;
+    final maxAge = _revalidateThumbnails ? Duration.zero : const Duration(seconds: 2);
+    _revalidateThumbnails = false;
+    if (_thumbnailSubs.isNotEmpty) {
+      // Refresh: drop the previous batches before queueing new ones.
+      for (final sub in _thumbnailSubs) {
+        sub.cancel();
+      }
+      _thumbnailSubs.clear();
+      unawaited(_MeetingPageEnhancedState._windowChannel
+          .invokeMethod<dynamic>('cancelCapture', <String, dynamic>{'requestId': _previewRequestId})
+          .catchError((_) => null));
+    }
+    if (monitors.isNotEmpty) {
+      _listenThumbnails(
+        NativeThumbnails.capture(
+          [for (final m in monitors) ThumbnailTarget.monitor(m.id)],
+          maxWidth: 360,
+          maxHeight: 225,
+          requestId: _previewRequestId,
+          maxAge: maxAge,
+          useTextures: true,
+        ),
+      );
+    }
+    if (windows.isNotEmpty) {
+      _listenThumbnails(
+        NativeThumbnails.capture(
+          [for (final w in windows) ThumbnailTarget.window(w.hwnd)],
+          maxWidth: 96,
+          maxHeight: 60,
+          requestId: _previewRequestId,
+          maxAge: maxAge,
+          useTextures: true,
+        ),
+      );
+    }
+  }
+
+  void _listenThumbnails(Stream<ThumbnailTile> tiles) {
+    late final StreamSubscription<ThumbnailTile> sub;
+    sub = tiles.listen(
+      (tile) async {
+        final key = '${tile.type}:${tile.id}';
+        if (tile.textureId != null) {
+          // Later frames land in the same texture natively; only the first
+          // tile (or a size change) needs a rebuild.
+          final current = _texturePreviews[key];
+          if (!mounted ||
+              (current?.textureId == tile.textureId &&
+                  current?.width == tile.width &&
+                  current?.height == tile.height)) {
+            return;
+          }
+          setState(() {
+            _previews.remove(key)?.dispose();
+            _texturePreviews[key] = tile;
+          });
+          return;
+        }
+        if (tile.bytes == null) return;
+        final img = await _decodeBgra(<String, dynamic>{
+          'width': tile.width,
+          'height': tile.height,
+          'bytes': tile.bytes,
+        });
+        if (img == null) return;
+        if (!mounted) {
+          img.dispose();
+          return;
+        }
+        setState(() {
+          _previews.remove(key)?.dispose();
+          _previews[key] = img;
+        });
+      },
+      onError: (_) {
+        if (!mounted || !_batchThumbnails) return;
+        setState(() {
+          _batchThumbnails = false;
+        });
+      },
+      onDone: () => _thumbnailSubs.remove(sub),
+    );
+    _thumbnailSubs.add(sub);
+  }
+
   @override
   void dispose() {
+    for (final sub in _thumbnailSubs) {
+      sub.cancel();
+    }
+    if (_previewLoading.isNotEmpty || _thumbnailSubs.isNotEmpty) {
+      unawaited(_MeetingPageEnhancedState._windowChannel
+          .invokeMethod<dynamic>('cancelCapture', <String, dynamic>{'requestId': _previewRequestId})
+          .catchError((_) => null));
+    }
     for (final img in _previews.values) {
       img.dispose();
     }
     _previews.clear();
+    if (_texturePreviews.isNotEmpty) {
+      _texturePreviews.clear();
+      unawaited(NativeThumbnails.releaseTextures());
+    }
+    _thumbnailSubs.clear();
     super.dispose();
   }
 
   void _refresh() {
     setState(() {
+      _revalidateThumbnails = true;
       _dataFuture = _loadAll();
     });
   }
@@ -4030,6 +4317,24 @@ class _ScreenCapturePickerDialogState extends State<_ScreenCapturePickerDialog>
     return completer.future;
   }
 
+  /// Texture or decoded image for [key], or null while none has arrived.
+  Widget? _previewWidget(String key, BoxFit fit) {
+    final texture = _texturePreviews[key];
+    if (texture != null && texture.width > 0 && texture.height > 0) {
+      return FittedBox(
+        fit: fit,
+        clipBehavior: Clip.hardEdge,
+        child: SizedBox(
+          width: texture.width.toDouble(),
+          height: texture.height.toDouble(),
+          child: Texture(textureId: texture.textureId!),
+        ),
+      );
+    }
+    final image = _previews[key];
+    return image == null ? null : RawImage(image: image, fit: fit);
+  }
+
   Future<void> _ensurePreview(String key, Future<dynamic> Function() loader) async {
     if (_previews.containsKey(key)) return;
     if (_previewLoading.contains(key)) return;
@@ -4056,15 +4361,25 @@ class _ScreenCapturePickerDialogState extends State<_ScreenCapturePickerDialog>
   Widget _windowTile(_ShareableWindowInfo w) {
     final selected = _target == ScreenCaptureTarget.window && _selectedHwnd == w.hwnd;
     final cs = Theme.of(context).colorScheme;
+    final preview = _previewWidget('window:${w.hwnd}', BoxFit.cover);
 
     return ListTile(
       dense: true,
       contentPadding: const EdgeInsets.symmetric(horizontal: 8),
-      leading: Icon(
-        w.isMinimized ? Icons.minimize : Icons.crop_free,
-        color: w.isMinimized ? cs.onSurface.withValues(alpha: 0.55) : cs.onSurface,
-        size: 18,
-      ),
+      leading: preview != null
+          ? ClipRRect(
+              borderRadius: BorderRadius.circular(4),
+              child: SizedBox(
+                width: 48,
+                height: 30,
+                child: preview,
+              ),
+            )
+          : Icon(
+              w.isMinimized ? Icons.minimize : Icons.crop_free,
+              color: w.isMinimized ? cs.onSurface.withValues(alpha: 0.55) : cs.onSurface,
+              size: 18,
+            ),
       title: Text(
         w.title,
         maxLines: 1,
@@ -4097,14 +4412,19 @@ class _ScreenCapturePickerDialogState extends State<_ScreenCapturePickerDialog>
   Widget _screenTileMonitor(_MonitorInfo m) {
     final selected = _target == ScreenCaptureTarget.screen && _selectedMonitorId == m.id;
     final key = 'monitor:${m.id}';
-    final preview = _previews[key];
-    if (preview == null) {
+    final preview = _previewWidget(key, BoxFit.contain);
+    if (preview == null && !_batchThumbnails) {
       WidgetsBinding.instance.addPostFrameCallback((_) {
         _ensurePreview(
           key,
           () => _MeetingPageEnhancedState._windowChannel.invokeMethod<dynamic>(
             'captureMonitorThumbnailPixels',
-            <String, dynamic>{'monitorId': m.id, 'maxWidth': 360, 'maxHeight': 225},
+            <String, dynamic>{
+              'monitorId': m.id,
+              'maxWidth': 360,
+              'maxHeight': 225,
+              'requestId': _previewRequestId,
+            },
           ),
         );
       });
@@ -4131,7 +4451,7 @@ class _ScreenCapturePickerDialogState extends State<_ScreenCapturePickerDialog>
     required String title,
     required String subtitle,
     required IconData icon,
-    required ui.Image? preview,
+    required Widget? preview,
     required VoidCallback onTap,
   }) {
     return InkWell(
@@ -4160,7 +4480,7 @@ class _ScreenCapturePickerDialogState extends State<_ScreenCapturePickerDialog>
                       Container(
                         color: Colors.black,
                         alignment: Alignment.center,
-                        child: RawImage(image: preview, fit: BoxFit.contain),
+                        child: preview,
                       )
                     else
                       Container(
@@ -5945,7 +6265,9 @@ class _AskAiDialogState extends State<_AskAiDialog> {
 /// Fullscreen screenshot tool overlay (like Windows Snipping Tool)
 class _ScreenshotToolOverlay extends StatefulWidget {
   final ui.Image screenshot;
-  final Uint8List screenshotBytes;
+
+  /// Native snapshot [screenshot] was decoded from; crops are copied from it.
+  final int snapshotId;
   final int screenOffsetX;
   final int screenOffsetY;
   final int screenWidth;
@@ -5953,7 +6275,7 @@ class _ScreenshotToolOverlay extends StatefulWidget {
 
   const _ScreenshotToolOverlay({
     required this.screenshot,
-    required this.screenshotBytes,
+    required this.snapshotId,
     required this.screenOffsetX,
     required this.screenOffsetY,
     required this.screenWidth,
@@ -5965,7 +6287,6 @@ class _ScreenshotToolOverlay extends StatefulWidget {
 }
 
 class _ScreenshotToolOverlayState extends State<_ScreenshotToolOverlay> {
-  static const MethodChannel _windowChannel = MethodChannel('com.finalround/window');
   final FocusNode _focusNode = FocusNode();
   Offset? _startPoint;
   Offset? _currentPoint;
@@ -6027,39 +6348,16 @@ class _ScreenshotToolOverlayState extends State<_ScreenshotToolOverlay> {
   }
 
   Future<void> _captureAndCopyRegion(int x, int y, int w, int h) async {
-    // Extract the region from the screenshot bytes (BGRA format)
-    final stride = widget.screenWidth * 4;
-    final regionBytes = <int>[];
-
-    for (int row = 0; row < h; row++) {
-      final srcY = y + row;
-      if (srcY < 0 || srcY >= widget.screenHeight) continue;
-      
-      final srcRowStart = srcY * stride;
-      for (int col = 0; col < w; col++) {
-        final srcX = x + col;
-        if (srcX < 0 || srcX >= widget.screenWidth) continue;
-        
-        final srcIdx = srcRowStart + (srcX * 4);
-        if (srcIdx + 3 < widget.screenshotBytes.length) {
-          regionBytes.add(widget.screenshotBytes[srcIdx]);     // B
-          regionBytes.add(widget.screenshotBytes[srcIdx + 1]); // G
-          regionBytes.add(widget.screenshotBytes[srcIdx + 2]); // R
-          regionBytes.add(widget.screenshotBytes[srcIdx + 3]); // A
-        }
-      }
-    }
-
-    // Copy to clipboard
-    try {
-      await _windowChannel.invokeMethod<void>('copyImageToClipboard', {
-        'width': w,
-        'height': h,
-        'bytes': Uint8List.fromList(regionBytes),
-      });
-    } catch (e) {
-      print('Failed to copy to clipboard: $e');
-    }
+    // Crop the frozen snapshot natively, straight into the clipboard, so the
+    // copy is exactly what was on screen when the tool opened.
+    final ok = await NativeScreenSnapshot.copyToClipboard(
+      widget.snapshotId,
+      x: widget.screenOffsetX + x,
+      y: widget.screenOffsetY + y,
+      width: w,
+      height: h,
+    );
+    if (!ok) print('Failed to copy to clipboard');
   }
 
   void _cancel() {
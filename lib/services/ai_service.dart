@@ -262,6 +262,7 @@ class AiService {
     String? systemPrompt,
     String? model,
     List<Uint8List>? imagesPngBytes,
+    List<int>? imageIds,
     List<Map<String, dynamic>>? previousAiResponses,
     Duration timeout = const Duration(seconds: 60),
   }) async {
@@ -309,6 +310,12 @@ class AiService {
 
     if (hasImages) {
       payload['imagesPngBase64'] = validImages.map((b) => base64Encode(b)).toList();
+      // Stable per-session ids from the native capture's perceptual dedupe:
+      // the same id means the same (or a near-identical) screenshot, so the
+      // backend can reuse what it already processed for it.
+      if (imageIds != null && imageIds.length == validImages.length) {
+        payload['imageIds'] = imageIds;
+      }
     }
     
     if (previousAiResponses != null && previousAiResponses.isNotEmpty) {
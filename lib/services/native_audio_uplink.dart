@@ -0,0 +1,115 @@
+import 'package:flutter/services.dart';
+import 'dart:typed_data';
+
+/// Transcription socket owned by the Windows runner.
+///
+/// System audio is read from the loopback ring and batched natively, so it
+/// never crosses the platform channel; Dart sends control messages and mic
+/// audio, and receives server messages on [events].
+class NativeAudioUplink {
+  static const platform = MethodChannel('com.finalround/uplink');
+  static const _eventChannel = EventChannel('com.finalround/uplink_events');
+
+  /// Starts connecting in the background. Messages sent before the socket is
+  /// open are queued natively.
+  static Future<bool> connect(String url) async {
+    try {
+      final result = await platform.invokeMethod<bool>('connect', <String, dynamic>{'url': url});
+      return result ?? false;
+    } catch (e) {
+      print('[NativeAudioUplink] Error connecting: $e');
+      return false;
+    }
+  }
+
+  static Future<void> send(String text) async {
+    try {
+      await platform.invokeMethod('send', <String, dynamic>{'text': text});
+    } catch (e) {
+      print('[NativeAudioUplink] Error sending message: $e');
+    }
+  }
+
+  /// [source] must match `[a-z_]+`.
+  static Future<void> sendAudio(Uint8List bytes, {String source = 'mic'}) async {
+    try {
+      await platform.invokeMethod('sendAudio', <String, dynamic>{'source': source, 'bytes': bytes});
+    } catch (e) {
+      print('[NativeAudioUplink] Error sending audio: $e');
+    }
+  }
+
+  /// Flushes queued frames and closes the socket.
+  static Future<void> disconnect() async {
+    try {
+      await platform.invokeMethod('disconnect');
+    } catch (e) {
+      print('[NativeAudioUplink] Error disconnecting: $e');
+    }
+  }
+
+  static Future<NativeUplinkStats?> getStats() async {
+    try {
+      final result = await platform.invokeMethod<Map<dynamic, dynamic>>('getStats');
+      return result == null ? null : NativeUplinkStats.fromMap(result);
+    } catch (e) {
+      print('[NativeAudioUplink] Error getting stats: $e');
+      return null;
+    }
+  }
+
+  /// `{type: 'message', data}` for each server text message, and
+  /// `{type: 'closed', error}` when the socket ends (empty error = clean close).
+  static Stream<Map<dynamic, dynamic>> events() {
+    return _eventChannel
+        .receiveBroadcastStream()
+        .where((event) => event is Map)
+        .cast<Map<dynamic, dynamic>>();
+  }
+}
+
+class NativeUplinkStats {
+  final bool connected;
+  final bool stalled;
+  final double handshakeMs;
+  final double sendLatencyMs;
+  final int queueDepth;
+  final int queuedBytes;
+  final int framesSent;
+  final int bytesSent;
+  final int droppedBytes;
+  final int systemBytes;
+  final int gapSamples;
+
+  const NativeUplinkStats({
+    required this.connected,
+    required this.stalled,
+    required this.handshakeMs,
+    required this.sendLatencyMs,
+    required this.queueDepth,
+    required this.queuedBytes,
+    required this.framesSent,
+    required this.bytesSent,
+    required this.droppedBytes,
+    required this.systemBytes,
+    required this.gapSamples,
+  });
+
+  factory NativeUplinkStats.fromMap(Map<dynamic, dynamic> m) {
+    int i(String k) => (m[k] as num?)?.toInt() ?? 0;
+    double d(String k) => (m[k] as num?)?.toDouble() ?? 0.0;
+    return NativeUplinkStats(
+      connected: m['connected'] == true,
+      stalled: m['stalled'] == true,
+      handshakeMs: d('handshakeMs'),
+      sendLatencyMs: d('sendLatencyMs'),
+      queueDepth: i('queueDepth'),
+      queuedBytes: i('queuedBytes'),
+      framesSent: i('framesSent'),
+      bytesSent: i('bytesSent'),
+      droppedBytes: i('droppedBytes'),
+      systemBytes: i('systemBytes'),
+      gapSamples: i('gapSamples'),
+    );
+  }
+}
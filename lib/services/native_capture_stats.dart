@@ -0,0 +1,58 @@
+import 'package:flutter/services.dart';
+
+/// Capture pipeline timings kept by the Windows runner.
+///
+/// Every window-channel method records its latency and a per-stage
+/// breakdown (PrintWindow, DWM fallbacks, restore settle, DIB copies,
+/// scaling, encoding, the channel reply, ...). With tracing on, each stage is
+/// also kept for a Chrome trace dump (chrome://tracing or Perfetto).
+class NativeCaptureStats {
+  static const _windowChannel = MethodChannel('com.finalround/window');
+
+  /// `{methods: {<method>: {count, meanMs, p50Ms, p90Ms, p99Ms, maxMs,
+  /// histogram, stages: {<stage>: {...}}}}, tracing, traceEvents}`, or null
+  /// if the runner doesn't keep stats. [reset] clears them after reading.
+  static Future<Map<dynamic, dynamic>?> get({bool reset = false}) async {
+    try {
+      return await _windowChannel.invokeMethod<Map<dynamic, dynamic>>('getCaptureStats', <String, dynamic>{
+        'reset': reset,
+      });
+    } on MissingPluginException {
+      return null;
+    } catch (e) {
+      print('[NativeCaptureStats] Error reading stats: $e');
+      return null;
+    }
+  }
+
+  /// Starts (fresh) or stops keeping trace events.
+  static Future<bool> setTracing(bool enabled) async {
+    try {
+      final result = await _windowChannel.invokeMethod<bool>('setCaptureTracing', <String, dynamic>{
+        'enabled': enabled,
+      });
+      return result ?? false;
+    } on MissingPluginException {
+      return false;
+    } catch (e) {
+      print('[NativeCaptureStats] Error setting tracing: $e');
+      return false;
+    }
+  }
+
+  /// Writes the trace as Chrome trace JSON to [path] (default: the temp
+  /// directory) and returns the file written, or null on failure.
+  static Future<String?> dumpTrace({String? path}) async {
+    try {
+      final result = await _windowChannel.invokeMethod<Map<dynamic, dynamic>>('dumpCaptureTrace', <String, dynamic>{
+        if (path != null) 'path': path,
+      });
+      return result?['path'] as String?;
+    } on MissingPluginException {
+      return null;
+    } catch (e) {
+      print('[NativeCaptureStats] Error dumping trace: $e');
+      return null;
+    }
+  }
+}
@@ -0,0 +1,101 @@
+import 'package:flutter/services.dart';
+
+/// One recognized line (or word) with its box in capture pixels.
+class OcrTextBox {
+  final String text;
+  final int x;
+  final int y;
+  final int width;
+  final int height;
+
+  const OcrTextBox({
+    required this.text,
+    required this.x,
+    required this.y,
+    required this.width,
+    required this.height,
+  });
+
+  factory OcrTextBox.fromMap(Map<dynamic, dynamic> map) => OcrTextBox(
+        text: map['text'] as String? ?? '',
+        x: map['x'] as int? ?? 0,
+        y: map['y'] as int? ?? 0,
+        width: map['width'] as int? ?? 0,
+        height: map['height'] as int? ?? 0,
+      );
+}
+
+class OcrLine extends OcrTextBox {
+  final List<OcrTextBox> words;
+
+  const OcrLine({
+    required super.text,
+    required super.x,
+    required super.y,
+    required super.width,
+    required super.height,
+    required this.words,
+  });
+
+  factory OcrLine.fromMap(Map<dynamic, dynamic> map) {
+    final box = OcrTextBox.fromMap(map);
+    final words = map['words'];
+    return OcrLine(
+      text: box.text,
+      x: box.x,
+      y: box.y,
+      width: box.width,
+      height: box.height,
+      words: words is List ? words.whereType<Map>().map(OcrTextBox.fromMap).toList() : const [],
+    );
+  }
+}
+
+class OcrResult {
+  /// Lines joined with newlines, top to bottom.
+  final String text;
+  final List<OcrLine> lines;
+
+  /// BCP-47 tag of the recognizer language.
+  final String language;
+
+  const OcrResult({required this.text, required this.lines, required this.language});
+
+  factory OcrResult.fromMap(Map<dynamic, dynamic> map) {
+    final lines = map['lines'];
+    return OcrResult(
+      text: map['text'] as String? ?? '',
+      lines: lines is List ? lines.whereType<Map>().map(OcrLine.fromMap).toList() : const [],
+      language: map['language'] as String? ?? '',
+    );
+  }
+}
+
+/// On-device OCR of a capture target by the Windows runner
+/// (Windows.Media.Ocr, nothing leaves the machine).
+///
+/// Takes the same target args as `captureForUpload` ({target: 'rect' |
+/// 'monitor' | 'window' | 'active', ...}). Only text-bearing bands of the
+/// capture are recognized, in parallel, so a 1080p screen of code usually
+/// comes back in a few hundred milliseconds as a few KB of text.
+class NativeOcr {
+  static const _windowChannel = MethodChannel('com.finalround/window');
+
+  /// Null if the runner has no OCR, no OCR language is installed or the
+  /// capture failed. Rethrows when the target itself is gone.
+  static Future<OcrResult?> recognize(Map<String, dynamic> target) async {
+    try {
+      final result = await _windowChannel.invokeMethod<Map<dynamic, dynamic>>('recognizeText', target);
+      return result == null ? null : OcrResult.fromMap(result);
+    } on MissingPluginException {
+      return null;
+    } on PlatformException catch (e) {
+      if (e.code == 'NO_TARGET' || e.code == 'NO_WINDOW' || e.code == 'BAD_TARGET') rethrow;
+      print('[NativeOcr] Error recognizing text: $e');
+      return null;
+    } catch (e) {
+      print('[NativeOcr] Error recognizing text: $e');
+      return null;
+    }
+  }
+}
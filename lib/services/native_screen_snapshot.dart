@@ -0,0 +1,165 @@
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+
+/// A frozen screen capture held by the Windows runner.
+///
+/// The region selector shows [ScreenSnapshot.preview] and then crops, scales,
+/// encodes or copies from the same pixels, so the result is exactly what the
+/// user saw and the screen is captured only once. Coordinates are screen
+/// (virtual-desktop) pixels. Call [release] when the session ends.
+class NativeScreenSnapshot {
+  static const _windowChannel = MethodChannel('com.finalround/window');
+
+  /// Captures the whole virtual screen, with a preview scaled to fit
+  /// [previewMaxWidth] x [previewMaxHeight] or at full size when
+  /// [fullPreview]. Null if the capture failed or the runner can't snapshot.
+  static Future<ScreenSnapshot?> create({
+    int? previewMaxWidth,
+    int? previewMaxHeight,
+    bool fullPreview = false,
+  }) async {
+    try {
+      final result = await _windowChannel.invokeMethod<Map<dynamic, dynamic>>('createScreenSnapshot', <String, dynamic>{
+        if (previewMaxWidth != null) 'previewMaxWidth': previewMaxWidth,
+        if (previewMaxHeight != null) 'previewMaxHeight': previewMaxHeight,
+        'includePixels': fullPreview,
+      });
+      return result == null ? null : ScreenSnapshot.fromMap(result);
+    } on MissingPluginException {
+      return null;
+    } catch (e) {
+      print('[NativeScreenSnapshot] Error creating snapshot: $e');
+      return null;
+    }
+  }
+
+  /// BGRA pixels of a screen rectangle of [snapshotId], scaled down to fit
+  /// [maxWidth] x [maxHeight]: `{width, height, bytes, sourceX, ...}`.
+  static Future<Map<dynamic, dynamic>?> pixels(
+    int snapshotId, {
+    required int x,
+    required int y,
+    required int width,
+    required int height,
+    int? maxWidth,
+    int? maxHeight,
+  }) async {
+    try {
+      return await _windowChannel.invokeMethod<Map<dynamic, dynamic>>('getScreenSnapshotPixels', <String, dynamic>{
+        'snapshotId': snapshotId,
+        'x': x,
+        'y': y,
+        'width': width,
+        'height': height,
+        if (maxWidth != null) 'maxWidth': maxWidth,
+        if (maxHeight != null) 'maxHeight': maxHeight,
+      });
+    } catch (e) {
+      print('[NativeScreenSnapshot] Error reading pixels: $e');
+      return null;
+    }
+  }
+
+  /// Encoded image of a screen rectangle of [snapshotId], as
+  /// `captureForUpload` would produce it.
+  static Future<Uint8List?> encode(
+    int snapshotId, {
+    required int x,
+    required int y,
+    required int width,
+    required int height,
+    String format = 'png',
+    int? maxDimension,
+    int? maxBytes,
+  }) async {
+    try {
+      final result = await _windowChannel.invokeMethod<Map<dynamic, dynamic>>('encodeScreenSnapshot', <String, dynamic>{
+        'snapshotId': snapshotId,
+        'x': x,
+        'y': y,
+        'width': width,
+        'height': height,
+        'format': format,
+        if (maxDimension != null) 'maxDimension': maxDimension,
+        if (maxBytes != null) 'maxBytes': maxBytes,
+      });
+      final bytes = result?['bytes'];
+      return bytes is Uint8List ? bytes : null;
+    } catch (e) {
+      print('[NativeScreenSnapshot] Error encoding snapshot: $e');
+      return null;
+    }
+  }
+
+  /// Copies a screen rectangle of [snapshotId] to the clipboard natively.
+  static Future<bool> copyToClipboard(
+    int snapshotId, {
+    required int x,
+    required int y,
+    required int width,
+    required int height,
+  }) async {
+    try {
+      final ok = await _windowChannel.invokeMethod<bool>('copyScreenSnapshotToClipboard', <String, dynamic>{
+        'snapshotId': snapshotId,
+        'x': x,
+        'y': y,
+        'width': width,
+        'height': height,
+      });
+      return ok ?? false;
+    } catch (e) {
+      print('[NativeScreenSnapshot] Error copying to clipboard: $e');
+      return false;
+    }
+  }
+
+  static Future<void> release(int snapshotId) async {
+    try {
+      await _windowChannel.invokeMethod<dynamic>('releaseScreenSnapshot', <String, dynamic>{'snapshotId': snapshotId});
+    } catch (e) {
+      print('[NativeScreenSnapshot] Error releasing snapshot: $e');
+    }
+  }
+}
+
+class ScreenSnapshot {
+  final int id;
+
+  /// Screen rectangle the snapshot covers.
+  final int x;
+  final int y;
+  final int width;
+  final int height;
+
+  /// BGRA preview of the whole snapshot; null unless one was requested.
+  final Uint8List? preview;
+  final int previewWidth;
+  final int previewHeight;
+
+  const ScreenSnapshot({
+    required this.id,
+    required this.x,
+    required this.y,
+    required this.width,
+    required this.height,
+    this.preview,
+    this.previewWidth = 0,
+    this.previewHeight = 0,
+  });
+
+  factory ScreenSnapshot.fromMap(Map<dynamic, dynamic> map) {
+    final bytes = map['bytes'];
+    return ScreenSnapshot(
+      id: (map['snapshotId'] as num?)?.toInt() ?? 0,
+      x: (map['x'] as num?)?.toInt() ?? 0,
+      y: (map['y'] as num?)?.toInt() ?? 0,
+      width: (map['width'] as num?)?.toInt() ?? 0,
+      height: (map['height'] as num?)?.toInt() ?? 0,
+      preview: bytes is Uint8List ? bytes : null,
+      previewWidth: (map['previewWidth'] as num?)?.toInt() ?? 0,
+      previewHeight: (map['previewHeight'] as num?)?.toInt() ?? 0,
+    );
+  }
+}
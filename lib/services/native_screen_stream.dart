@@ -0,0 +1,107 @@
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+
+/// Continuous, paced screen capture owned by the Windows runner.
+///
+/// The runner captures the target at a fixed rate, drops frames that did not
+/// change, and keeps the newest one encoded, so attaching screen context to
+/// an AI request costs no capture time. [events] reports each changed frame
+/// (without its bytes); fetch the image with [latestFrame].
+class NativeScreenStream {
+  static const _windowChannel = MethodChannel('com.finalround/window');
+  static const _eventChannel = EventChannel('com.finalround/screen_stream');
+
+  static Stream<Map<dynamic, dynamic>>? _events;
+
+  /// `{streamId, sequence, change, width, height, ...}` per changed frame, or
+  /// `{streamId, error[, ended]}`.
+  static Stream<Map<dynamic, dynamic>> get events {
+    return _events ??= _eventChannel
+        .receiveBroadcastStream()
+        .where((event) => event is Map)
+        .cast<Map<dynamic, dynamic>>();
+  }
+
+  /// Starts streaming [target] (`target: monitor|window|rect` plus its
+  /// `monitorId`, `hwnd` or `x/y/width/height`) at [fps], encoded like
+  /// `captureForUpload`. [pngPreset] is `fast` (the stream default),
+  /// `balanced` or `smallest`. Returns the stream id, or null if unsupported.
+  static Future<int?> start(
+    Map<String, dynamic> target, {
+    double fps = 2,
+    String format = 'png',
+    int? maxDimension,
+    int? maxBytes,
+    String? pngPreset,
+  }) async {
+    try {
+      final result = await _windowChannel.invokeMethod<Map<dynamic, dynamic>>('startScreenStream', <String, dynamic>{
+        ...target,
+        'fps': fps,
+        'format': format,
+        if (maxDimension != null) 'maxDimension': maxDimension,
+        if (maxBytes != null) 'maxBytes': maxBytes,
+        if (pngPreset != null) 'pngPreset': pngPreset,
+      });
+      return (result?['streamId'] as num?)?.toInt();
+    } on MissingPluginException {
+      return null;
+    } catch (e) {
+      print('[NativeScreenStream] Error starting stream: $e');
+      return null;
+    }
+  }
+
+  static Future<void> stop(int streamId) async {
+    try {
+      await _windowChannel.invokeMethod<dynamic>('stopScreenStream', <String, dynamic>{'streamId': streamId});
+    } catch (e) {
+      print('[NativeScreenStream] Error stopping stream: $e');
+    }
+  }
+
+  /// Newest encoded frame; null before the first frame or if the stream has
+  /// ended.
+  static Future<ScreenStreamFrame?> latestFrame(int streamId) async {
+    try {
+      final result = await _windowChannel.invokeMethod<Map<dynamic, dynamic>>(
+          'getScreenStreamFrame', <String, dynamic>{'streamId': streamId});
+      return result == null ? null : ScreenStreamFrame.fromMap(result);
+    } on PlatformException {
+      return null;
+    } on MissingPluginException {
+      return null;
+    }
+  }
+}
+
+class ScreenStreamFrame {
+  final Uint8List bytes;
+  final String mimeType;
+  final int width;
+  final int height;
+  final int sequence;
+  final Duration age;
+
+  const ScreenStreamFrame({
+    required this.bytes,
+    required this.mimeType,
+    required this.width,
+    required this.height,
+    required this.sequence,
+    required this.age,
+  });
+
+  factory ScreenStreamFrame.fromMap(Map<dynamic, dynamic> map) {
+    final bytes = map['bytes'];
+    return ScreenStreamFrame(
+      bytes: bytes is Uint8List ? bytes : Uint8List(0),
+      mimeType: map['mimeType'] as String? ?? '',
+      width: (map['width'] as num?)?.toInt() ?? 0,
+      height: (map['height'] as num?)?.toInt() ?? 0,
+      sequence: (map['sequence'] as num?)?.toInt() ?? 0,
+      age: Duration(milliseconds: (map['ageMs'] as num?)?.toInt() ?? 0),
+    );
+  }
+}
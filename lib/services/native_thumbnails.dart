@@ -0,0 +1,176 @@
+import 'dart:async';
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+
+/// Window and monitor thumbnails captured in parallel by the Windows runner.
+///
+/// One `captureThumbnails` call covers a whole picker; tiles are streamed
+/// back over an event channel as each capture finishes instead of one
+/// method-channel round trip per tile.
+class NativeThumbnails {
+  static const _windowChannel = MethodChannel('com.finalround/window');
+  static const _eventChannel = EventChannel('com.finalround/thumbnails');
+
+  static Stream<Map<dynamic, dynamic>>? _events;
+  static int _nextBatchId = 1;
+
+  static Stream<Map<dynamic, dynamic>> _allEvents() {
+    return _events ??= _eventChannel
+        .receiveBroadcastStream()
+        .where((event) => event is Map)
+        .cast<Map<dynamic, dynamic>>();
+  }
+
+  /// Captures [targets] at up to [maxWidth] x [maxHeight] (BGRA) and emits
+  /// each tile as it is ready; the stream closes when the batch is done.
+  ///
+  /// Tiles cached natively are emitted first ([ThumbnailTile.source] `fresh`
+  /// or `stale`). Stale tiles, and any older than [maxAge], are recaptured
+  /// and re-emitted only if their content changed.
+  ///
+  /// With [useTextures] each target's pixels go to a native external texture
+  /// and tiles carry [ThumbnailTile.textureId] instead of bytes; call
+  /// [releaseTextures] once those previews are gone.
+  ///
+  /// Errors with a [PlatformException] or [MissingPluginException] if the
+  /// runner can't batch, so callers can fall back to per-tile capture.
+  /// Pass [requestId] to cancel the batch later with `cancelCapture`.
+  static Stream<ThumbnailTile> capture(
+    List<ThumbnailTarget> targets, {
+    required int maxWidth,
+    required int maxHeight,
+    String? requestId,
+    bool useCache = true,
+    Duration maxAge = const Duration(seconds: 2),
+    bool useTextures = false,
+  }) {
+    final batchId = _nextBatchId++;
+    late final StreamController<ThumbnailTile> controller;
+    StreamSubscription<Map<dynamic, dynamic>>? sub;
+
+    Future<void> close() async {
+      await sub?.cancel();
+      sub = null;
+      if (!controller.isClosed) await controller.close();
+    }
+
+    controller = StreamController<ThumbnailTile>(
+      onListen: () {
+        // Listen before asking for tiles so none are missed.
+        sub = _allEvents().listen((event) {
+          if ((event['batchId'] as num?)?.toInt() != batchId) return;
+          if (event['done'] == true) {
+            close();
+            return;
+          }
+          controller.add(ThumbnailTile.fromMap(event));
+        });
+        _windowChannel.invokeMethod<dynamic>('captureThumbnails', <String, dynamic>{
+          'batchId': batchId,
+          'targets': [for (final t in targets) t.toMap()],
+          'maxWidth': maxWidth,
+          'maxHeight': maxHeight,
+          'useCache': useCache,
+          'maxAgeMs': maxAge.inMilliseconds,
+          'useTextures': useTextures,
+          if (requestId != null) 'requestId': requestId,
+        }).catchError((Object e) {
+          if (!controller.isClosed) controller.addError(e);
+          close();
+        });
+      },
+      onCancel: close,
+    );
+    return controller.stream;
+  }
+
+  /// Unregisters the textures handed out by `capture(useTextures: true)`.
+  static Future<void> releaseTextures() async {
+    try {
+      await _windowChannel.invokeMethod<dynamic>('releaseCaptureTextures');
+    } catch (e) {
+      print('[NativeThumbnails] Error releasing textures: $e');
+    }
+  }
+
+  /// Sets the native cache's byte budget and/or empties it; returns stats.
+  static Future<Map<dynamic, dynamic>?> configureCache({int? budgetBytes, bool clear = false}) async {
+    try {
+      return await _windowChannel.invokeMethod<Map<dynamic, dynamic>>('configureThumbnailCache', <String, dynamic>{
+        if (budgetBytes != null) 'budgetBytes': budgetBytes,
+        'clear': clear,
+      });
+    } catch (e) {
+      print('[NativeThumbnails] Error configuring cache: $e');
+      return null;
+    }
+  }
+
+  /// `{entries, bytes, budgetBytes, hits, misses, evictions}`.
+  static Future<Map<dynamic, dynamic>?> cacheStats() async {
+    try {
+      return await _windowChannel.invokeMethod<Map<dynamic, dynamic>>('getThumbnailCacheStats');
+    } catch (e) {
+      print('[NativeThumbnails] Error getting cache stats: $e');
+      return null;
+    }
+  }
+}
+
+class ThumbnailTarget {
+  final String type;
+  final int id;
+
+  const ThumbnailTarget.window(int hwnd)
+      : type = 'window',
+        id = hwnd;
+
+  const ThumbnailTarget.monitor(int monitorId)
+      : type = 'monitor',
+        id = monitorId;
+
+  Map<String, dynamic> toMap() => <String, dynamic>{'type': type, 'id': id};
+}
+
+class ThumbnailTile {
+  final String type;
+  final int id;
+  final int width;
+  final int height;
+
+  /// BGRA pixels; null when [error] or [textureId] is set.
+  final Uint8List? bytes;
+
+  /// External texture now showing this tile (`useTextures` batches).
+  final int? textureId;
+  final String? error;
+
+  /// `captured`, or `fresh`/`stale` when served from the native cache.
+  final String source;
+
+  const ThumbnailTile({
+    required this.type,
+    required this.id,
+    required this.width,
+    required this.height,
+    this.bytes,
+    this.textureId,
+    this.error,
+    this.source = 'captured',
+  });
+
+  factory ThumbnailTile.fromMap(Map<dynamic, dynamic> map) {
+    final bytes = map['bytes'];
+    return ThumbnailTile(
+      type: map['type'] as String? ?? '',
+      id: (map['id'] as num?)?.toInt() ?? 0,
+      width: (map['width'] as num?)?.toInt() ?? 0,
+      height: (map['height'] as num?)?.toInt() ?? 0,
+      bytes: bytes is Uint8List ? bytes : null,
+      textureId: (map['textureId'] as num?)?.toInt(),
+      error: map['error'] as String?,
+      source: map['source'] as String? ?? 'captured',
+    );
+  }
+}
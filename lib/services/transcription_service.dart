@@ -1,16 +1,25 @@
 import 'dart:async';
 import 'dart:convert';
+import 'dart:io';
 import 'dart:typed_data';
 
 import 'package:flutter/foundation.dart';
 import 'package:web_socket_channel/web_socket_channel.dart';
+import '../config/app_config.dart';
 import 'http_client_service.dart';
+import 'native_audio_uplink.dart';
 
 class TranscriptionService {
   WebSocketChannel? _channel;
   StreamSubscription? _channelSubscription;
   bool _disconnecting = false;
 
+  // Native uplink mode: the Windows runner owns the socket and reads system
+  // audio itself (see NativeAudioUplink).
+  final bool usesNativeUplink;
+  bool _nativeConnected = false;
+  StreamSubscription? _nativeSubscription;
+
   final String serverUrl;
   String? _authToken;
   VoidCallback? _onSessionRevoked;
@@ -18,7 +27,9 @@ class TranscriptionService {
   final StreamController<TranscriptionResult> _transcriptController =
       StreamController<TranscriptionResult>.broadcast();
 
-  TranscriptionService({required this.serverUrl, String? authToken}) : _authToken = authToken;
+  TranscriptionService({required this.serverUrl, String? authToken, bool? useNativeUplink})
+      : _authToken = authToken,
+        usesNativeUplink = useNativeUplink ?? (AppConfig.useNativeAudioUplink && !kIsWeb && Platform.isWindows);
 
   void setAuthToken(String? token) {
     _authToken = token;
@@ -33,7 +44,7 @@ class TranscriptionService {
   }
 
   Stream<TranscriptionResult> get transcriptStream => _transcriptController.stream;
-  bool get isConnected => _channel != null;
+  bool get isConnected => _channel != null || _nativeConnected;
 
   Future<void> connect() async {
     try {
@@ -47,6 +58,10 @@ class TranscriptionService {
           'token': _authToken!,
         }).toString();
       }
+      if (usesNativeUplink) {
+        await _connectNative(wsUrl);
+        return;
+      }
       _channel = HttpClientService.createWebSocketChannel(Uri.parse(wsUrl));
 
       // Cancel any existing subscription first
@@ -57,56 +72,7 @@ class TranscriptionService {
           if (_disconnecting || _channel == null) {
             return;
           }
-          
-          final data = jsonDecode(message);
-
-          if (data['type'] == 'transcript') {
-            final text = (data['text'] as String?) ?? '';
-            if (text.trim().isEmpty) return;
-            
-            final receivedSource = (data['source'] as String?) ?? 'unknown';
-
-            _transcriptController.add(
-              TranscriptionResult(
-                text: text,
-                isFinal: data['is_final'] == true,
-                source: receivedSource,
-                confidence: data['confidence']?.toDouble() ?? 0.0,
-              ),
-            );
-            return;
-          }
-
-          if (data['type'] == 'session_revoked') {
-            // Force sign-out flow in the app.
-            _transcriptController.addError('Session revoked');
-            try {
-              _onSessionRevoked?.call();
-            } catch (_) {}
-            disconnect();
-            return;
-          }
-
-          if (data['type'] == 'status') {
-            return;
-          }
-
-          if (data['type'] == 'plan_update') {
-            // Plan was updated on the backend, notify listeners to refresh billing info
-            print('[TranscriptionService] Plan update received: ${data['plan']}, notifying listeners');
-            try {
-              _onPlanUpdated?.call();
-            } catch (e) {
-              print('[TranscriptionService] Error in plan update callback: $e');
-            }
-            return;
-          }
-
-          if (data['type'] == 'error') {
-            print('[TranscriptionService] Error from server: ${data['message']}');
-            _transcriptController.addError(data['message']);
-            return;
-          }
+          _handleServerMessage(message);
         },
         onError: (error) {
           if (_disconnecting) return;
@@ -132,7 +98,98 @@ class TranscriptionService {
     }
   }
 
+  Future<void> _connectNative(String wsUrl) async {
+    await _nativeSubscription?.cancel();
+    _nativeSubscription = NativeAudioUplink.events().listen((event) {
+      if (_disconnecting || !_nativeConnected) return;
+      if (event['type'] == 'message') {
+        _handleServerMessage(event['data']);
+        return;
+      }
+      if (event['type'] == 'closed') {
+        final error = (event['error'] as String?) ?? '';
+        if (error.isNotEmpty) {
+          print('[TranscriptionService] Native uplink error: $error');
+          if (!_transcriptController.isClosed) {
+            _transcriptController.addError(error);
+          }
+        } else {
+          print('[TranscriptionService] Native uplink closed');
+        }
+        disconnect();
+      }
+    });
+
+    if (!await NativeAudioUplink.connect(wsUrl)) {
+      await _nativeSubscription?.cancel();
+      _nativeSubscription = null;
+      throw StateError('Native uplink failed to start');
+    }
+    _nativeConnected = true;
+
+    print('[TranscriptionService] Native uplink started, sending start message');
+    NativeAudioUplink.send(jsonEncode({'type': 'start'}));
+  }
+
+  void _handleServerMessage(dynamic message) {
+    final data = jsonDecode(message);
+
+    if (data['type'] == 'transcript') {
+      final text = (data['text'] as String?) ?? '';
+      if (text.trim().isEmpty) return;
+      
+      final receivedSource = (data['source'] as String?) ?? 'unknown';
+
+      _transcriptController.add(
+        TranscriptionResult(
+          text: text,
+          isFinal: data['is_final'] == true,
+          source: receivedSource,
+          confidence: data['confidence']?.toDouble() ?? 0.0,
+        ),
+      );
+      return;
+    }
+
+    if (data['type'] == 'session_revoked') {
+      // Force sign-out flow in the app.
+      _transcriptController.addError('Session revoked');
+      try {
+        _onSessionRevoked?.call();
+      } catch (_) {}
+      disconnect();
+      return;
+    }
+
+    if (data['type'] == 'status') {
+      return;
+    }
+
+    if (data['type'] == 'plan_update') {
+      // Plan was updated on the backend, notify listeners to refresh billing info
+      print('[TranscriptionService] Plan update received: ${data['plan']}, notifying listeners');
+      try {
+        _onPlanUpdated?.call();
+      } catch (e) {
+        print('[TranscriptionService] Error in plan update callback: $e');
+      }
+      return;
+    }
+
+    if (data['type'] == 'error') {
+      print('[TranscriptionService] Error from server: ${data['message']}');
+      _transcriptController.addError(data['message']);
+      return;
+    }
+  }
+
   void sendAudio(dynamic audioData, {String source = 'mic'}) {
+    if (_nativeConnected) {
+      final Uint8List audioBytes = audioData is Uint8List ? audioData : Uint8List.fromList(audioData as List<int>);
+      NativeAudioUplink.sendAudio(audioBytes, source: source);
+      return;
+    }
+
     final channel = _channel;
     if (channel == null) {
       // Avoid log spam in tight loop.
@@ -159,9 +216,45 @@ class TranscriptionService {
     }
   }
 
+  /// Forward a compacted silence run as metadata instead of zero-filled PCM,
+  /// so the server can keep its audio timeline continuous.
+  void sendAudioGap({required int startSample, required int samples, String source = 'system'}) {
+    final channel = _channel;
+    if ((channel == null && !_nativeConnected) || samples <= 0) return;
+
+    try {
+      final message = jsonEncode({
+        'type': 'audio_gap',
+        'source': source,
+        'startSample': startSample,
+        'samples': samples,
+        'sampleRate': 16000,
+      });
+      if (channel == null) {
+        NativeAudioUplink.send(message);
+      } else {
+        channel.sink.add(message);
+      }
+    } catch (e) {
+      print('[TranscriptionService] Error sending audio gap: $e');
+    }
+  }
+
   void disconnect() {
     if (_disconnecting) return;
 
+    if (_nativeConnected) {
+      _disconnecting = true;
+      _nativeConnected = false;
+      _nativeSubscription?.cancel();
+      _nativeSubscription = null;
+      // Queued natively ahead of the close, so the server still sees it.
+      NativeAudioUplink.send(jsonEncode({'type': 'stop'}));
+      NativeAudioUplink.disconnect();
+      _disconnecting = false;
+      return;
+    }
+
     final channel = _channel;
     if (channel == null) return;
 
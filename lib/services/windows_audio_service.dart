@@ -3,6 +3,7 @@ import 'dart:typed_data';
 
 class WindowsAudioService {
   static const platform = MethodChannel('com.finalround/audio');
+  static const _levelChannel = EventChannel('com.finalround/audio_levels');
 
   /// Start capturing system audio (Windows Stereo Mix / Loopback)
   static Future<bool> startSystemAudioCapture() async {
@@ -26,19 +27,44 @@ class WindowsAudioService {
 
   /// Get system audio data
   /// Returns a stream of audio bytes from system audio
-  static Future<List<int>> getSystemAudioFrame({int? lengthBytes}) async {
+  /// The codec already hands us a Uint8List; return it as-is instead of
+  /// copying it into a List<int>.
+  static Future<Uint8List> getSystemAudioFrame({int? lengthBytes}) async {
     try {
       final result = await platform.invokeMethod<Uint8List>(
         'getSystemAudioFrame',
         lengthBytes == null ? null : <String, dynamic>{'length': lengthBytes},
       );
-      return result?.toList() ?? <int>[];
+      return result ?? Uint8List(0);
     } catch (e) {
       print('[WindowsAudioService] Error getting system audio frame: $e');
-      return [];
+      return Uint8List(0);
     }
   }
 
+  /// Drain the silence runs the native pipeline compacted out of the system
+  /// audio stream. Each gap is `{startSample, length}` on the 16kHz timeline.
+  static Future<List<SystemAudioGap>> getSystemAudioGaps() async {
+    try {
+      final result = await platform.invokeMethod<List<dynamic>>('getSystemAudioGaps');
+      if (result == null) return const <SystemAudioGap>[];
+      return result.map(SystemAudioGap.tryParse).whereType<SystemAudioGap>().toList(growable: false);
+    } catch (e) {
+      print('[WindowsAudioService] Error getting system audio gaps: $e');
+      return const <SystemAudioGap>[];
+    }
+  }
+
+  /// Low-rate (~80ms) level feed computed natively from system audio, so meters
+  /// and waveforms don't need raw PCM in the UI isolate.
+  static Stream<SystemAudioLevel> systemAudioLevels() {
+    return _levelChannel
+        .receiveBroadcastStream()
+        .map(SystemAudioLevel.tryParse)
+        .where((level) => level != null)
+        .cast<SystemAudioLevel>();
+  }
+
   /// Mix microphone and system audio
   static List<int> mixAudio(List<int> micAudio, List<int> systemAudio) {
     final length = micAudio.length;
@@ -73,3 +99,51 @@ class WindowsAudioService {
     return mixedAudio;
   }
 }
+
+/// A run of silence removed from the 16kHz system audio stream.
+class SystemAudioGap {
+  final int startSample;
+  final int length;
+
+  const SystemAudioGap({required this.startSample, required this.length});
+
+  static SystemAudioGap? tryParse(dynamic raw) {
+    if (raw is! Map) return null;
+    final start = (raw['startSample'] as num?)?.toInt();
+    final length = (raw['length'] as num?)?.toInt();
+    if (start == null || length == null || length <= 0) return null;
+    return SystemAudioGap(startSample: start, length: length);
+  }
+}
+
+/// One metering window of native audio: RMS, peak and a min/max waveform,
+/// all normalized to [-1, 1].
+class SystemAudioLevel {
+  final String source;
+  final double rms;
+  final double peak;
+
+  /// Interleaved (min, max) pairs across the window.
+  final Float32List waveform;
+  final int endSample;
+
+  const SystemAudioLevel({
+    required this.source,
+    required this.rms,
+    required this.peak,
+    required this.waveform,
+    required this.endSample,
+  });
+
+  static SystemAudioLevel? tryParse(dynamic raw) {
+    if (raw is! Map) return null;
+    final waveform = raw['waveform'];
+    return SystemAudioLevel(
+      source: (raw['source'] as String?) ?? 'system',
+      rms: (raw['rms'] as num?)?.toDouble() ?? 0.0,
+      peak: (raw['peak'] as num?)?.toDouble() ?? 0.0,
+      waveform: waveform is Float32List ? waveform : Float32List(0),
+      endSample: (raw['endSample'] as num?)?.toInt() ?? 0,
+    );
+  }
+}
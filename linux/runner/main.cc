@@ -1,6 +1,11 @@
+#include <X11/Xlib.h>
+
 #include "my_application.h"
 
 int main(int argc, char** argv) {
+  // The window channel captures on a worker thread with its own X
+  // connection; Xlib needs this before any other call for that.
+  XInitThreads();
   g_autoptr(MyApplication) app = my_application_new();
   return g_application_run(G_APPLICATION(app), argc, argv);
 }
@@ -0,0 +1,271 @@
+#include "window_channel.h"
+
+#include <glib-unix.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr char kChannelName[] = "com.finalround/window";
+
+// Reads an integer argument from a map; false when absent or not an int.
+bool GetIntArg(FlValue* args, const char* key, int64_t& out) {
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) return false;
+  FlValue* value = fl_value_lookup_string(args, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_INT) return false;
+  out = fl_value_get_int(value);
+  return true;
+}
+
+FlMethodResponse* ErrorResponse(const char* code, const char* message) {
+  return FL_METHOD_RESPONSE(fl_method_error_response_new(code, message, nullptr));
+}
+
+FlMethodResponse* SuccessResponse(FlValue* value) {
+  FlMethodResponse* response = FL_METHOD_RESPONSE(fl_method_success_response_new(value));
+  fl_value_unref(value);
+  return response;
+}
+
+// {width, height, bytes}, as SetPixelsOutcome replies on Windows.
+FlMethodResponse* PixelsResponse(const std::vector<uint8_t>& bgra, int width, int height) {
+  FlValue* map = fl_value_new_map();
+  fl_value_set_string_take(map, "width", fl_value_new_int(width));
+  fl_value_set_string_take(map, "height", fl_value_new_int(height));
+  fl_value_set_string_take(map, "bytes", fl_value_new_uint8_list(bgra.data(), bgra.size()));
+  return SuccessResponse(map);
+}
+
+// A capture-thread response waiting for the main loop to send it.
+struct PendingResponse {
+  FlMethodCall* method_call;  // Owned reference.
+  FlMethodResponse* response;  // Owned reference.
+};
+
+gboolean SendPendingResponse(gpointer user_data) {
+  auto* pending = static_cast<PendingResponse*>(user_data);
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(pending->method_call, pending->response, &error)) {
+    g_warning("Failed to send window channel response: %s", error->message);
+  }
+  g_object_unref(pending->response);
+  g_object_unref(pending->method_call);
+  delete pending;
+  return G_SOURCE_REMOVE;
+}
+
+}  // namespace
+
+WindowChannel::WindowChannel(FlBinaryMessenger* messenger) {
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  channel_ = fl_method_channel_new(messenger, kChannelName, FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(channel_, OnMethodCall, this, nullptr);
+  // Lets capture latency be compared against plain XGetImage.
+  if (g_getenv("FINALROUND_X11_NO_SHM") != nullptr) capture_.set_use_shm(false);
+  if (capture_.ok()) {
+    x_watch_ = g_unix_fd_add(capture_.ConnectionFd(), G_IO_IN, OnXEvents, this);
+    const Window active = capture_.ActiveWindow();
+    if (active != 0) {
+      foreground_.OnForeground(active, capture_.IsShareableWindow(active, static_cast<long>(getpid())));
+    }
+  }
+}
+
+WindowChannel::~WindowChannel() {
+  {
+    std::lock_guard<std::mutex> lock(jobs_mutex_);
+    stopping_ = true;
+  }
+  jobs_cv_.notify_all();
+  if (capture_thread_.joinable()) capture_thread_.join();
+  // Responses already handed to the main loop own their call and go out on
+  // their own; anything still queued is answered here.
+  for (CaptureJob& job : jobs_) {
+    g_autoptr(FlMethodResponse) response = ErrorResponse("CAPTURE_FAILED", "Window channel closed.");
+    fl_method_call_respond(job.method_call, response, nullptr);
+    g_object_unref(job.method_call);
+  }
+  jobs_.clear();
+  if (x_watch_ != 0) g_source_remove(x_watch_);
+  fl_method_channel_set_method_call_handler(channel_, nullptr, nullptr, nullptr);
+  g_clear_object(&channel_);
+}
+
+gboolean WindowChannel::OnXEvents(gint fd, GIOCondition condition, gpointer user_data) {
+  static_cast<WindowChannel*>(user_data)->UpdateForeground();
+  return G_SOURCE_CONTINUE;
+}
+
+void WindowChannel::UpdateForeground() {
+  Window active = 0;
+  if (!capture_.TakeActiveWindowChange(active) || active == 0) return;
+  foreground_.OnForeground(active, capture_.IsShareableWindow(active, static_cast<long>(getpid())));
+}
+
+void WindowChannel::OnMethodCall(FlMethodChannel* channel, FlMethodCall* method_call, gpointer user_data) {
+  auto* self = static_cast<WindowChannel*>(user_data);
+  g_autoptr(FlMethodResponse) response = self->HandleMethodCall(method_call);
+  if (response == nullptr) return;  // The capture thread responds.
+  g_autoptr(GError) error = nullptr;
+  if (!fl_method_call_respond(method_call, response, &error)) {
+    g_warning("Failed to send window channel response: %s", error->message);
+  }
+}
+
+void WindowChannel::RunOnCaptureThread(FlMethodCall* method_call, CaptureTask task) {
+  {
+    std::lock_guard<std::mutex> lock(jobs_mutex_);
+    jobs_.push_back(CaptureJob{FL_METHOD_CALL(g_object_ref(method_call)), std::move(task)});
+  }
+  if (!capture_thread_.joinable()) capture_thread_ = std::thread(&WindowChannel::CaptureThreadProc, this);
+  jobs_cv_.notify_one();
+}
+
+void WindowChannel::CaptureThreadProc() {
+  // Its own connection: Xlib calls on capture_ stay on the main thread.
+  X11Capture capture(false);
+  if (g_getenv("FINALROUND_X11_NO_SHM") != nullptr) capture.set_use_shm(false);
+  for (;;) {
+    CaptureJob job;
+    {
+      std::unique_lock<std::mutex> lock(jobs_mutex_);
+      jobs_cv_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+      if (stopping_) return;
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+    FlMethodResponse* response = capture.ok()
+                                     ? job.task(capture)
+                                     : ErrorResponse("CAPTURE_FAILED", "Could not open the X display.");
+    g_idle_add(SendPendingResponse, new PendingResponse{job.method_call, response});
+  }
+}
+
+FlMethodResponse* WindowChannel::HandleMethodCall(FlMethodCall* method_call) {
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+  if (!capture_.ok()) {
+    // No X display (e.g. a Wayland-only session).
+    return FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  if (strcmp(method, "listMonitors") == 0) {
+    FlValue* list = fl_value_new_list();
+    for (const X11Monitor& m : capture_.ListMonitors()) {
+      FlValue* map = fl_value_new_map();
+      fl_value_set_string_take(map, "id", fl_value_new_int(m.id));
+      fl_value_set_string_take(map, "index", fl_value_new_int(m.index));
+      fl_value_set_string_take(map, "width", fl_value_new_int(m.width));
+      fl_value_set_string_take(map, "height", fl_value_new_int(m.height));
+      fl_value_set_string_take(map, "isPrimary", fl_value_new_bool(m.primary));
+      fl_value_set_string_take(map, "device", fl_value_new_string(m.name.c_str()));
+      fl_value_append_take(list, map);
+    }
+    return SuccessResponse(list);
+  } else if (strcmp(method, "listShareableWindows") == 0) {
+    // Window ids travel under "hwnd" so the Dart picker needs no changes.
+    FlValue* list = fl_value_new_list();
+    for (const X11ClientWindow& w : capture_.ListWindows(static_cast<long>(getpid()))) {
+      FlValue* map = fl_value_new_map();
+      fl_value_set_string_take(map, "hwnd", fl_value_new_int(static_cast<int64_t>(w.window)));
+      fl_value_set_string_take(map, "title", fl_value_new_string(w.title.c_str()));
+      fl_value_set_string_take(map, "isMinimized", fl_value_new_bool(w.minimized));
+      fl_value_append_take(list, map);
+    }
+    return SuccessResponse(list);
+  } else if (strcmp(method, "getVirtualScreenBounds") == 0) {
+    int x = 0, y = 0, w = 0, h = 0;
+    capture_.ScreenBounds(x, y, w, h);
+    FlValue* map = fl_value_new_map();
+    fl_value_set_string_take(map, "x", fl_value_new_int(x));
+    fl_value_set_string_take(map, "y", fl_value_new_int(y));
+    fl_value_set_string_take(map, "width", fl_value_new_int(w));
+    fl_value_set_string_take(map, "height", fl_value_new_int(h));
+    return SuccessResponse(map);
+  } else if (strcmp(method, "captureRectPixels") == 0) {
+    int64_t x = 0, y = 0, w = 0, h = 0;
+    GetIntArg(args, "x", x);
+    GetIntArg(args, "y", y);
+    GetIntArg(args, "width", w);
+    GetIntArg(args, "height", h);
+    if (w <= 0 || h <= 0 || w > G_MAXINT || h > G_MAXINT) {
+      return ErrorResponse("BAD_ARGS", "Invalid or missing width/height");
+    }
+    const int rx = static_cast<int>(x), ry = static_cast<int>(y);
+    const int rw = static_cast<int>(w), rh = static_cast<int>(h);
+    RunOnCaptureThread(method_call, [rx, ry, rw, rh](X11Capture& capture) {
+      std::vector<uint8_t> pixels;
+      if (!capture.CaptureRect(rx, ry, rw, rh, pixels)) {
+        return ErrorResponse("CAPTURE_FAILED", "Failed to capture screen region.");
+      }
+      return PixelsResponse(pixels, rw, rh);
+    });
+    return nullptr;
+  } else if (strcmp(method, "captureMonitorPixels") == 0) {
+    int64_t id = 0;
+    if (!GetIntArg(args, "monitorId", id) || id == 0) {
+      return ErrorResponse("BAD_ARGS", "Missing monitorId");
+    }
+    for (const X11Monitor& m : capture_.ListMonitors()) {
+      if (m.id != id) continue;
+      RunOnCaptureThread(method_call, [m](X11Capture& capture) {
+        std::vector<uint8_t> pixels;
+        if (!capture.CaptureRect(m.x, m.y, m.width, m.height, pixels)) {
+          return ErrorResponse("CAPTURE_FAILED", "Failed to capture monitor.");
+        }
+        return PixelsResponse(pixels, m.width, m.height);
+      });
+      return nullptr;
+    }
+    return ErrorResponse("NO_MONITOR", "Monitor not found");
+  } else if (strcmp(method, "captureWindowPixels") == 0 || strcmp(method, "captureActiveWindowPixels") == 0) {
+    const long self_pid = static_cast<long>(getpid());
+    Window target = 0;
+    if (strcmp(method, "captureActiveWindowPixels") == 0) {
+      // Our own window is usually the active one; take the window the user
+      // last had in front instead, as the Windows runner does, or failing
+      // that the topmost other visible window.
+      const Window active = capture_.ActiveWindow();
+      if (active != 0 && capture_.IsShareableWindow(active, self_pid)) target = active;
+      if (target == 0) {
+        UpdateForeground();
+        target = static_cast<Window>(foreground_.LastTarget([this, self_pid](ForegroundTracker::WindowId id) {
+          X11ClientWindow w;
+          return capture_.IsShareableWindow(static_cast<Window>(id), self_pid, &w) && !w.minimized;
+        }));
+      }
+      for (const X11ClientWindow& w : capture_.ListWindows(self_pid)) {
+        if (target != 0) break;
+        if (!w.minimized) target = w.window;
+      }
+      if (target == 0) return ErrorResponse("NO_TARGET", "No window to capture");
+    } else {
+      int64_t id = 0;
+      if (args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_INT) {
+        id = fl_value_get_int(args);
+      } else {
+        GetIntArg(args, "hwnd", id);
+      }
+      if (id == 0) return ErrorResponse("BAD_ARGS", "Missing hwnd");
+      target = static_cast<Window>(id);
+      if (!capture_.WindowExists(target)) return ErrorResponse("NO_WINDOW", "Window no longer exists");
+      if (capture_.WindowPid(target) == self_pid) {
+        return ErrorResponse("BAD_TARGET", "Cannot capture this app window");
+      }
+    }
+    RunOnCaptureThread(method_call, [target](X11Capture& capture) {
+      std::vector<uint8_t> pixels;
+      int width = 0, height = 0;
+      if (!capture.CaptureWindow(target, pixels, width, height)) {
+        return ErrorResponse("CAPTURE_FAILED", "Failed to capture window.");
+      }
+      return PixelsResponse(pixels, width, height);
+    });
+    return nullptr;
+  }
+
+  return FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+}
@@ -0,0 +1,66 @@
+#ifndef RUNNER_WINDOW_CHANNEL_H_
+#define RUNNER_WINDOW_CHANNEL_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "foreground_tracker.h"
+#include "x11_capture.h"
+
+// The Linux side of the "com.finalround/window" channel: monitor and window
+// listing plus raw BGRA capture, replying with the same shapes as the
+// Windows runner. Everything else is left not-implemented, so the Dart
+// callers take their MissingPluginException fallbacks.
+//
+// Listing and target lookup run on the GTK main thread. Pixel reads run on
+// a worker thread with its own X connection and are answered from the main
+// loop, so a large or slow capture doesn't stall the UI.
+class WindowChannel {
+ public:
+  explicit WindowChannel(FlBinaryMessenger* messenger);
+  ~WindowChannel();
+
+  WindowChannel(const WindowChannel&) = delete;
+  WindowChannel& operator=(const WindowChannel&) = delete;
+
+ private:
+  // Produces a response on the capture thread.
+  using CaptureTask = std::function<FlMethodResponse*(X11Capture& capture)>;
+  struct CaptureJob {
+    FlMethodCall* method_call = nullptr;  // Owned reference.
+    CaptureTask task;
+  };
+
+  static void OnMethodCall(FlMethodChannel* channel, FlMethodCall* method_call, gpointer user_data);
+  // nullptr when the call was handed to the capture thread, which responds.
+  FlMethodResponse* HandleMethodCall(FlMethodCall* method_call);
+
+  // Queues |task| for the capture thread (started on first use); its
+  // response is sent on the main loop.
+  void RunOnCaptureThread(FlMethodCall* method_call, CaptureTask task);
+  void CaptureThreadProc();
+
+  // Watch on the X connection; feeds _NET_ACTIVE_WINDOW changes to
+  // |foreground_|.
+  static gboolean OnXEvents(gint fd, GIOCondition condition, gpointer user_data);
+  void UpdateForeground();
+
+  FlMethodChannel* channel_ = nullptr;
+  // Main thread only.
+  X11Capture capture_;
+  ForegroundTracker foreground_{8};
+  guint x_watch_ = 0;
+
+  std::thread capture_thread_;
+  std::mutex jobs_mutex_;
+  std::condition_variable jobs_cv_;
+  std::deque<CaptureJob> jobs_;
+  bool stopping_ = false;
+};
+
+#endif  // RUNNER_WINDOW_CHANNEL_H_
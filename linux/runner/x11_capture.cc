@@ -0,0 +1,473 @@
+#include "x11_capture.h"
+
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/Xcomposite.h>
+#ifdef HAVE_XRANDR
+#include <X11/extensions/Xrandr.h>
+#endif
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+// Largest capture accepted, in pixels (a little over 16K x 16K).
+constexpr int64_t kMaxCapturePixels = int64_t{1} << 28;
+
+// The process-wide X error handler is installed once and chains to the one
+// it replaced (GDK's). Errors are reported on the thread that reads the
+// failing request's reply, i.e. the thread using that connection, so each
+// thread keeps its own trap state.
+XErrorHandler g_previous_handler = nullptr;
+std::once_flag g_install_handler;
+thread_local Display* t_trap_display = nullptr;
+thread_local int t_x_error = 0;
+
+int TrapXError(Display* display, XErrorEvent* event) {
+  if (display == t_trap_display) {
+    t_x_error = event->error_code;
+    return 0;
+  }
+  return g_previous_handler ? g_previous_handler(display, event) : 0;
+}
+
+// Records X errors on |display| raised on this thread while alive instead
+// of passing them to the default handler, which would exit the process.
+// Windows can vanish between listing and capture, so BadWindow / BadMatch
+// are expected here. Nests, and traps on other threads don't interfere.
+class ScopedErrorTrap {
+ public:
+  explicit ScopedErrorTrap(Display* display)
+      : display_(display), outer_display_(t_trap_display), outer_error_(t_x_error) {
+    std::call_once(g_install_handler, []() { g_previous_handler = XSetErrorHandler(TrapXError); });
+    XSync(display_, False);
+    t_trap_display = display_;
+    t_x_error = 0;
+  }
+  ~ScopedErrorTrap() {
+    XSync(display_, False);
+    t_trap_display = outer_display_;
+    t_x_error = outer_error_;
+  }
+
+  bool failed() {
+    XSync(display_, False);
+    return t_x_error != 0;
+  }
+
+ private:
+  Display* display_;
+  Display* outer_display_;
+  int outer_error_;
+};
+
+void FillOpaqueBlack(uint8_t* out, size_t pixels) {
+  for (size_t i = 0; i < pixels; i++) {
+    out[i * 4] = 0;
+    out[i * 4 + 1] = 0;
+    out[i * 4 + 2] = 0;
+    out[i * 4 + 3] = 255;
+  }
+}
+
+// Scales the |mask| field of |pixel| to 0..255.
+uint8_t Channel(unsigned long pixel, unsigned long mask) {
+  if (mask == 0) return static_cast<uint8_t>(pixel & 0xff);
+  const int shift = __builtin_ctzl(mask);
+  const int bits = __builtin_popcountl(mask);
+  const unsigned long v = (pixel & mask) >> shift;
+  if (bits >= 8) return static_cast<uint8_t>(v >> (bits - 8));
+  return static_cast<uint8_t>(v * 255 / ((1ul << bits) - 1));
+}
+
+// Converts |image| into BGRA rows |out_w| pixels apart, alpha forced to 255.
+void ConvertImage(const XImage* image, uint8_t* out, int out_w) {
+  const size_t out_stride = static_cast<size_t>(out_w) * 4u;
+  const int w = image->width;
+  const int h = image->height;
+  if (image->bits_per_pixel == 32 && image->byte_order == LSBFirst && image->red_mask == 0xff0000 &&
+      image->green_mask == 0xff00 && image->blue_mask == 0xff) {
+    // The usual 24/32-bit TrueColor layout is BGRX in memory already.
+    for (int y = 0; y < h; y++) {
+      const uint8_t* src = reinterpret_cast<const uint8_t*>(image->data) +
+                           static_cast<size_t>(y) * static_cast<size_t>(image->bytes_per_line);
+      uint8_t* dst = out + static_cast<size_t>(y) * out_stride;
+      memcpy(dst, src, static_cast<size_t>(w) * 4u);
+      for (int x = 0; x < w; x++) dst[x * 4 + 3] = 255;
+    }
+    return;
+  }
+  XImage* mutable_image = const_cast<XImage*>(image);
+  for (int y = 0; y < h; y++) {
+    uint8_t* dst = out + static_cast<size_t>(y) * out_stride;
+    for (int x = 0; x < w; x++) {
+      const unsigned long p = XGetPixel(mutable_image, x, y);
+      dst[x * 4] = Channel(p, image->blue_mask);
+      dst[x * 4 + 1] = Channel(p, image->green_mask);
+      dst[x * 4 + 2] = Channel(p, image->red_mask);
+      dst[x * 4 + 3] = 255;
+    }
+  }
+}
+
+}  // namespace
+
+X11Capture::X11Capture(bool watch_active_window) {
+  display_ = XOpenDisplay(nullptr);
+  if (!display_) return;
+  root_ = DefaultRootWindow(display_);
+  shm_available_ = XShmQueryExtension(display_) == True;
+  int event_base = 0, error_base = 0, major = 0, minor = 2;
+  composite_available_ = XCompositeQueryExtension(display_, &event_base, &error_base) &&
+                         XCompositeQueryVersion(display_, &major, &minor) && (major > 0 || minor >= 2);
+  active_window_atom_ = GetAtom("_NET_ACTIVE_WINDOW");
+  // The window manager announces focus changes as _NET_ACTIVE_WINDOW
+  // updates. Only selected when someone drains them, or they pile up in
+  // the event queue.
+  if (watch_active_window) XSelectInput(display_, root_, PropertyChangeMask);
+  XFlush(display_);
+}
+
+X11Capture::~X11Capture() {
+  if (!display_) return;
+  ReleaseShmSegment();
+  XCloseDisplay(display_);
+}
+
+Atom X11Capture::GetAtom(const char* name) {
+  return XInternAtom(display_, name, False);
+}
+
+bool X11Capture::GetWindowProperty(Window window, Atom property, Atom type, std::vector<unsigned long>& out) {
+  out.clear();
+  Atom actual_type = None;
+  int format = 0;
+  unsigned long count = 0, after = 0;
+  unsigned char* data = nullptr;
+  if (XGetWindowProperty(display_, window, property, 0, 4096, False, type, &actual_type, &format, &count, &after,
+                         &data) != Success) {
+    return false;
+  }
+  // Format-32 properties come back as an array of long, whatever its width.
+  if (data && actual_type == type && format == 32) {
+    const unsigned long* values = reinterpret_cast<const unsigned long*>(data);
+    out.assign(values, values + count);
+  }
+  if (data) XFree(data);
+  return !out.empty();
+}
+
+std::string X11Capture::GetWindowTitle(Window window) {
+  std::string title;
+  Atom actual_type = None;
+  int format = 0;
+  unsigned long count = 0, after = 0;
+  unsigned char* data = nullptr;
+  const Atom utf8 = GetAtom("UTF8_STRING");
+  if (XGetWindowProperty(display_, window, GetAtom("_NET_WM_NAME"), 0, 1024, False, utf8, &actual_type, &format,
+                         &count, &after, &data) == Success &&
+      data) {
+    if (actual_type == utf8 && format == 8) title.assign(reinterpret_cast<const char*>(data), count);
+    XFree(data);
+  }
+  if (title.empty()) {
+    char* name = nullptr;
+    if (XFetchName(display_, window, &name) && name) {
+      title = name;
+      XFree(name);
+    }
+  }
+  return title;
+}
+
+bool X11Capture::HasState(const std::vector<unsigned long>& states, const char* name) {
+  const Atom atom = GetAtom(name);
+  return std::find(states.begin(), states.end(), atom) != states.end();
+}
+
+std::vector<X11Monitor> X11Capture::ListMonitors() {
+  std::vector<X11Monitor> monitors;
+  if (!display_) return monitors;
+#ifdef HAVE_XRANDR
+  int event_base = 0, error_base = 0, major = 0, minor = 0;
+  if (XRRQueryExtension(display_, &event_base, &error_base) && XRRQueryVersion(display_, &major, &minor) &&
+      (major > 1 || (major == 1 && minor >= 5))) {
+    int count = 0;
+    XRRMonitorInfo* infos = XRRGetMonitors(display_, root_, True, &count);
+    for (int i = 0; infos && i < count; i++) {
+      if (infos[i].width <= 0 || infos[i].height <= 0) continue;
+      X11Monitor m;
+      m.index = static_cast<int>(monitors.size()) + 1;
+      m.id = m.index;
+      m.x = infos[i].x;
+      m.y = infos[i].y;
+      m.width = infos[i].width;
+      m.height = infos[i].height;
+      m.primary = infos[i].primary != 0;
+      if (char* name = XGetAtomName(display_, infos[i].name)) {
+        m.name = name;
+        XFree(name);
+      }
+      monitors.push_back(m);
+    }
+    if (infos) XRRFreeMonitors(infos);
+  }
+#endif
+  if (monitors.empty()) {
+    X11Monitor m;
+    m.id = 1;
+    m.index = 1;
+    ScreenBounds(m.x, m.y, m.width, m.height);
+    m.primary = true;
+    m.name = DisplayString(display_);
+    monitors.push_back(m);
+  }
+  return monitors;
+}
+
+std::vector<X11ClientWindow> X11Capture::ListWindows(long exclude_pid) {
+  std::vector<X11ClientWindow> windows;
+  if (!display_) return windows;
+
+  // Stacking order is bottom-to-top; list topmost first like EnumWindows.
+  std::vector<unsigned long> clients;
+  bool stacking = GetWindowProperty(root_, GetAtom("_NET_CLIENT_LIST_STACKING"), XA_WINDOW, clients);
+  if (stacking) {
+    std::reverse(clients.begin(), clients.end());
+  } else if (!GetWindowProperty(root_, GetAtom("_NET_CLIENT_LIST"), XA_WINDOW, clients)) {
+    return windows;
+  }
+
+  ScopedErrorTrap trap(display_);
+  for (unsigned long client : clients) {
+    X11ClientWindow entry;
+    if (ReadClientWindow(static_cast<Window>(client), exclude_pid, entry)) windows.push_back(entry);
+  }
+  return windows;
+}
+
+bool X11Capture::IsShareableWindow(Window window, long exclude_pid, X11ClientWindow* entry) {
+  if (!display_ || window == 0) return false;
+  X11ClientWindow read;
+  ScopedErrorTrap trap(display_);
+  if (!ReadClientWindow(window, exclude_pid, read) || trap.failed()) return false;
+  if (entry) *entry = read;
+  return true;
+}
+
+bool X11Capture::ReadClientWindow(Window window, long exclude_pid, X11ClientWindow& entry) {
+  std::vector<unsigned long> values;
+  if (GetWindowProperty(window, GetAtom("_NET_WM_WINDOW_TYPE"), XA_ATOM, values) &&
+      (HasState(values, "_NET_WM_WINDOW_TYPE_DOCK") || HasState(values, "_NET_WM_WINDOW_TYPE_DESKTOP") ||
+       HasState(values, "_NET_WM_WINDOW_TYPE_SPLASH"))) {
+    return false;
+  }
+  if (exclude_pid > 0 && GetWindowProperty(window, GetAtom("_NET_WM_PID"), XA_CARDINAL, values) &&
+      static_cast<long>(values[0]) == exclude_pid) {
+    return false;
+  }
+  GetWindowProperty(window, GetAtom("_NET_WM_STATE"), XA_ATOM, values);
+  if (HasState(values, "_NET_WM_STATE_SKIP_TASKBAR")) return false;
+
+  entry.window = window;
+  entry.title = GetWindowTitle(window);
+  if (entry.title.empty()) return false;
+  entry.minimized = HasState(values, "_NET_WM_STATE_HIDDEN");
+  return true;
+}
+
+Window X11Capture::ActiveWindow() {
+  if (!display_) return 0;
+  std::vector<unsigned long> values;
+  ScopedErrorTrap trap(display_);
+  if (!GetWindowProperty(root_, GetAtom("_NET_ACTIVE_WINDOW"), XA_WINDOW, values)) return 0;
+  return static_cast<Window>(values[0]);
+}
+
+bool X11Capture::TakeActiveWindowChange(Window& active) {
+  if (!display_) return false;
+  bool changed = false;
+  while (XPending(display_) > 0) {
+    XEvent event;
+    XNextEvent(display_, &event);
+    if (event.type == PropertyNotify && event.xproperty.window == root_ &&
+        event.xproperty.atom == active_window_atom_) {
+      changed = true;
+    }
+  }
+  // Events only say the property changed; read it once for the batch.
+  if (changed) active = ActiveWindow();
+  return changed;
+}
+
+bool X11Capture::WindowExists(Window window) {
+  if (!display_ || window == 0) return false;
+  XWindowAttributes attrs{};
+  ScopedErrorTrap trap(display_);
+  return XGetWindowAttributes(display_, window, &attrs) && !trap.failed();
+}
+
+long X11Capture::WindowPid(Window window) {
+  if (!display_ || window == 0) return -1;
+  std::vector<unsigned long> values;
+  ScopedErrorTrap trap(display_);
+  if (!GetWindowProperty(window, GetAtom("_NET_WM_PID"), XA_CARDINAL, values)) return -1;
+  return static_cast<long>(values[0]);
+}
+
+void X11Capture::ScreenBounds(int& x, int& y, int& width, int& height) const {
+  x = 0;
+  y = 0;
+  width = display_ ? DisplayWidth(display_, DefaultScreen(display_)) : 0;
+  height = display_ ? DisplayHeight(display_, DefaultScreen(display_)) : 0;
+}
+
+bool X11Capture::EnsureShmSegment(size_t bytes) {
+  if (shm_size_ >= bytes) return true;
+  ReleaseShmSegment();
+  // Grow in 1 MB steps so slightly larger captures reuse the segment.
+  const size_t size = (bytes + (1u << 20) - 1) & ~static_cast<size_t>((1u << 20) - 1);
+  shm_info_.shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+  if (shm_info_.shmid < 0) return false;
+  shm_info_.shmaddr = static_cast<char*>(shmat(shm_info_.shmid, nullptr, 0));
+  if (shm_info_.shmaddr == reinterpret_cast<char*>(-1)) {
+    shmctl(shm_info_.shmid, IPC_RMID, nullptr);
+    return false;
+  }
+  shm_info_.readOnly = False;
+  bool attached = false;
+  {
+    ScopedErrorTrap trap(display_);
+    attached = XShmAttach(display_, &shm_info_) && !trap.failed();
+  }
+  // Marked for removal now; the kernel frees it once both sides detach.
+  shmctl(shm_info_.shmid, IPC_RMID, nullptr);
+  if (!attached) {
+    // A remote server can't see our memory; stay on XGetImage from now on.
+    shmdt(shm_info_.shmaddr);
+    shm_available_ = false;
+    return false;
+  }
+  shm_size_ = size;
+  return true;
+}
+
+void X11Capture::ReleaseShmSegment() {
+  if (shm_size_ == 0) return;
+  XShmDetach(display_, &shm_info_);
+  XSync(display_, False);
+  shmdt(shm_info_.shmaddr);
+  shm_size_ = 0;
+}
+
+bool X11Capture::ReadDrawable(Drawable drawable, Visual* visual, int depth, int x, int y, int w, int h,
+                              uint8_t* out, int out_w) {
+  if (use_shm_ && shm_available_) {
+    XImage* image = XShmCreateImage(display_, visual, static_cast<unsigned int>(depth), ZPixmap, nullptr,
+                                    &shm_info_, static_cast<unsigned int>(w), static_cast<unsigned int>(h));
+    if (image) {
+      bool read = false;
+      if (EnsureShmSegment(static_cast<size_t>(image->bytes_per_line) * static_cast<size_t>(image->height))) {
+        image->data = shm_info_.shmaddr;
+        ScopedErrorTrap trap(display_);
+        read = XShmGetImage(display_, drawable, image, x, y, AllPlanes) && !trap.failed();
+        if (read) ConvertImage(image, out, out_w);
+      }
+      image->data = nullptr;
+      XDestroyImage(image);
+      if (read) return true;
+    }
+  }
+
+  XImage* image = nullptr;
+  {
+    ScopedErrorTrap trap(display_);
+    image = XGetImage(display_, drawable, x, y, static_cast<unsigned int>(w), static_cast<unsigned int>(h),
+                      AllPlanes, ZPixmap);
+    if (trap.failed() && image) {
+      XDestroyImage(image);
+      image = nullptr;
+    }
+  }
+  if (!image) return false;
+  ConvertImage(image, out, out_w);
+  XDestroyImage(image);
+  return true;
+}
+
+bool X11Capture::CaptureRect(int x, int y, int w, int h, std::vector<uint8_t>& out) {
+  if (!display_ || w <= 0 || h <= 0 || static_cast<int64_t>(w) * h > kMaxCapturePixels) return false;
+  int root_x = 0, root_y = 0, root_w = 0, root_h = 0;
+  ScreenBounds(root_x, root_y, root_w, root_h);
+  const int x0 = (std::max)(x, root_x);
+  const int y0 = (std::max)(y, root_y);
+  const int x1 = static_cast<int>((std::min)(static_cast<int64_t>(x) + w, static_cast<int64_t>(root_x) + root_w));
+  const int y1 = static_cast<int>((std::min)(static_cast<int64_t>(y) + h, static_cast<int64_t>(root_y) + root_h));
+
+  const size_t pixels = static_cast<size_t>(w) * static_cast<size_t>(h);
+  out.resize(pixels * 4u);
+  if (x0 >= x1 || y0 >= y1) {
+    FillOpaqueBlack(out.data(), pixels);
+    return true;
+  }
+  if (x0 != x || y0 != y || x1 - x0 != w || y1 - y0 != h) FillOpaqueBlack(out.data(), pixels);
+  const int screen = DefaultScreen(display_);
+  uint8_t* dst = out.data() + (static_cast<size_t>(y0 - y) * static_cast<size_t>(w) + static_cast<size_t>(x0 - x)) * 4u;
+  return ReadDrawable(root_, DefaultVisual(display_, screen), DefaultDepth(display_, screen), x0 - root_x,
+                      y0 - root_y, x1 - x0, y1 - y0, dst, w);
+}
+
+bool X11Capture::CaptureWindow(Window window, std::vector<uint8_t>& out, int& width, int& height) {
+  if (!display_ || window == 0) return false;
+  XWindowAttributes attrs{};
+  {
+    ScopedErrorTrap trap(display_);
+    if (!XGetWindowAttributes(display_, window, &attrs) || trap.failed()) return false;
+  }
+  if (attrs.map_state != IsViewable || attrs.width <= 0 || attrs.height <= 0 ||
+      static_cast<int64_t>(attrs.width) * attrs.height > kMaxCapturePixels) {
+    return false;
+  }
+  width = attrs.width;
+  height = attrs.height;
+
+  if (composite_available_) {
+    // Automatic redirection gives the window an off-screen pixmap that
+    // holds its full contents whatever covers it; unredirected again after
+    // so a compositing manager's own redirection is left as it was.
+    Pixmap pixmap = None;
+    {
+      ScopedErrorTrap trap(display_);
+      XCompositeRedirectWindow(display_, window, CompositeRedirectAutomatic);
+      pixmap = XCompositeNameWindowPixmap(display_, window);
+      if (trap.failed()) pixmap = None;
+    }
+    bool read = false;
+    if (pixmap != None) {
+      out.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 4u);
+      read = ReadDrawable(pixmap, attrs.visual, attrs.depth, 0, 0, width, height, out.data(), width);
+    }
+    {
+      ScopedErrorTrap trap(display_);
+      if (pixmap != None) XFreePixmap(display_, pixmap);
+      XCompositeUnredirectWindow(display_, window, CompositeRedirectAutomatic);
+    }
+    if (read) return true;
+  }
+
+  // No XComposite: read the window's area of the screen, which shows
+  // whatever currently covers it.
+  int root_x = 0, root_y = 0;
+  Window child = 0;
+  {
+    ScopedErrorTrap trap(display_);
+    if (!XTranslateCoordinates(display_, window, root_, 0, 0, &root_x, &root_y, &child) || trap.failed()) {
+      return false;
+    }
+  }
+  return CaptureRect(root_x, root_y, width, height, out);
+}
@@ -0,0 +1,127 @@
+#ifndef RUNNER_X11_CAPTURE_H_
+#define RUNNER_X11_CAPTURE_H_
+
+#include <X11/Xlib.h>
+#include <X11/extensions/XShm.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One output as listMonitors reports it. |id| is index + 1 so it is never
+// 0, which the Dart side treats as "no monitor".
+struct X11Monitor {
+  int64_t id = 0;
+  int index = 0;
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+  bool primary = false;
+  std::string name;
+};
+
+// One EWMH client window as listShareableWindows reports it.
+struct X11ClientWindow {
+  Window window = 0;
+  std::string title;
+  bool minimized = false;
+};
+
+// Screen, monitor and window capture over a private Xlib connection.
+//
+// Pixels come back as tightly packed top-down BGRA with opaque alpha, the
+// same layout the Windows runner replies with. Screen reads go through
+// MIT-SHM (XShmGetImage into one reused segment) when the server offers it
+// and fall back to XGetImage otherwise; windows are read from their
+// XComposite backing pixmap so occluded windows still capture.
+//
+// One instance is not thread-safe, but each has its own connection, so
+// separate instances can be used from separate threads (the window channel
+// lists and tracks focus with one on the GTK main thread and captures with
+// another on a worker). Call XInitThreads() first in that case.
+class X11Capture {
+ public:
+  // |watch_active_window| selects root property events for
+  // TakeActiveWindowChange(); leave it off if nothing drains them.
+  explicit X11Capture(bool watch_active_window = true);
+  ~X11Capture();
+
+  X11Capture(const X11Capture&) = delete;
+  X11Capture& operator=(const X11Capture&) = delete;
+
+  // False when no X display could be opened (e.g. a pure Wayland session).
+  bool ok() const { return display_ != nullptr; }
+
+  bool has_shm() const { return shm_available_; }
+  bool has_composite() const { return composite_available_; }
+
+  // Forces the XGetImage path; used to compare latencies against SHM.
+  void set_use_shm(bool use_shm) { use_shm_ = use_shm; }
+
+  // Monitors from XRandR; the whole root window when XRandR is unavailable.
+  std::vector<X11Monitor> ListMonitors();
+
+  // _NET_CLIENT_LIST in stacking order, minus docks, desktops, windows that
+  // skip the taskbar, untitled windows and windows owned by |exclude_pid|.
+  std::vector<X11ClientWindow> ListWindows(long exclude_pid);
+
+  // Whether |window| is one ListWindows(|exclude_pid|) would include.
+  // Fills |entry| when given.
+  bool IsShareableWindow(Window window, long exclude_pid, X11ClientWindow* entry = nullptr);
+
+  // _NET_ACTIVE_WINDOW, or 0.
+  Window ActiveWindow();
+
+  // The connection's file descriptor, readable when events arrive; -1
+  // without a display.
+  int ConnectionFd() const { return display_ ? ConnectionNumber(display_) : -1; }
+
+  // Drains queued events; true, with the current _NET_ACTIVE_WINDOW (0 =
+  // none) in |active|, when it changed since the last call. Other calls may
+  // pull events off the socket into the queue, so drain before relying on
+  // it rather than only when ConnectionFd() is readable.
+  bool TakeActiveWindowChange(Window& active);
+
+  bool WindowExists(Window window);
+
+  // _NET_WM_PID of |window|, or -1 when unknown.
+  long WindowPid(Window window);
+
+  // The root window: the bounding box of all monitors.
+  void ScreenBounds(int& x, int& y, int& width, int& height) const;
+
+  // Captures the screen rectangle x,y,w,h. Parts off the root window are
+  // opaque black so the reply is always w x h. Replaces |out|.
+  bool CaptureRect(int x, int y, int w, int h, std::vector<uint8_t>& out);
+
+  // Captures |window|'s own contents (no frame), even when covered by other
+  // windows. False for unmapped or minimized windows.
+  bool CaptureWindow(Window window, std::vector<uint8_t>& out, int& width, int& height);
+
+ private:
+  Atom GetAtom(const char* name);
+  bool GetWindowProperty(Window window, Atom property, Atom type, std::vector<unsigned long>& out);
+  std::string GetWindowTitle(Window window);
+  // ListWindows' filter for one client; the caller traps X errors.
+  bool ReadClientWindow(Window window, long exclude_pid, X11ClientWindow& entry);
+  bool HasState(const std::vector<unsigned long>& states, const char* name);
+
+  // Reads x,y,w,h of |drawable| (which must lie fully inside it) as BGRA
+  // starting at |out|, rows |out_w| pixels apart. SHM first, then XGetImage.
+  bool ReadDrawable(Drawable drawable, Visual* visual, int depth, int x, int y, int w, int h,
+                    uint8_t* out, int out_w);
+  bool EnsureShmSegment(size_t bytes);
+  void ReleaseShmSegment();
+
+  Display* display_ = nullptr;
+  Window root_ = 0;
+  Atom active_window_atom_ = None;
+  bool shm_available_ = false;
+  bool composite_available_ = false;
+  bool use_shm_ = true;
+  XShmSegmentInfo shm_info_{};
+  size_t shm_size_ = 0;
+};
+
+#endif  // RUNNER_X11_CAPTURE_H_
@@ -0,0 +1,102 @@
+// getSystemAudioFrame: dequeue from the capture ring into a reply buffer,
+// then serialize it the way StandardMethodCodec does, for the request sizes
+// Dart uses (1280 = 40 ms, 1600 = 50 ms, 3200 = 100 ms of 16 kHz PCM16).
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "byte_buffer_pool.h"
+#include "pcm_ring_buffer.h"
+
+namespace {
+
+constexpr size_t kRingBytes = 64000;
+
+// What StandardCodecSerializer writes for a Uint8List success reply: the
+// envelope byte, the type byte, the size (1, 3 or 5 bytes) and the payload,
+// into a fresh vector as EncodeSuccessEnvelope returns one.
+std::unique_ptr<std::vector<uint8_t>> EncodeLikeStandardCodec(const std::vector<uint8_t>& payload) {
+  auto out = std::make_unique<std::vector<uint8_t>>();
+  out->push_back(0);  // success
+  out->push_back(8);  // kUInt8List
+  const size_t size = payload.size();
+  if (size < 254) {
+    out->push_back(static_cast<uint8_t>(size));
+  } else if (size <= 0xffff) {
+    out->push_back(254);
+    out->push_back(static_cast<uint8_t>(size));
+    out->push_back(static_cast<uint8_t>(size >> 8));
+  } else {
+    out->push_back(255);
+    for (int i = 0; i < 4; i++) out->push_back(static_cast<uint8_t>(size >> (8 * i)));
+  }
+  out->insert(out->end(), payload.begin(), payload.end());
+  return out;
+}
+
+std::vector<uint8_t> Chunk(size_t size) {
+  std::vector<uint8_t> chunk(size);
+  for (size_t i = 0; i < size; i++) chunk[i] = static_cast<uint8_t>(i * 7);
+  return chunk;
+}
+
+// The original path: a byte deque drained with front()/pop_front() into a
+// vector built by push_back, then copied into the reply value.
+void BM_AudioFrameDequeLoop(benchmark::State& state) {
+  const size_t requested = static_cast<size_t>(state.range(0));
+  const std::vector<uint8_t> chunk = Chunk(requested);
+  std::deque<uint8_t> queue;
+  for (auto _ : state) {
+    queue.insert(queue.end(), chunk.begin(), chunk.end());
+    while (queue.size() > kRingBytes) queue.pop_front();
+    std::vector<uint8_t> frame;
+    while (frame.size() < requested && !queue.empty()) {
+      frame.push_back(queue.front());
+      queue.pop_front();
+    }
+    const std::vector<uint8_t> value = frame;
+    benchmark::DoNotOptimize(EncodeLikeStandardCodec(value));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * requested));
+}
+
+// The current path: two memcpy reads from the ring into a pooled buffer that
+// is moved into the reply and recycled after serialization.
+void BM_AudioFramePooledRing(benchmark::State& state) {
+  const size_t requested = static_cast<size_t>(state.range(0));
+  const std::vector<uint8_t> chunk = Chunk(requested);
+  PcmRingBuffer ring(kRingBytes);
+  ByteBufferPool pool(4);
+  for (auto _ : state) {
+    ring.Write(chunk.data(), chunk.size());
+    std::vector<uint8_t> frame = pool.Acquire(requested);
+    frame.resize(ring.Read(frame.data(), requested));
+    benchmark::DoNotOptimize(EncodeLikeStandardCodec(frame));
+    pool.Release(std::move(frame));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * requested));
+}
+
+// Dequeue alone, to separate it from the codec's share.
+void BM_AudioFrameRingReadOnly(benchmark::State& state) {
+  const size_t requested = static_cast<size_t>(state.range(0));
+  const std::vector<uint8_t> chunk = Chunk(requested);
+  PcmRingBuffer ring(kRingBytes);
+  std::vector<uint8_t> frame(requested);
+  for (auto _ : state) {
+    ring.Write(chunk.data(), chunk.size());
+    benchmark::DoNotOptimize(ring.Read(frame.data(), requested));
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * requested));
+}
+
+BENCHMARK(BM_AudioFrameDequeLoop)->Arg(1280)->Arg(1600)->Arg(3200);
+BENCHMARK(BM_AudioFramePooledRing)->Arg(1280)->Arg(1600)->Arg(3200);
+BENCHMARK(BM_AudioFrameRingReadOnly)->Arg(1280)->Arg(1600)->Arg(3200);
+
+}  // namespace
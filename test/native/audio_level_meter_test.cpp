@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "audio_level_meter.h"
+
+namespace {
+
+constexpr float kScale = 1.0f / 32768.0f;
+
+TEST(AudioLevelMeterTest, OneSidedBinsKeepTheirEnvelope) {
+  AudioLevelMeter meter(8, 2);
+  // Bin 0 is all positive, bin 1 all negative: neither range includes 0.
+  const int16_t samples[8] = {100, 200, 300, 400, -50, -60, -70, -80};
+  std::vector<AudioLevelSnapshot> out;
+  meter.Process(samples, 8, out);
+  ASSERT_EQ(out.size(), 1u);
+  ASSERT_EQ(out[0].waveform.size(), 4u);
+  EXPECT_FLOAT_EQ(out[0].waveform[0], 100 * kScale);
+  EXPECT_FLOAT_EQ(out[0].waveform[1], 400 * kScale);
+  EXPECT_FLOAT_EQ(out[0].waveform[2], -80 * kScale);
+  EXPECT_FLOAT_EQ(out[0].waveform[3], -50 * kScale);
+  EXPECT_FLOAT_EQ(out[0].peak, 400 * kScale);
+  EXPECT_EQ(out[0].end_sample, 8u);
+
+  // The next window starts from empty bins, not the previous extremes.
+  const int16_t next[8] = {7, 7, 7, 7, 7, 7, 7, 7};
+  meter.Process(next, 8, out);
+  ASSERT_EQ(out.size(), 2u);
+  EXPECT_FLOAT_EQ(out[1].waveform[0], 7 * kScale);
+  EXPECT_FLOAT_EQ(out[1].waveform[3], 7 * kScale);
+}
+
+TEST(AudioLevelMeterTest, SilenceWidensOnlyTheBinsItCovers) {
+  AudioLevelMeter meter(8, 4);
+  std::vector<AudioLevelSnapshot> out;
+  const int16_t loud[2] = {500, 600};
+  meter.Process(loud, 2, out);  // bin 0
+  meter.AddSilence(3, out);     // bin 1 and half of bin 2
+  const int16_t tail[3] = {900, 1000, 1100};
+  meter.Process(tail, 3, out);  // rest of bin 2, bin 3
+  ASSERT_EQ(out.size(), 1u);
+  const std::vector<float>& w = out[0].waveform;
+  EXPECT_FLOAT_EQ(w[0], 500 * kScale);
+  EXPECT_FLOAT_EQ(w[1], 600 * kScale);
+  EXPECT_FLOAT_EQ(w[2], 0.0f);
+  EXPECT_FLOAT_EQ(w[3], 0.0f);
+  EXPECT_FLOAT_EQ(w[4], 0.0f);
+  EXPECT_FLOAT_EQ(w[5], 900 * kScale);
+  EXPECT_FLOAT_EQ(w[6], 1000 * kScale);
+  EXPECT_FLOAT_EQ(w[7], 1100 * kScale);
+}
+
+TEST(AudioLevelMeterTest, AllSilenceIsFlat) {
+  AudioLevelMeter meter(1280, 16);
+  std::vector<AudioLevelSnapshot> out;
+  meter.AddSilence(1280 * 3, out);
+  ASSERT_EQ(out.size(), 3u);
+  for (const auto& snap : out) {
+    EXPECT_EQ(snap.rms, 0.0f);
+    EXPECT_EQ(snap.peak, 0.0f);
+    for (float v : snap.waveform) EXPECT_EQ(v, 0.0f);
+  }
+  EXPECT_EQ(out[2].end_sample, 1280u * 3);
+}
+
+}  // namespace
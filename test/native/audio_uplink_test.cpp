@@ -0,0 +1,354 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_uplink.h"
+#include "loopback_websocket.h"
+
+namespace {
+
+using std::chrono::milliseconds;
+
+std::vector<uint8_t> Bytes(size_t size, uint8_t first = 0) {
+  std::vector<uint8_t> bytes(size);
+  for (size_t i = 0; i < size; i++) bytes[i] = static_cast<uint8_t>(first + i * 7);
+  return bytes;
+}
+
+std::vector<uint8_t> Base64Decode(const std::string& text) {
+  static const std::string kAlphabet =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::vector<uint8_t> out;
+  uint32_t bits = 0;
+  int count = 0;
+  for (char c : text) {
+    if (c == '=') break;
+    bits = (bits << 6) | static_cast<uint32_t>(kAlphabet.find(c));
+    count += 6;
+    if (count >= 8) {
+      count -= 8;
+      out.push_back(static_cast<uint8_t>(bits >> count));
+    }
+  }
+  return out;
+}
+
+// The value of "|key|":"..." in a flat JSON message.
+std::string Field(const std::string& message, const std::string& key) {
+  const std::string tag = "\"" + key + "\":\"";
+  const size_t start = message.find(tag);
+  if (start == std::string::npos) return std::string();
+  const size_t from = start + tag.size();
+  return message.substr(from, message.find('"', from) - from);
+}
+
+bool IsAudio(const std::string& message, const std::string& source) {
+  return Field(message, "type") == "audio" && Field(message, "source") == source;
+}
+
+// Concatenated PCM of |source|'s audio frames, and how many frames.
+std::vector<uint8_t> AudioOf(const std::vector<std::string>& messages, const std::string& source,
+                             size_t* frames = nullptr) {
+  std::vector<uint8_t> bytes;
+  size_t count = 0;
+  for (const std::string& message : messages) {
+    if (!IsAudio(message, source)) continue;
+    const std::vector<uint8_t> chunk = Base64Decode(Field(message, "audio"));
+    bytes.insert(bytes.end(), chunk.begin(), chunk.end());
+    count++;
+  }
+  if (frames) *frames = count;
+  return bytes;
+}
+
+bool WaitUntil(const std::function<bool()>& done, milliseconds timeout = milliseconds(3000)) {
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!done()) {
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    std::this_thread::sleep_for(milliseconds(2));
+  }
+  return true;
+}
+
+// Stands in for AudioCapture's system audio ring and gap list.
+class FakeSystemAudio {
+ public:
+  void Push(const std::vector<uint8_t>& bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bytes_.insert(bytes_.end(), bytes.begin(), bytes.end());
+  }
+  void PushGap(uint64_t start_sample, uint64_t length) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AudioGap gap;
+    gap.start_sample = start_sample;
+    gap.length = length;
+    gaps_.push_back(gap);
+  }
+  size_t queued() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_.size();
+  }
+
+  size_t Read(uint8_t* out, size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t n = (std::min)(capacity, bytes_.size());
+    std::copy(bytes_.begin(), bytes_.begin() + static_cast<std::ptrdiff_t>(n), out);
+    bytes_.erase(bytes_.begin(), bytes_.begin() + static_cast<std::ptrdiff_t>(n));
+    return n;
+  }
+  std::vector<AudioGap> TakeGaps() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<AudioGap> gaps;
+    gaps.swap(gaps_);
+    return gaps;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::deque<uint8_t> bytes_;
+  std::vector<AudioGap> gaps_;
+};
+
+// AudioUplink over a real socket to MockWebSocketServer on loopback.
+class AudioUplinkTest : public ::testing::Test {
+ protected:
+  AudioUplinkTest()
+      : uplink_([]() { return std::make_unique<PosixWebSocketTransport>(); },
+                [this](std::string message) {
+                  std::lock_guard<std::mutex> lock(mutex_);
+                  received_.push_back(std::move(message));
+                },
+                [this](const std::string& error) {
+                  std::lock_guard<std::mutex> lock(mutex_);
+                  closed_.push_back(error);
+                }) {
+    uplink_.SetSystemAudioSource(
+        [this](uint8_t* out, size_t capacity) { return system_.Read(out, capacity); },
+        [this]() { return system_.TakeGaps(); });
+  }
+
+  bool Connect() {
+    return uplink_.Connect(server_.url()) && WaitUntil([this] { return uplink_.GetStats().connected; });
+  }
+
+  std::vector<std::string> Received() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return received_;
+  }
+  std::vector<std::string> Closed() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return closed_;
+  }
+
+  MockWebSocketServer server_;
+  FakeSystemAudio system_;
+  std::mutex mutex_;
+  std::vector<std::string> received_;
+  std::vector<std::string> closed_;
+  // Last, so it goes first: its threads call into the members above.
+  AudioUplink uplink_;
+};
+
+// 20 ms capture packets are drained every tick and coalesced into frames
+// of up to the 200 ms latency budget.
+TEST_F(AudioUplinkTest, CoalescesSystemAudioIntoFrames) {
+  ASSERT_TRUE(Connect());
+  EXPECT_GT(uplink_.GetStats().handshake_ms, 0.0);
+
+  std::vector<uint8_t> pushed;
+  for (int i = 0; i < 30; i++) {
+    const std::vector<uint8_t> packet = Bytes(640, static_cast<uint8_t>(i));
+    system_.Push(packet);
+    pushed.insert(pushed.end(), packet.begin(), packet.end());
+    std::this_thread::sleep_for(milliseconds(10));
+  }
+  ASSERT_TRUE(WaitUntil([&] { return AudioOf(server_.Messages(), "system").size() == pushed.size(); }));
+
+  size_t frames = 0;
+  EXPECT_EQ(AudioOf(server_.Messages(), "system", &frames), pushed);
+  EXPECT_GE(frames, 1u);
+  EXPECT_LE(frames, 5u);
+  const UplinkStats stats = uplink_.GetStats();
+  EXPECT_EQ(stats.system_bytes_read, pushed.size());
+  EXPECT_EQ(stats.audio_bytes_sent, pushed.size());
+  EXPECT_EQ(stats.frames_sent, frames);
+  EXPECT_FALSE(stats.stalled);
+  EXPECT_EQ(system_.queued(), 0u);
+}
+
+// A control message flushes the audio queued before it.
+TEST_F(AudioUplinkTest, ControlMessagesFollowEarlierAudio) {
+  ASSERT_TRUE(Connect());
+  uplink_.SendAudio("mic", Bytes(1000).data(), 1000);
+  uplink_.SendText("{\"type\":\"config\"}");
+  ASSERT_TRUE(server_.WaitForMessages(2, milliseconds(3000)));
+  const std::vector<std::string> messages = server_.Messages();
+  EXPECT_TRUE(IsAudio(messages[0], "mic"));
+  EXPECT_EQ(messages[1], "{\"type\":\"config\"}");
+}
+
+// Audio read before a gap goes out before it, and the gap before the audio
+// read with it, so the server can always place audio on the timeline.
+TEST_F(AudioUplinkTest, GapsGoOutBeforeTheAudioAfterThem) {
+  ASSERT_TRUE(Connect());
+  const std::vector<uint8_t> before = Bytes(640, 1);
+  const std::vector<uint8_t> after = Bytes(640, 2);
+  system_.Push(before);
+  ASSERT_TRUE(WaitUntil([&] { return uplink_.GetStats().system_bytes_read == before.size(); }));
+  system_.PushGap(320, 1600);
+  system_.Push(after);
+  ASSERT_TRUE(server_.WaitForMessages(3, milliseconds(3000)));
+
+  const std::vector<std::string> messages = server_.Messages();
+  ASSERT_EQ(messages.size(), 3u);
+  EXPECT_TRUE(IsAudio(messages[0], "system"));
+  EXPECT_EQ(Base64Decode(Field(messages[0], "audio")), before);
+  EXPECT_EQ(messages[1],
+            "{\"type\":\"audio_gap\",\"source\":\"system\",\"startSample\":320,\"samples\":1600,"
+            "\"sampleRate\":16000}");
+  EXPECT_TRUE(IsAudio(messages[2], "system"));
+  EXPECT_EQ(Base64Decode(Field(messages[2], "audio")), after);
+  EXPECT_EQ(uplink_.GetStats().gap_samples, 1600u);
+}
+
+TEST_F(AudioUplinkTest, DeliversServerMessages) {
+  server_.SetEcho(true);
+  ASSERT_TRUE(Connect());
+  uplink_.SendText("{\"type\":\"hello\"}");
+  const std::string big = "{\"type\":\"note\",\"text\":\"" + std::string(40000, 'x') + "\"}";
+  uplink_.SendText(big);
+  ASSERT_TRUE(WaitUntil([this] { return Received().size() == 2; }));
+  EXPECT_EQ(Received()[0], "{\"type\":\"hello\"}");
+  EXPECT_EQ(Received()[1], big);
+  EXPECT_TRUE(Closed().empty());
+}
+
+// A server that stops reading: the blocked send backs frames up in the
+// batcher, system audio stays in the capture ring, and once the socket
+// drains the oldest queued audio is dropped (never control messages) and
+// reading resumes.
+TEST_F(AudioUplinkTest, StalledSocketLeavesAudioInTheRing) {
+  ASSERT_TRUE(Connect());
+  server_.SetStalled(true);
+  const size_t kFrame = 16000;  // One full frame per call.
+  size_t mic_sent = 0;
+  for (int i = 0; i < 3; i++, mic_sent += kFrame) uplink_.SendAudio("mic", Bytes(kFrame, 1).data(), kFrame);
+  std::this_thread::sleep_for(milliseconds(100));
+  for (int i = 0; i < 24; i++, mic_sent += kFrame) uplink_.SendAudio("mic", Bytes(kFrame, 2).data(), kFrame);
+  uplink_.SendText("{\"type\":\"marker\"}");
+  const std::vector<uint8_t> system_audio = Bytes(6400, 3);
+  system_.Push(system_audio);
+
+  std::this_thread::sleep_for(milliseconds(400));
+  EXPECT_EQ(system_.queued(), system_audio.size());
+  EXPECT_GE(uplink_.GetStats().queue_depth, 4u);
+  EXPECT_EQ(uplink_.GetStats().dropped_bytes, 0u);
+
+  server_.SetStalled(false);
+  // The send that blocked ~400 ms keeps system audio back a while longer.
+  ASSERT_TRUE(WaitUntil([this] { return uplink_.GetStats().stalled; }));
+  EXPECT_GT(system_.queued(), 0u);
+  ASSERT_TRUE(WaitUntil([this] { return !uplink_.GetStats().stalled && system_.queued() == 0; }));
+  ASSERT_TRUE(WaitUntil([&] { return AudioOf(server_.Messages(), "system").size() == system_audio.size(); }));
+
+  const std::vector<std::string> messages = server_.Messages();
+  const UplinkStats stats = uplink_.GetStats();
+  EXPECT_GT(stats.dropped_bytes, 0u);
+  EXPECT_EQ(AudioOf(messages, "mic").size() + stats.dropped_bytes, mic_sent);
+  EXPECT_EQ(AudioOf(messages, "system"), system_audio);
+  EXPECT_GT(stats.send_latency_ms, 0.0);
+  size_t markers = 0;
+  for (const std::string& message : messages) markers += message == "{\"type\":\"marker\"}";
+  EXPECT_EQ(markers, 1u);
+}
+
+// Once only system audio is flowing, a slow send must not hold the ring
+// back for good: no other frame comes along to show the socket recovered.
+TEST_F(AudioUplinkTest, StallEndsWithOnlySystemAudio) {
+  ASSERT_TRUE(Connect());
+  server_.SetStalled(true);
+  const std::string big = "{\"type\":\"context\",\"text\":\"" + std::string(256 * 1024, 'x') + "\"}";
+  uplink_.SendText(big);
+  std::this_thread::sleep_for(milliseconds(400));
+  server_.SetStalled(false);
+  ASSERT_TRUE(server_.WaitForMessages(1, milliseconds(3000)));
+  EXPECT_GT(uplink_.GetStats().send_latency_ms, 250.0);
+
+  const std::vector<uint8_t> later = Bytes(640, 5);
+  system_.Push(later);
+  ASSERT_TRUE(WaitUntil([&] { return AudioOf(server_.Messages(), "system") == later; }));
+  EXPECT_FALSE(uplink_.GetStats().stalled);
+}
+
+TEST_F(AudioUplinkTest, DisconnectFlushesThenCloses) {
+  ASSERT_TRUE(Connect());
+  // Well inside the latency budget: only Disconnect's flush sends it.
+  uplink_.SendAudio("mic", Bytes(1000).data(), 1000);
+  uplink_.Disconnect();
+  bool close_frame = false;
+  ASSERT_TRUE(server_.WaitForDisconnect(milliseconds(3000), &close_frame));
+  EXPECT_TRUE(close_frame);
+  const std::vector<std::string> messages = server_.Messages();
+  ASSERT_EQ(messages.size(), 1u);
+  EXPECT_EQ(AudioOf(messages, "mic"), Bytes(1000));
+  EXPECT_TRUE(WaitUntil([this] { return !uplink_.GetStats().connected; }));
+  EXPECT_TRUE(Closed().empty());
+}
+
+// A session stuck in the handshake or a send is aborted after the grace
+// period, without blocking the caller or reporting a close.
+TEST_F(AudioUplinkTest, DisconnectAbortsAStuckSession) {
+  server_.SetAnswerUpgrade(false);
+  ASSERT_TRUE(uplink_.Connect(server_.url()));
+  ASSERT_TRUE(WaitUntil([this] { return server_.connections() == 1; }));
+  auto start = std::chrono::steady_clock::now();
+  uplink_.Disconnect();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, milliseconds(100));
+  ASSERT_TRUE(server_.WaitForDisconnect(milliseconds(3000)));
+  EXPECT_GE(std::chrono::steady_clock::now() - start, milliseconds(400));
+
+  // The next session replaces it cleanly, and can get stuck in a send.
+  server_.SetAnswerUpgrade(true);
+  ASSERT_TRUE(Connect());
+  server_.SetStalled(true);
+  for (int i = 0; i < 4; i++) uplink_.SendAudio("mic", Bytes(16000).data(), 16000);
+  std::this_thread::sleep_for(milliseconds(100));
+  start = std::chrono::steady_clock::now();
+  uplink_.Disconnect();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, milliseconds(100));
+  EXPECT_TRUE(WaitUntil([this] { return !uplink_.GetStats().connected; }));
+  EXPECT_GE(std::chrono::steady_clock::now() - start, milliseconds(400));
+  EXPECT_TRUE(Closed().empty());
+}
+
+TEST_F(AudioUplinkTest, ReportsRemoteClose) {
+  ASSERT_TRUE(Connect());
+  server_.SendClose();
+  ASSERT_TRUE(WaitUntil([this] { return !Closed().empty(); }));
+  EXPECT_TRUE(WaitUntil([this] { return !uplink_.GetStats().connected; }));
+  EXPECT_EQ(Closed(), std::vector<std::string>{""});
+
+  // A dropped connection reports an error.
+  ASSERT_TRUE(Connect());
+  server_.Drop();
+  ASSERT_TRUE(WaitUntil([this] { return Closed().size() == 2; }));
+  EXPECT_FALSE(Closed()[1].empty());
+
+  // So does a failed connect.
+  ASSERT_TRUE(uplink_.Connect(L"ws://127.0.0.1:1/transcribe"));
+  ASSERT_TRUE(WaitUntil([this] { return Closed().size() == 3; }));
+  EXPECT_FALSE(Closed()[2].empty());
+  std::this_thread::sleep_for(milliseconds(50));
+  EXPECT_EQ(Closed().size(), 3u);
+}
+
+}  // namespace
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "capture_stats.h"
+
+namespace {
+
+using Clock = CaptureStats::Clock;
+using std::chrono::microseconds;
+
+TEST(CaptureStatsTest, HistogramCountsAndPercentiles) {
+  CaptureStats::Histogram h;
+  EXPECT_EQ(h.Percentile(0.5), 0u);
+  for (uint64_t us = 1; us <= 100; us++) h.Add(us);
+
+  EXPECT_EQ(h.count, 100u);
+  EXPECT_EQ(h.total_us, 5050u);
+  EXPECT_EQ(h.min_us, 1u);
+  EXPECT_EQ(h.max_us, 100u);
+  // Power-of-two buckets: 1, 2-3, 4-7, ... 32-63, 64-127.
+  EXPECT_EQ(h.buckets[0], 0u);
+  EXPECT_EQ(h.buckets[1], 1u);
+  EXPECT_EQ(h.buckets[2], 2u);
+  EXPECT_EQ(h.buckets[6], 32u);
+  EXPECT_EQ(h.buckets[7], 37u);
+
+  EXPECT_EQ(h.Percentile(0.0), 1u);
+  EXPECT_EQ(h.Percentile(0.31), 31u);
+  EXPECT_EQ(h.Percentile(0.5), 63u);
+  // The top bucket's bound (127) is capped at the largest sample.
+  EXPECT_EQ(h.Percentile(0.9), 100u);
+  EXPECT_EQ(h.Percentile(0.99), 100u);
+  EXPECT_EQ(h.Percentile(2.0), 100u);
+}
+
+TEST(CaptureStatsTest, ExtremeSamplesLandInEndBuckets) {
+  CaptureStats::Histogram h;
+  h.Add(0);
+  h.Add(uint64_t{1} << 40);
+  EXPECT_EQ(h.buckets[0], 1u);
+  EXPECT_EQ(h.buckets[CaptureStats::kBuckets - 1], 1u);
+  EXPECT_EQ(h.min_us, 0u);
+  EXPECT_EQ(h.Percentile(0.5), 0u);
+  EXPECT_EQ(h.Percentile(1.0), uint64_t{1} << 40);
+  EXPECT_EQ(CaptureStats::Histogram::BucketLimit(CaptureStats::kBuckets - 1), UINT64_MAX);
+}
+
+TEST(CaptureStatsTest, FilesStagesAndTotalsPerMethod) {
+  CaptureStats stats;
+  const Clock::time_point t0 = Clock::now();
+  stats.Record("captureWindow", "print window", t0, t0 + microseconds(250));
+  stats.Record("captureWindow", "print window", t0, t0 + microseconds(750));
+  stats.Record("captureWindow", "encode", t0, t0 + microseconds(40));
+  stats.RecordTotal("captureWindow", t0, t0 + microseconds(1200));
+  // A clock that ran backwards counts as 0.
+  stats.RecordTotal("captureScreen", t0 + microseconds(5), t0);
+
+  std::map<std::string, CaptureStats::MethodStats> snapshot = stats.Snapshot();
+  ASSERT_EQ(snapshot.size(), 2u);
+  const CaptureStats::MethodStats& window = snapshot["captureWindow"];
+  EXPECT_EQ(window.total.count, 1u);
+  EXPECT_EQ(window.total.total_us, 1200u);
+  ASSERT_EQ(window.stages.size(), 2u);
+  const CaptureStats::Histogram& print = window.stages.at("print window");
+  EXPECT_EQ(print.count, 2u);
+  EXPECT_EQ(print.total_us, 1000u);
+  EXPECT_EQ(print.min_us, 250u);
+  EXPECT_EQ(print.max_us, 750u);
+  EXPECT_EQ(print.Percentile(0.5), 255u);
+  EXPECT_EQ(window.stages.at("encode").count, 1u);
+  EXPECT_EQ(snapshot["captureScreen"].total.max_us, 0u);
+
+  stats.Reset();
+  EXPECT_TRUE(stats.Snapshot().empty());
+}
+
+TEST(CaptureStatsTest, StageTimersUseTheInnermostMethod) {
+  CaptureStats stats;
+  { ScopedStageTimer timer(stats, "unscoped"); }
+  {
+    const std::string outer = "captureThumbnails";
+    ScopedCaptureMethod outer_scope(outer);
+    { ScopedStageTimer timer(stats, "scale"); }
+    {
+      const std::string inner = "captureForUpload";
+      ScopedCaptureMethod inner_scope(inner);
+      ScopedStageTimer timer(stats, "encode");
+      timer.Stop();
+      timer.Stop();  // Records once.
+    }
+    EXPECT_EQ(ScopedCaptureMethod::Current(), outer);
+  }
+  EXPECT_EQ(ScopedCaptureMethod::Current(), "other");
+
+  std::map<std::string, CaptureStats::MethodStats> snapshot = stats.Snapshot();
+  EXPECT_EQ(snapshot["other"].stages["unscoped"].count, 1u);
+  EXPECT_EQ(snapshot["captureThumbnails"].stages["scale"].count, 1u);
+  EXPECT_EQ(snapshot["captureForUpload"].stages["encode"].count, 1u);
+  EXPECT_EQ(snapshot.size(), 3u);
+}
+
+TEST(CaptureStatsTest, TracesOnlyWhileEnabled) {
+  CaptureStats stats;
+  const Clock::time_point t0 = Clock::now();
+  stats.Record("captureWindow", "before", t0, t0 + microseconds(10));
+  EXPECT_EQ(stats.trace_event_count(), 0u);
+
+  stats.SetTracing(true);
+  EXPECT_TRUE(stats.tracing());
+  stats.Record("capture\"Window", "print window", t0, t0 + microseconds(10));
+  stats.Record("captureWindow", "encode", t0, t0 + microseconds(20));
+  EXPECT_EQ(stats.trace_event_count(), 2u);
+  const std::string json = stats.TraceJson();
+  EXPECT_NE(json.find("\"name\":\"print window\",\"cat\":\"capture\\\"Window\",\"ph\":\"X\""), std::string::npos);
+  EXPECT_NE(json.find("\"dur\":20}"), std::string::npos);
+
+  // Turning tracing off keeps the trace; back on starts a new one.
+  stats.SetTracing(false);
+  stats.Record("captureWindow", "after", t0, t0 + microseconds(10));
+  EXPECT_EQ(stats.trace_event_count(), 2u);
+  stats.SetTracing(true);
+  EXPECT_EQ(stats.trace_event_count(), 0u);
+}
+
+}  // namespace
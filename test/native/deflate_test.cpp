@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "deflate.h"
+#include "reference_codecs.h"
+
+namespace {
+
+std::vector<uint8_t> RandomBytes(size_t size, uint32_t seed) {
+  std::vector<uint8_t> bytes(size);
+  for (auto& b : bytes) {
+    seed = seed * 1664525u + 1013904223u;
+    b = static_cast<uint8_t>(seed >> 24);
+  }
+  return bytes;
+}
+
+// Inputs that exercise literals, short and maximal matches, long runs and
+// several Huffman blocks.
+std::vector<std::vector<uint8_t>> Corpus() {
+  std::vector<std::vector<uint8_t>> corpus;
+  corpus.push_back({});
+  corpus.push_back({42});
+  const std::string text =
+      "The quick brown fox jumps over the lazy dog. The quick brown fox jumps over the lazy cat. ";
+  std::vector<uint8_t> prose;
+  for (int i = 0; i < 200; i++) prose.insert(prose.end(), text.begin(), text.end());
+  corpus.push_back(prose);
+  corpus.push_back(std::vector<uint8_t>(100000, 7));
+  corpus.push_back(RandomBytes(70000, 1));
+  // Screen-like: mostly runs with noisy stretches, long enough for several
+  // blocks.
+  std::vector<uint8_t> screen = SyntheticScreen(400, 300, 3);
+  corpus.push_back(screen);
+  return corpus;
+}
+
+TEST(DeflateTest, ChecksumsMatchZlib) {
+  const std::vector<uint8_t> data = RandomBytes(5000, 9);
+  EXPECT_EQ(Crc32(data.data(), data.size()), crc32(0, data.data(), static_cast<uInt>(data.size())));
+  EXPECT_EQ(Adler32(data.data(), data.size()), adler32(1, data.data(), static_cast<uInt>(data.size())));
+  // Incremental forms chain like zlib's.
+  EXPECT_EQ(Crc32(data.data() + 1000, 4000, Crc32(data.data(), 1000)),
+            crc32(0, data.data(), static_cast<uInt>(data.size())));
+
+  const uint32_t a = Adler32(data.data(), 1234);
+  const uint32_t b = Adler32(data.data() + 1234, data.size() - 1234);
+  EXPECT_EQ(Adler32Combine(a, b, data.size() - 1234), Adler32(data.data(), data.size()));
+  EXPECT_EQ(Adler32Combine(a, Adler32(nullptr, 0), 0), a);
+}
+
+TEST(DeflateTest, ZlibCompressRoundTripsAtEveryLevel) {
+  const auto corpus = Corpus();
+  for (int level = 1; level <= 9; level++) {
+    for (size_t i = 0; i < corpus.size(); i++) {
+      const std::vector<uint8_t>& input = corpus[i];
+      std::vector<uint8_t> compressed;
+      ZlibCompress(input.data(), input.size(), level, compressed);
+      std::vector<uint8_t> inflated;
+      ASSERT_TRUE(InflateZlib(compressed.data(), compressed.size(), inflated))
+          << "level " << level << " input " << i;
+      ASSERT_EQ(inflated, input) << "level " << level << " input " << i;
+    }
+  }
+}
+
+TEST(DeflateTest, CompressesRedundantInput) {
+  const auto corpus = Corpus();
+  std::vector<uint8_t> compressed;
+  ZlibCompress(corpus[2].data(), corpus[2].size(), 6, compressed);
+  EXPECT_LT(compressed.size(), corpus[2].size() / 20);
+  compressed.clear();
+  ZlibCompress(corpus[3].data(), corpus[3].size(), 1, compressed);
+  EXPECT_LT(compressed.size(), 1000u);
+
+  // Random data may not shrink but must not blow up either.
+  compressed.clear();
+  ZlibCompress(corpus[4].data(), corpus[4].size(), 9, compressed);
+  EXPECT_LT(compressed.size(), corpus[4].size() + corpus[4].size() / 50 + 64);
+}
+
+TEST(DeflateTest, ZlibCompressAppends) {
+  std::vector<uint8_t> out = {1, 2, 3};
+  const uint8_t data[4] = {9, 9, 9, 9};
+  ZlibCompress(data, sizeof(data), 6, out);
+  ASSERT_GT(out.size(), 3u);
+  EXPECT_EQ(out[0], 1);
+  std::vector<uint8_t> inflated;
+  ASSERT_TRUE(InflateZlib(out.data() + 3, out.size() - 3, inflated));
+  EXPECT_EQ(inflated, std::vector<uint8_t>(data, data + 4));
+}
+
+// Pieces deflated independently, each primed with up to 32 KiB before it,
+// then framed as one zlib stream the way EncodePngBgra's segments are.
+std::vector<uint8_t> SegmentedZlib(const std::vector<uint8_t>& input, size_t segment, int level) {
+  std::vector<uint8_t> out;
+  ZlibHeader(level, out);
+  uint32_t adler = Adler32(nullptr, 0);
+  for (size_t start = 0; start < input.size() || start == 0; start += segment) {
+    const size_t size = (std::min)(segment, input.size() - start);
+    const size_t dict = (std::min)(start, size_t{32768});
+    const bool last = start + size >= input.size();
+    DeflateSegment(input.data() + start, dict, size, level, last, out);
+    adler = Adler32Combine(adler, Adler32(input.data() + start, size), size);
+    if (last) break;
+  }
+  ZlibTrailer(adler, out);
+  return out;
+}
+
+TEST(DeflateTest, SegmentedStreamInflatesWithZlib) {
+  const auto corpus = Corpus();
+  // Segment sizes that split matches, runs and Huffman blocks at odd places,
+  // including segments smaller than the priming window.
+  for (size_t segment : {size_t{4097}, size_t{32768}, size_t{65536 + 3}}) {
+    for (int level : {1, 6}) {
+      for (size_t i = 0; i < corpus.size(); i++) {
+        const std::vector<uint8_t>& input = corpus[i];
+        const std::vector<uint8_t> compressed = SegmentedZlib(input, segment, level);
+        std::vector<uint8_t> inflated;
+        ASSERT_TRUE(InflateZlib(compressed.data(), compressed.size(), inflated))
+            << "segment " << segment << " level " << level << " input " << i;
+        ASSERT_EQ(inflated, input) << "segment " << segment << " level " << level << " input " << i;
+      }
+    }
+  }
+}
+
+}  // namespace
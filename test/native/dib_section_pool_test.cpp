@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <vector>
+
+#include "dib_section_pool.h"
+
+namespace {
+
+// Heap-backed stand-ins for CreateDIBSection/DeleteObject that track what
+// is live.
+class FakeSections {
+ public:
+  DibSectionPool::Dib Create(int width, int height) {
+    DibSectionPool::Dib dib;
+    if (fail_) return dib;
+    dib.width = width;
+    dib.height = height;
+    dib.bits = new uint8_t[dib.bytes()]();
+    dib.bitmap = dib.bits;
+    live_.insert(dib.bitmap);
+    created_++;
+    return dib;
+  }
+  void Destroy(const DibSectionPool::Dib& dib) {
+    ASSERT_EQ(live_.erase(dib.bitmap), 1u) << "freed twice or unknown";
+    delete[] static_cast<uint8_t*>(dib.bits);
+  }
+
+  bool fail_ = false;
+  int created_ = 0;
+  std::set<void*> live_;
+};
+
+TEST(DibSectionPoolTest, ReusesExactSizesOnly) {
+  FakeSections sections;
+  {
+    DibSectionPool pool(1 << 20, [&](int w, int h) { return sections.Create(w, h); },
+                        [&](const DibSectionPool::Dib& dib) { sections.Destroy(dib); });
+    DibSectionPool::Dib a = pool.Acquire(100, 50, false);
+    ASSERT_NE(a.bitmap, nullptr);
+    pool.Release(a);
+
+    const DibSectionPool::Dib b = pool.Acquire(100, 50, false);
+    EXPECT_EQ(b.bitmap, a.bitmap);
+    // Same byte count, different shape: not interchangeable.
+    const DibSectionPool::Dib c = pool.Acquire(50, 100, false);
+    EXPECT_NE(c.bitmap, a.bitmap);
+    EXPECT_EQ(sections.created_, 2);
+
+    const DibSectionPool::Stats stats = pool.GetStats();
+    EXPECT_EQ(stats.acquires, 3u);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.pooled, 0u);
+    pool.Release(b);
+    pool.Release(c);
+    EXPECT_EQ(pool.GetStats().pooled, 2u);
+    EXPECT_EQ(pool.GetStats().pooled_bytes, 2u * 100 * 50 * 4);
+  }
+  // The destructor frees what was idle.
+  EXPECT_TRUE(sections.live_.empty());
+}
+
+// A recycled section must not leak the previous capture into a renderer
+// that leaves pixels unpainted.
+TEST(DibSectionPoolTest, ClearZeroesRecycledSections) {
+  FakeSections sections;
+  DibSectionPool pool(1 << 20, [&](int w, int h) { return sections.Create(w, h); },
+                      [&](const DibSectionPool::Dib& dib) { sections.Destroy(dib); });
+  DibSectionPool::Dib dib = pool.Acquire(64, 64, true);
+  memset(dib.bits, 0xab, dib.bytes());
+  pool.Release(dib);
+
+  dib = pool.Acquire(64, 64, false);
+  EXPECT_EQ(static_cast<uint8_t*>(dib.bits)[dib.bytes() - 1], 0xab);
+  pool.Release(dib);
+
+  dib = pool.Acquire(64, 64, true);
+  EXPECT_EQ(pool.GetStats().hits, 2u);
+  const std::vector<uint8_t> zeros(dib.bytes(), 0);
+  EXPECT_EQ(memcmp(dib.bits, zeros.data(), zeros.size()), 0);
+  pool.Release(dib);
+}
+
+TEST(DibSectionPoolTest, CapEvictsOldestFirst) {
+  FakeSections sections;
+  const size_t kDib = 100 * 100 * 4;
+  DibSectionPool pool(3 * kDib, [&](int w, int h) { return sections.Create(w, h); },
+                      [&](const DibSectionPool::Dib& dib) { sections.Destroy(dib); });
+  std::vector<DibSectionPool::Dib> dibs;
+  for (int i = 0; i < 4; i++) dibs.push_back(pool.Acquire(100, 100 + i, false));
+  // 100x100..100x103 grow by a row each, so only two fit under the cap:
+  // the third and fourth releases each free the oldest idle section.
+  for (const auto& dib : dibs) pool.Release(dib);
+  DibSectionPool::Stats stats = pool.GetStats();
+  EXPECT_LE(stats.pooled_bytes, 3 * kDib);
+  EXPECT_EQ(stats.pooled, 2u);
+  EXPECT_EQ(stats.evictions, 2u);
+  EXPECT_EQ(stats.high_water_bytes, (100u * 102 + 100 * 103) * 4);
+  EXPECT_EQ(sections.live_.size(), 2u);
+
+  // The newest two survived.
+  EXPECT_EQ(pool.Acquire(100, 103, false).bitmap, dibs[3].bitmap);
+  EXPECT_EQ(pool.Acquire(100, 102, false).bitmap, dibs[2].bitmap);
+  EXPECT_EQ(pool.GetStats().hits, 2u);
+  pool.Release(dibs[2]);
+  pool.Release(dibs[3]);
+
+  // Larger than the whole pool: freed on release.
+  const DibSectionPool::Dib huge = pool.Acquire(1000, 1000, false);
+  pool.Release(huge);
+  EXPECT_EQ(pool.GetStats().evictions, 3u);
+  EXPECT_EQ(sections.live_.count(huge.bitmap), 0u);
+
+  pool.Trim();
+  stats = pool.GetStats();
+  EXPECT_EQ(stats.pooled, 0u);
+  EXPECT_EQ(stats.pooled_bytes, 0u);
+  EXPECT_EQ(stats.evictions, 5u);
+  EXPECT_TRUE(sections.live_.empty());
+}
+
+TEST(DibSectionPoolTest, CreateFailureReturnsEmptyDib) {
+  FakeSections sections;
+  DibSectionPool pool(1 << 20, [&](int w, int h) { return sections.Create(w, h); },
+                      [&](const DibSectionPool::Dib& dib) { sections.Destroy(dib); });
+  sections.fail_ = true;
+  const DibSectionPool::Dib dib = pool.Acquire(10, 10, true);
+  EXPECT_EQ(dib.bitmap, nullptr);
+  pool.Release(dib);  // No-op.
+  EXPECT_EQ(pool.GetStats().pooled, 0u);
+  EXPECT_EQ(pool.GetStats().hits, 0u);
+}
+
+}  // namespace
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""Writes the .bmp fixtures for dib_decoder_test.cpp.
+
+Every image is 13x7 (so rows need padding at 1, 4, 8, 16 and 24 bpp) and
+uses the pixel formulas R/G/B/A below, which the test mirrors. Rerun after
+changing either side:
+
+    python3 test/native/fixtures/dib/make_fixtures.py
+"""
+
+import os
+import struct
+
+W, H = 13, 7
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def R(x, y): return (x * 19 + y * 5) & 255
+def G(x, y): return (y * 36 + x) & 255
+def B(x, y): return ((x + y) * 9) & 255
+def A(x, y): return (x * 17 + y * 29) & 255
+
+
+def info_header(size, width, height, bpp, compression, colors_used=0):
+    # BITMAPINFOHEADER fields; V4/V5 headers append masks and zero padding.
+    return struct.pack('<IiiHHIIiiII', size, width, height, 1, bpp, compression,
+                       0, 2835, 2835, colors_used, 0)
+
+
+def v5_header(width, height, bpp, compression, masks):
+    base = info_header(124, width, height, bpp, compression)
+    body = struct.pack('<IIII', *masks) + struct.pack('<I', 0x73524742)  # 'sRGB'
+    return base + body + b'\0' * (124 - len(base) - len(body))
+
+
+def v4_header(width, height, bpp, compression, masks):
+    base = info_header(108, width, height, bpp, compression)
+    body = struct.pack('<IIII', *masks) + struct.pack('<I', 0x73524742)
+    return base + body + b'\0' * (108 - len(base) - len(body))
+
+
+def rows(width, height, bpp, pixel, top_down=False):
+    stride = (width * bpp + 31) // 32 * 4
+    out = b''
+    order = range(height) if top_down else range(height - 1, -1, -1)
+    for y in order:
+        if bpp < 8:
+            per_byte = 8 // bpp
+            row = bytearray((width + per_byte - 1) // per_byte)
+            for x in range(width):
+                row[x // per_byte] |= pixel(x, y) << (8 - bpp * (1 + x % per_byte))
+            row = bytes(row)
+        else:
+            row = b''.join(pixel(x, y) for x in range(width)) if bpp > 8 else \
+                bytes(pixel(x, y) for x in range(width))
+        out += row + b'\0' * (stride - len(row))
+    return out
+
+
+def write(name, dib, palette_and_masks_size):
+    # BITMAPFILEHEADER: pixel rows follow the info header, masks and palette.
+    bits_offset = 14 + palette_and_masks_size
+    data = b'BM' + struct.pack('<IHHI', 14 + len(dib), 0, 0, bits_offset) + dib
+    with open(os.path.join(HERE, name), 'wb') as f:
+        f.write(data)
+
+
+def palette(entries, color):
+    # RGBQUAD: blue, green, red, reserved.
+    return b''.join(bytes((color(i)[2], color(i)[1], color(i)[0], 0)) for i in range(entries))
+
+
+def pal1_color(i): return [(10, 20, 30), (200, 100, 50)][i]
+def pal4_color(i): return (i * 16, 255 - i * 16, i * 7)
+def pal8_color(i): return (i, 255 - i, (i * 3) & 255)
+
+
+def main():
+    # 1 bpp, bottom-up.
+    pal = palette(2, pal1_color)
+    hdr = info_header(40, W, H, 1, 0)
+    write('pal1.bmp', hdr + pal + rows(W, H, 1, lambda x, y: (x + y) & 1), len(hdr) + len(pal))
+
+    # 4 bpp, bottom-up.
+    pal = palette(16, pal4_color)
+    hdr = info_header(40, W, H, 4, 0)
+    write('pal4.bmp', hdr + pal + rows(W, H, 4, lambda x, y: (x + 2 * y) % 16), len(hdr) + len(pal))
+
+    # 8 bpp, top-down, colors_used = 0 (full palette).
+    pal = palette(256, pal8_color)
+    hdr = info_header(40, W, -H, 8, 0)
+    write('pal8_top_down.bmp',
+          hdr + pal + rows(W, H, 8, lambda x, y: (x * 19 + y * 7) & 255, top_down=True),
+          len(hdr) + len(pal))
+
+    # 24 bpp BGR, bottom-up.
+    hdr = info_header(40, W, H, 24, 0)
+    write('rgb24.bmp', hdr + rows(W, H, 24, lambda x, y: bytes((B(x, y), G(x, y), R(x, y)))), len(hdr))
+
+    # 32 bpp BI_RGB with the fourth byte left zero: decodes opaque.
+    hdr = info_header(40, W, H, 32, 0)
+    write('rgb32_zero_alpha.bmp',
+          hdr + rows(W, H, 32, lambda x, y: bytes((B(x, y), G(x, y), R(x, y), 0))), len(hdr))
+
+    # 32 bpp V5 BI_BITFIELDS with straight alpha.
+    hdr = v5_header(W, H, 32, 3, (0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000))
+    write('argb32_v5.bmp',
+          hdr + rows(W, H, 32, lambda x, y: bytes((B(x, y), G(x, y), R(x, y), A(x, y)))), len(hdr))
+
+    # 16 bpp 5:6:5 via BITMAPINFOHEADER + three masks.
+    masks = struct.pack('<III', 0xF800, 0x07E0, 0x001F)
+    hdr = info_header(40, W, H, 16, 3)
+    write('rgb565.bmp', hdr + masks + rows(W, H, 16, lambda x, y: struct.pack(
+        '<H', (R(x, y) >> 3) << 11 | (G(x, y) >> 2) << 5 | B(x, y) >> 3)), len(hdr) + len(masks))
+
+    # 16 bpp x:5:5:5, BI_RGB default masks.
+    hdr = info_header(40, W, H, 16, 0)
+    write('rgb555.bmp', hdr + rows(W, H, 16, lambda x, y: struct.pack(
+        '<H', (R(x, y) >> 3) << 10 | (G(x, y) >> 3) << 5 | B(x, y) >> 3)), len(hdr))
+
+    # 32 bpp 10:10:10 masks (wider than 8 bits per channel).
+    def ten(v): return v << 2 | v >> 6
+    masks = struct.pack('<III', 0x3FF00000, 0x000FFC00, 0x000003FF)
+    hdr = info_header(40, W, H, 32, 3)
+    write('rgb32_1010102.bmp', hdr + masks + rows(W, H, 32, lambda x, y: struct.pack(
+        '<I', ten(R(x, y)) << 20 | ten(G(x, y)) << 10 | ten(B(x, y)))), len(hdr) + len(masks))
+
+    # 16 bpp 4:4:4:4 with alpha, V4 header.
+    hdr = v4_header(W, H, 16, 3, (0x0F00, 0x00F0, 0x000F, 0xF000))
+    write('argb4444_v4.bmp', hdr + rows(W, H, 16, lambda x, y: struct.pack(
+        '<H', (A(x, y) >> 4) << 12 | (R(x, y) >> 4) << 8 | (G(x, y) >> 4) << 4 | B(x, y) >> 4)),
+        len(hdr))
+
+    # Malformed: a red mask with two runs (0x80000100). Its upper bit used to
+    # index past the 8-bit lookup table.
+    masks = struct.pack('<III', 0x80000100, 0x0000FE00, 0x000000FF)
+    hdr = info_header(40, 4, 1, 32, 3)
+    write('bad_mask_split.bmp', hdr + masks + b'\xff' * 16, len(hdr) + len(masks))
+
+    # Malformed: green overlaps red.
+    masks = struct.pack('<III', 0x00FF0000, 0x00FFFF00, 0x000000FF)
+    hdr = info_header(40, 4, 1, 32, 3)
+    write('bad_mask_overlap.bmp', hdr + masks + b'\xff' * 16, len(hdr) + len(masks))
+
+
+if __name__ == '__main__':
+    main()
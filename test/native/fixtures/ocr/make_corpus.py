@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""Writes the screenshot-like text images for ocr_layout_test.cpp.
+
+Text is rendered with Pillow's built-in font (no system fonts needed), and
+expected.txt records, per rendered line, the image, whether it is light
+text on a dark background, and the line's ink box as x0 y0 x1 y1
+(exclusive), measured from the line rendered on its own. Rerun after
+changing the corpus (needs Pillow >= 10.1):
+
+    python3 test/native/fixtures/ocr/make_corpus.py
+"""
+
+import os
+
+from PIL import Image, ImageDraw, ImageFont
+
+W, H = 480, 320
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+PROSE = [
+    'The quick brown fox jumps over the lazy dog.',
+    'Pack my box with five dozen liquor jugs, quickly.',
+    'Sphinx of black quartz, judge my vow (42 times).',
+    'How vexingly quick daft zebras jump!',
+    'Grumpy wizards make toxic brew for the jovial queen.',
+]
+CODE = [
+    'int main(int argc, char** argv) {',
+    '  std::vector<uint8_t> pixels;',
+    '  if (!Capture(pixels)) return 1;',
+    '  return Recognize(pixels.data());',
+    '}',
+]
+
+
+def ink_box(text, xy, font):
+    mask = Image.new('L', (W, H), 0)
+    ImageDraw.Draw(mask).text(xy, text, fill=255, font=font)
+    return mask.getbbox()
+
+
+class Screen:
+    def __init__(self, name, background, light_on_dark):
+        self.name = name
+        self.image = Image.new('RGB', (W, H), background)
+        self.draw = ImageDraw.Draw(self.image)
+        self.light_on_dark = light_on_dark
+        self.lines = []
+
+    def text(self, xy, text, colour, size):
+        font = ImageFont.load_default(size)
+        self.draw.text(xy, text, fill=colour, font=font)
+        self.lines.append(ink_box(text, xy, font))
+
+    def save(self, manifest):
+        self.image.save(os.path.join(HERE, self.name + '.png'), optimize=True)
+        for box in self.lines:
+            manifest.append('%s.png %d %d %d %d %d' % ((self.name, int(self.light_on_dark)) + box))
+
+
+def main():
+    manifest = []
+
+    # Black on white, two paragraphs split by a hairline rule, which is too
+    # thin to count as a line.
+    s = Screen('light_document', (255, 255, 255), False)
+    for i, line in enumerate(PROSE[:3]):
+        s.text((24, 20 + i * 26), line, (20, 20, 20), 16)
+    s.draw.line([(24, 112), (456, 112)], fill=(200, 200, 200))
+    for i, line in enumerate(PROSE[3:]):
+        s.text((24, 200 + i * 26), line, (20, 20, 20), 16)
+    s.save(manifest)
+
+    # An editor's dark theme: light code beside a full-height gutter border,
+    # which the layout must not take for text.
+    s = Screen('dark_editor', (30, 30, 30), True)
+    s.draw.line([(40, 0), (40, H - 1)], fill=(90, 90, 90))
+    for i, line in enumerate(CODE):
+        s.text((56, 24 + i * 24), line, (212, 212, 212), 15)
+    s.save(manifest)
+
+    # Small grey UI text on a tinted panel.
+    s = Screen('small_ui', (236, 240, 246), False)
+    for i, line in enumerate(['File   Edit   View   Help', 'Recent meetings', 'Tuesday standup, 9:30',
+                              'Design review, 14:00', 'Settings']):
+        s.text((16, 16 + i * 20), line, (70, 76, 88), 12)
+    s.save(manifest)
+
+    # Nothing to read.
+    s = Screen('blank', (128, 132, 140), False)
+    s.save(manifest)
+
+    with open(os.path.join(HERE, 'expected.txt'), 'w') as f:
+        f.write('# image light_on_dark x0 y0 x1 y1, one row per text line\n')
+        f.write('\n'.join(manifest) + '\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "foreground_tracker.h"
+
+namespace {
+
+using WindowId = ForegroundTracker::WindowId;
+
+// Stands in for the platform hooks: scripted foreground changes, classified
+// the way IsForegroundTarget / IsShareableWindow would, and a set of windows
+// that have since closed.
+class FakeEventSource {
+ public:
+  static constexpr WindowId kSelf = 1;
+  static constexpr WindowId kTaskbar = 2;
+  static constexpr WindowId kDesktop = 3;
+
+  explicit FakeEventSource(ForegroundTracker& tracker) : tracker_(tracker) {}
+
+  void Focus(WindowId window) {
+    tracker_.OnForeground(window, window != kSelf && window != kTaskbar && window != kDesktop);
+  }
+  void Close(WindowId window) { closed_.insert(window); }
+  void Reopen(WindowId window) { closed_.erase(window); }
+
+  WindowId LastTarget() {
+    return tracker_.LastTarget([this](WindowId id) { return closed_.count(id) == 0; });
+  }
+
+ private:
+  ForegroundTracker& tracker_;
+  std::set<WindowId> closed_;
+};
+
+TEST(ForegroundTrackerTest, IgnoresNonTargets) {
+  ForegroundTracker tracker(4);
+  FakeEventSource source(tracker);
+  EXPECT_EQ(source.LastTarget(), 0u);
+  source.Focus(FakeEventSource::kSelf);
+  source.Focus(FakeEventSource::kTaskbar);
+  source.Focus(0);
+  EXPECT_EQ(source.LastTarget(), 0u);
+
+  // Clicking through to ourselves keeps the window the user came from.
+  source.Focus(10);
+  source.Focus(FakeEventSource::kDesktop);
+  source.Focus(FakeEventSource::kSelf);
+  EXPECT_EQ(source.LastTarget(), 10u);
+}
+
+TEST(ForegroundTrackerTest, RefocusMovesToFrontWithoutDuplicates) {
+  ForegroundTracker tracker(3);
+  FakeEventSource source(tracker);
+  source.Focus(10);
+  source.Focus(11);
+  source.Focus(10);
+  source.Focus(10);
+  source.Focus(12);
+  // History is 12 10 11: had 10 been stored twice, 11 would have been
+  // pushed out by the bound.
+  EXPECT_EQ(source.LastTarget(), 12u);
+  source.Close(12);
+  EXPECT_EQ(source.LastTarget(), 10u);
+  source.Close(10);
+  EXPECT_EQ(source.LastTarget(), 11u);
+}
+
+TEST(ForegroundTrackerTest, HistoryIsBounded) {
+  ForegroundTracker tracker(3);
+  FakeEventSource source(tracker);
+  for (WindowId w = 10; w <= 15; w++) source.Focus(w);  // Keeps 15 14 13.
+  source.Close(15);
+  source.Close(14);
+  source.Close(13);
+  EXPECT_EQ(source.LastTarget(), 0u);  // 12 and older fell off the end.
+
+  // A bound of 0 still remembers one window.
+  ForegroundTracker single(0);
+  single.OnForeground(5, true);
+  single.OnForeground(6, true);
+  EXPECT_EQ(single.LastTarget(nullptr), 6u);
+}
+
+TEST(ForegroundTrackerTest, EvictsUnusableEntries) {
+  ForegroundTracker tracker(8);
+  FakeEventSource source(tracker);
+  source.Focus(10);
+  source.Focus(11);
+  source.Focus(12);
+  source.Close(12);
+  source.Close(11);
+  EXPECT_EQ(source.LastTarget(), 10u);
+
+  // The failed entries were dropped, not skipped: coming back doesn't
+  // revive them until they are focused again.
+  source.Reopen(12);
+  source.Reopen(11);
+  EXPECT_EQ(source.LastTarget(), 10u);
+  source.Focus(11);
+  EXPECT_EQ(source.LastTarget(), 11u);
+
+  // Nothing usable empties the history.
+  source.Close(10);
+  source.Close(11);
+  EXPECT_EQ(source.LastTarget(), 0u);
+  source.Reopen(10);
+  source.Reopen(11);
+  EXPECT_EQ(source.LastTarget(), 0u);
+}
+
+// Events arrive on the UI thread while capture workers query.
+TEST(ForegroundTrackerTest, ConcurrentEventsAndQueries) {
+  ForegroundTracker tracker(8);
+  std::atomic<bool> stop{false};
+  std::atomic<int> bad{0};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&] {
+      while (!stop) {
+        const WindowId w = tracker.LastTarget([](WindowId id) { return id % 7 != 0; });
+        if (w != 0 && (w % 7 == 0 || w == 1)) bad++;
+      }
+    });
+  }
+  for (WindowId i = 0; i < 100000; i++) tracker.OnForeground(i % 50 + 1, i % 50 != 0);
+  stop = true;
+  for (std::thread& reader : readers) reader.join();
+  EXPECT_EQ(bad.load(), 0);
+}
+
+}  // namespace
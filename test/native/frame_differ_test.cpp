@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "frame_differ.h"
+#include "upload_history.h"
+
+namespace {
+
+// Every pixel distinct within its tile, so any single write changes a hash.
+std::vector<uint8_t> Pattern(int width, int height, size_t stride, uint8_t seed = 0) {
+  std::vector<uint8_t> bgra(stride * static_cast<size_t>(height), 0xee);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      uint8_t* p = bgra.data() + static_cast<size_t>(y) * stride + static_cast<size_t>(x) * 4;
+      p[0] = static_cast<uint8_t>(x + seed);
+      p[1] = static_cast<uint8_t>(y);
+      p[2] = static_cast<uint8_t>(x * 3 + y * 5);
+      p[3] = 255;
+    }
+  }
+  return bgra;
+}
+
+void Poke(std::vector<uint8_t>& bgra, size_t stride, int x, int y) {
+  bgra[static_cast<size_t>(y) * stride + static_cast<size_t>(x) * 4 + 1] ^= 0x80;
+}
+
+void ExpectRect(const DirtyRect& r, int x, int y, int width, int height) {
+  EXPECT_EQ(r.x, x);
+  EXPECT_EQ(r.y, y);
+  EXPECT_EQ(r.width, width);
+  EXPECT_EQ(r.height, height);
+}
+
+TEST(FrameDifferTest, IdenticalFramesAreUnchanged) {
+  FrameDiffer differ;
+  const std::vector<uint8_t> frame = Pattern(256, 192, 256 * 4);
+  EXPECT_EQ(differ.Update(frame.data(), 256, 192, 0).kind, FrameDiff::Kind::kFirst);
+
+  const std::vector<uint8_t> copy = frame;
+  const FrameDiff diff = differ.Update(copy.data(), 256, 192, 0);
+  EXPECT_EQ(diff.kind, FrameDiff::Kind::kUnchanged);
+  EXPECT_TRUE(diff.rects.empty());
+  EXPECT_EQ(diff.changed_fraction, 0.0);
+}
+
+TEST(FrameDifferTest, OnePixelDirtiesOneTile) {
+  FrameDiffer differ;
+  std::vector<uint8_t> frame = Pattern(256, 192, 256 * 4);
+  differ.Update(frame.data(), 256, 192, 0);
+
+  Poke(frame, 256 * 4, 130, 70);
+  const FrameDiff diff = differ.Update(frame.data(), 256, 192, 0);
+  EXPECT_EQ(diff.kind, FrameDiff::Kind::kDirty);
+  ASSERT_EQ(diff.rects.size(), 1u);
+  ExpectRect(diff.rects[0], 128, 64, 64, 64);
+  EXPECT_DOUBLE_EQ(diff.changed_fraction, 1.0 / 12);
+}
+
+// 100x70 is 2x2 tiles, the right column 36 and the bottom row 6 pixels.
+TEST(FrameDifferTest, EdgeTilesAreClippedToTheFrame) {
+  const size_t stride = 100 * 4 + 12;
+  FrameDiffer differ;
+  std::vector<uint8_t> frame = Pattern(100, 70, stride);
+  differ.Update(frame.data(), 100, 70, stride);
+
+  Poke(frame, stride, 99, 69);
+  FrameDiff diff = differ.Update(frame.data(), 100, 70, stride);
+  ASSERT_EQ(diff.rects.size(), 1u);
+  ExpectRect(diff.rects[0], 64, 64, 36, 6);
+
+  Poke(frame, stride, 10, 69);
+  Poke(frame, stride, 70, 10);
+  diff = differ.Update(frame.data(), 100, 70, stride);
+  ASSERT_EQ(diff.rects.size(), 2u);
+  ExpectRect(diff.rects[0], 64, 0, 36, 64);
+  ExpectRect(diff.rects[1], 0, 64, 64, 6);
+
+  // Row padding is not part of the image.
+  frame[stride - 1] ^= 0xff;
+  EXPECT_EQ(differ.Update(frame.data(), 100, 70, stride).kind, FrameDiff::Kind::kUnchanged);
+}
+
+TEST(FrameDifferTest, AdjacentTilesMerge) {
+  FrameDiffer differ(1.0);
+  std::vector<uint8_t> frame = Pattern(256, 256, 256 * 4);
+  differ.Update(frame.data(), 256, 256, 0);
+
+  for (int y : {10, 70, 130}) {
+    for (int x : {70, 130}) Poke(frame, 256 * 4, x, y);
+  }
+  const FrameDiff diff = differ.Update(frame.data(), 256, 256, 0);
+  EXPECT_EQ(diff.kind, FrameDiff::Kind::kDirty);
+  ASSERT_EQ(diff.rects.size(), 1u);
+  ExpectRect(diff.rects[0], 64, 0, 128, 192);
+}
+
+TEST(FrameDifferTest, SizeChangeOrMostTilesChangedIsNotDirty) {
+  FrameDiffer differ;
+  const std::vector<uint8_t> wide = Pattern(256, 128, 256 * 4);
+  differ.Update(wide.data(), 256, 128, 0);
+
+  // The same bytes read as another size: nothing to compare against.
+  FrameDiff diff = differ.Update(wide.data(), 128, 256, 0);
+  EXPECT_EQ(diff.kind, FrameDiff::Kind::kFirst);
+  EXPECT_TRUE(diff.rects.empty());
+  EXPECT_EQ(diff.changed_fraction, 1.0);
+  EXPECT_EQ(differ.Update(wide.data(), 128, 256, 0).kind, FrameDiff::Kind::kUnchanged);
+
+  const std::vector<uint8_t> other = Pattern(128, 256, 128 * 4, 1);
+  diff = differ.Update(other.data(), 128, 256, 0);
+  EXPECT_EQ(diff.kind, FrameDiff::Kind::kChanged);
+  EXPECT_EQ(diff.changed_fraction, 1.0);
+}
+
+// Interleaved captures of two targets each diff against their own last
+// frame.
+TEST(FrameDifferTest, HistoriesArePerTarget) {
+  UploadHistories histories;
+  const std::shared_ptr<UploadHistory> a = histories.Get("window:1");
+  const std::shared_ptr<UploadHistory> b = histories.Get("window:2");
+  ASSERT_NE(a, b);
+  EXPECT_EQ(histories.Get("window:1"), a);
+
+  const std::vector<uint8_t> frame_a = Pattern(128, 128, 128 * 4, 0);
+  const std::vector<uint8_t> frame_b = Pattern(128, 128, 128 * 4, 9);
+  EXPECT_EQ(a->differ.Update(frame_a.data(), 128, 128, 0).kind, FrameDiff::Kind::kFirst);
+  EXPECT_EQ(b->differ.Update(frame_b.data(), 128, 128, 0).kind, FrameDiff::Kind::kFirst);
+  EXPECT_EQ(a->differ.Update(frame_a.data(), 128, 128, 0).kind, FrameDiff::Kind::kUnchanged);
+  EXPECT_EQ(b->differ.Update(frame_b.data(), 128, 128, 0).kind, FrameDiff::Kind::kUnchanged);
+}
+
+TEST(FrameDifferTest, TooManyTargetsStartOver) {
+  UploadHistories histories(2);
+  const std::shared_ptr<UploadHistory> a = histories.Get("a");
+  histories.Get("b");
+  EXPECT_EQ(histories.size(), 2u);
+
+  histories.Get("c");
+  EXPECT_EQ(histories.size(), 1u);
+  // |a| was dropped from the map; its holder keeps a working history, and
+  // the key starts fresh.
+  const std::vector<uint8_t> frame = Pattern(64, 64, 64 * 4);
+  a->differ.Update(frame.data(), 64, 64, 0);
+  EXPECT_EQ(a->differ.Update(frame.data(), 64, 64, 0).kind, FrameDiff::Kind::kUnchanged);
+  EXPECT_NE(histories.Get("a"), a);
+}
+
+}  // namespace
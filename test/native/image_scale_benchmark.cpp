@@ -0,0 +1,43 @@
+// ScaleBgra throughput for the runner's common shapes: capture downscales
+// for upload (1600 px long edge) and thumbnails, per filter and thread count.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "image_scale.h"
+#include "reference_codecs.h"
+
+namespace {
+
+void BM_ScaleBgra(benchmark::State& state) {
+  const int src_w = static_cast<int>(state.range(0));
+  const int src_h = static_cast<int>(state.range(1));
+  const int dst_w = static_cast<int>(state.range(2));
+  const ScaleFilter filter = static_cast<ScaleFilter>(state.range(3));
+  const int threads = static_cast<int>(state.range(4));
+  const int dst_h = static_cast<int>(static_cast<int64_t>(src_h) * dst_w / src_w);
+  const std::vector<uint8_t> src = SyntheticScreen(src_w, src_h);
+  std::vector<uint8_t> out;
+  for (auto _ : state) {
+    ScaleBgra(src.data(), src_w, src_h, 0, dst_w, dst_h, filter, out, threads);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * src_w * src_h * 4);
+}
+
+void ScaleArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"src_w", "src_h", "dst_w", "filter", "threads"});
+  const int shapes[][3] = {{1920, 1080, 1600}, {2560, 1440, 1600}, {3840, 2160, 1600}, {3840, 2160, 320}};
+  for (const auto& shape : shapes) {
+    for (int filter : {static_cast<int>(ScaleFilter::kBox), static_cast<int>(ScaleFilter::kBilinear),
+                       static_cast<int>(ScaleFilter::kLanczos3)}) {
+      for (int threads : {1, 0}) b->Args({shape[0], shape[1], shape[2], filter, threads});
+    }
+  }
+}
+
+BENCHMARK(BM_ScaleBgra)->Apply(ScaleArgs)->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "image_scale.h"
+#include "reference_codecs.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+double Triangle(double x) {
+  x = std::fabs(x);
+  return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+double Sinc(double x) {
+  if (x == 0.0) return 1.0;
+  x *= kPi;
+  return std::sin(x) / x;
+}
+
+double Lanczos3(double x) {
+  if (x <= -3.0 || x >= 3.0) return 0.0;
+  return Sinc(x) * Sinc(x / 3.0);
+}
+
+// Normalized double-precision weights for one axis: weights[i][s] is how
+// much source coordinate s contributes to output coordinate i.
+std::vector<std::vector<double>> ReferenceWeights(int src, int dst, ScaleFilter filter) {
+  std::vector<std::vector<double>> weights(static_cast<size_t>(dst), std::vector<double>(src, 0.0));
+  const double scale = static_cast<double>(src) / dst;
+  for (int i = 0; i < dst; i++) {
+    std::vector<double>& w = weights[static_cast<size_t>(i)];
+    if (filter == ScaleFilter::kBox) {
+      const double start = i * scale;
+      const double end = (std::min)(static_cast<double>(src), (i + 1) * scale);
+      for (int s = 0; s < src; s++) {
+        w[s] = (std::max)(0.0, (std::min)(end, s + 1.0) - (std::max)(start, static_cast<double>(s)));
+      }
+    } else {
+      const double radius = filter == ScaleFilter::kBilinear ? 1.0 : 3.0;
+      const double filter_scale = (std::max)(1.0, scale);
+      const double center = (i + 0.5) * scale;
+      const double support = radius * filter_scale;
+      for (int s = 0; s < src; s++) {
+        if (s + 0.5 <= center - support || s + 0.5 >= center + support) continue;
+        const double x = (s + 0.5 - center) / filter_scale;
+        w[s] = filter == ScaleFilter::kBilinear ? Triangle(x) : Lanczos3(x);
+      }
+    }
+    double total = 0.0;
+    for (double v : w) total += v;
+    for (double& v : w) v /= total;
+  }
+  return weights;
+}
+
+// The separable resample done in doubles, rounded once at the end.
+std::vector<uint8_t> ReferenceScale(const std::vector<uint8_t>& src, int src_w, int src_h, int dst_w,
+                                    int dst_h, ScaleFilter filter) {
+  const auto cols = ReferenceWeights(src_w, dst_w, filter);
+  const auto rows = ReferenceWeights(src_h, dst_h, filter);
+  std::vector<double> mid(static_cast<size_t>(src_w) * 4);
+  std::vector<uint8_t> out(static_cast<size_t>(dst_w) * dst_h * 4);
+  for (int y = 0; y < dst_h; y++) {
+    std::fill(mid.begin(), mid.end(), 0.0);
+    for (int sy = 0; sy < src_h; sy++) {
+      const double w = rows[static_cast<size_t>(y)][sy];
+      if (w == 0.0) continue;
+      for (size_t i = 0; i < mid.size(); i++) mid[i] += w * src[static_cast<size_t>(sy) * src_w * 4 + i];
+    }
+    for (int x = 0; x < dst_w; x++) {
+      for (int ch = 0; ch < 4; ch++) {
+        double acc = 0.0;
+        for (int sx = 0; sx < src_w; sx++) acc += cols[static_cast<size_t>(x)][sx] * mid[sx * 4 + ch];
+        out[(static_cast<size_t>(y) * dst_w + x) * 4 + ch] =
+            static_cast<uint8_t>((std::min)(255.0, (std::max)(0.0, std::round(acc))));
+      }
+    }
+  }
+  return out;
+}
+
+int MaxAbsDiff(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+  int worst = 0;
+  for (size_t i = 0; i < a.size() && i < b.size(); i++) worst = (std::max)(worst, std::abs(a[i] - b[i]));
+  return worst;
+}
+
+TEST(ImageScaleTest, MatchesDoublePrecisionReference) {
+  // Up and down, integer and fractional ratios, widths that leave SIMD tails.
+  const int cases[][4] = {{64, 48, 32, 24},  {100, 75, 33, 17}, {37, 29, 37, 29},
+                          {50, 40, 71, 53},  {8, 8, 3, 5},      {301, 7, 19, 3},
+                          {5, 300, 2, 41}};
+  for (ScaleFilter filter : {ScaleFilter::kBox, ScaleFilter::kBilinear, ScaleFilter::kLanczos3}) {
+    for (const auto& c : cases) {
+      const std::vector<uint8_t> src = SyntheticScreen(c[0], c[1], 21);
+      std::vector<uint8_t> out;
+      ASSERT_TRUE(ScaleBgra(src.data(), c[0], c[1], 0, c[2], c[3], filter, out, 1));
+      ASSERT_EQ(out.size(), static_cast<size_t>(c[2]) * c[3] * 4);
+      // 14-bit weights and a 6-bit intermediate: off by at most 1, plus 1
+      // for Lanczos, whose overshoot amplifies the intermediate rounding.
+      const int tolerance = filter == ScaleFilter::kLanczos3 ? 2 : 1;
+      EXPECT_LE(MaxAbsDiff(out, ReferenceScale(src, c[0], c[1], c[2], c[3], filter)), tolerance)
+          << static_cast<int>(filter) << ": " << c[0] << "x" << c[1] << " -> " << c[2] << "x" << c[3];
+    }
+  }
+}
+
+TEST(ImageScaleTest, ThreadCountDoesNotChangeOutput) {
+  const std::vector<uint8_t> src = SyntheticScreen(640, 480, 22);
+  std::vector<uint8_t> one, four;
+  ASSERT_TRUE(ScaleBgra(src.data(), 640, 480, 0, 300, 225, ScaleFilter::kLanczos3, one, 1));
+  ASSERT_TRUE(ScaleBgra(src.data(), 640, 480, 0, 300, 225, ScaleFilter::kLanczos3, four, 4));
+  EXPECT_EQ(one, four);
+}
+
+TEST(ImageScaleTest, ExtremeDownscaleAveragesTheWholeSpan) {
+  // Beyond 16384:1 per-tap rounding used to overflow the int16 weights.
+  for (int width : {16384, 20000, 40000, 70000}) {
+    std::vector<uint8_t> src(static_cast<size_t>(width) * 4);
+    double sum = 0.0;
+    for (int x = 0; x < width; x++) {
+      const uint8_t v = static_cast<uint8_t>(x * 251 / width);  // ramp 0..250
+      src[static_cast<size_t>(x) * 4 + 0] = v;
+      src[static_cast<size_t>(x) * 4 + 1] = static_cast<uint8_t>(250 - v);
+      src[static_cast<size_t>(x) * 4 + 2] = 200;
+      src[static_cast<size_t>(x) * 4 + 3] = 255;
+      sum += v;
+    }
+    const double mean = sum / width;
+    for (ScaleFilter filter : {ScaleFilter::kBox, ScaleFilter::kBilinear}) {
+      std::vector<uint8_t> out;
+      ASSERT_TRUE(ScaleBgra(src.data(), width, 1, 0, 1, 1, filter, out, 1));
+      if (filter == ScaleFilter::kBox) {
+        EXPECT_NEAR(out[0], mean, 1.0) << width;
+        EXPECT_NEAR(out[1], 250 - mean, 1.0) << width;
+      } else {
+        // The stretched triangle peaks at the centre, where the ramp is at
+        // its midpoint too.
+        EXPECT_NEAR(out[0], 125, 2.0) << width;
+      }
+      EXPECT_EQ(out[2], 200) << width;
+      EXPECT_EQ(out[3], 255) << width;
+    }
+
+    // The same along the vertical axis.
+    std::vector<uint8_t> out;
+    ASSERT_TRUE(ScaleBgra(src.data(), 1, width, 4, 1, 1, ScaleFilter::kBox, out, 1));
+    EXPECT_NEAR(out[0], mean, 1.0) << width;
+  }
+}
+
+TEST(ImageScaleTest, FitWithinKeepsAspectAndNeverUpscales) {
+  int w = 0, h = 0;
+  FitWithin(3840, 2160, 1600, 1600, w, h);
+  EXPECT_EQ(w, 1600);
+  EXPECT_EQ(h, 900);
+  FitWithin(800, 600, 1600, 1600, w, h);
+  EXPECT_EQ(w, 800);
+  EXPECT_EQ(h, 600);
+  FitWithin(100000, 1, 100, 100, w, h);
+  EXPECT_EQ(w, 100);
+  EXPECT_EQ(h, 1);
+}
+
+}  // namespace
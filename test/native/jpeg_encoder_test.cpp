@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "jpeg_encoder.h"
+#include "reference_codecs.h"
+
+namespace {
+
+// Smooth content, where baseline JPEG at high quality is near lossless.
+std::vector<uint8_t> Gradient(int width, int height) {
+  std::vector<uint8_t> bgra(static_cast<size_t>(width) * height * 4);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      uint8_t* p = &bgra[(static_cast<size_t>(y) * width + x) * 4];
+      p[0] = static_cast<uint8_t>(64 + x * 128 / width);
+      p[1] = static_cast<uint8_t>(32 + y * 160 / height);
+      p[2] = static_cast<uint8_t>(200 - (x + y) * 100 / (width + height));
+      p[3] = 255;
+    }
+  }
+  return bgra;
+}
+
+double RoundTripError(const std::vector<uint8_t>& bgra, int width, int height, size_t stride,
+                      int quality, size_t* size = nullptr) {
+  std::vector<uint8_t> jpeg;
+  EXPECT_TRUE(EncodeJpegBgra(bgra.data(), width, height, stride, quality, jpeg));
+  if (size) *size = jpeg.size();
+  int w = 0, h = 0;
+  std::vector<uint8_t> rgb;
+  EXPECT_TRUE(DecodeJpegRgb(jpeg, w, h, rgb)) << width << "x" << height;
+  EXPECT_EQ(w, width);
+  EXPECT_EQ(h, height);
+  return MeanAbsDiff(rgb, BgraToRgb(bgra.data(), width, height, stride));
+}
+
+TEST(JpegEncoderTest, DecodesAtOddSizes) {
+  // Partial MCUs on both axes, and images smaller than one MCU.
+  const int sizes[][2] = {{1, 1}, {7, 9}, {17, 15}, {16, 16}, {33, 8}, {64, 47}};
+  for (const auto& size : sizes) {
+    const std::vector<uint8_t> bgra = Gradient(size[0], size[1]);
+    EXPECT_LT(RoundTripError(bgra, size[0], size[1], 0, 90), 3.0) << size[0] << "x" << size[1];
+  }
+}
+
+TEST(JpegEncoderTest, QualityTradesSizeForError) {
+  const int width = 160, height = 120;
+  const std::vector<uint8_t> bgra = SyntheticScreen(width, height, 7);
+  size_t size_low = 0, size_high = 0;
+  const double error_low = RoundTripError(bgra, width, height, 0, 40, &size_low);
+  const double error_high = RoundTripError(bgra, width, height, 0, 95, &size_high);
+  EXPECT_LT(size_low, size_high);
+  EXPECT_LT(error_high, error_low);
+  EXPECT_LT(error_high, 4.0);
+}
+
+TEST(JpegEncoderTest, HonoursStride) {
+  const int width = 30, height = 20;
+  const size_t stride = width * 4 + 8;
+  const std::vector<uint8_t> packed = Gradient(width, height);
+  std::vector<uint8_t> padded(stride * height, 0);
+  for (int y = 0; y < height; y++) {
+    std::copy(packed.begin() + y * width * 4, packed.begin() + (y + 1) * width * 4,
+              padded.begin() + y * stride);
+  }
+  EXPECT_LT(RoundTripError(padded, width, height, stride, 90), 3.0);
+}
+
+}  // namespace
@@ -0,0 +1,384 @@
+#include "loopback_websocket.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+constexpr int kOpText = 0x1;
+constexpr int kOpBinary = 0x2;
+constexpr int kOpClose = 0x8;
+constexpr int kOpPing = 0x9;
+
+// Small socket buffers, so a server that stops reading backs up the
+// client's sends after a frame or two instead of after megabytes.
+constexpr int kSocketBufferBytes = 4096;
+
+bool WriteAll(int fd, const void* data, size_t size) {
+  const char* p = static_cast<const char*>(data);
+  while (size > 0) {
+    const ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+    if (n <= 0) return false;
+    p += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool ReadExact(int fd, void* data, size_t size) {
+  char* p = static_cast<char*>(data);
+  while (size > 0) {
+    const ssize_t n = recv(fd, p, size, 0);
+    if (n <= 0) return false;
+    p += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+// Reads an HTTP head up to the blank line. |stop| (optional) is checked
+// between polls.
+bool ReadHttpHead(int fd, std::string& head, const std::atomic<bool>* stop) {
+  char c = 0;
+  while (head.size() < 4 || head.compare(head.size() - 4, 4, "\r\n\r\n") != 0) {
+    if (stop) {
+      pollfd pfd{fd, POLLIN, 0};
+      if (poll(&pfd, 1, 20) == 0) {
+        if (*stop) return false;
+        continue;
+      }
+    }
+    if (recv(fd, &c, 1, 0) != 1) return false;
+    head.push_back(c);
+  }
+  return true;
+}
+
+std::string EncodeFrame(int opcode, const std::string& payload, bool masked) {
+  std::string frame;
+  frame.push_back(static_cast<char>(0x80 | opcode));
+  const uint8_t mask_bit = masked ? 0x80 : 0;
+  const uint64_t size = payload.size();
+  if (size < 126) {
+    frame.push_back(static_cast<char>(mask_bit | size));
+  } else if (size <= 0xffff) {
+    frame.push_back(static_cast<char>(mask_bit | 126));
+    frame.push_back(static_cast<char>(size >> 8));
+    frame.push_back(static_cast<char>(size));
+  } else {
+    frame.push_back(static_cast<char>(mask_bit | 127));
+    for (int shift = 56; shift >= 0; shift -= 8) frame.push_back(static_cast<char>(size >> shift));
+  }
+  const uint8_t key[4] = {0x37, 0xfa, 0x21, 0x3d};
+  if (masked) frame.append(reinterpret_cast<const char*>(key), 4);
+  const size_t start = frame.size();
+  frame += payload;
+  if (masked) {
+    for (size_t i = 0; i < payload.size(); i++) frame[start + i] ^= static_cast<char>(key[i % 4]);
+  }
+  return frame;
+}
+
+bool ReadFrame(int fd, int& opcode, bool& fin, std::string& payload) {
+  uint8_t head[2];
+  if (!ReadExact(fd, head, 2)) return false;
+  fin = (head[0] & 0x80) != 0;
+  opcode = head[0] & 0x0f;
+  uint64_t size = head[1] & 0x7f;
+  if (size == 126 || size == 127) {
+    uint8_t ext[8];
+    const size_t bytes = size == 126 ? 2 : 8;
+    if (!ReadExact(fd, ext, bytes)) return false;
+    size = 0;
+    for (size_t i = 0; i < bytes; i++) size = (size << 8) | ext[i];
+  }
+  uint8_t key[4] = {0, 0, 0, 0};
+  const bool masked = (head[1] & 0x80) != 0;
+  if (masked && !ReadExact(fd, key, 4)) return false;
+  payload.resize(static_cast<size_t>(size));
+  if (size > 0 && !ReadExact(fd, &payload[0], payload.size())) return false;
+  if (masked) {
+    for (size_t i = 0; i < payload.size(); i++) payload[i] ^= static_cast<char>(key[i % 4]);
+  }
+  return true;
+}
+
+std::string Narrow(const std::wstring& text) {
+  std::string out;
+  for (wchar_t c : text) out.push_back(static_cast<char>(c));
+  return out;
+}
+
+}  // namespace
+
+PosixWebSocketTransport::~PosixWebSocketTransport() {
+  if (fd_ >= 0) close(fd_);
+}
+
+bool PosixWebSocketTransport::Open(const std::wstring& url, double& handshake_ms, std::string& error) {
+  const std::string narrow = Narrow(url);
+  if (narrow.rfind("ws://", 0) != 0) {
+    error = "unsupported URL scheme";
+    return false;
+  }
+  const std::string rest = narrow.substr(5);
+  const size_t slash = rest.find('/');
+  const std::string authority = rest.substr(0, slash);
+  const std::string path = slash == std::string::npos ? "/" : rest.substr(slash);
+  const size_t colon = authority.rfind(':');
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(static_cast<uint16_t>(colon == std::string::npos ? 80 : std::stoi(authority.substr(colon + 1))));
+  if (inet_pton(AF_INET, authority.substr(0, colon).c_str(), &addr.sin_addr) != 1) {
+    error = "invalid URL";
+    return false;
+  }
+
+  int fd = -1;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (aborted_) {
+      error = "aborted";
+      return false;
+    }
+    fd = fd_ = socket(AF_INET, SOCK_STREAM, 0);
+  }
+  if (fd < 0) {
+    error = "socket failed";
+    return false;
+  }
+  setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &kSocketBufferBytes, sizeof(kSocketBufferBytes));
+  if (connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+    error = "connect failed (" + std::to_string(errno) + ")";
+    return false;
+  }
+  {
+    // Shutting down a socket that was not yet connected did nothing.
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (aborted_) {
+      error = "aborted";
+      return false;
+    }
+  }
+
+  const std::string request = "GET " + path + " HTTP/1.1\r\nHost: " + authority +
+                              "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                              "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                              "Sec-WebSocket-Version: 13\r\n\r\n";
+  const auto start = std::chrono::steady_clock::now();
+  std::string response;
+  if (!WriteAll(fd, request.data(), request.size()) || !ReadHttpHead(fd, response, nullptr)) {
+    error = "handshake failed";
+    return false;
+  }
+  handshake_ms =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  if (response.rfind("HTTP/1.1 101", 0) != 0) {
+    error = "server refused upgrade (" + response.substr(0, response.find('\r')) + ")";
+    return false;
+  }
+  return true;
+}
+
+bool PosixWebSocketTransport::SendText(const std::string& text, std::string& error) {
+  const std::string frame = EncodeFrame(kOpText, text, true);
+  if (!WriteAll(fd_, frame.data(), frame.size())) {
+    error = "send failed (" + std::to_string(errno) + ")";
+    return false;
+  }
+  return true;
+}
+
+UplinkTransport::ReceiveStatus PosixWebSocketTransport::Receive(std::string& message, std::string& error) {
+  message.clear();
+  std::string payload;
+  int opcode = 0;
+  bool fin = false;
+  for (;;) {
+    if (!ReadFrame(fd_, opcode, fin, payload)) {
+      error = "receive failed (connection lost)";
+      return ReceiveStatus::kFailed;
+    }
+    if (opcode == kOpClose) return ReceiveStatus::kClosed;
+    if (opcode >= kOpClose) continue;  // Ping, pong.
+    if (opcode == kOpBinary) {
+      message.clear();
+      continue;
+    }
+    message += payload;
+    if (fin) return ReceiveStatus::kMessage;
+  }
+}
+
+void PosixWebSocketTransport::Close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (aborted_ || fd_ < 0) return;
+  }
+  const std::string frame = EncodeFrame(kOpClose, std::string("\x03\xe8", 2), true);
+  WriteAll(fd_, frame.data(), frame.size());
+  std::lock_guard<std::mutex> lock(mutex_);
+  shutdown(fd_, SHUT_RDWR);
+}
+
+void PosixWebSocketTransport::Abort() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  aborted_ = true;
+  if (fd_ >= 0) shutdown(fd_, SHUT_RDWR);
+}
+
+MockWebSocketServer::MockWebSocketServer() {
+  listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+  const int one = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  // Inherited by accepted sockets.
+  setsockopt(listen_fd_, SOL_SOCKET, SO_RCVBUF, &kSocketBufferBytes, sizeof(kSocketBufferBytes));
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+  socklen_t len = sizeof(addr);
+  getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+  port_ = ntohs(addr.sin_port);
+  listen(listen_fd_, 4);
+  thread_ = std::thread(&MockWebSocketServer::ServeThreadProc, this);
+}
+
+MockWebSocketServer::~MockWebSocketServer() {
+  stop_ = true;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (client_fd_ >= 0) shutdown(client_fd_, SHUT_RDWR);
+  }
+  thread_.join();
+  close(listen_fd_);
+}
+
+std::wstring MockWebSocketServer::url() const {
+  const std::string url = "ws://127.0.0.1:" + std::to_string(port_) + "/transcribe";
+  return std::wstring(url.begin(), url.end());
+}
+
+void MockWebSocketServer::SendClose() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (client_fd_ >= 0) SendFrame(client_fd_, kOpClose, std::string("\x03\xe8", 2));
+}
+
+void MockWebSocketServer::Drop() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (client_fd_ >= 0) shutdown(client_fd_, SHUT_RDWR);
+}
+
+std::vector<std::string> MockWebSocketServer::Messages() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return messages_;
+}
+
+bool MockWebSocketServer::WaitForMessages(size_t count, std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return cv_.wait_for(lock, timeout, [&] { return messages_.size() >= count; });
+}
+
+bool MockWebSocketServer::WaitForDisconnect(std::chrono::milliseconds timeout, bool* close_frame) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  const bool done = cv_.wait_for(lock, timeout, [&] { return connections_ > 0 && !connected_; });
+  if (close_frame) *close_frame = close_frame_;
+  return done;
+}
+
+int MockWebSocketServer::connections() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return connections_;
+}
+
+void MockWebSocketServer::ServeThreadProc() {
+  while (!stop_) {
+    pollfd pfd{listen_fd_, POLLIN, 0};
+    if (poll(&pfd, 1, 20) <= 0) continue;
+    const int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) continue;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      client_fd_ = fd;
+      connections_++;
+      connected_ = true;
+      close_frame_ = false;
+    }
+    cv_.notify_all();
+    Serve(fd);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      client_fd_ = -1;
+      connected_ = false;
+      close(fd);
+    }
+    cv_.notify_all();
+  }
+}
+
+void MockWebSocketServer::Serve(int fd) {
+  std::string head;
+  if (!ReadHttpHead(fd, head, &stop_)) return;
+  if (!answer_upgrade_) {
+    // Hold the connection until the client gives up.
+    char c = 0;
+    while (!stop_) {
+      pollfd pfd{fd, POLLIN, 0};
+      if (poll(&pfd, 1, 20) > 0 && recv(fd, &c, 1, 0) <= 0) return;
+    }
+    return;
+  }
+  const std::string response =
+      "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+      "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n\r\n";
+  {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (!WriteAll(fd, response.data(), response.size())) return;
+  }
+
+  std::string message;
+  std::string payload;
+  while (!stop_) {
+    if (stalled_) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      continue;
+    }
+    pollfd pfd{fd, POLLIN, 0};
+    // Stalling may have begun during the poll.
+    if (poll(&pfd, 1, 20) <= 0 || stalled_) continue;
+    int opcode = 0;
+    bool fin = false;
+    if (!ReadFrame(fd, opcode, fin, payload)) return;
+    if (opcode == kOpClose) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        close_frame_ = true;
+      }
+      SendFrame(fd, kOpClose, payload);
+      return;
+    }
+    if (opcode == kOpPing) continue;
+    message += payload;
+    if (!fin) continue;
+    if (echo_) SendFrame(fd, kOpText, message);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      messages_.push_back(std::move(message));
+    }
+    cv_.notify_all();
+    message.clear();
+  }
+}
+
+bool MockWebSocketServer::SendFrame(int fd, int opcode, const std::string& payload) {
+  const std::string frame = EncodeFrame(opcode, payload, false);
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  return WriteAll(fd, frame.data(), frame.size());
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "uplink_transport.h"
+
+// A WebSocket client over POSIX sockets, enough of RFC 6455 for
+// AudioUplink's tests: ws:// to a numeric host, masked text frames out,
+// unfragmented or fragmented text frames in. Abort() shuts the socket down,
+// which wakes a blocked send or receive.
+class PosixWebSocketTransport : public UplinkTransport {
+ public:
+  PosixWebSocketTransport() = default;
+  ~PosixWebSocketTransport() override;
+
+  PosixWebSocketTransport(const PosixWebSocketTransport&) = delete;
+  PosixWebSocketTransport& operator=(const PosixWebSocketTransport&) = delete;
+
+  bool Open(const std::wstring& url, double& handshake_ms, std::string& error) override;
+  bool SendText(const std::string& text, std::string& error) override;
+  ReceiveStatus Receive(std::string& message, std::string& error) override;
+  void Close() override;
+  void Abort() override;
+
+ private:
+  std::mutex mutex_;
+  bool aborted_ = false;
+  int fd_ = -1;
+};
+
+// A single-client WebSocket server on 127.0.0.1 that records the text
+// messages it receives and can echo them, stop reading (so the client's
+// sends back up), leave the upgrade unanswered, close, or drop the
+// connection. Serves one connection at a time, any number in turn.
+class MockWebSocketServer {
+ public:
+  MockWebSocketServer();
+  ~MockWebSocketServer();
+
+  MockWebSocketServer(const MockWebSocketServer&) = delete;
+  MockWebSocketServer& operator=(const MockWebSocketServer&) = delete;
+
+  std::wstring url() const;
+
+  void SetEcho(bool echo) { echo_ = echo; }
+  void SetStalled(bool stalled) { stalled_ = stalled; }
+  // When false, new connections get no reply to the upgrade request.
+  void SetAnswerUpgrade(bool answer) { answer_upgrade_ = answer; }
+
+  // Sends a close frame to the current client.
+  void SendClose();
+  // Ends the current connection without a close frame.
+  void Drop();
+
+  std::vector<std::string> Messages();
+  // Waits until at least |count| messages have arrived.
+  bool WaitForMessages(size_t count, std::chrono::milliseconds timeout);
+  // Waits until the current connection has ended; |close_frame| tells
+  // whether the client sent a close frame first.
+  bool WaitForDisconnect(std::chrono::milliseconds timeout, bool* close_frame = nullptr);
+  int connections();
+
+ private:
+  void ServeThreadProc();
+  void Serve(int fd);
+  bool SendFrame(int fd, int opcode, const std::string& payload);
+
+  int listen_fd_ = -1;
+  int port_ = 0;
+  std::thread thread_;
+  std::atomic<bool> stop_{false};
+  std::atomic<bool> echo_{false};
+  std::atomic<bool> stalled_{false};
+  std::atomic<bool> answer_upgrade_{true};
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::string> messages_;
+  int client_fd_ = -1;
+  int connections_ = 0;
+  bool connected_ = false;
+  bool close_frame_ = false;
+  // Serializes frames written by the serving thread and SendClose.
+  std::mutex write_mutex_;
+};
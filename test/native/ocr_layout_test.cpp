@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ocr_layout.h"
+#include "reference_codecs.h"
+
+namespace {
+
+// One rendered line of the corpus, from expected.txt.
+struct ExpectedLine {
+  bool light_on_dark = false;
+  int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+};
+
+// Rows and columns detection may gain or lose at a line's edges, where
+// antialiased ink is faint.
+constexpr int kEdgeSlack = 2;
+
+std::string FixturePath(const std::string& name) {
+  return std::string(OCR_FIXTURE_DIR) + "/" + name;
+}
+
+std::map<std::string, std::vector<ExpectedLine>> ReadExpected() {
+  std::map<std::string, std::vector<ExpectedLine>> corpus;
+  std::ifstream file(FixturePath("expected.txt"));
+  std::string row;
+  while (std::getline(file, row)) {
+    if (row.empty() || row[0] == '#') continue;
+    std::istringstream in(row);
+    std::string image;
+    int light = 0;
+    ExpectedLine line;
+    in >> image >> light >> line.x0 >> line.y0 >> line.x1 >> line.y1;
+    line.light_on_dark = light != 0;
+    corpus[image].push_back(line);
+  }
+  return corpus;
+}
+
+// The corpus image as BGRA, as a capture would deliver it.
+std::vector<uint8_t> LoadBgra(const std::string& name, int& width, int& height) {
+  return ReadPngBgra(FixturePath(name), width, height);
+}
+
+class OcrCorpusTest : public testing::Test {
+ protected:
+  static void SetUpTestSuite() { corpus_ = new std::map<std::string, std::vector<ExpectedLine>>(ReadExpected()); }
+  static void TearDownTestSuite() {
+    delete corpus_;
+    corpus_ = nullptr;
+  }
+
+  static const std::vector<ExpectedLine>& Expected(const std::string& image) { return (*corpus_)[image]; }
+
+  static std::map<std::string, std::vector<ExpectedLine>>* corpus_;
+};
+
+std::map<std::string, std::vector<ExpectedLine>>* OcrCorpusTest::corpus_ = nullptr;
+
+TEST_F(OcrCorpusTest, CorpusIsPresent) {
+  EXPECT_EQ(Expected("light_document.png").size(), 5u);
+  EXPECT_EQ(Expected("dark_editor.png").size(), 5u);
+  EXPECT_EQ(Expected("small_ui.png").size(), 5u);
+}
+
+// Each rendered line comes back as exactly one text line with the same
+// extent, and nothing else (rules, gutter borders) does.
+TEST_F(OcrCorpusTest, FindsEveryRenderedLine) {
+  for (const char* image : {"light_document.png", "dark_editor.png", "small_ui.png"}) {
+    SCOPED_TRACE(image);
+    int width = 0, height = 0;
+    const std::vector<uint8_t> bgra = LoadBgra(image, width, height);
+    ASSERT_FALSE(bgra.empty());
+    OcrLayout layout;
+    ASSERT_TRUE(AnalyzeOcrLayout(bgra.data(), width, height, 0, 256, 2, layout));
+
+    const std::vector<ExpectedLine>& expected = Expected(image);
+    ASSERT_EQ(layout.lines.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+      SCOPED_TRACE(i);
+      const TextLine& found = layout.lines[i];
+      EXPECT_NEAR(found.y, expected[i].y0, kEdgeSlack);
+      // A lone descender stem is under FindTextLines' per-row ink minimum,
+      // so the bottom may stop above it; band padding takes it back in.
+      const int descender = (std::max)(kEdgeSlack, (expected[i].y1 - expected[i].y0) / 4);
+      EXPECT_LE(found.y + found.height, expected[i].y1 + kEdgeSlack);
+      EXPECT_GE(found.y + found.height, expected[i].y1 - descender);
+      EXPECT_NEAR(found.x, expected[i].x0, kEdgeSlack);
+      EXPECT_NEAR(found.x + found.width, expected[i].x1, kEdgeSlack);
+    }
+  }
+}
+
+// Bands run top to bottom, hold every line whole in exactly one band and
+// carry the line's polarity; the extracted pixels are always dark text on
+// light. Neighbouring bands may share a few rows of line padding.
+TEST_F(OcrCorpusTest, BandsCoverLinesWithTheirPolarity) {
+  for (const char* image : {"light_document.png", "dark_editor.png", "small_ui.png"}) {
+    SCOPED_TRACE(image);
+    int width = 0, height = 0;
+    const std::vector<uint8_t> bgra = LoadBgra(image, width, height);
+    ASSERT_FALSE(bgra.empty());
+    OcrLayout layout;
+    ASSERT_TRUE(AnalyzeOcrLayout(bgra.data(), width, height, 0, 64, 4, layout));
+    ASSERT_FALSE(layout.bands.empty());
+
+    for (size_t i = 1; i < layout.bands.size(); i++) {
+      EXPECT_GT(layout.bands[i].y, layout.bands[i - 1].y);
+    }
+    for (const ExpectedLine& line : Expected(image)) {
+      int holders = 0;
+      for (const OcrBand& band : layout.bands) {
+        EXPECT_LE(band.height, 64);
+        if (band.y > line.y0 || band.y + band.height < line.y1) continue;
+        holders++;
+        EXPECT_LE(band.x, line.x0);
+        EXPECT_GE(band.x + band.width, line.x1);
+        EXPECT_EQ(band.light_on_dark, line.light_on_dark);
+      }
+      EXPECT_EQ(holders, 1) << "line at y=" << line.y0;
+    }
+
+    for (const OcrBand& band : layout.bands) {
+      std::vector<uint8_t> pixels;
+      ExtractOcrBand(layout.luma.data(), width, band, pixels);
+      ASSERT_EQ(pixels.size(), static_cast<size_t>(band.width) * band.height);
+      uint64_t total = 0;
+      for (uint8_t p : pixels) total += p;
+      EXPECT_GT(total / pixels.size(), 128u);
+    }
+  }
+}
+
+// A flat screen gives nothing to recognize.
+TEST_F(OcrCorpusTest, BlankScreenHasNoBands) {
+  int width = 0, height = 0;
+  const std::vector<uint8_t> bgra = LoadBgra("blank.png", width, height);
+  ASSERT_FALSE(bgra.empty());
+  OcrLayout layout;
+  ASSERT_TRUE(AnalyzeOcrLayout(bgra.data(), width, height, 0, 256, 2, layout));
+  EXPECT_TRUE(layout.lines.empty());
+  EXPECT_TRUE(layout.bands.empty());
+}
+
+TEST_F(OcrCorpusTest, SameLayoutForAnyThreadCount) {
+  int width = 0, height = 0;
+  const std::vector<uint8_t> bgra = LoadBgra("dark_editor.png", width, height);
+  ASSERT_FALSE(bgra.empty());
+  std::vector<uint8_t> luma, one, many;
+  LumaPlane(bgra.data(), width, height, 0, luma);
+  BinarizeSauvola(luma.data(), width, height, 31, 0.2, 1, one);
+  BinarizeSauvola(luma.data(), width, height, 31, 0.2, 7, many);
+  EXPECT_EQ(one, many);
+}
+
+TEST(OcrLayoutTest, LumaPlaneHonoursStride) {
+  // 2x2 with a 4-byte pad per row: blue, green / red, white.
+  const uint8_t bgra[] = {255, 0, 0, 255, 0, 255, 0, 255, 9, 9, 9, 9,
+                          0, 0, 255, 255, 255, 255, 255, 255, 9, 9, 9, 9};
+  std::vector<uint8_t> luma;
+  LumaPlane(bgra, 2, 2, 12, luma);
+  ASSERT_EQ(luma.size(), 4u);
+  EXPECT_EQ(luma[0], (29 * 255 + 128) >> 8);
+  EXPECT_EQ(luma[1], (150 * 255 + 128) >> 8);
+  EXPECT_EQ(luma[2], (77 * 255 + 128) >> 8);
+  EXPECT_EQ(luma[3], 255);
+}
+
+TEST(OcrLayoutTest, TallPicturesAreCutIntoBands) {
+  // One "line" 300 rows tall on a light grey plane.
+  const int width = 200, height = 400;
+  const std::vector<uint8_t> luma(static_cast<size_t>(width) * height, 200);
+  const std::vector<TextLine> lines = {TextLine{10, 50, 100, 300}};
+  const std::vector<OcrBand> bands = PlanOcrBands(lines, luma.data(), width, height, 64, 4);
+  ASSERT_FALSE(bands.empty());
+  int covered = 0;
+  for (const OcrBand& band : bands) {
+    EXPECT_LE(band.height, 64);
+    EXPECT_FALSE(band.light_on_dark);
+    covered += band.height;
+  }
+  EXPECT_GE(covered, 300);
+}
+
+TEST(OcrLayoutTest, EmptyInputs) {
+  OcrLayout layout;
+  EXPECT_FALSE(AnalyzeOcrLayout(nullptr, 10, 10, 0, 64, 1, layout));
+  EXPECT_TRUE(FindTextLines(nullptr, 0, 0).empty());
+  EXPECT_TRUE(PlanOcrBands({}, nullptr, 0, 0, 64, 1).empty());
+}
+
+}  // namespace
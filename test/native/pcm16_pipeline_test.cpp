@@ -0,0 +1,270 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <vector>
+
+#include "pcm16_pipeline.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// The decimator's filter in double precision, unquantized: the same
+// Blackman-windowed sinc, split into phases each normalized to unity DC
+// gain, as Pcm16Decimator's constructor designs it.
+class FloatDecimator {
+ public:
+  FloatDecimator(uint32_t in_rate, uint32_t out_rate) {
+    const uint32_t g = std::gcd(in_rate, out_rate);
+    up_ = out_rate / g;
+    down_ = in_rate / g;
+    const uint32_t ratio = (in_rate + out_rate - 1) / out_rate;
+    taps_ = (std::max)(16u, 8u * ratio);
+    const size_t len = static_cast<size_t>(up_) * taps_;
+    const double fc = 0.5 * 0.92 * (std::min)(in_rate, out_rate) / (static_cast<double>(in_rate) * up_);
+    const double center = (len - 1) / 2.0;
+    std::vector<double> proto(len);
+    for (size_t n = 0; n < len; n++) {
+      const double x = 2.0 * fc * (n - center);
+      const double sinc = std::abs(x) < 1e-12 ? 1.0 : std::sin(kPi * x) / (kPi * x);
+      const double r = static_cast<double>(n) / (len - 1);
+      proto[n] = 2.0 * fc * sinc * (0.42 - 0.5 * std::cos(2 * kPi * r) + 0.08 * std::cos(4 * kPi * r));
+    }
+    coeffs_.resize(len);
+    for (uint32_t p = 0; p < up_; p++) {
+      double sum = 0;
+      for (uint32_t k = 0; k < taps_; k++) sum += proto[p + k * up_];
+      for (uint32_t k = 0; k < taps_; k++) coeffs_[p * taps_ + k] = proto[p + k * up_] / sum;
+    }
+  }
+
+  uint32_t taps() const { return taps_; }
+
+  // Largest sum of |coefficient| over any phase: the worst-case gain.
+  double MaxL1() const {
+    double worst = 0;
+    for (uint32_t p = 0; p < up_; p++) {
+      double l1 = 0;
+      for (uint32_t k = 0; k < taps_; k++) l1 += std::abs(coeffs_[p * taps_ + k]);
+      worst = (std::max)(worst, l1);
+    }
+    return worst;
+  }
+
+  // Signs of phase 0's taps, newest sample first.
+  std::vector<int> Phase0Signs() const {
+    std::vector<int> signs(taps_);
+    for (uint32_t k = 0; k < taps_; k++) signs[k] = coeffs_[k] < 0 ? -1 : 1;
+    return signs;
+  }
+
+  // Whole-signal resample, unrounded.
+  std::vector<double> Run(const std::vector<int16_t>& in) const {
+    std::vector<double> out;
+    for (uint64_t acc = 0; acc < in.size() * static_cast<uint64_t>(up_); acc += down_) {
+      const size_t i = static_cast<size_t>(acc / up_);
+      const uint32_t phase = static_cast<uint32_t>(acc % up_);
+      double sum = 0;
+      for (uint32_t k = 0; k < taps_ && k <= i; k++) sum += coeffs_[phase * taps_ + k] * in[i - k];
+      out.push_back(sum);
+    }
+    return out;
+  }
+
+ private:
+  uint32_t up_ = 0, down_ = 0, taps_ = 0;
+  std::vector<double> coeffs_;
+};
+
+std::vector<int16_t> Resample(Pcm16Decimator& decimator, const std::vector<int16_t>& in) {
+  std::vector<int16_t> out;
+  decimator.Process(in.data(), in.size(), out);
+  return out;
+}
+
+// A sum of tones and noise at about -6 dBFS: speech-like, never clipping.
+std::vector<int16_t> Program(size_t count, uint32_t rate) {
+  std::vector<int16_t> samples(count);
+  uint32_t state = 12345;
+  for (size_t i = 0; i < count; i++) {
+    state = state * 1664525u + 1013904223u;
+    const double t = static_cast<double>(i) / rate;
+    const double v = 7000 * std::sin(2 * kPi * 220 * t) + 5000 * std::sin(2 * kPi * 1375 * t) +
+                     2000 * std::sin(2 * kPi * 5100 * t) + static_cast<int>(state >> 22) - 512;
+    samples[i] = static_cast<int16_t>(std::lround(v));
+  }
+  return samples;
+}
+
+const uint32_t kInputRates[] = {44100, 48000, 96000};
+
+TEST(Pcm16DecimatorTest, UnityDcGain) {
+  for (uint32_t rate : kInputRates) {
+    SCOPED_TRACE(rate);
+    for (int16_t level : {int16_t{10000}, int16_t{-20000}, int16_t{32767}, int16_t{-32768}}) {
+      Pcm16Decimator decimator(rate, 16000);
+      ASSERT_TRUE(decimator.valid());
+      const std::vector<int16_t> out = Resample(decimator, std::vector<int16_t>(rate / 10, level));
+      ASSERT_GT(out.size(), 100u);
+      // Past the filter's warm-up every output is the input level.
+      for (size_t i = 64; i < out.size(); i++) ASSERT_NEAR(out[i], level, 1) << "at " << i;
+    }
+  }
+}
+
+// The worst case for the int32 accumulator: full-scale samples lined up
+// with every coefficient's sign. The true result is past full scale, so the
+// output must pin to +32767 rather than wrap.
+TEST(Pcm16DecimatorTest, FullScaleSaturatesWithoutWrapping) {
+  for (uint32_t rate : kInputRates) {
+    SCOPED_TRACE(rate);
+    const FloatDecimator reference(rate, 16000);
+    // Q15 products of the worst phase summed must fit int32.
+    ASSERT_LT(reference.MaxL1() * 32768.0 * 32768.0, 2147483647.0);
+    ASSERT_GT(reference.MaxL1(), 1.0);
+
+    // Phase 0's first output lands on input sample 0 and then every
+    // |down| inputs; rebuild the aligned worst case just before one.
+    Pcm16Decimator decimator(rate, 16000);
+    const std::vector<int> signs = reference.Phase0Signs();
+    const uint32_t g = std::gcd(rate, 16000u);
+    const size_t down = rate / g;
+    std::vector<int16_t> in(down * (signs.size() + 1), 0);
+    const size_t newest = down * signs.size();
+    for (size_t k = 0; k < signs.size(); k++) in[newest - k] = static_cast<int16_t>(signs[k] * 32767);
+    const std::vector<int16_t> out = Resample(decimator, in);
+    const size_t up = 16000 / g;
+    ASSERT_GT(out.size(), signs.size() * up);
+    EXPECT_EQ(out[signs.size() * up], 32767);
+
+    // A full-scale square wave overshoots at every edge; nothing wraps.
+    // Tap rounding error scales with level: a few LSB at full scale.
+    Pcm16Decimator square(rate, 16000);
+    std::vector<int16_t> wave(rate / 5);
+    for (size_t i = 0; i < wave.size(); i++) wave[i] = (i / (rate / 400)) % 2 ? -32767 : 32767;
+    const std::vector<int16_t> filtered = Resample(square, wave);
+    const std::vector<double> ideal = reference.Run(wave);
+    ASSERT_EQ(filtered.size(), ideal.size());
+    for (size_t i = 0; i < filtered.size(); i++) {
+      const double clamped = (std::max)(-32768.0, (std::min)(32767.0, ideal[i]));
+      ASSERT_NEAR(filtered[i], std::lround(clamped), 8) << "at " << i;
+    }
+  }
+}
+
+TEST(Pcm16DecimatorTest, PacketSplitInvariance) {
+  for (uint32_t rate : kInputRates) {
+    SCOPED_TRACE(rate);
+    const std::vector<int16_t> in = Program(rate / 4, rate);
+    Pcm16Decimator whole(rate, 16000);
+    const std::vector<int16_t> expected = Resample(whole, in);
+
+    Pcm16Decimator single(rate, 16000);
+    std::vector<int16_t> one_by_one;
+    for (int16_t s : in) single.Process(&s, 1, one_by_one);
+    EXPECT_EQ(one_by_one, expected);
+
+    // WASAPI-like packets of uneven size.
+    Pcm16Decimator packets(rate, 16000);
+    std::vector<int16_t> chunked;
+    for (size_t start = 0, n = 0; start < in.size(); start += n) {
+      n = (std::min)(in.size() - start, size_t{97} + (start % 389));
+      packets.Process(in.data() + start, n, chunked);
+    }
+    EXPECT_EQ(chunked, expected);
+  }
+}
+
+// Silent packets are skipped rather than filtered; the timeline must
+// advance exactly as if the zeros had been processed.
+TEST(Pcm16DecimatorTest, SkipMatchesProcessedSilence) {
+  for (uint32_t rate : {16000u, 44100u, 48000u, 96000u}) {
+    SCOPED_TRACE(rate);
+    Pcm16Decimator skipped(rate, 16000);
+    Pcm16Decimator processed(rate, 16000);
+    const std::vector<int16_t> audio = Program(1000, rate);
+    size_t skipped_total = 0, processed_total = 0;
+    for (size_t n : {size_t{1}, size_t{2}, size_t{3}, size_t{441}, size_t{480}, size_t{1000}, size_t{7}}) {
+      const std::vector<int16_t> zeros(n, 0);
+      std::vector<int16_t> out;
+      const size_t produced = skipped.Skip(n);
+      processed.Process(zeros.data(), n, out);
+      ASSERT_EQ(produced, out.size()) << "packet of " << n;
+      skipped_total += produced;
+      processed_total += out.size();
+
+      // Audio after the silent packet comes out the same either way.
+      std::vector<int16_t> a, b;
+      skipped.Process(audio.data(), audio.size(), a);
+      processed.Process(audio.data(), audio.size(), b);
+      ASSERT_EQ(a, b) << "after a packet of " << n;
+      skipped_total += a.size();
+      processed_total += b.size();
+    }
+    EXPECT_EQ(skipped_total, processed_total);
+  }
+}
+
+// Q15 coefficients and int32 accumulation against the same filter in
+// double precision, on programme material.
+TEST(Pcm16DecimatorTest, AgreesWithFloatFilter) {
+  for (uint32_t rate : kInputRates) {
+    SCOPED_TRACE(rate);
+    const std::vector<int16_t> in = Program(rate / 2, rate);
+    Pcm16Decimator decimator(rate, 16000);
+    const std::vector<int16_t> fixed = Resample(decimator, in);
+    const std::vector<double> ideal = FloatDecimator(rate, 16000).Run(in);
+    ASSERT_EQ(fixed.size(), ideal.size());
+    // The float path rounds to PCM16 too; Q15 tap rounding may move an
+    // output at most one step from it.
+    for (size_t i = 0; i < fixed.size(); i++) ASSERT_NEAR(fixed[i], std::lround(ideal[i]), 1) << "at " << i;
+  }
+}
+
+TEST(Pcm16DecimatorTest, SameRateIsPassthrough) {
+  Pcm16Decimator decimator(16000, 16000);
+  ASSERT_TRUE(decimator.valid());
+  const std::vector<int16_t> in = Program(500, 16000);
+  EXPECT_EQ(Resample(decimator, in), in);
+  EXPECT_EQ(decimator.Skip(123), 123u);
+  EXPECT_FALSE(Pcm16Decimator(0, 16000).valid());
+}
+
+// The float path's PCM16 downmix (ToMonoFloat, then FloatToPcm16's scale
+// by 32767 and truncation), for comparison.
+int16_t FloatDownmix(const int16_t* frame, uint16_t channels) {
+  int32_t sum = 0;
+  for (uint16_t ch = 0; ch < channels; ch++) sum += frame[ch];
+  const float avg = static_cast<float>(sum) / static_cast<float>(channels) / 32768.0f;
+  const float scaled = (std::max)(-1.0f, (std::min)(1.0f, avg)) * 32767.0f;
+  return static_cast<int16_t>(scaled);
+}
+
+TEST(DownmixPcm16Test, AgreesWithFloatPath) {
+  for (uint16_t channels : {uint16_t{1}, uint16_t{2}, uint16_t{6}, uint16_t{8}}) {
+    SCOPED_TRACE(channels);
+    const size_t frames = 4096;
+    std::vector<int16_t> in(frames * channels);
+    uint32_t state = channels;
+    for (auto& s : in) {
+      state = state * 1664525u + 1013904223u;
+      s = static_cast<int16_t>(state >> 16);
+    }
+    // Full-scale frames too.
+    std::fill(in.begin(), in.begin() + channels, int16_t{32767});
+    std::fill(in.begin() + channels, in.begin() + 2 * channels, int16_t{-32768});
+    std::vector<int16_t> out(frames);
+    DownmixPcm16ToMono(in.data(), frames, channels, out.data());
+    EXPECT_EQ(out[0], 32767);
+    EXPECT_EQ(out[1], -32768);
+    for (size_t i = 0; i < frames; i++) {
+      ASSERT_NEAR(out[i], FloatDownmix(in.data() + i * channels, channels), 1) << "frame " << i;
+    }
+  }
+}
+
+}  // namespace
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "perceptual_hash.h"
+
+namespace {
+
+constexpr int kWidth = 640;
+constexpr int kHeight = 400;
+// captureForUpload's default similarityThreshold.
+constexpr int kThreshold = 4;
+
+uint32_t Next(uint32_t& state) {
+  state = state * 1664525u + 1013904223u;
+  return state >> 8;
+}
+
+// A desktop-like scene: a gradient wallpaper with |seed|-placed windows.
+// |dx| shifts the whole scene right.
+std::vector<uint8_t> Scene(uint32_t seed, int dx = 0) {
+  std::vector<uint8_t> bgra(static_cast<size_t>(kWidth) * kHeight * 4);
+  for (int y = 0; y < kHeight; y++) {
+    for (int x = 0; x < kWidth; x++) {
+      uint8_t* p = bgra.data() + (static_cast<size_t>(y) * kWidth + x) * 4;
+      p[0] = static_cast<uint8_t>(60 + y * 120 / kHeight);
+      p[1] = static_cast<uint8_t>(40 + (x - dx) * 60 / kWidth);
+      p[2] = 30;
+      p[3] = 255;
+    }
+  }
+  uint32_t state = seed;
+  for (int i = 0; i < 6; i++) {
+    const int w = 80 + static_cast<int>(Next(state) % 240);
+    const int h = 60 + static_cast<int>(Next(state) % 160);
+    const int left = static_cast<int>(Next(state) % (kWidth - w)) + dx;
+    const int top = static_cast<int>(Next(state) % (kHeight - h));
+    const uint8_t shade = static_cast<uint8_t>(Next(state) % 256);
+    for (int y = top; y < top + h; y++) {
+      for (int x = (std::max)(left, 0); x < (std::min)(left + w, kWidth); x++) {
+        uint8_t* p = bgra.data() + (static_cast<size_t>(y) * kWidth + x) * 4;
+        p[0] = p[1] = p[2] = shade;
+      }
+    }
+  }
+  return bgra;
+}
+
+// +-3 per channel, as from a re-rendered or dithered frame.
+std::vector<uint8_t> WithNoise(std::vector<uint8_t> bgra) {
+  uint32_t state = 99;
+  for (size_t i = 0; i < bgra.size(); i += 4) {
+    for (size_t c = 0; c < 3; c++) {
+      const int v = bgra[i + c] + static_cast<int>(Next(state) % 7) - 3;
+      bgra[i + c] = static_cast<uint8_t>((std::min)((std::max)(v, 0), 255));
+    }
+  }
+  return bgra;
+}
+
+ImageFingerprint Fingerprint(const std::vector<uint8_t>& bgra) {
+  ImageFingerprint fp;
+  EXPECT_TRUE(ComputeFingerprint(bgra.data(), kWidth, kHeight, 0, fp));
+  return fp;
+}
+
+TEST(PerceptualHashTest, NearIdenticalImagesShareAnId) {
+  const std::vector<uint8_t> original = Scene(1);
+  const std::vector<uint8_t> noisy = WithNoise(original);
+  const std::vector<uint8_t> shifted = Scene(1, 1);
+
+  RecentImageIndex index(4, 4);
+  const uint64_t id = index.Add("screen", Fingerprint(original));
+  EXPECT_NE(id, 0u);
+  for (const auto* image : {&original, &noisy, &shifted}) {
+    const RecentImageIndex::Match match = index.Find("screen", Fingerprint(*image), kThreshold, nullptr);
+    EXPECT_EQ(match.image_id, id);
+    EXPECT_LE(match.distance, kThreshold);
+  }
+  EXPECT_EQ(index.Find("screen", Fingerprint(original), kThreshold, nullptr).distance, 0);
+}
+
+TEST(PerceptualHashTest, DifferentImageGetsANewId) {
+  const ImageFingerprint a = Fingerprint(Scene(1));
+  const ImageFingerprint b = Fingerprint(Scene(2));
+  EXPECT_GT(FingerprintDistance(a, b), kThreshold);
+
+  RecentImageIndex index(4, 4);
+  const uint64_t first = index.Add("screen", a);
+  EXPECT_EQ(index.Find("screen", b, kThreshold, nullptr).image_id, 0u);
+  const uint64_t second = index.Add("screen", b);
+  EXPECT_NE(second, first);
+  // Matches are per target and limited to ids the caller still has.
+  EXPECT_EQ(index.Find("other", a, kThreshold, nullptr).image_id, 0u);
+  const std::vector<uint64_t> known = {second};
+  EXPECT_EQ(index.Find("screen", a, kThreshold, &known).image_id, 0u);
+  EXPECT_EQ(index.Find("screen", b, kThreshold, &known).image_id, second);
+
+  // Different source sizes never match.
+  ImageFingerprint resized = a;
+  resized.width++;
+  EXPECT_EQ(FingerprintDistance(a, resized), -1);
+  EXPECT_EQ(index.Find("screen", resized, 64, nullptr).image_id, 0u);
+}
+
+TEST(PerceptualHashTest, EvictsLeastRecentlyUsedAtTheBound) {
+  std::vector<ImageFingerprint> images;
+  for (uint32_t seed = 1; seed <= 4; seed++) images.push_back(Fingerprint(Scene(seed)));
+
+  RecentImageIndex index(2, 2);
+  const uint64_t id0 = index.Add("screen", images[0]);
+  index.Add("screen", images[1]);
+  // A match counts as a use, so images[1] is now the oldest.
+  EXPECT_EQ(index.Find("screen", images[0], kThreshold, nullptr).image_id, id0);
+  index.Add("screen", images[2]);
+  EXPECT_EQ(index.Find("screen", images[1], kThreshold, nullptr).image_id, 0u);
+  EXPECT_EQ(index.Find("screen", images[0], kThreshold, nullptr).image_id, id0);
+
+  // A third target drops the least recently used one.
+  index.Add("window:1", images[3]);
+  EXPECT_EQ(index.Find("screen", images[0], kThreshold, nullptr).image_id, id0);
+  index.Add("window:2", images[3]);
+  EXPECT_EQ(index.Find("window:1", images[3], kThreshold, nullptr).image_id, 0u);
+  EXPECT_EQ(index.Find("screen", images[0], kThreshold, nullptr).image_id, id0);
+}
+
+// Ids survive other images' eviction and are never handed out twice, even
+// after Clear().
+TEST(PerceptualHashTest, IdsAreStableAcrossEvictions) {
+  RecentImageIndex index(3, 1);
+  std::set<uint64_t> issued;
+  std::vector<std::pair<uint64_t, ImageFingerprint>> live;
+  for (uint32_t seed = 1; seed <= 8; seed++) {
+    const ImageFingerprint fp = Fingerprint(Scene(seed));
+    const uint64_t id = index.Add("screen", fp);
+    EXPECT_TRUE(issued.insert(id).second) << id;
+    live.emplace_back(id, fp);
+    if (live.size() > 3) live.erase(live.begin());
+    for (const auto& entry : live) {
+      EXPECT_EQ(index.Find("screen", entry.second, 0, nullptr).image_id, entry.first) << seed;
+    }
+  }
+  index.Clear();
+  EXPECT_EQ(index.Find("screen", live.back().second, kThreshold, nullptr).image_id, 0u);
+  EXPECT_TRUE(issued.insert(index.Add("screen", live.back().second)).second);
+}
+
+}  // namespace
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "pixel_buffer_pool.h"
+
+namespace {
+
+TEST(PixelBufferPoolTest, SizeClassesRoundUpByAtMostAQuarter) {
+  EXPECT_EQ(PixelBufferPool::SizeClass(1), PixelBufferPool::kMinPooledBytes);
+  EXPECT_EQ(PixelBufferPool::SizeClass(PixelBufferPool::kMinPooledBytes), PixelBufferPool::kMinPooledBytes);
+  // Four classes per power of two.
+  EXPECT_EQ(PixelBufferPool::SizeClass(65537), 81920u);
+  EXPECT_EQ(PixelBufferPool::SizeClass(81920), 81920u);
+  EXPECT_EQ(PixelBufferPool::SizeClass(131072), 131072u);
+  EXPECT_EQ(PixelBufferPool::SizeClass(131073), 163840u);
+  // 1080p and 4K BGRA, and a slightly shorter 4K capture sharing its class.
+  EXPECT_EQ(PixelBufferPool::SizeClass(1920u * 1080 * 4), 8388608u);
+  EXPECT_EQ(PixelBufferPool::SizeClass(3840u * 2160 * 4), 33554432u);
+  EXPECT_EQ(PixelBufferPool::SizeClass(3840u * 2100 * 4), 33554432u);
+
+  for (size_t size = 65536; size < (size_t{1} << 26); size = size * 9 / 8 + 7) {
+    const size_t size_class = PixelBufferPool::SizeClass(size);
+    ASSERT_GE(size_class, size);
+    ASSERT_LE(size_class - size, size / 4) << size;
+    ASSERT_EQ(PixelBufferPool::SizeClass(size_class), size_class) << size;
+  }
+}
+
+TEST(PixelBufferPoolTest, ReusesBuffersWithinAClass) {
+  PixelBufferPool pool(1 << 24);
+  std::vector<uint8_t> a = pool.Acquire(100000);  // Class 114688.
+  ASSERT_EQ(a.size(), 100000u);
+  EXPECT_GE(a.capacity(), 114688u);
+  const uint8_t* storage = a.data();
+  pool.Release(std::move(a));
+  EXPECT_TRUE(a.empty());
+
+  std::vector<uint8_t> b = pool.Acquire(110000);
+  EXPECT_EQ(b.data(), storage);
+  EXPECT_EQ(b.size(), 110000u);
+  std::vector<uint8_t> c = pool.Acquire(120000);  // Class 131072: a miss.
+  EXPECT_NE(c.data(), storage);
+
+  PixelBufferPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(stats.acquires, 3u);
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.releases, 1u);
+  EXPECT_EQ(stats.pooled_buffers, 0u);
+
+  // Reserve keeps a buffer that is big enough and swaps one that is not.
+  pool.Release(std::move(c));
+  std::vector<uint8_t> small(10);
+  pool.Reserve(small, 125000);
+  EXPECT_EQ(small.size(), 125000u);
+  EXPECT_EQ(pool.GetStats().hits, 2u);
+  const uint8_t* kept = small.data();
+  pool.Reserve(small, 90000);
+  EXPECT_EQ(small.data(), kept);
+
+  // Small buffers, like the one Reserve just swapped out, stay with the heap.
+  EXPECT_EQ(pool.GetStats().evictions, 1u);
+  std::vector<uint8_t> tiny = pool.Acquire(1000);
+  pool.Release(std::move(tiny));
+  stats = pool.GetStats();
+  EXPECT_EQ(stats.acquires, 4u);
+  EXPECT_EQ(stats.pooled_buffers, 0u);
+  EXPECT_EQ(stats.evictions, 2u);
+}
+
+TEST(PixelBufferPoolTest, CapEvictsLeastRecentlyReleased) {
+  PixelBufferPool pool(400000);
+  std::vector<uint8_t> a = pool.Acquire(131072);
+  std::vector<uint8_t> b = pool.Acquire(131072);
+  std::vector<uint8_t> c = pool.Acquire(196608);
+  const uint8_t* b_storage = b.data();
+  const uint8_t* c_storage = c.data();
+  pool.Release(std::move(a));
+  pool.Release(std::move(b));
+  // 131072 * 2 + 196608 > 400000: |a|, released first, goes.
+  pool.Release(std::move(c));
+
+  PixelBufferPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(stats.pooled_buffers, 2u);
+  EXPECT_EQ(stats.pooled_bytes, 131072u + 196608u);
+  EXPECT_EQ(stats.high_water_bytes, 131072u + 196608u);
+  EXPECT_EQ(stats.evictions, 1u);
+  EXPECT_EQ(pool.Acquire(131072).data(), b_storage);
+  std::vector<uint8_t> again = pool.Acquire(196608);
+  EXPECT_EQ(again.data(), c_storage);
+  EXPECT_EQ(pool.GetStats().hits, 2u);
+
+  // Larger than the cap: never pooled.
+  pool.Release(std::vector<uint8_t>(500000));
+  EXPECT_EQ(pool.GetStats().evictions, 2u);
+  EXPECT_EQ(pool.GetStats().pooled_buffers, 0u);
+
+  // Lowering the cap and trimming free idle buffers.
+  pool.Release(std::move(again));
+  pool.Release(pool.Acquire(70000));
+  EXPECT_EQ(pool.GetStats().pooled_buffers, 2u);
+  pool.SetMaxBytes(100000);
+  stats = pool.GetStats();
+  EXPECT_EQ(stats.pooled_buffers, 1u);
+  EXPECT_LE(stats.pooled_bytes, 100000u);
+  EXPECT_EQ(stats.max_bytes, 100000u);
+  pool.Trim();
+  stats = pool.GetStats();
+  EXPECT_EQ(stats.pooled_buffers, 0u);
+  EXPECT_EQ(stats.pooled_bytes, 0u);
+  EXPECT_EQ(stats.high_water_bytes, 131072u + 196608u);
+}
+
+}  // namespace
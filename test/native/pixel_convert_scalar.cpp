@@ -0,0 +1,13 @@
+// The runner's pixel_convert.cpp with its SIMD paths compiled out, wrapped
+// in namespace scalar so it links beside the real one. Standard headers
+// come first so the wrapped file's own includes are no-ops.
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "pixel_convert_scalar.h"
+
+#define PIXEL_CONVERT_NO_SIMD 1
+namespace scalar {
+#include "pixel_convert.cpp"
+}  // namespace scalar
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// pixel_convert.cpp built again with PIXEL_CONVERT_NO_SIMD, so the tests
+// can hold the SSE2 paths to the scalar ones in the same binary. Same
+// contracts as pixel_convert.h.
+namespace scalar {
+
+void SwapRedBlue(const uint8_t* src, uint8_t* dst, size_t count);
+void SwapRedBlueOpaque(const uint8_t* src, uint8_t* dst, size_t count);
+void SetOpaque(const uint8_t* src, uint8_t* dst, size_t count);
+void PremultiplyAlpha(const uint8_t* src, uint8_t* dst, size_t count);
+void UnpremultiplyAlpha(const uint8_t* src, uint8_t* dst, size_t count);
+void BgraToGray(const uint8_t* src, uint8_t* dst, size_t count);
+void BgraToRgb565(const uint8_t* src, uint8_t* dst, size_t count);
+void BgraToRgb24(const uint8_t* src, uint8_t* dst, size_t count);
+void BgraToBgr24(const uint8_t* src, uint8_t* dst, size_t count);
+
+}  // namespace scalar
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "pixel_convert.h"
+#include "pixel_convert_scalar.h"
+
+namespace {
+
+using Convert = void (*)(const uint8_t* src, uint8_t* dst, size_t count);
+
+struct Conversion {
+  const char* name;
+  Convert simd;
+  Convert scalar;
+  size_t dst_bytes_per_pixel;
+};
+
+const Conversion kConversions[] = {
+    {"SwapRedBlue", SwapRedBlue, scalar::SwapRedBlue, 4},
+    {"SwapRedBlueOpaque", SwapRedBlueOpaque, scalar::SwapRedBlueOpaque, 4},
+    {"SetOpaque", SetOpaque, scalar::SetOpaque, 4},
+    {"PremultiplyAlpha", PremultiplyAlpha, scalar::PremultiplyAlpha, 4},
+    {"UnpremultiplyAlpha", UnpremultiplyAlpha, scalar::UnpremultiplyAlpha, 4},
+    {"BgraToGray", BgraToGray, scalar::BgraToGray, 1},
+    {"BgraToRgb565", BgraToRgb565, scalar::BgraToRgb565, 2},
+    {"BgraToRgb24", BgraToRgb24, scalar::BgraToRgb24, 3},
+    {"BgraToBgr24", BgraToBgr24, scalar::BgraToBgr24, 3},
+};
+
+// Random channels, with every fourth pixel's alpha pinned to 0 or 255 so
+// the premultiply paths see their special cases.
+std::vector<uint8_t> Pixels(size_t count, uint32_t seed) {
+  std::vector<uint8_t> px(count * 4);
+  uint32_t state = seed;
+  for (size_t i = 0; i < px.size(); i++) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    px[i] = static_cast<uint8_t>(state >> 24);
+  }
+  for (size_t i = 0; i < count; i += 4) px[i * 4 + 3] = (i / 4) % 2 ? 255 : 0;
+  return px;
+}
+
+// Every count up to a few vector widths, so each SSE2 loop runs zero, one
+// and several times with every possible scalar tail, plus a long odd run.
+std::vector<size_t> Counts() {
+  std::vector<size_t> counts;
+  for (size_t n = 0; n <= 40; n++) counts.push_back(n);
+  counts.push_back(1021);
+  return counts;
+}
+
+TEST(PixelConvertTest, SimdMatchesScalar) {
+  for (const Conversion& c : kConversions) {
+    SCOPED_TRACE(c.name);
+    for (size_t count : Counts()) {
+      SCOPED_TRACE(count);
+      const std::vector<uint8_t> src = Pixels(count, static_cast<uint32_t>(count * 2654435761u + 1));
+      std::vector<uint8_t> simd(count * c.dst_bytes_per_pixel + 16, 0xab);
+      std::vector<uint8_t> ref(simd.size(), 0xab);
+      c.simd(src.data(), simd.data(), count);
+      c.scalar(src.data(), ref.data(), count);
+      // Includes the guard bytes: nothing is written past the output.
+      ASSERT_EQ(simd, ref);
+    }
+  }
+}
+
+// Misaligned source and destination (one pixel off a 16-byte boundary).
+TEST(PixelConvertTest, SimdMatchesScalarUnaligned) {
+  const size_t count = 77;
+  const std::vector<uint8_t> backing = Pixels(count + 1, 99);
+  for (const Conversion& c : kConversions) {
+    SCOPED_TRACE(c.name);
+    std::vector<uint8_t> simd(count * c.dst_bytes_per_pixel + 8, 0);
+    std::vector<uint8_t> ref(simd.size(), 0);
+    c.simd(backing.data() + 4, simd.data() + 4, count);
+    c.scalar(backing.data() + 4, ref.data() + 4, count);
+    ASSERT_EQ(simd, ref);
+  }
+}
+
+// dst == src, as the pooled capture buffers are converted.
+TEST(PixelConvertTest, InPlaceMatchesScalar) {
+  for (const Conversion& c : kConversions) {
+    SCOPED_TRACE(c.name);
+    for (size_t count : {size_t{7}, size_t{8}, size_t{35}, size_t{1021}}) {
+      SCOPED_TRACE(count);
+      std::vector<uint8_t> simd = Pixels(count, 7);
+      std::vector<uint8_t> ref = simd;
+      c.simd(simd.data(), simd.data(), count);
+      c.scalar(ref.data(), ref.data(), count);
+      simd.resize(count * c.dst_bytes_per_pixel);
+      ref.resize(count * c.dst_bytes_per_pixel);
+      ASSERT_EQ(simd, ref);
+    }
+  }
+}
+
+// The documented arithmetic, for every alpha and a spread of values.
+TEST(PixelConvertTest, PremultiplyRoundsToNearest) {
+  std::vector<uint8_t> px;
+  for (int a = 0; a < 256; a++) {
+    for (int v = 0; v < 256; v += 5) px.insert(px.end(), {uint8_t(v), uint8_t(255 - v), uint8_t(v / 2), uint8_t(a)});
+  }
+  const size_t count = px.size() / 4;
+  std::vector<uint8_t> pre(px.size());
+  PremultiplyAlpha(px.data(), pre.data(), count);
+  std::vector<uint8_t> back(px.size());
+  UnpremultiplyAlpha(pre.data(), back.data(), count);
+  for (size_t i = 0; i < count; i++) {
+    const unsigned a = px[i * 4 + 3];
+    ASSERT_EQ(pre[i * 4 + 3], a);
+    ASSERT_EQ(back[i * 4 + 3], a);
+    for (int c = 0; c < 3; c++) {
+      const unsigned v = px[i * 4 + c];
+      ASSERT_EQ(pre[i * 4 + c], (v * a * 2 + 255) / 510) << "v=" << v << " a=" << a;
+      if (a == 0) {
+        ASSERT_EQ(back[i * 4 + c], 0);
+      } else {
+        // Premultiplying loses precision below 255 levels of alpha.
+        ASSERT_NEAR(back[i * 4 + c], v, 255.0 / a / 2 + 1) << "v=" << v << " a=" << a;
+      }
+    }
+  }
+}
+
+TEST(PixelConvertTest, PackedFormatsMatchSpec) {
+  const uint8_t px[] = {0x12, 0x9c, 0xf7, 0x40};  // B G R A
+  uint8_t gray = 0;
+  BgraToGray(px, &gray, 1);
+  EXPECT_EQ(gray, (29 * 0x12 + 150 * 0x9c + 77 * 0xf7 + 128) >> 8);
+  uint8_t rgb565[2];
+  BgraToRgb565(px, rgb565, 1);
+  const unsigned word = ((0xf7 & 0xf8) << 8) | ((0x9c & 0xfc) << 3) | (0x12 >> 3);
+  EXPECT_EQ(rgb565[0], word & 0xff);
+  EXPECT_EQ(rgb565[1], word >> 8);
+  uint8_t rgb[3], bgr[3];
+  BgraToRgb24(px, rgb, 1);
+  BgraToBgr24(px, bgr, 1);
+  EXPECT_EQ(std::memcmp(rgb, "\xf7\x9c\x12", 3), 0);
+  EXPECT_EQ(std::memcmp(bgr, "\x12\x9c\xf7", 3), 0);
+}
+
+}  // namespace
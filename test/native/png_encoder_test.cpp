@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "png_encoder.h"
+#include "reference_codecs.h"
+
+namespace {
+
+void ExpectRoundTrip(const std::vector<uint8_t>& bgra, int width, int height, size_t stride,
+                     const PngOptions& options) {
+  std::vector<uint8_t> png;
+  ASSERT_TRUE(EncodePngBgra(bgra.data(), width, height, stride, options, png));
+  int w = 0, h = 0;
+  std::vector<uint8_t> rgb;
+  ASSERT_TRUE(DecodePngRgb(png, w, h, rgb)) << width << "x" << height;
+  EXPECT_EQ(w, width);
+  EXPECT_EQ(h, height);
+  EXPECT_EQ(rgb, BgraToRgb(bgra.data(), width, height, stride)) << width << "x" << height;
+}
+
+TEST(PngEncoderTest, RoundTripsOddSizesWithEveryPreset) {
+  const int sizes[][2] = {{1, 1}, {3, 2}, {17, 13}, {333, 77}, {1, 200}, {200, 1}};
+  for (PngPreset preset : {PngPreset::kFast, PngPreset::kBalanced, PngPreset::kSmallest}) {
+    for (const auto& size : sizes) {
+      const std::vector<uint8_t> bgra = SyntheticScreen(size[0], size[1], 5);
+      ExpectRoundTrip(bgra, size[0], size[1], 0, PngPresetOptions(preset));
+    }
+  }
+}
+
+TEST(PngEncoderTest, HonoursStride) {
+  const int width = 37, height = 21;
+  const size_t stride = width * 4 + 12;
+  const std::vector<uint8_t> packed = SyntheticScreen(width, height, 2);
+  std::vector<uint8_t> padded(stride * height, 0xAB);
+  for (int y = 0; y < height; y++) {
+    std::copy(packed.begin() + y * width * 4, packed.begin() + (y + 1) * width * 4,
+              padded.begin() + y * stride);
+  }
+  ExpectRoundTrip(padded, width, height, stride, PngOptions());
+}
+
+TEST(PngEncoderTest, IgnoresAlpha) {
+  std::vector<uint8_t> bgra = SyntheticScreen(16, 16, 4);
+  std::vector<uint8_t> opaque, transparent;
+  ASSERT_TRUE(EncodePngBgra(bgra.data(), 16, 16, 0, PngOptions(), opaque));
+  for (size_t i = 3; i < bgra.size(); i += 4) bgra[i] = static_cast<uint8_t>(i);
+  ASSERT_TRUE(EncodePngBgra(bgra.data(), 16, 16, 0, PngOptions(), transparent));
+  EXPECT_EQ(opaque, transparent);
+}
+
+// A frame big enough for many 512 KiB segments: each is its own IDAT, the
+// concatenated stream inflates to the original pixels, and the bytes don't
+// change with the thread count.
+TEST(PngEncoderTest, SegmentedStreamRoundTripsForAnyThreadCount) {
+  const int width = 1280, height = 720;
+  const std::vector<uint8_t> bgra = SyntheticScreen(width, height, 6);
+  const std::vector<uint8_t> rgb_expected = BgraToRgb(bgra.data(), width, height);
+  for (PngPreset preset : {PngPreset::kFast, PngPreset::kBalanced}) {
+    std::vector<uint8_t> reference;
+    for (int threads : {1, 3, 0}) {
+      PngOptions options = PngPresetOptions(preset);
+      options.threads = threads;
+      std::vector<uint8_t> png;
+      ASSERT_TRUE(EncodePngBgra(bgra.data(), width, height, 0, options, png));
+      int w = 0, h = 0;
+      std::vector<uint8_t> rgb;
+      size_t idat_chunks = 0;
+      ASSERT_TRUE(DecodePngRgb(png, w, h, rgb, &idat_chunks)) << "threads " << threads;
+      // Filtered rows are 3841 bytes, about 2.6 MiB in all.
+      EXPECT_GE(idat_chunks, 5u) << "threads " << threads;
+      ASSERT_EQ(rgb, rgb_expected) << "threads " << threads;
+      if (reference.empty()) {
+        reference = png;
+      } else {
+        EXPECT_EQ(png, reference) << "threads " << threads;
+      }
+    }
+  }
+}
+
+TEST(PngEncoderTest, RejectsBadInput) {
+  std::vector<uint8_t> png;
+  const uint8_t pixel[4] = {};
+  EXPECT_FALSE(EncodePngBgra(nullptr, 1, 1, 0, PngOptions(), png));
+  EXPECT_FALSE(EncodePngBgra(pixel, 0, 1, 0, PngOptions(), png));
+  EXPECT_FALSE(EncodePngBgra(pixel, 1, 0, 0, PngOptions(), png));
+}
+
+}  // namespace
@@ -0,0 +1,247 @@
+#include "reference_codecs.h"
+
+#include <csetjmp>
+#include <cstdio>  // before jpeglib.h, which needs FILE
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <jpeglib.h>
+#include <zlib.h>
+
+namespace {
+
+uint32_t ReadU32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+uint8_t Paeth(int a, int b, int c) {
+  const int p = a + b - c;
+  const int pa = std::abs(p - a);
+  const int pb = std::abs(p - b);
+  const int pc = std::abs(p - c);
+  if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+  if (pb <= pc) return static_cast<uint8_t>(b);
+  return static_cast<uint8_t>(c);
+}
+
+struct JpegError {
+  jpeg_error_mgr mgr;
+  jmp_buf jump;
+};
+
+void OnJpegError(j_common_ptr cinfo) {
+  longjmp(reinterpret_cast<JpegError*>(cinfo->err)->jump, 1);
+}
+
+// xorshift32: small, fast and the same everywhere.
+uint32_t NextRandom(uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+}  // namespace
+
+bool InflateZlib(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+  out.clear();
+  z_stream zs;
+  std::memset(&zs, 0, sizeof(zs));
+  if (inflateInit(&zs) != Z_OK) return false;
+  zs.next_in = const_cast<Bytef*>(data);
+  zs.avail_in = static_cast<uInt>(size);
+  uint8_t buffer[65536];
+  int status = Z_OK;
+  while (status == Z_OK) {
+    zs.next_out = buffer;
+    zs.avail_out = sizeof(buffer);
+    status = inflate(&zs, Z_NO_FLUSH);
+    out.insert(out.end(), buffer, buffer + (sizeof(buffer) - zs.avail_out));
+    if (status == Z_BUF_ERROR && zs.avail_in == 0) break;
+  }
+  const bool ok = status == Z_STREAM_END && zs.avail_in == 0;
+  inflateEnd(&zs);
+  return ok;
+}
+
+bool DecodePngRgb(const std::vector<uint8_t>& png,
+                  int& width,
+                  int& height,
+                  std::vector<uint8_t>& rgb,
+                  size_t* idat_chunks) {
+  static const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  if (png.size() < 8 || std::memcmp(png.data(), kSignature, 8) != 0) return false;
+  std::vector<uint8_t> idat;
+  size_t idats = 0;
+  bool seen_header = false;
+  bool seen_end = false;
+  size_t pos = 8;
+  while (pos + 12 <= png.size() && !seen_end) {
+    const size_t length = ReadU32(&png[pos]);
+    if (pos + 12 + length > png.size()) return false;
+    const uint8_t* type = &png[pos + 4];
+    const uint8_t* body = &png[pos + 8];
+    const uint32_t crc = static_cast<uint32_t>(crc32(0, type, static_cast<uInt>(length + 4)));
+    if (crc != ReadU32(body + length)) return false;
+    if (std::memcmp(type, "IHDR", 4) == 0) {
+      if (length != 13) return false;
+      width = static_cast<int>(ReadU32(body));
+      height = static_cast<int>(ReadU32(body + 4));
+      // 8-bit truecolor, deflate, adaptive filtering, no interlace.
+      if (body[8] != 8 || body[9] != 2 || body[10] != 0 || body[11] != 0 || body[12] != 0) {
+        return false;
+      }
+      seen_header = true;
+    } else if (std::memcmp(type, "IDAT", 4) == 0) {
+      idat.insert(idat.end(), body, body + length);
+      idats++;
+    } else if (std::memcmp(type, "IEND", 4) == 0) {
+      seen_end = true;
+    }
+    pos += 12 + length;
+  }
+  if (!seen_header || !seen_end || pos != png.size() || width <= 0 || height <= 0) return false;
+  if (idat_chunks) *idat_chunks = idats;
+
+  std::vector<uint8_t> filtered;
+  if (!InflateZlib(idat.data(), idat.size(), filtered)) return false;
+  const size_t row_bytes = static_cast<size_t>(width) * 3;
+  if (filtered.size() != (row_bytes + 1) * static_cast<size_t>(height)) return false;
+
+  rgb.assign(row_bytes * static_cast<size_t>(height), 0);
+  for (int y = 0; y < height; y++) {
+    const uint8_t filter = filtered[static_cast<size_t>(y) * (row_bytes + 1)];
+    const uint8_t* in = &filtered[static_cast<size_t>(y) * (row_bytes + 1) + 1];
+    uint8_t* row = &rgb[static_cast<size_t>(y) * row_bytes];
+    const uint8_t* up = y > 0 ? row - row_bytes : nullptr;
+    for (size_t i = 0; i < row_bytes; i++) {
+      const int a = i >= 3 ? row[i - 3] : 0;
+      const int b = up ? up[i] : 0;
+      const int c = up && i >= 3 ? up[i - 3] : 0;
+      int predictor = 0;
+      switch (filter) {
+        case 0: predictor = 0; break;
+        case 1: predictor = a; break;
+        case 2: predictor = b; break;
+        case 3: predictor = (a + b) / 2; break;
+        case 4: predictor = Paeth(a, b, c); break;
+        default: return false;
+      }
+      row[i] = static_cast<uint8_t>(in[i] + predictor);
+    }
+  }
+  return true;
+}
+
+bool DecodeJpegRgb(const std::vector<uint8_t>& jpeg, int& width, int& height, std::vector<uint8_t>& rgb) {
+  jpeg_decompress_struct cinfo;
+  JpegError error;
+  cinfo.err = jpeg_std_error(&error.mgr);
+  error.mgr.error_exit = OnJpegError;
+  if (setjmp(error.jump)) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo, const_cast<unsigned char*>(jpeg.data()), static_cast<unsigned long>(jpeg.size()));
+  if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  cinfo.out_color_space = JCS_RGB;
+  jpeg_start_decompress(&cinfo);
+  width = static_cast<int>(cinfo.output_width);
+  height = static_cast<int>(cinfo.output_height);
+  const size_t row_bytes = static_cast<size_t>(width) * 3;
+  rgb.assign(row_bytes * static_cast<size_t>(height), 0);
+  while (cinfo.output_scanline < cinfo.output_height) {
+    JSAMPROW row = &rgb[cinfo.output_scanline * row_bytes];
+    jpeg_read_scanlines(&cinfo, &row, 1);
+  }
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  return true;
+}
+
+std::vector<uint8_t> ReadPngBgra(const std::string& path, int& width, int& height) {
+  std::ifstream file(path, std::ios::binary);
+  const std::vector<uint8_t> png((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  std::vector<uint8_t> rgb;
+  if (!DecodePngRgb(png, width, height, rgb)) return {};
+  std::vector<uint8_t> bgra(static_cast<size_t>(width) * height * 4);
+  for (size_t i = 0, j = 0; i < rgb.size(); i += 3, j += 4) {
+    bgra[j] = rgb[i + 2];
+    bgra[j + 1] = rgb[i + 1];
+    bgra[j + 2] = rgb[i];
+    bgra[j + 3] = 255;
+  }
+  return bgra;
+}
+
+void PasteBgra(std::vector<uint8_t>& dst, int dst_width, const std::vector<uint8_t>& src, int width, int height,
+               int x, int y) {
+  const size_t row_bytes = static_cast<size_t>(width) * 4;
+  for (int row = 0; row < height; row++) {
+    std::memcpy(dst.data() + (static_cast<size_t>(y + row) * dst_width + x) * 4, src.data() + row * row_bytes,
+                row_bytes);
+  }
+}
+
+std::vector<uint8_t> BgraToRgb(const uint8_t* bgra, int width, int height, size_t stride) {
+  if (stride == 0) stride = static_cast<size_t>(width) * 4;
+  std::vector<uint8_t> rgb;
+  rgb.reserve(static_cast<size_t>(width) * height * 3);
+  for (int y = 0; y < height; y++) {
+    const uint8_t* p = bgra + static_cast<size_t>(y) * stride;
+    for (int x = 0; x < width; x++, p += 4) {
+      rgb.push_back(p[2]);
+      rgb.push_back(p[1]);
+      rgb.push_back(p[0]);
+    }
+  }
+  return rgb;
+}
+
+std::vector<uint8_t> SyntheticScreen(int width, int height, uint32_t seed) {
+  uint32_t state = seed ? seed : 1;
+  std::vector<uint8_t> bgra(static_cast<size_t>(width) * height * 4);
+  const int title_bar = height / 20 + 1;
+  for (int y = 0; y < height; y++) {
+    // Every few rows in the body is a line of "text": dark glyph-like runs.
+    const bool text_row = y > title_bar && (y / 4) % 5 == 1;
+    for (int x = 0; x < width; x++) {
+      uint8_t* p = &bgra[(static_cast<size_t>(y) * width + x) * 4];
+      uint8_t r, g, b;
+      if (y < title_bar) {
+        r = 32; g = 48; b = 96;
+      } else if (x < width / 5) {
+        r = g = b = 240;  // side panel
+      } else if (text_row && (NextRandom(state) & 3) != 0) {
+        const uint8_t ink = static_cast<uint8_t>(20 + (NextRandom(state) & 63));
+        r = g = b = ink;
+      } else if (y > height * 3 / 4) {
+        // A photo-ish gradient strip.
+        r = static_cast<uint8_t>(x * 255 / (width > 1 ? width - 1 : 1));
+        g = static_cast<uint8_t>(y * 255 / (height > 1 ? height - 1 : 1));
+        b = static_cast<uint8_t>((x + y) & 0xff);
+      } else {
+        r = g = b = 255;
+      }
+      p[0] = b;
+      p[1] = g;
+      p[2] = r;
+      p[3] = 255;
+    }
+  }
+  return bgra;
+}
+
+double MeanAbsDiff(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+  if (a.size() != b.size() || a.empty()) return 1e9;
+  uint64_t total = 0;
+  for (size_t i = 0; i < a.size(); i++) total += static_cast<uint64_t>(std::abs(a[i] - b[i]));
+  return static_cast<double>(total) / static_cast<double>(a.size());
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Independent decoders (system zlib and libjpeg) that the encoder tests
+// round-trip through, plus deterministic test images.
+
+// Inflates a complete zlib stream. False on any error, a bad Adler-32 or
+// trailing bytes.
+bool InflateZlib(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+// Decodes an 8-bit truecolor, non-interlaced PNG (what EncodePngBgra
+// writes), checking every chunk CRC. |rgb| is tightly packed. |idat_chunks|
+// receives the number of IDAT chunks when non-null.
+bool DecodePngRgb(const std::vector<uint8_t>& png,
+                  int& width,
+                  int& height,
+                  std::vector<uint8_t>& rgb,
+                  size_t* idat_chunks = nullptr);
+
+// Decodes a baseline JPEG to tightly packed RGB.
+bool DecodeJpegRgb(const std::vector<uint8_t>& jpeg, int& width, int& height, std::vector<uint8_t>& rgb);
+
+// Reads a PNG fixture (as DecodePngRgb accepts) into opaque top-down BGRA,
+// the layout captures arrive in. Empty on any error.
+std::vector<uint8_t> ReadPngBgra(const std::string& path, int& width, int& height);
+
+// Copies |src| (width x height BGRA) into |dst| (dst_width wide) with its
+// top-left corner at x,y. The caller keeps it inside |dst|.
+void PasteBgra(std::vector<uint8_t>& dst, int dst_width, const std::vector<uint8_t>& src, int width, int height,
+               int x, int y);
+
+// Drops alpha and swaps BGRA to RGB.
+std::vector<uint8_t> BgraToRgb(const uint8_t* bgra, int width, int height, size_t stride = 0);
+
+// A screenshot-like BGRA image: window chrome, flat panels, a gradient and
+// noisy "text" rows, so encoders see both runs and detail. Same |seed|, same
+// pixels.
+std::vector<uint8_t> SyntheticScreen(int width, int height, uint32_t seed = 1);
+
+// Mean absolute difference per channel between two equally sized buffers.
+double MeanAbsDiff(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b);
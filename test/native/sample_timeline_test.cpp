@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "pcm_ring_buffer.h"
+#include "sample_timeline.h"
+#include "silence_compactor.h"
+
+namespace {
+
+TEST(PcmRingBufferTest, WriteReportsDroppedBytes) {
+  PcmRingBuffer ring(8);
+  const uint8_t data[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+  EXPECT_EQ(ring.Write(data, 6), 0u);
+  EXPECT_EQ(ring.Write(data + 6, 4), 2u);
+  uint8_t out[8] = {};
+  ASSERT_EQ(ring.Read(out, sizeof(out)), 8u);
+  EXPECT_EQ(out[0], 2);
+  EXPECT_EQ(out[7], 9);
+
+  // Past capacity the head of the new data is dropped too.
+  EXPECT_EQ(ring.Write(data, 4), 0u);
+  EXPECT_EQ(ring.Write(data, 12), 8u);
+  ASSERT_EQ(ring.Read(out, sizeof(out)), 8u);
+  EXPECT_EQ(out[0], 4);
+}
+
+TEST(SampleTimelineTest, PopFrontReportsDroppedRanges) {
+  SampleTimeline timeline;
+  timeline.Append(0, 100);
+  timeline.Append(100, 50);  // merges
+  timeline.Append(400, 100);
+  EXPECT_EQ(timeline.queued_samples(), 250u);
+
+  timeline.PopFront(20);
+  std::vector<AudioGap> dropped;
+  timeline.PopFront(180, &dropped);
+  ASSERT_EQ(dropped.size(), 2u);
+  EXPECT_EQ(dropped[0].start_sample, 20u);
+  EXPECT_EQ(dropped[0].length, 130u);
+  EXPECT_EQ(dropped[1].start_sample, 400u);
+  EXPECT_EQ(dropped[1].length, 50u);
+  EXPECT_EQ(timeline.queued_samples(), 50u);
+
+  timeline.PopFront(1000);
+  EXPECT_EQ(timeline.queued_samples(), 0u);
+}
+
+TEST(SampleTimelineTest, InsertGapKeepsSortedAndMerges) {
+  std::vector<AudioGap> gaps;
+  InsertGap(gaps, AudioGap{100, 10});
+  InsertGap(gaps, AudioGap{300, 10});
+  InsertGap(gaps, AudioGap{0, 10});
+  ASSERT_EQ(gaps.size(), 3u);
+  EXPECT_EQ(gaps[0].start_sample, 0u);
+  EXPECT_EQ(gaps[2].start_sample, 300u);
+
+  // Bridges the first two and touches nothing else.
+  InsertGap(gaps, AudioGap{10, 90});
+  ASSERT_EQ(gaps.size(), 2u);
+  EXPECT_EQ(gaps[0].start_sample, 0u);
+  EXPECT_EQ(gaps[0].length, 110u);
+
+  // Overlaps the tail of one and the head of the next.
+  InsertGap(gaps, AudioGap{105, 200});
+  ASSERT_EQ(gaps.size(), 1u);
+  EXPECT_EQ(gaps[0].length, 310u);
+
+  InsertGap(gaps, AudioGap{50, 0});
+  EXPECT_EQ(gaps.size(), 1u);
+}
+
+// Value of the (non-silent) sample at timeline position |t|.
+int16_t SampleAt(uint64_t t) {
+  return static_cast<int16_t>(100 + t % 30000);
+}
+
+// Drives the compactor, ring and timeline the way AudioCapture does, with a
+// ring small enough to overflow, and checks the receiver can rebuild the
+// timeline: every position is either the next audio sample read or inside
+// exactly one gap.
+TEST(SampleTimelineTest, OverflowKeepsReceiverTimelineContinuous) {
+  SilenceCompactor compactor(32, 320);
+  PcmRingBuffer ring(4000);
+  SampleTimeline timeline;
+  std::vector<AudioGap> pending;
+
+  std::vector<int16_t> expected;
+  std::vector<int16_t> received;
+  std::vector<AudioGap> received_gaps;
+  size_t overflow_bytes = 0;
+  uint64_t t = 0;
+  for (int packet = 0; packet < 400; packet++) {
+    // Alternate speech and silence so gaps and audio interleave.
+    std::vector<int16_t> samples(480);
+    const bool silent = (packet / 7) % 3 == 2;
+    for (auto& s : samples) {
+      s = silent ? 0 : SampleAt(t);
+      expected.push_back(s);
+      t++;
+    }
+
+    const uint64_t packet_start = compactor.next_sample();
+    std::vector<int16_t> kept;
+    std::vector<AudioGap> gaps;
+    compactor.Process(samples.data(), samples.size(), kept, gaps);
+    const size_t dropped =
+        ring.Write(reinterpret_cast<const uint8_t*>(kept.data()), kept.size() * sizeof(int16_t));
+    uint64_t pos = packet_start;
+    for (const auto& gap : gaps) {
+      timeline.Append(pos, gap.start_sample - pos);
+      pos = gap.start_sample + gap.length;
+    }
+    timeline.Append(pos, compactor.next_sample() - pos);
+    for (const auto& gap : gaps) InsertGap(pending, gap);
+    timeline.PopFront(dropped / sizeof(int16_t), &pending);
+    overflow_bytes += dropped;
+
+    // A slow reader: one 1600-byte frame every third packet.
+    if (packet % 3 == 0) {
+      std::vector<int16_t> frame(800);
+      const size_t n = ring.Read(reinterpret_cast<uint8_t*>(frame.data()), 1600);
+      timeline.PopFront(n / sizeof(int16_t));
+      received.insert(received.end(), frame.begin(), frame.begin() + static_cast<std::ptrdiff_t>(n / 2));
+      received_gaps.insert(received_gaps.end(), pending.begin(), pending.end());
+      pending.clear();
+    }
+  }
+  received_gaps.insert(received_gaps.end(), pending.begin(), pending.end());
+  ASSERT_GT(overflow_bytes, 0u);
+  ASSERT_GT(ring.size(), 0u);
+
+  std::vector<AudioGap> gaps;
+  for (const auto& gap : received_gaps) InsertGap(gaps, gap);
+  size_t gi = 0, ai = 0;
+  uint64_t pos = 0;
+  const uint64_t end = t - timeline.queued_samples();
+  while (pos < end) {
+    if (gi < gaps.size() && gaps[gi].start_sample == pos) {
+      pos += gaps[gi].length;
+      gi++;
+      continue;
+    }
+    ASSERT_LT(ai, received.size()) << "timeline hole at " << pos;
+    ASSERT_EQ(received[ai++], expected[pos]) << "at " << pos;
+    pos++;
+  }
+  EXPECT_EQ(pos, end);
+  EXPECT_EQ(ai, received.size());
+  EXPECT_EQ(gi, gaps.size());
+}
+
+}  // namespace
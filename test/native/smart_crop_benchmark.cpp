@@ -0,0 +1,68 @@
+// captureForUpload's smartCrop analysis on screenshots built from the OCR
+// corpus fixtures: text windows on a wallpaper (a crop is found) and a
+// screen tiled with an editor (the crop is declined), at 1080p, 1440p and
+// 4K.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "reference_codecs.h"
+#include "smart_crop.h"
+
+namespace {
+
+enum Scene { kWindows = 0, kTiled = 1 };
+
+std::vector<uint8_t> BuildScreen(int width, int height, Scene scene, bool& ok) {
+  std::vector<uint8_t> screen(static_cast<size_t>(width) * height * 4);
+  for (size_t i = 0; i < screen.size(); i += 4) {
+    screen[i] = 110;
+    screen[i + 1] = 64;
+    screen[i + 2] = 40;
+    screen[i + 3] = 255;
+  }
+  int dw = 0, dh = 0, ew = 0, eh = 0;
+  const std::vector<uint8_t> doc = ReadPngBgra(std::string(OCR_FIXTURE_DIR) + "/light_document.png", dw, dh);
+  const std::vector<uint8_t> editor = ReadPngBgra(std::string(OCR_FIXTURE_DIR) + "/dark_editor.png", ew, eh);
+  ok = !doc.empty() && !editor.empty();
+  if (!ok) return screen;
+  if (scene == kWindows) {
+    PasteBgra(screen, width, editor, ew, eh, width / 8, height / 8);
+    PasteBgra(screen, width, doc, dw, dh, width / 2, height / 2);
+  } else {
+    for (int y = 0; y + eh <= height; y += eh) {
+      for (int x = 0; x + ew <= width; x += ew) PasteBgra(screen, width, editor, ew, eh, x, y);
+    }
+  }
+  return screen;
+}
+
+void BM_FindContentCrop(benchmark::State& state) {
+  const int width = static_cast<int>(state.range(0));
+  const int height = static_cast<int>(state.range(1));
+  bool ok = false;
+  const std::vector<uint8_t> screen = BuildScreen(width, height, static_cast<Scene>(state.range(2)), ok);
+  if (!ok) {
+    state.SkipWithError("Missing OCR fixtures");
+    return;
+  }
+  CropRect crop;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(FindContentCrop(screen.data(), width, height, 0, 0.85, crop));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * width * height * 4);
+}
+
+BENCHMARK(BM_FindContentCrop)
+    ->ArgNames({"w", "h", "tiled"})
+    ->Args({1920, 1080, kWindows})
+    ->Args({2560, 1440, kWindows})
+    ->Args({3840, 2160, kWindows})
+    ->Args({1920, 1080, kTiled})
+    ->Args({2560, 1440, kTiled})
+    ->Args({3840, 2160, kTiled});
+
+}  // namespace
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "reference_codecs.h"
+#include "smart_crop.h"
+
+namespace {
+
+constexpr int kWidth = 1920;
+constexpr int kHeight = 1080;
+constexpr double kMaxKeep = 0.85;  // As captureForUpload uses it.
+
+// A wallpaper with a gradient too gentle to count as detail.
+std::vector<uint8_t> Desktop(int width, int height) {
+  std::vector<uint8_t> bgra(static_cast<size_t>(width) * height * 4);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      uint8_t* p = bgra.data() + (static_cast<size_t>(y) * width + x) * 4;
+      p[0] = static_cast<uint8_t>(96 + y * 64 / height);
+      p[1] = 64;
+      p[2] = static_cast<uint8_t>(32 + x * 32 / width);
+      p[3] = 255;
+    }
+  }
+  return bgra;
+}
+
+struct Fixture {
+  std::vector<uint8_t> bgra;
+  int width = 0;
+  int height = 0;
+};
+
+Fixture Load(const char* name) {
+  Fixture f;
+  f.bgra = ReadPngBgra(std::string(OCR_FIXTURE_DIR) + "/" + name, f.width, f.height);
+  return f;
+}
+
+void ExpectContains(const CropRect& crop, int x, int y, int width, int height) {
+  EXPECT_LE(crop.x, x);
+  EXPECT_LE(crop.y, y);
+  EXPECT_GE(crop.x + crop.width, x + width);
+  EXPECT_GE(crop.y + crop.height, y + height);
+}
+
+void ExpectOnGrid(const CropRect& crop, int width, int height) {
+  EXPECT_EQ(crop.x % kCropBlockSize, 0);
+  EXPECT_EQ(crop.y % kCropBlockSize, 0);
+  EXPECT_TRUE((crop.x + crop.width) % kCropBlockSize == 0 || crop.x + crop.width == width);
+  EXPECT_TRUE((crop.y + crop.height) % kCropBlockSize == 0 || crop.y + crop.height == height);
+  EXPECT_GE(crop.x, 0);
+  EXPECT_GE(crop.y, 0);
+  EXPECT_LE(crop.x + crop.width, width);
+  EXPECT_LE(crop.y + crop.height, height);
+}
+
+TEST(SmartCropTest, CropsToTextWindowOnDesktop) {
+  const Fixture doc = Load("light_document.png");
+  ASSERT_FALSE(doc.bgra.empty());
+  std::vector<uint8_t> screen = Desktop(kWidth, kHeight);
+  PasteBgra(screen, kWidth, doc.bgra, doc.width, doc.height, 700, 380);
+
+  CropRect crop;
+  ASSERT_TRUE(FindContentCrop(screen.data(), kWidth, kHeight, 0, kMaxKeep, crop));
+  ExpectOnGrid(crop, kWidth, kHeight);
+  ExpectContains(crop, 700, 380, doc.width, doc.height);
+  // At most the padding block plus grid alignment beyond the window.
+  EXPECT_GE(crop.x, 700 - 2 * kCropBlockSize);
+  EXPECT_GE(crop.y, 380 - 2 * kCropBlockSize);
+  EXPECT_LE(crop.x + crop.width, 700 + doc.width + 2 * kCropBlockSize);
+  EXPECT_LE(crop.y + crop.height, 380 + doc.height + 2 * kCropBlockSize);
+}
+
+TEST(SmartCropTest, IgnoresLoneIcon) {
+  const Fixture doc = Load("light_document.png");
+  ASSERT_FALSE(doc.bgra.empty());
+  std::vector<uint8_t> screen = Desktop(kWidth, kHeight);
+  PasteBgra(screen, kWidth, doc.bgra, doc.width, doc.height, 700, 380);
+  CropRect without_icon;
+  ASSERT_TRUE(FindContentCrop(screen.data(), kWidth, kHeight, 0, kMaxKeep, without_icon));
+
+  // A 24x24 checkerboard "tray icon" in the far corner.
+  std::vector<uint8_t> icon(24 * 24 * 4);
+  for (int i = 0; i < 24 * 24; i++) {
+    const uint8_t v = ((i % 24) / 4 + (i / 24) / 4) % 2 ? 255 : 0;
+    icon[i * 4] = icon[i * 4 + 1] = icon[i * 4 + 2] = v;
+    icon[i * 4 + 3] = 255;
+  }
+  PasteBgra(screen, kWidth, icon, 24, 24, kWidth - 40, 12);
+  CropRect with_icon;
+  ASSERT_TRUE(FindContentCrop(screen.data(), kWidth, kHeight, 0, kMaxKeep, with_icon));
+  EXPECT_EQ(with_icon.x, without_icon.x);
+  EXPECT_EQ(with_icon.y, without_icon.y);
+  EXPECT_EQ(with_icon.width, without_icon.width);
+  EXPECT_EQ(with_icon.height, without_icon.height);
+}
+
+TEST(SmartCropTest, SpansWindowsOfSimilarSize) {
+  const Fixture doc = Load("light_document.png");
+  const Fixture editor = Load("dark_editor.png");
+  ASSERT_FALSE(doc.bgra.empty());
+  ASSERT_FALSE(editor.bgra.empty());
+  std::vector<uint8_t> screen = Desktop(kWidth, kHeight);
+  PasteBgra(screen, kWidth, editor.bgra, editor.width, editor.height, 96, 64);
+  PasteBgra(screen, kWidth, doc.bgra, doc.width, doc.height, 1000, 600);
+
+  CropRect crop;
+  ASSERT_TRUE(FindContentCrop(screen.data(), kWidth, kHeight, 0, kMaxKeep, crop));
+  ExpectOnGrid(crop, kWidth, kHeight);
+  ExpectContains(crop, 96, 64, editor.width, editor.height);
+  ExpectContains(crop, 1000, 600, doc.width, doc.height);
+}
+
+TEST(SmartCropTest, HonoursStride) {
+  const Fixture doc = Load("small_ui.png");
+  ASSERT_FALSE(doc.bgra.empty());
+  const int width = 1280, height = 720;
+  std::vector<uint8_t> screen = Desktop(width, height);
+  PasteBgra(screen, width, doc.bgra, doc.width, doc.height, 400, 200);
+  CropRect packed;
+  ASSERT_TRUE(FindContentCrop(screen.data(), width, height, 0, kMaxKeep, packed));
+
+  const size_t stride = static_cast<size_t>(width) * 4 + 64;
+  std::vector<uint8_t> padded(stride * height, 0xcd);
+  for (int y = 0; y < height; y++) {
+    std::copy(screen.begin() + static_cast<std::ptrdiff_t>(y) * width * 4,
+              screen.begin() + static_cast<std::ptrdiff_t>(y + 1) * width * 4, padded.begin() + y * stride);
+  }
+  CropRect strided;
+  ASSERT_TRUE(FindContentCrop(padded.data(), width, height, stride, kMaxKeep, strided));
+  EXPECT_EQ(strided.x, packed.x);
+  EXPECT_EQ(strided.y, packed.y);
+  EXPECT_EQ(strided.width, packed.width);
+  EXPECT_EQ(strided.height, packed.height);
+}
+
+// Nothing to gain: no detail, detail everywhere, or too small to analyse.
+// |out| is left alone each time.
+TEST(SmartCropTest, DeclinesWhenNothingToGain) {
+  const CropRect sentinel{1, 2, 3, 4};
+  CropRect crop = sentinel;
+  const std::vector<uint8_t> flat = Desktop(kWidth, kHeight);
+  EXPECT_FALSE(FindContentCrop(flat.data(), kWidth, kHeight, 0, kMaxKeep, crop));
+
+  const Fixture editor = Load("dark_editor.png");
+  ASSERT_FALSE(editor.bgra.empty());
+  std::vector<uint8_t> busy = Desktop(kWidth, kHeight);
+  for (int y = 0; y + editor.height <= kHeight; y += editor.height) {
+    for (int x = 0; x + editor.width <= kWidth; x += editor.width) {
+      PasteBgra(busy, kWidth, editor.bgra, editor.width, editor.height, x, y);
+    }
+  }
+  EXPECT_FALSE(FindContentCrop(busy.data(), kWidth, kHeight, 0, kMaxKeep, crop));
+
+  const std::vector<uint8_t> tiny = SyntheticScreen(48, 48);
+  EXPECT_FALSE(FindContentCrop(tiny.data(), 48, 48, 0, kMaxKeep, crop));
+  EXPECT_FALSE(FindContentCrop(nullptr, kWidth, kHeight, 0, kMaxKeep, crop));
+  EXPECT_EQ(crop.x, sentinel.x);
+  EXPECT_EQ(crop.width, sentinel.width);
+}
+
+}  // namespace
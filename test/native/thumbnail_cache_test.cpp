@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "thumbnail_cache.h"
+
+namespace {
+
+ThumbnailCache::Entry Tile(size_t bytes, uint8_t fill = 0) {
+  ThumbnailCache::Entry entry;
+  entry.width = static_cast<int>(bytes / 4);
+  entry.height = 1;
+  entry.bytes.assign(bytes, fill);
+  return entry;
+}
+
+std::vector<uint8_t> Pixels(int width, int height, uint8_t seed) {
+  std::vector<uint8_t> bgra(static_cast<size_t>(width) * height * 4);
+  for (size_t i = 0; i < bgra.size(); i++) bgra[i] = static_cast<uint8_t>(i * 7 + seed);
+  return bgra;
+}
+
+TEST(ThumbnailCacheTest, EvictsLeastRecentlyUsed) {
+  ThumbnailCache cache(300);
+  cache.Put("a", Tile(100));
+  cache.Put("b", Tile(100));
+  cache.Put("c", Tile(100));
+  ThumbnailCache::Entry out;
+  // Using "a" leaves "b" as the oldest.
+  ASSERT_TRUE(cache.Lookup("a", out));
+  cache.Put("d", Tile(100));
+  EXPECT_FALSE(cache.Lookup("b", out));
+  EXPECT_TRUE(cache.Lookup("a", out));
+  EXPECT_TRUE(cache.Lookup("c", out));
+  EXPECT_TRUE(cache.Lookup("d", out));
+
+  const ThumbnailCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(stats.entries, 3u);
+  EXPECT_EQ(stats.hits, 4u);
+  EXPECT_EQ(stats.misses, 1u);
+  EXPECT_EQ(stats.evictions, 1u);
+}
+
+TEST(ThumbnailCacheTest, StaysWithinTheByteBudget) {
+  ThumbnailCache cache(1000);
+  cache.Put("a", Tile(400, 1));
+  cache.Put("b", Tile(400, 2));
+  // Replacing an entry counts only its new size.
+  cache.Put("a", Tile(200, 3));
+  EXPECT_EQ(cache.GetStats().bytes, 600u);
+  ThumbnailCache::Entry out;
+  ASSERT_TRUE(cache.Lookup("a", out));
+  EXPECT_EQ(out.bytes.size(), 200u);
+  EXPECT_EQ(out.bytes[0], 3);
+
+  // One large tile pushes out both older ones.
+  cache.Put("c", Tile(900));
+  ThumbnailCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(stats.entries, 1u);
+  EXPECT_EQ(stats.bytes, 900u);
+  EXPECT_EQ(stats.evictions, 2u);
+
+  // Larger than the whole budget: not kept, and the old "c" goes too.
+  cache.Put("c", Tile(1001));
+  EXPECT_FALSE(cache.Lookup("c", out));
+  EXPECT_EQ(cache.GetStats().bytes, 0u);
+
+  cache.Put("a", Tile(400));
+  cache.Put("b", Tile(400));
+  cache.SetBudget(500);
+  stats = cache.GetStats();
+  EXPECT_EQ(stats.entries, 1u);
+  EXPECT_LE(stats.bytes, 500u);
+  EXPECT_EQ(stats.budget_bytes, 500u);
+  EXPECT_TRUE(cache.Lookup("b", out));
+}
+
+// A stale tile sent from the cache is recaptured; if the capture looks the
+// same nothing is sent again and only the entry's generation moves on.
+TEST(ThumbnailCacheTest, UnchangedRevalidationIsNotEmitted) {
+  ThumbnailCache cache;
+  const std::vector<uint8_t> first = Pixels(48, 32, 0);
+  EXPECT_TRUE(cache.PutCapture("window:1:160x90", first.data(), 48, 32, 0, 1, nullptr));
+
+  ThumbnailCache::Entry cached;
+  ASSERT_TRUE(cache.Lookup("window:1:160x90", cached));
+  EXPECT_EQ(cached.bytes, first);
+  EXPECT_EQ(cached.generation, 1u);
+  EXPECT_EQ(cached.content_hash, SampledContentHash(first.data(), 48, 32, 0));
+
+  const std::vector<uint8_t> same = first;
+  EXPECT_FALSE(cache.PutCapture("window:1:160x90", same.data(), 48, 32, 0, 2, &cached.content_hash));
+  ThumbnailCache::Entry touched;
+  ASSERT_TRUE(cache.Lookup("window:1:160x90", touched));
+  EXPECT_EQ(touched.generation, 2u);
+  EXPECT_GE(touched.captured_at, cached.captured_at);
+
+  const std::vector<uint8_t> changed = Pixels(48, 32, 1);
+  EXPECT_TRUE(cache.PutCapture("window:1:160x90", changed.data(), 48, 32, 0, 3, &cached.content_hash));
+  ASSERT_TRUE(cache.Lookup("window:1:160x90", touched));
+  EXPECT_EQ(touched.bytes, changed);
+  EXPECT_EQ(touched.generation, 3u);
+
+  // Without a tile on screen every capture is sent, changed or not.
+  EXPECT_TRUE(cache.PutCapture("window:1:160x90", changed.data(), 48, 32, 0, 4, nullptr));
+}
+
+TEST(ThumbnailCacheTest, PutCapturePacksPaddedRows) {
+  ThumbnailCache cache;
+  const int width = 5, height = 3;
+  const size_t stride = width * 4 + 8;
+  std::vector<uint8_t> padded(stride * height, 0xee);
+  const std::vector<uint8_t> packed = Pixels(width, height, 5);
+  for (int y = 0; y < height; y++) {
+    std::copy(packed.begin() + y * width * 4, packed.begin() + (y + 1) * width * 4, padded.begin() + y * stride);
+  }
+  cache.PutCapture("tile", padded.data(), width, height, stride, 1, nullptr);
+  ThumbnailCache::Entry out;
+  ASSERT_TRUE(cache.Lookup("tile", out));
+  EXPECT_EQ(out.bytes, packed);
+  EXPECT_EQ(out.content_hash, SampledContentHash(packed.data(), width, height, 0));
+}
+
+}  // namespace
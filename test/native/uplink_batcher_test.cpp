@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "uplink_batcher.h"
+
+namespace {
+
+std::string Encoded(const std::vector<uint8_t>& bytes) {
+  return Base64Encode(bytes.data(), bytes.size());
+}
+
+std::string AudioFrame(const std::string& source, const std::vector<uint8_t>& bytes) {
+  return "{\"type\":\"audio\",\"source\":\"" + source + "\",\"audio\":\"" + Encoded(bytes) + "\"}";
+}
+
+std::vector<uint8_t> Bytes(size_t size, uint8_t first = 0) {
+  std::vector<uint8_t> bytes(size);
+  for (size_t i = 0; i < size; i++) bytes[i] = static_cast<uint8_t>(first + i);
+  return bytes;
+}
+
+TEST(Base64EncodeTest, MatchesRfc4648Vectors) {
+  const std::string input = "foobar";
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(input.data());
+  EXPECT_EQ(Base64Encode(data, 0), "");
+  EXPECT_EQ(Base64Encode(data, 1), "Zg==");
+  EXPECT_EQ(Base64Encode(data, 2), "Zm8=");
+  EXPECT_EQ(Base64Encode(data, 3), "Zm9v");
+  EXPECT_EQ(Base64Encode(data, 4), "Zm9vYg==");
+  EXPECT_EQ(Base64Encode(data, 5), "Zm9vYmE=");
+  EXPECT_EQ(Base64Encode(data, 6), "Zm9vYmFy");
+  const uint8_t high[3] = {0xfb, 0xff, 0xbf};
+  EXPECT_EQ(Base64Encode(high, 3), "+/+/");
+}
+
+TEST(UplinkBatcherTest, CoalescesUntilLatencyBudget) {
+  UplinkBatcher batcher(200, 1000, 4000);
+  const std::vector<uint8_t> a = Bytes(100, 0);
+  const std::vector<uint8_t> b = Bytes(100, 100);
+  batcher.AddAudio("mic", a.data(), a.size(), 1000);
+  batcher.AddAudio("mic", b.data(), b.size(), 1100);
+
+  std::vector<UplinkFrame> out;
+  batcher.TakeReady(1199, false, out);
+  EXPECT_TRUE(out.empty());
+  EXPECT_EQ(batcher.pending_bytes(), 200u);
+
+  // The budget runs from the oldest byte, not the latest chunk.
+  batcher.TakeReady(1200, false, out);
+  ASSERT_EQ(out.size(), 1u);
+  EXPECT_EQ(out[0].audio_bytes, 200u);
+  EXPECT_EQ(out[0].text, AudioFrame("mic", Bytes(200, 0)));
+  EXPECT_EQ(batcher.pending_bytes(), 0u);
+}
+
+TEST(UplinkBatcherTest, SplitsAtMaxFrameBytesPerSource) {
+  UplinkBatcher batcher(200, 64, 4000);
+  const std::vector<uint8_t> mic = Bytes(150, 0);
+  const std::vector<uint8_t> system = Bytes(10, 50);
+  batcher.AddAudio("mic", mic.data(), mic.size(), 0);
+  batcher.AddAudio("system", system.data(), system.size(), 0);
+  EXPECT_EQ(batcher.queued_frames(), 2u);
+
+  std::vector<UplinkFrame> out;
+  batcher.TakeReady(0, true, out);
+  ASSERT_EQ(out.size(), 4u);
+  EXPECT_EQ(out[0].text, AudioFrame("mic", std::vector<uint8_t>(mic.begin(), mic.begin() + 64)));
+  EXPECT_EQ(out[1].text, AudioFrame("mic", std::vector<uint8_t>(mic.begin() + 64, mic.begin() + 128)));
+  EXPECT_EQ(out[2].text, AudioFrame("mic", std::vector<uint8_t>(mic.begin() + 128, mic.end())));
+  EXPECT_EQ(out[3].text, AudioFrame("system", system));
+}
+
+TEST(UplinkBatcherTest, ControlFlushesPendingAudioFirst) {
+  UplinkBatcher batcher(200, 1000, 4000);
+  const std::vector<uint8_t> audio = Bytes(40);
+  batcher.AddAudio("mic", audio.data(), audio.size(), 0);
+  batcher.AddControl("{\"type\":\"gap\"}");
+  batcher.AddAudio("mic", audio.data(), audio.size(), 10);
+
+  std::vector<UplinkFrame> out;
+  batcher.TakeReady(10, false, out);
+  ASSERT_EQ(out.size(), 2u);
+  EXPECT_EQ(out[0].audio_bytes, 40u);
+  EXPECT_EQ(out[1].text, "{\"type\":\"gap\"}");
+  EXPECT_EQ(out[1].audio_bytes, 0u);
+  // The audio after the control message is still batching.
+  EXPECT_EQ(batcher.pending_bytes(), 40u);
+}
+
+TEST(UplinkBatcherTest, TrimReadyAudioKeepsControlMessages) {
+  UplinkBatcher batcher(200, 10, 4000);
+  const std::vector<uint8_t> audio = Bytes(30);
+  batcher.AddAudio("mic", audio.data(), audio.size(), 0);  // three frames
+  batcher.AddControl("stop");
+  const std::vector<uint8_t> tail = Bytes(10, 30);
+  batcher.AddAudio("mic", tail.data(), tail.size(), 0);
+  ASSERT_EQ(batcher.queued_frames(), 5u);
+
+  batcher.TrimReadyAudio(2);
+  EXPECT_EQ(batcher.queued_frames(), 2u);
+  EXPECT_EQ(batcher.dropped_bytes(), 30u);
+
+  std::vector<UplinkFrame> out;
+  batcher.TakeReady(0, false, out);
+  ASSERT_EQ(out.size(), 2u);
+  EXPECT_EQ(out[0].text, "stop");
+  EXPECT_EQ(out[1].text, AudioFrame("mic", tail));
+
+  // Only control messages left: nothing to drop.
+  batcher.AddControl("a");
+  batcher.AddControl("b");
+  batcher.TrimReadyAudio(0);
+  EXPECT_EQ(batcher.queued_frames(), 2u);
+}
+
+}  // namespace
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "image_scale.h"
+#include "reference_codecs.h"
+#include "upload_encoder.h"
+
+namespace {
+
+TEST(UploadEncoderTest, PngKeepsSmallCapturesExact) {
+  const int width = 300, height = 200;
+  const std::vector<uint8_t> bgra = SyntheticScreen(width, height, 11);
+  UploadEncodeOptions options;
+  options.format = UploadFormat::kPng;
+  EncodedUpload out;
+  ASSERT_TRUE(EncodeForUpload(bgra.data(), width, height, 0, options, out));
+  EXPECT_EQ(out.mime_type, "image/png");
+  EXPECT_EQ(out.quality, 0);
+  EXPECT_TRUE(out.within_budget);
+
+  int w = 0, h = 0;
+  std::vector<uint8_t> rgb;
+  ASSERT_TRUE(DecodePngRgb(out.bytes, w, h, rgb));
+  EXPECT_EQ(w, width);
+  EXPECT_EQ(h, height);
+  EXPECT_EQ(rgb, BgraToRgb(bgra.data(), width, height));
+}
+
+TEST(UploadEncoderTest, PngDownscalesToMaxDimension) {
+  const int width = 1000, height = 500;
+  const std::vector<uint8_t> bgra = SyntheticScreen(width, height, 12);
+  UploadEncodeOptions options;
+  options.max_dimension = 400;
+  EncodedUpload out;
+  ASSERT_TRUE(EncodeForUpload(bgra.data(), width, height, 0, options, out));
+  EXPECT_EQ(out.width, 400);
+  EXPECT_EQ(out.height, 200);
+
+  // The PNG holds exactly the box-filtered image.
+  std::vector<uint8_t> scaled;
+  ASSERT_TRUE(ScaleBgra(bgra.data(), width, height, 0, 400, 200, ScaleFilter::kBox, scaled, 1));
+  int w = 0, h = 0;
+  std::vector<uint8_t> rgb;
+  ASSERT_TRUE(DecodePngRgb(out.bytes, w, h, rgb));
+  EXPECT_EQ(w, 400);
+  EXPECT_EQ(h, 200);
+  EXPECT_EQ(rgb, BgraToRgb(scaled.data(), 400, 200));
+}
+
+TEST(UploadEncoderTest, JpegDecodesCloseToSource) {
+  const int width = 320, height = 240;
+  const std::vector<uint8_t> bgra = SyntheticScreen(width, height, 13);
+  UploadEncodeOptions options;
+  options.format = UploadFormat::kJpeg;
+  options.jpeg_quality = 90;
+  EncodedUpload out;
+  ASSERT_TRUE(EncodeForUpload(bgra.data(), width, height, 0, options, out));
+  EXPECT_EQ(out.mime_type, "image/jpeg");
+  EXPECT_EQ(out.quality, 90);
+
+  int w = 0, h = 0;
+  std::vector<uint8_t> rgb;
+  ASSERT_TRUE(DecodeJpegRgb(out.bytes, w, h, rgb));
+  ASSERT_EQ(w, width);
+  ASSERT_EQ(h, height);
+  EXPECT_LT(MeanAbsDiff(rgb, BgraToRgb(bgra.data(), width, height)), 4.0);
+}
+
+TEST(UploadEncoderTest, AutoFallsBackToJpegWithinBudget) {
+  const int width = 800, height = 600;
+  const std::vector<uint8_t> bgra = SyntheticScreen(width, height, 14);
+  UploadEncodeOptions options;
+  options.format = UploadFormat::kPng;
+  EncodedUpload png;
+  ASSERT_TRUE(EncodeForUpload(bgra.data(), width, height, 0, options, png));
+
+  options.format = UploadFormat::kAuto;
+  options.max_bytes = png.bytes.size() / 2;
+  EncodedUpload out;
+  ASSERT_TRUE(EncodeForUpload(bgra.data(), width, height, 0, options, out));
+  EXPECT_EQ(out.mime_type, "image/jpeg");
+  EXPECT_TRUE(out.within_budget);
+  EXPECT_LE(out.bytes.size(), options.max_bytes);
+  int w = 0, h = 0;
+  std::vector<uint8_t> rgb;
+  ASSERT_TRUE(DecodeJpegRgb(out.bytes, w, h, rgb));
+  EXPECT_EQ(w, out.width);
+  EXPECT_EQ(h, out.height);
+}
+
+TEST(UploadEncoderTest, ReportsAnUnreachableBudget) {
+  const int width = 1200, height = 900;
+  const std::vector<uint8_t> bgra = SyntheticScreen(width, height, 15);
+  UploadEncodeOptions options;
+  options.format = UploadFormat::kJpeg;
+  options.max_bytes = 200;
+  EncodedUpload out;
+  ASSERT_TRUE(EncodeForUpload(bgra.data(), width, height, 0, options, out));
+  EXPECT_FALSE(out.within_budget);
+  EXPECT_FALSE(out.bytes.empty());
+  // Shrunk towards the floor before giving up, and still decodable.
+  EXPECT_LT((std::max)(out.width, out.height), 1200);
+  int w = 0, h = 0;
+  std::vector<uint8_t> rgb;
+  ASSERT_TRUE(DecodeJpegRgb(out.bytes, w, h, rgb));
+  EXPECT_EQ(w, out.width);
+  EXPECT_EQ(h, out.height);
+}
+
+TEST(UploadEncoderTest, HonoursStride) {
+  const int width = 50, height = 40;
+  const size_t stride = width * 4 + 16;
+  const std::vector<uint8_t> packed = SyntheticScreen(width, height, 16);
+  std::vector<uint8_t> padded(stride * height, 0x55);
+  for (int y = 0; y < height; y++) {
+    std::copy(packed.begin() + y * width * 4, packed.begin() + (y + 1) * width * 4,
+              padded.begin() + y * stride);
+  }
+  UploadEncodeOptions options;
+  EncodedUpload out;
+  ASSERT_TRUE(EncodeForUpload(padded.data(), width, height, stride, options, out));
+  int w = 0, h = 0;
+  std::vector<uint8_t> rgb;
+  ASSERT_TRUE(DecodePngRgb(out.bytes, w, h, rgb));
+  EXPECT_EQ(rgb, BgraToRgb(packed.data(), width, height));
+}
+
+}  // namespace
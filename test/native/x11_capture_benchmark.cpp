@@ -0,0 +1,58 @@
+// Linux captureRectPixels: XShmGetImage into the reused segment against
+// plain XGetImage, for a thumbnail-sized region up to a full 1080p monitor.
+// Needs an X server (run under xvfb-run for a headless number); reports an
+// error per benchmark without one.
+
+#include <benchmark/benchmark.h>
+
+#include <X11/Xlib.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "x11_capture.h"
+
+namespace {
+
+void CaptureRect(benchmark::State& state, bool use_shm) {
+  const int w = static_cast<int>(state.range(0));
+  const int h = static_cast<int>(state.range(1));
+  X11Capture capture(false);
+  if (!capture.ok()) {
+    state.SkipWithError("No X display");
+    return;
+  }
+  if (use_shm && !capture.has_shm()) {
+    state.SkipWithError("No MIT-SHM");
+    return;
+  }
+  int x = 0, y = 0, root_w = 0, root_h = 0;
+  capture.ScreenBounds(x, y, root_w, root_h);
+  if (root_w < w || root_h < h) {
+    state.SkipWithError("Screen smaller than the region");
+    return;
+  }
+  capture.set_use_shm(use_shm);
+  std::vector<uint8_t> pixels;
+  for (auto _ : state) {
+    if (!capture.CaptureRect(x, y, w, h, pixels)) {
+      state.SkipWithError("CaptureRect failed");
+      break;
+    }
+    benchmark::DoNotOptimize(pixels.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * w * h * 4);
+}
+
+void BM_X11CaptureRectShm(benchmark::State& state) {
+  CaptureRect(state, true);
+}
+
+void BM_X11CaptureRectXGetImage(benchmark::State& state) {
+  CaptureRect(state, false);
+}
+
+BENCHMARK(BM_X11CaptureRectShm)->Args({320, 180})->Args({1280, 720})->Args({1920, 1080});
+BENCHMARK(BM_X11CaptureRectXGetImage)->Args({320, 180})->Args({1280, 720})->Args({1920, 1080});
+
+}  // namespace
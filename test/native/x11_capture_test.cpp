@@ -0,0 +1,180 @@
+// Linux screen capture against a live X server. Every test skips when
+// DISPLAY is unset; ctest runs them under xvfb-run when it is installed.
+
+#include <gtest/gtest.h>
+
+#include <X11/Xlib.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "x11_capture.h"
+
+namespace {
+
+// As the runner's main() does: before any other Xlib call in the process.
+const Status kThreadsInitialized = XInitThreads();
+
+constexpr int kWindowX = 40;
+constexpr int kWindowY = 30;
+constexpr int kWindowWidth = 64;
+constexpr int kWindowHeight = 48;
+
+bool HaveDisplay() {
+  const char* display = std::getenv("DISPLAY");
+  return display != nullptr && display[0] != '\0';
+}
+
+// A mapped, unmanaged window filled with one colour, on a connection of its
+// own so X11Capture only sees it through the server.
+class SolidWindow {
+ public:
+  explicit SolidWindow(unsigned long rgb) {
+    display_ = XOpenDisplay(nullptr);
+    if (!display_) return;
+    const int screen = DefaultScreen(display_);
+    // background_pixel below is 0xRRGGBB only on a 24-bit TrueColor root.
+    if (DefaultDepth(display_, screen) < 24) return;
+    XSetWindowAttributes attrs{};
+    attrs.override_redirect = True;  // Keeps a window manager from moving it.
+    attrs.background_pixel = rgb;
+    attrs.event_mask = ExposureMask | StructureNotifyMask;
+    window_ = XCreateWindow(display_, RootWindow(display_, screen), kWindowX, kWindowY, kWindowWidth,
+                            kWindowHeight, 0, CopyFromParent, InputOutput, CopyFromParent,
+                            CWOverrideRedirect | CWBackPixel | CWEventMask, &attrs);
+    XMapRaised(display_, window_);
+    XEvent event;
+    do {
+      XNextEvent(display_, &event);
+    } while (event.type != Expose);
+    XSync(display_, False);
+  }
+  ~SolidWindow() {
+    if (!display_) return;
+    if (window_) XDestroyWindow(display_, window_);
+    XCloseDisplay(display_);
+  }
+
+  bool ok() const { return window_ != 0; }
+  Window window() const { return window_; }
+
+ private:
+  Display* display_ = nullptr;
+  Window window_ = 0;
+};
+
+// Counts pixels of |bgra| that are exactly 0xRRGGBB and opaque.
+size_t CountColour(const std::vector<uint8_t>& bgra, unsigned long rgb) {
+  size_t n = 0;
+  for (size_t i = 0; i + 3 < bgra.size(); i += 4) {
+    if (bgra[i] == (rgb & 0xff) && bgra[i + 1] == ((rgb >> 8) & 0xff) && bgra[i + 2] == ((rgb >> 16) & 0xff) &&
+        bgra[i + 3] == 0xff) {
+      n++;
+    }
+  }
+  return n;
+}
+
+TEST(X11CaptureTest, CapturesRectOverSolidWindowWithAndWithoutShm) {
+  if (!HaveDisplay()) GTEST_SKIP() << "DISPLAY is not set";
+  SolidWindow window(0xff4010);
+  ASSERT_TRUE(window.ok());
+  X11Capture capture(false);
+  ASSERT_TRUE(capture.ok());
+
+  const int w = kWindowWidth - 16, h = kWindowHeight - 16;
+  std::vector<uint8_t> shm;
+  ASSERT_TRUE(capture.CaptureRect(kWindowX + 8, kWindowY + 8, w, h, shm));
+  ASSERT_EQ(shm.size(), static_cast<size_t>(w * h * 4));
+  EXPECT_EQ(CountColour(shm, 0xff4010), static_cast<size_t>(w * h));
+
+  capture.set_use_shm(false);
+  std::vector<uint8_t> plain;
+  ASSERT_TRUE(capture.CaptureRect(kWindowX + 8, kWindowY + 8, w, h, plain));
+  EXPECT_EQ(plain, shm);
+}
+
+TEST(X11CaptureTest, PadsOffScreenPartsWithBlack) {
+  if (!HaveDisplay()) GTEST_SKIP() << "DISPLAY is not set";
+  X11Capture capture(false);
+  ASSERT_TRUE(capture.ok());
+  std::vector<uint8_t> pixels;
+  ASSERT_TRUE(capture.CaptureRect(-8, -4, 16, 8, pixels));
+  ASSERT_EQ(pixels.size(), 16u * 8u * 4u);
+  // Row 0 lies above the root window.
+  for (int x = 0; x < 16; x++) {
+    EXPECT_EQ(pixels[x * 4 + 0], 0);
+    EXPECT_EQ(pixels[x * 4 + 1], 0);
+    EXPECT_EQ(pixels[x * 4 + 2], 0);
+    EXPECT_EQ(pixels[x * 4 + 3], 0xff);
+  }
+}
+
+TEST(X11CaptureTest, CapturesWindowContents) {
+  if (!HaveDisplay()) GTEST_SKIP() << "DISPLAY is not set";
+  SolidWindow window(0x20c080);
+  ASSERT_TRUE(window.ok());
+  X11Capture capture(false);
+  ASSERT_TRUE(capture.ok());
+  ASSERT_TRUE(capture.WindowExists(window.window()));
+
+  std::vector<uint8_t> pixels;
+  int width = 0, height = 0;
+  ASSERT_TRUE(capture.CaptureWindow(window.window(), pixels, width, height));
+  EXPECT_EQ(width, kWindowWidth);
+  EXPECT_EQ(height, kWindowHeight);
+  EXPECT_EQ(CountColour(pixels, 0x20c080), static_cast<size_t>(kWindowWidth * kWindowHeight));
+}
+
+TEST(X11CaptureTest, MissingWindowFailsWithoutXError) {
+  if (!HaveDisplay()) GTEST_SKIP() << "DISPLAY is not set";
+  X11Capture capture(false);
+  ASSERT_TRUE(capture.ok());
+  // Nothing allocates ids this close to the top of a client's range.
+  const Window bogus = 0x7ffffff;
+  EXPECT_FALSE(capture.WindowExists(bogus));
+  EXPECT_EQ(capture.WindowPid(bogus), -1);
+  std::vector<uint8_t> pixels;
+  int width = 0, height = 0;
+  EXPECT_FALSE(capture.CaptureWindow(bogus, pixels, width, height));
+  // The connection survives the trapped errors.
+  EXPECT_TRUE(capture.CaptureRect(0, 0, 8, 8, pixels));
+}
+
+// The window channel's split: one instance on this thread listing windows
+// and hitting bad ids, another capturing on a worker.
+TEST(X11CaptureTest, InstancesOnSeparateThreads) {
+  if (!HaveDisplay()) GTEST_SKIP() << "DISPLAY is not set";
+  SolidWindow window(0x3050f0);
+  ASSERT_TRUE(window.ok());
+
+  X11Capture capture;
+  ASSERT_TRUE(capture.ok());
+
+  std::atomic<int> worker_failures{0};
+  std::thread worker([&] {
+    X11Capture capture(false);
+    if (!capture.ok()) {
+      worker_failures++;
+      return;
+    }
+    std::vector<uint8_t> pixels;
+    for (int i = 0; i < 50; i++) {
+      if (!capture.CaptureRect(kWindowX, kWindowY, kWindowWidth, kWindowHeight, pixels) ||
+          CountColour(pixels, 0x3050f0) != static_cast<size_t>(kWindowWidth * kWindowHeight)) {
+        worker_failures++;
+      }
+    }
+  });
+  for (int i = 0; i < 50; i++) {
+    capture.ListWindows(0);
+    EXPECT_FALSE(capture.WindowExists(0x7ffffff));
+  }
+  worker.join();
+  EXPECT_EQ(worker_failures.load(), 0);
+}
+
+}  // namespace
@@ -119,20 +119,30 @@ static void ResampleLinear(const std::vector<float>& inMono,
   }
 }
 
-static void MonoFloatToPcm16Bytes(const std::vector<float>& inMono,
-                                  std::vector<uint8_t>& outBytes) {
-  outBytes.clear();
-  outBytes.resize(inMono.size() * 2);
+static void MonoFloatToPcm16(const std::vector<float>& inMono,
+                             std::vector<int16_t>& outSamples) {
+  outSamples.clear();
+  outSamples.resize(inMono.size());
   for (size_t i = 0; i < inMono.size(); i++) {
-    const int16_t s = FloatToPcm16(inMono[i]);
-    outBytes[i * 2 + 0] = static_cast<uint8_t>(s & 0xFF);
-    outBytes[i * 2 + 1] = static_cast<uint8_t>((s >> 8) & 0xFF);
+    outSamples[i] = FloatToPcm16(inMono[i]);
   }
 }
 
+// Number of 16kHz samples ResampleLinear produces for |frames| input frames.
+static size_t ResampledCount(uint32_t frames, uint32_t inRate, uint32_t outRate) {
+  if (frames == 0 || inRate == 0 || outRate == 0) return 0;
+  if (inRate == outRate) return frames;
+  const double ratio = static_cast<double>(outRate) / static_cast<double>(inRate);
+  return static_cast<size_t>(std::max(1.0, std::floor(frames * ratio)));
+}
+
+// Cap on queued gap records; adjacent runs are merged so this is rarely hit.
+static constexpr size_t kMaxPendingGaps = 512;
+
 }  // namespace
 
-AudioCapture::AudioCapture() : is_capturing_(false), is_initialized_(false) {
+AudioCapture::AudioCapture()
+    : is_capturing_(false), is_initialized_(false), audio_bytes_(kSystemAudioBufferBytes) {
 }
 
 AudioCapture::~AudioCapture() {
@@ -163,8 +173,12 @@ bool AudioCapture::StartSystemAudio() {
   // Clear any buffered audio from a previous run.
   {
     std::lock_guard<std::mutex> lock(frames_mutex_);
-    audio_bytes_.clear();
+    audio_bytes_.Clear();
+    queued_timeline_.Clear();
+    pending_gaps_.clear();
   }
+  silence_compactor_.Reset();
+  level_meter_.Reset();
 
   is_capturing_ = true;
   capture_thread_ = new std::thread(&AudioCapture::CaptureThreadProc, this);
@@ -204,28 +218,29 @@ void AudioCapture::StopSystemAudio() {
   }
 }
 
-std::vector<uint8_t> AudioCapture::GetSystemAudioFrame(size_t requested_bytes) {
-  if (requested_bytes == 0) {
-    return std::vector<uint8_t>();
+size_t AudioCapture::ReadSystemAudioFrame(uint8_t* out, size_t requested_bytes) {
+  if (!out || requested_bytes == 0) {
+    return 0;
   }
 
   std::lock_guard<std::mutex> lock(frames_mutex_);
+  const size_t n = audio_bytes_.Read(out, requested_bytes & ~static_cast<size_t>(1));
+  queued_timeline_.PopFront(n / sizeof(int16_t));
+  return n;
+}
 
-  const size_t available = audio_bytes_.size();
-  if (available == 0) {
-    return std::vector<uint8_t>();
-  }
-
-  const size_t to_copy = (std::min)(requested_bytes, available);
-  std::vector<uint8_t> out;
-  out.reserve(to_copy);
-  for (size_t i = 0; i < to_copy; i++) {
-    out.push_back(audio_bytes_.front());
-    audio_bytes_.pop_front();
-  }
+std::vector<AudioGap> AudioCapture::TakeSystemAudioGaps() {
+  std::lock_guard<std::mutex> lock(frames_mutex_);
+  std::vector<AudioGap> out;
+  out.swap(pending_gaps_);
   return out;
 }
 
+void AudioCapture::SetLevelCallback(std::function<void(const AudioLevelSnapshot&)> callback) {
+  std::lock_guard<std::mutex> lock(level_mutex_);
+  level_callback_ = std::move(callback);
+}
+
 bool AudioCapture::InitializeWASAPI() {
   // Initialize COM library (may already be initialized by Flutter as STA).
   // If CoInitializeEx returns RPC_E_CHANGED_MODE, proceed but DO NOT call CoUninitialize.
@@ -290,6 +305,17 @@ bool AudioCapture::InitializeWASAPI() {
             << capture_format_->nSamplesPerSec << " Hz, "
             << capture_format_->wBitsPerSample << " bits" << std::endl;
 
+  // 16-bit shared-mode endpoints stay in integers end to end.
+  pcm16_decimator_.reset();
+  if (IsPcm16Format(capture_format_)) {
+    pcm16_decimator_ = std::make_unique<Pcm16Decimator>(capture_format_->nSamplesPerSec, 16000);
+    if (!pcm16_decimator_->valid()) {
+      pcm16_decimator_.reset();
+    } else {
+      std::cout << "[AudioCapture] Using fixed-point PCM16 pipeline" << std::endl;
+    }
+  }
+
   hr = audio_client_->Initialize(
       AUDCLNT_SHAREMODE_SHARED,
       AUDCLNT_STREAMFLAGS_LOOPBACK | AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
@@ -356,6 +382,7 @@ void AudioCapture::CleanupWASAPI() {
     CoTaskMemFree(capture_format_);
     capture_format_ = nullptr;
   }
+  pcm16_decimator_.reset();
 
   if (loopback_device_) {
     loopback_device_->Release();
@@ -421,36 +448,74 @@ void AudioCapture::CaptureThreadProc() {
 
           const size_t bytes_available = static_cast<size_t>(frames_read) * capture_format_->nBlockAlign;
           if (bytes_available > 0) {
-            // Pull raw bytes
-            std::vector<uint8_t> raw;
-            raw.resize(bytes_available);
+            // Convert to 16kHz mono PCM16 so Dart can mix with mic audio safely.
+            // Silent packets are not materialized at all: the compactor only
+            // advances the timeline and records a gap.
+            std::vector<int16_t> pcm16;
+            std::vector<int16_t> kept;
+            std::vector<AudioGap> gaps;
+            std::vector<AudioLevelSnapshot> levels;
+            const uint64_t packet_start = silence_compactor_.next_sample();
+
             if (flags & AUDCLNT_BUFFERFLAGS_SILENT) {
-              memset(raw.data(), 0, bytes_available);
+              const size_t count = pcm16_decimator_
+                  ? pcm16_decimator_->Skip(frames_read)
+                  : ResampledCount(frames_read, capture_format_->nSamplesPerSec, 16000);
+              level_meter_.AddSilence(count, levels);
+              silence_compactor_.AddSilence(count, kept, gaps);
+            } else if (pcm16_decimator_) {
+              // Fixed-point path: int32 downmix, Q15 polyphase FIR, saturate.
+              pcm16_mono_.resize(frames_read);
+              DownmixPcm16ToMono(reinterpret_cast<const int16_t*>(buffer), frames_read,
+                                 capture_format_->nChannels, pcm16_mono_.data());
+              pcm16_decimator_->Process(pcm16_mono_.data(), pcm16_mono_.size(), pcm16);
+              level_meter_.Process(pcm16.data(), pcm16.size(), levels);
+              silence_compactor_.Process(pcm16.data(), pcm16.size(), kept, gaps);
             } else {
-              memcpy(raw.data(), buffer, bytes_available);
+              std::vector<float> mono;
+              std::vector<float> mono16k;
+              if (ToMonoFloat(capture_format_, buffer, frames_read, mono)) {
+                ResampleLinear(mono, capture_format_->nSamplesPerSec, 16000, mono16k);
+                MonoFloatToPcm16(mono16k, pcm16);
+              }
+              level_meter_.Process(pcm16.data(), pcm16.size(), levels);
+              silence_compactor_.Process(pcm16.data(), pcm16.size(), kept, gaps);
             }
 
-            // Convert to 16kHz mono PCM16 so Dart can mix with mic audio safely.
-            std::vector<float> mono;
-            std::vector<float> mono16k;
-            std::vector<uint8_t> outPcm16;
-
-            if (ToMonoFloat(capture_format_, raw.data(), frames_read, mono)) {
-              ResampleLinear(mono, capture_format_->nSamplesPerSec, 16000, mono16k);
-              MonoFloatToPcm16Bytes(mono16k, outPcm16);
+            if (!levels.empty()) {
+              std::lock_guard<std::mutex> lock(level_mutex_);
+              if (level_callback_) {
+                for (const auto& level : levels) {
+                  level_callback_(level);
+                }
+              }
             }
 
-            if (!outPcm16.empty()) {
+            if (!kept.empty() || !gaps.empty()) {
               std::lock_guard<std::mutex> lock(frames_mutex_);
-              // Append bytes.
-              for (const auto b : outPcm16) {
-                audio_bytes_.push_back(b);
+              // Append bytes (Windows is little-endian, so int16 storage is
+              // already PCM16LE). The ring drops the oldest audio on overflow.
+              const size_t dropped = audio_bytes_.Write(reinterpret_cast<const uint8_t*>(kept.data()),
+                                                        kept.size() * sizeof(int16_t));
+
+              // The kept samples fill this packet's span of the timeline
+              // around its gaps (which the compactor emits in order).
+              uint64_t pos = packet_start;
+              for (const auto& gap : gaps) {
+                queued_timeline_.Append(pos, gap.start_sample - pos);
+                pos = gap.start_sample + gap.length;
               }
+              queued_timeline_.Append(pos, silence_compactor_.next_sample() - pos);
 
-              // Cap buffer to ~2 seconds of audio at 16kHz mono PCM16.
-              // 16000 samples/sec * 2 bytes/sample * 2 sec = 64000 bytes.
-              while (audio_bytes_.size() > 64000) {
-                audio_bytes_.pop_front();
+              for (const auto& gap : gaps) {
+                InsertGap(pending_gaps_, gap);
+              }
+              // Audio the ring dropped becomes a gap too, so the receiver's
+              // timeline stays continuous.
+              queued_timeline_.PopFront(dropped / sizeof(int16_t), &pending_gaps_);
+              if (pending_gaps_.size() > kMaxPendingGaps) {
+                pending_gaps_.erase(pending_gaps_.begin(),
+                                    pending_gaps_.begin() + static_cast<std::ptrdiff_t>(pending_gaps_.size() - kMaxPendingGaps));
               }
             }
           }
@@ -1,9 +1,9 @@
 #pragma once
 
 #include <flutter/standard_method_codec.h>
+#include <functional>
 #include <memory>
 #include <vector>
-#include <deque>
 #include <thread>
 #include <mutex>
 #include <comdef.h>
@@ -11,14 +11,35 @@
 #include <mmdeviceapi.h>
 #include <mmreg.h>
 
+#include "audio_level_meter.h"
+#include "pcm16_pipeline.h"
+#include "pcm_ring_buffer.h"
+#include "sample_timeline.h"
+#include "silence_compactor.h"
+
 class AudioCapture {
  public:
+  // The system audio queue: ~2 seconds of 16kHz mono PCM16
+  // (16000 samples/sec * 2 bytes/sample * 2 sec). No frame read can return
+  // more than this.
+  static constexpr size_t kSystemAudioBufferBytes = 64000;
+
   AudioCapture();
   ~AudioCapture();
 
   bool StartSystemAudio();
   void StopSystemAudio();
-  std::vector<uint8_t> GetSystemAudioFrame(size_t requested_bytes);
+  // Copies up to |requested_bytes| of queued 16kHz mono PCM16 into |out|
+  // (which must hold that many bytes) and returns the number written, always
+  // whole samples.
+  size_t ReadSystemAudioFrame(uint8_t* out, size_t requested_bytes);
+  // Drains the silence runs compacted out of the stream, and the audio the
+  // queue dropped on overflow, since the last call.
+  std::vector<AudioGap> TakeSystemAudioGaps();
+
+  // Receives level/waveform snapshots (~every 80 ms) on the capture thread
+  // while set. Setting nullptr waits for an in-flight callback to return.
+  void SetLevelCallback(std::function<void(const AudioLevelSnapshot&)> callback);
 
  private:
   bool is_capturing_ = false;
@@ -35,8 +56,25 @@ class AudioCapture {
   std::thread* capture_thread_ = nullptr;
   
   // Audio byte buffer (16kHz mono PCM16)
-  std::deque<uint8_t> audio_bytes_;
+  PcmRingBuffer audio_bytes_;
+  // Timeline positions of the samples in |audio_bytes_|.
+  SampleTimeline queued_timeline_;
+  // Silence removed from |audio_bytes_|, and audio it dropped on overflow,
+  // on the same 16kHz sample timeline. Sorted by start.
+  std::vector<AudioGap> pending_gaps_;
   std::mutex frames_mutex_;
+
+  // Only touched by the capture thread (and reset before it starts).
+  SilenceCompactor silence_compactor_;
+  // Set when the endpoint mix format is PCM16: selects the fixed-point
+  // downmix/resample path instead of the float one.
+  std::unique_ptr<Pcm16Decimator> pcm16_decimator_;
+  // Downmix scratch for the fixed-point path, reused across packets.
+  std::vector<int16_t> pcm16_mono_;
+  AudioLevelMeter level_meter_;
+
+  std::mutex level_mutex_;
+  std::function<void(const AudioLevelSnapshot&)> level_callback_;
   
   // Capture thread function
   void CaptureThreadProc();
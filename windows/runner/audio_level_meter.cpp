@@ -0,0 +1,88 @@
+#include "audio_level_meter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+AudioLevelMeter::AudioLevelMeter(uint32_t window_samples, uint32_t bins)
+    : window_samples_(window_samples > 0 ? window_samples : 1),
+      bins_(bins > 0 ? bins : 1) {
+  bins_ = (std::min)(bins_, window_samples_);
+  bin_samples_ = window_samples_ / bins_;
+  window_samples_ = bin_samples_ * bins_;
+  Reset();
+}
+
+void AudioLevelMeter::Reset() {
+  next_sample_ = 0;
+  filled_ = 0;
+  sum_squares_ = 0;
+  peak_ = 0;
+  // Empty bins: the first sample sets both ends.
+  bin_min_.assign(bins_, INT16_MAX);
+  bin_max_.assign(bins_, INT16_MIN);
+}
+
+void AudioLevelMeter::Process(const int16_t* samples,
+                              size_t count,
+                              std::vector<AudioLevelSnapshot>& out) {
+  if (!samples) return;
+  for (size_t i = 0; i < count; i++) {
+    Accumulate(samples[i]);
+    FlushIfComplete(out);
+  }
+}
+
+void AudioLevelMeter::AddSilence(size_t count, std::vector<AudioLevelSnapshot>& out) {
+  while (count > 0) {
+    // Zeros leave the level accumulators untouched; only the bins they
+    // land in take 0 into their range.
+    const size_t step = (std::min)(count, static_cast<size_t>(window_samples_ - filled_));
+    const uint32_t first_bin = filled_ / bin_samples_;
+    const uint32_t last_bin = (filled_ + static_cast<uint32_t>(step) - 1) / bin_samples_;
+    for (uint32_t b = first_bin; b <= last_bin; b++) {
+      bin_min_[b] = (std::min)(bin_min_[b], static_cast<int16_t>(0));
+      bin_max_[b] = (std::max)(bin_max_[b], static_cast<int16_t>(0));
+    }
+    filled_ += static_cast<uint32_t>(step);
+    next_sample_ += step;
+    count -= step;
+    FlushIfComplete(out);
+  }
+}
+
+void AudioLevelMeter::Accumulate(int32_t sample) {
+  const uint32_t bin = filled_ / bin_samples_;
+  const int16_t s = static_cast<int16_t>(sample);
+  if (s < bin_min_[bin]) bin_min_[bin] = s;
+  if (s > bin_max_[bin]) bin_max_[bin] = s;
+  const int32_t mag = sample < 0 ? -sample : sample;
+  if (mag > peak_) peak_ = mag;
+  sum_squares_ += static_cast<uint64_t>(static_cast<int64_t>(sample) * sample);
+  filled_++;
+  next_sample_++;
+}
+
+void AudioLevelMeter::FlushIfComplete(std::vector<AudioLevelSnapshot>& out) {
+  if (filled_ < window_samples_) return;
+
+  constexpr float kScale = 1.0f / 32768.0f;
+  AudioLevelSnapshot snap;
+  const double mean_square = static_cast<double>(sum_squares_) / window_samples_;
+  snap.rms = static_cast<float>(std::sqrt(mean_square)) * kScale;
+  snap.peak = static_cast<float>(peak_) * kScale;
+  snap.waveform.resize(static_cast<size_t>(bins_) * 2);
+  for (uint32_t b = 0; b < bins_; b++) {
+    snap.waveform[b * 2] = static_cast<float>(bin_min_[b]) * kScale;
+    snap.waveform[b * 2 + 1] = static_cast<float>(bin_max_[b]) * kScale;
+  }
+  snap.end_sample = next_sample_;
+  out.push_back(std::move(snap));
+
+  filled_ = 0;
+  sum_squares_ = 0;
+  peak_ = 0;
+  std::fill(bin_min_.begin(), bin_min_.end(), static_cast<int16_t>(INT16_MAX));
+  std::fill(bin_max_.begin(), bin_max_.end(), static_cast<int16_t>(INT16_MIN));
+}
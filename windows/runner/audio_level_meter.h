@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One metering window of the 16kHz mono PCM16 stream, normalized to [-1, 1].
+struct AudioLevelSnapshot {
+  float rms = 0.0f;
+  float peak = 0.0f;
+  // |bins| (min, max) pairs across the window, interleaved.
+  std::vector<float> waveform;
+  // Timeline sample index just past the end of the window.
+  uint64_t end_sample = 0;
+};
+
+// Reduces PCM to a few dozen floats per window for UI level meters, so the UI
+// never has to pull raw audio just to draw activity.
+class AudioLevelMeter {
+ public:
+  // Default: 1280 samples (80 ms at 16kHz) split into 16 waveform bins.
+  explicit AudioLevelMeter(uint32_t window_samples = 1280, uint32_t bins = 16);
+
+  void Reset();
+
+  // Feeds |count| samples; every completed window is appended to |out|.
+  void Process(const int16_t* samples,
+               size_t count,
+               std::vector<AudioLevelSnapshot>& out);
+
+  // Feeds |count| samples of digital silence without materializing them.
+  void AddSilence(size_t count, std::vector<AudioLevelSnapshot>& out);
+
+ private:
+  void Accumulate(int32_t sample);
+  void FlushIfComplete(std::vector<AudioLevelSnapshot>& out);
+
+  uint32_t window_samples_;
+  uint32_t bins_;
+  uint32_t bin_samples_;
+
+  uint64_t next_sample_ = 0;
+  uint32_t filled_ = 0;
+  uint64_t sum_squares_ = 0;
+  int32_t peak_ = 0;
+  std::vector<int16_t> bin_min_;
+  std::vector<int16_t> bin_max_;
+};
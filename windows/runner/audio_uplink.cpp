@@ -0,0 +1,308 @@
+#include "audio_uplink.h"
+
+#include <chrono>
+#include <iostream>
+#include <utility>
+
+namespace {
+
+// How often the uplink thread drains the capture ring and checks budgets.
+constexpr auto kTick = std::chrono::milliseconds(20);
+
+// Coalescing: send at least every 200 ms, at most 0.5 s of PCM per frame.
+constexpr uint32_t kLatencyBudgetMs = 200;
+constexpr size_t kMaxFrameBytes = 16000;
+constexpr size_t kMaxPendingBytes = 64000;
+
+// Backpressure thresholds.
+constexpr size_t kStallQueueFrames = 4;
+constexpr size_t kMaxQueuedFrames = 16;
+constexpr double kStallSendMs = 250.0;
+
+// Disconnect lets a session flush for this long before aborting its
+// transport to cancel whatever call it is blocked in.
+constexpr auto kCloseGrace = std::chrono::milliseconds(500);
+
+uint64_t NowMs() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count());
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+AudioUplink::AudioUplink(TransportFactory make_transport,
+                         MessageCallback on_message,
+                         ClosedCallback on_closed)
+    : make_transport_(std::move(make_transport)),
+      on_message_(std::move(on_message)),
+      on_closed_(std::move(on_closed)),
+      batcher_(kLatencyBudgetMs, kMaxFrameBytes, kMaxPendingBytes) {}
+
+AudioUplink::~AudioUplink() {
+  // Shutting down: don't wait for the flush, cancel whatever is blocked.
+  Disconnect();
+  AbortTransport();
+  if (reaper_.joinable()) {
+    reaper_.join();
+  }
+}
+
+bool AudioUplink::Connect(const std::wstring& url) {
+  if (running_) return false;
+  if (reaper_.joinable()) {
+    // A session still winding down from Disconnect is being replaced; cut
+    // its flush short.
+    AbortTransport();
+    reaper_.join();
+  }
+  if (uplink_thread_.joinable()) {
+    // Previous session ended on its own (remote close); reap it.
+    uplink_thread_.join();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batcher_.Clear();
+    stats_ = UplinkStats();
+    stall_until_ms_ = 0;
+    wake_ = false;
+    session_done_ = false;
+  }
+  std::shared_ptr<UplinkTransport> transport = make_transport_();
+  {
+    std::lock_guard<std::mutex> lock(transport_mutex_);
+    transport_ = transport;
+  }
+  closing_ = false;
+  closed_reported_ = false;
+  running_ = true;
+  uplink_thread_ = std::thread(&AudioUplink::UplinkThreadProc, this, url, std::move(transport));
+  return true;
+}
+
+void AudioUplink::Disconnect() {
+  if (!uplink_thread_.joinable()) return;
+  closing_ = true;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+    wake_ = true;
+  }
+  cv_.notify_all();
+  // The flush, or a handshake still in progress, can block in the
+  // transport, so the session is joined here rather than on the caller's
+  // (platform) thread. Past the grace period the transport is aborted.
+  reaper_ = std::thread([this, session = std::move(uplink_thread_)]() mutable {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (!cv_.wait_for(lock, kCloseGrace, [this]() { return session_done_; })) {
+        lock.unlock();
+        AbortTransport();
+      }
+    }
+    session.join();
+  });
+}
+
+void AudioUplink::SetSystemAudioSource(SystemAudioReader read_audio, SystemGapReader read_gaps) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  read_audio_ = std::move(read_audio);
+  read_gaps_ = std::move(read_gaps);
+}
+
+void AudioUplink::SendText(std::string text) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batcher_.AddControl(std::move(text));
+    wake_ = true;
+  }
+  cv_.notify_all();
+}
+
+void AudioUplink::SendAudio(const std::string& source, const uint8_t* data, size_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  batcher_.AddAudio(source, data, size, NowMs());
+}
+
+UplinkStats AudioUplink::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  UplinkStats stats = stats_;
+  stats.queue_depth = batcher_.queued_frames();
+  stats.queued_bytes = batcher_.pending_bytes();
+  stats.dropped_bytes = batcher_.dropped_bytes();
+  return stats;
+}
+
+void AudioUplink::UplinkThreadProc(std::wstring url, std::shared_ptr<UplinkTransport> transport) {
+  std::string error;
+  double handshake_ms = 0.0;
+  if (!transport->Open(url, handshake_ms, error)) {
+    if (!closing_) std::cerr << "[AudioUplink] Connect failed: " << error << std::endl;
+    transport->Close();
+    running_ = false;
+    ReportClosed(error);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      session_done_ = true;
+    }
+    cv_.notify_all();
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.connected = true;
+    stats_.handshake_ms = handshake_ms;
+  }
+  receive_thread_ = std::thread(&AudioUplink::ReceiveThreadProc, this, transport.get());
+
+  std::vector<UplinkFrame> frames;
+  bool stopping = false;
+  while (!stopping) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait_for(lock, kTick, [this]() { return wake_ || !running_; });
+      wake_ = false;
+      stopping = !running_;
+    }
+
+    const uint64_t now = NowMs();
+    if (!stopping) {
+      PumpSystemAudio(now);
+    }
+
+    frames.clear();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      batcher_.TrimReadyAudio(kMaxQueuedFrames);
+      batcher_.TakeReady(now, stopping, frames);
+    }
+    for (const auto& frame : frames) {
+      if (!SendFrame(*transport, frame)) {
+        stopping = true;
+        break;
+      }
+    }
+  }
+
+  // Closing the transport also ends the blocking receive.
+  closing_ = true;
+  transport->Close();
+  if (receive_thread_.joinable()) {
+    receive_thread_.join();
+  }
+  running_ = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.connected = false;
+    session_done_ = true;
+  }
+  cv_.notify_all();
+}
+
+void AudioUplink::ReceiveThreadProc(UplinkTransport* transport) {
+  std::string message;
+  std::string error;
+  while (!closing_) {
+    const UplinkTransport::ReceiveStatus status = transport->Receive(message, error);
+    if (status == UplinkTransport::ReceiveStatus::kFailed) {
+      if (!closing_) ReportClosed(error);
+      break;
+    }
+    if (status == UplinkTransport::ReceiveStatus::kClosed) {
+      if (!closing_) ReportClosed(std::string());
+      break;
+    }
+    if (on_message_) on_message_(std::move(message));
+  }
+}
+
+void AudioUplink::AbortTransport() {
+  closing_ = true;
+  std::lock_guard<std::mutex> lock(transport_mutex_);
+  if (transport_) transport_->Abort();
+}
+
+void AudioUplink::PumpSystemAudio(uint64_t now_ms) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // Socket is behind: leave system audio in the capture ring, which keeps the
+  // newest ~2 s as history, rather than growing our own queue.
+  stats_.stalled = batcher_.queued_frames() >= kStallQueueFrames || now_ms < stall_until_ms_;
+  if (stats_.stalled) return;
+
+  // Audio first, then gaps, but the gaps go out first: every gap that
+  // precedes audio read here is then in hand. A gap may run ahead of the
+  // audio (it carries its absolute startSample), never behind it.
+  system_audio_.clear();
+  if (read_audio_) {
+    uint8_t scratch[3200];
+    size_t n = 0;
+    do {
+      n = read_audio_(scratch, sizeof(scratch));
+      system_audio_.insert(system_audio_.end(), scratch, scratch + n);
+    } while (n == sizeof(scratch));
+  }
+
+  if (read_gaps_) {
+    for (const auto& gap : read_gaps_()) {
+      stats_.gap_samples += gap.length;
+      batcher_.AddControl("{\"type\":\"audio_gap\",\"source\":\"system\",\"startSample\":" +
+                          std::to_string(gap.start_sample) +
+                          ",\"samples\":" + std::to_string(gap.length) +
+                          ",\"sampleRate\":16000}");
+    }
+  }
+
+  if (!system_audio_.empty()) {
+    batcher_.AddAudio("system", system_audio_.data(), system_audio_.size(), now_ms);
+    stats_.system_bytes_read += system_audio_.size();
+  }
+}
+
+bool AudioUplink::SendFrame(UplinkTransport& transport, const UplinkFrame& frame) {
+  const auto start = std::chrono::steady_clock::now();
+  std::string error;
+  const bool sent = transport.SendText(frame.text, error);
+  const double send_ms = ElapsedMs(start);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Back off reading system audio for as long as the send blocked. Waiting
+    // for the next send to come back fast instead would never end once only
+    // system audio is flowing, since nothing more gets queued to send.
+    if (send_ms > kStallSendMs) {
+      stall_until_ms_ = NowMs() + static_cast<uint64_t>(send_ms);
+    }
+    stats_.send_latency_ms = stats_.frames_sent == 0
+        ? send_ms
+        : stats_.send_latency_ms * 0.8 + send_ms * 0.2;
+    if (sent) {
+      stats_.frames_sent++;
+      stats_.bytes_sent += frame.text.size();
+      stats_.audio_bytes_sent += frame.audio_bytes;
+    }
+  }
+
+  if (!sent) {
+    ReportClosed(error);
+    return false;
+  }
+  return true;
+}
+
+void AudioUplink::ReportClosed(const std::string& error) {
+  // A session we are closing ourselves is not reported.
+  if (closing_ || closed_reported_.exchange(true)) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+    wake_ = true;
+  }
+  cv_.notify_all();
+  if (on_closed_) on_closed_(error);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "silence_compactor.h"
+#include "uplink_batcher.h"
+#include "uplink_transport.h"
+
+struct UplinkStats {
+  bool connected = false;
+  // Stalled: the send backlog is deep or the last send blocked, so system
+  // audio is being left in the capture ring (history) instead of queued.
+  bool stalled = false;
+  // HTTP upgrade round trip (request sent -> 101 received).
+  double handshake_ms = 0.0;
+  // Smoothed time a send blocks per frame. Stands in for a round-trip time:
+  // WinHTTP can't send pings and the server doesn't acknowledge audio, and
+  // a backed-up path shows up here first.
+  double send_latency_ms = 0.0;
+  size_t queue_depth = 0;
+  size_t queued_bytes = 0;
+  uint64_t frames_sent = 0;
+  uint64_t bytes_sent = 0;
+  uint64_t audio_bytes_sent = 0;
+  uint64_t dropped_bytes = 0;
+  uint64_t system_bytes_read = 0;
+  uint64_t gap_samples = 0;
+};
+
+// Native owner of the transcription WebSocket.
+//
+// System audio is drained straight from AudioCapture on the uplink thread
+// and coalesced (with any mic audio pushed from Dart) into larger frames
+// under a latency budget, so audio no longer crosses into Dart and back out.
+// Server messages are delivered through |on_message| on the receive thread;
+// owners marshal them to the platform thread. Each session gets a fresh
+// transport from |make_transport|.
+class AudioUplink {
+ public:
+  using TransportFactory = std::function<std::unique_ptr<UplinkTransport>()>;
+  using MessageCallback = std::function<void(std::string message)>;
+  using ClosedCallback = std::function<void(const std::string& error)>;
+  using SystemAudioReader = std::function<size_t(uint8_t* out, size_t capacity)>;
+  using SystemGapReader = std::function<std::vector<AudioGap>()>;
+
+  AudioUplink(TransportFactory make_transport, MessageCallback on_message, ClosedCallback on_closed);
+  ~AudioUplink();
+
+  // Starts connecting to |url| (ws:// or wss://) in the background. Messages
+  // sent before the upgrade completes are queued. Returns false if already
+  // connected.
+  bool Connect(const std::wstring& url);
+
+  // Stops the session without blocking the caller: queued frames are flushed
+  // and the socket closed on the uplink thread, which a reaper thread joins.
+  // A session that has not wound down within a short grace period (e.g.
+  // stuck in the handshake or a send) has its transport aborted, which
+  // cancels the blocked call. Not reported through |on_closed|.
+  void Disconnect();
+
+  void SetSystemAudioSource(SystemAudioReader read_audio, SystemGapReader read_gaps);
+
+  // Control message (already JSON); sent after any audio queued before it.
+  void SendText(std::string text);
+
+  // PCM16 from another source (e.g. the Dart mic stream), batched like
+  // system audio.
+  void SendAudio(const std::string& source, const uint8_t* data, size_t size);
+
+  UplinkStats GetStats();
+
+ private:
+  void UplinkThreadProc(std::wstring url, std::shared_ptr<UplinkTransport> transport);
+  void ReceiveThreadProc(UplinkTransport* transport);
+  // Aborts the current session's transport from any thread.
+  void AbortTransport();
+  void PumpSystemAudio(uint64_t now_ms);
+  bool SendFrame(UplinkTransport& transport, const UplinkFrame& frame);
+  void ReportClosed(const std::string& error);
+
+  TransportFactory make_transport_;
+  MessageCallback on_message_;
+  ClosedCallback on_closed_;
+
+  std::thread uplink_thread_;
+  std::thread receive_thread_;
+  // Joins a disconnected session's uplink thread.
+  std::thread reaper_;
+  std::atomic<bool> running_{false};
+  std::atomic<bool> closing_{false};
+  std::atomic<bool> closed_reported_{false};
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool wake_ = false;
+  // Set when the uplink thread has finished its session.
+  bool session_done_ = false;
+  UplinkBatcher batcher_;
+  SystemAudioReader read_audio_;
+  SystemGapReader read_gaps_;
+  UplinkStats stats_;
+  // A slow send holds system audio back in the capture ring until then.
+  uint64_t stall_until_ms_ = 0;
+  // PumpSystemAudio's read buffer, reused across pumps.
+  std::vector<uint8_t> system_audio_;
+
+  // The current session's transport; the uplink thread holds its own
+  // reference.
+  std::mutex transport_mutex_;
+  std::shared_ptr<UplinkTransport> transport_;
+};
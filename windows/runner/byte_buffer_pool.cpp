@@ -0,0 +1,30 @@
+#include "byte_buffer_pool.h"
+
+#include <utility>
+
+ByteBufferPool::ByteBufferPool(size_t max_buffers) : max_buffers_(max_buffers) {}
+
+std::vector<uint8_t> ByteBufferPool::Acquire(size_t size) {
+  std::vector<uint8_t> buffer;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Prefer the most recently released buffer that is already large enough.
+    for (size_t i = free_.size(); i > 0; i--) {
+      if (free_[i - 1].capacity() >= size) {
+        buffer = std::move(free_[i - 1]);
+        free_.erase(free_.begin() + static_cast<std::ptrdiff_t>(i - 1));
+        break;
+      }
+    }
+  }
+  buffer.resize(size);
+  return buffer;
+}
+
+void ByteBufferPool::Release(std::vector<uint8_t>&& buffer) {
+  if (buffer.capacity() == 0) return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (free_.size() >= max_buffers_) return;
+  buffer.clear();
+  free_.push_back(std::move(buffer));
+}
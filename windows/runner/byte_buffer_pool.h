@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Recycles std::vector<uint8_t> storage for channel results.
+//
+// The StandardMethodCodec serializes a result synchronously inside
+// MethodResult::Success, so once that returns the vector held by the
+// EncodableValue can be moved back here and reused for the next reply.
+class ByteBufferPool {
+ public:
+  explicit ByteBufferPool(size_t max_buffers);
+
+  // Returns a buffer resized to |size|, reusing pooled capacity if possible.
+  std::vector<uint8_t> Acquire(size_t size);
+
+  // Hands a buffer back; it is dropped if the pool is already full.
+  void Release(std::vector<uint8_t>&& buffer);
+
+ private:
+  const size_t max_buffers_;
+  std::mutex mutex_;
+  std::vector<std::vector<uint8_t>> free_;
+};
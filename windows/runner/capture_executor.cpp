@@ -0,0 +1,98 @@
+#include "capture_executor.h"
+
+#include <utility>
+
+CaptureExecutor::CaptureExecutor(size_t thread_count) {
+  if (thread_count == 0) thread_count = 1;
+  for (size_t i = 0; i < thread_count; i++) {
+    threads_.emplace_back(&CaptureExecutor::Run, this);
+  }
+}
+
+CaptureExecutor::~CaptureExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    for (auto& entry : jobs_) entry.second.cancelled = true;
+  }
+  cv_.notify_all();
+  for (auto& thread : threads_) {
+    if (thread.joinable()) thread.join();
+  }
+}
+
+CaptureExecutor::JobId CaptureExecutor::Submit(Step step, std::chrono::milliseconds delay) {
+  if (!step) return 0;
+  JobId id = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) return 0;
+    id = next_id_++;
+    Job job;
+    job.step = std::move(step);
+    job.due = Clock::now() + delay;
+    jobs_.emplace(id, std::move(job));
+  }
+  cv_.notify_one();
+  return id;
+}
+
+bool CaptureExecutor::Cancel(JobId id) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = jobs_.find(id);
+    if (it == jobs_.end() || it->second.cancelled) return false;
+    it->second.cancelled = true;
+  }
+  cv_.notify_all();
+  return true;
+}
+
+void CaptureExecutor::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    if (stopping_ && jobs_.empty()) return;
+
+    // Earliest runnable job; cancelled jobs are due immediately.
+    auto next = jobs_.end();
+    Clock::time_point next_due = Clock::time_point::max();
+    for (auto it = jobs_.begin(); it != jobs_.end(); ++it) {
+      if (it->second.running) continue;
+      const Clock::time_point due = it->second.cancelled ? Clock::time_point::min() : it->second.due;
+      if (next == jobs_.end() || due < next_due) {
+        next = it;
+        next_due = due;
+      }
+    }
+    if (next == jobs_.end()) {
+      cv_.wait(lock);
+      continue;
+    }
+    if (next_due > Clock::now()) {
+      cv_.wait_until(lock, next_due);
+      continue;
+    }
+
+    const JobId id = next->first;
+    const bool cancelled = next->second.cancelled;
+    Step step = std::move(next->second.step);
+    next->second.running = true;
+
+    lock.unlock();
+    const CaptureStep result = step(cancelled);
+    lock.lock();
+
+    auto it = jobs_.find(id);
+    if (it != jobs_.end()) {
+      // A job gets exactly one call after cancellation.
+      if (result.done || cancelled) {
+        jobs_.erase(it);
+      } else {
+        it->second.step = std::move(step);
+        it->second.running = false;
+        it->second.due = Clock::now() + result.delay;
+      }
+    }
+    cv_.notify_all();
+  }
+}
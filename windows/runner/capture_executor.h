@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// What a capture job wants after running one step.
+struct CaptureStep {
+  bool done = true;
+  std::chrono::milliseconds delay{0};
+
+  static CaptureStep Done() { return CaptureStep{}; }
+  // Run the next step after |delay| (e.g. waiting for DWM or a restored
+  // window to repaint) without holding a worker thread.
+  static CaptureStep After(std::chrono::milliseconds delay) { return CaptureStep{false, delay}; }
+};
+
+// Small pool running capture jobs as sequences of non-blocking steps.
+//
+// A job is a step function called repeatedly until it returns Done(); waits
+// between steps are timers, not Sleep(), so one slow window never stalls
+// other captures. A cancelled job gets one final call with |cancelled| set,
+// in which it must undo side effects (re-minimize, etc.) and finish.
+// Completion is reported by the job itself (usually via PlatformTaskRunner).
+class CaptureExecutor {
+ public:
+  using JobId = uint64_t;
+  using Step = std::function<CaptureStep(bool cancelled)>;
+
+  explicit CaptureExecutor(size_t thread_count = 2);
+  // Cancels every job, lets each run its cancel step, then joins.
+  ~CaptureExecutor();
+
+  CaptureExecutor(const CaptureExecutor&) = delete;
+  CaptureExecutor& operator=(const CaptureExecutor&) = delete;
+
+  // Returns 0 if the executor is shutting down.
+  JobId Submit(Step step, std::chrono::milliseconds delay = std::chrono::milliseconds(0));
+
+  // The job's cancel step runs as soon as a worker is free (after its
+  // current step, if one is running). Returns false for unknown/finished ids.
+  bool Cancel(JobId id);
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Job {
+    Step step;
+    Clock::time_point due;
+    bool cancelled = false;
+    bool running = false;
+  };
+
+  void Run();
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::map<JobId, Job> jobs_;
+  JobId next_id_ = 1;
+  bool stopping_ = false;
+  std::vector<std::thread> threads_;
+};
@@ -0,0 +1,164 @@
+#include "capture_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+thread_local const std::string* g_current_method = nullptr;
+
+const std::string& OtherMethod() {
+  static const std::string other("other");
+  return other;
+}
+
+void AppendJsonString(std::string& out, const char* s) {
+  out += '"';
+  for (; *s; s++) {
+    const unsigned char c = static_cast<unsigned char>(*s);
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += static_cast<char>(c);
+    } else if (c < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      out += buf;
+    } else {
+      out += static_cast<char>(c);
+    }
+  }
+  out += '"';
+}
+
+}  // namespace
+
+void CaptureStats::Histogram::Add(uint64_t us) {
+  min_us = count == 0 ? us : (std::min)(min_us, us);
+  max_us = (std::max)(max_us, us);
+  count++;
+  total_us += us;
+  size_t bucket = 0;
+  for (uint64_t v = us; v != 0; v >>= 1) bucket++;
+  buckets[(std::min)(bucket, kBuckets - 1)]++;
+}
+
+uint64_t CaptureStats::Histogram::Percentile(double q) const {
+  if (count == 0) return 0;
+  const double clamped = (std::min)((std::max)(q, 0.0), 1.0);
+  const uint64_t rank = (std::max)(uint64_t{1}, static_cast<uint64_t>(std::ceil(clamped * static_cast<double>(count))));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBuckets; i++) {
+    seen += buckets[i];
+    if (seen >= rank) return (std::min)(BucketLimit(i), max_us);
+  }
+  return max_us;
+}
+
+uint64_t CaptureStats::Histogram::BucketLimit(size_t i) {
+  if (i + 1 >= kBuckets) return UINT64_MAX;
+  return (uint64_t{1} << i) - 1;
+}
+
+CaptureStats::CaptureStats() : epoch_(Clock::now()) {}
+
+uint64_t CaptureStats::Micros(Clock::time_point start, Clock::time_point end) {
+  if (end <= start) return 0;
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+}
+
+uint32_t CaptureStats::ThreadIndexLocked() {
+  auto it = thread_ids_.find(std::this_thread::get_id());
+  if (it != thread_ids_.end()) return it->second;
+  const uint32_t index = static_cast<uint32_t>(thread_ids_.size()) + 1;
+  thread_ids_[std::this_thread::get_id()] = index;
+  return index;
+}
+
+void CaptureStats::Record(const std::string& method, const char* stage, Clock::time_point start, Clock::time_point end) {
+  const uint64_t us = Micros(start, end);
+  std::lock_guard<std::mutex> lock(mutex_);
+  methods_[method].stages[stage].Add(us);
+  if (!tracing_) return;
+  if (events_.size() >= kMaxTraceEvents) events_.pop_front();
+  events_.push_back(TraceEvent{method, stage,
+                               std::chrono::duration_cast<std::chrono::microseconds>(start - epoch_).count(),
+                               static_cast<int64_t>(us), ThreadIndexLocked()});
+}
+
+void CaptureStats::RecordTotal(const std::string& method, Clock::time_point start, Clock::time_point end) {
+  const uint64_t us = Micros(start, end);
+  std::lock_guard<std::mutex> lock(mutex_);
+  methods_[method].total.Add(us);
+}
+
+std::map<std::string, CaptureStats::MethodStats> CaptureStats::Snapshot() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return methods_;
+}
+
+void CaptureStats::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  methods_.clear();
+}
+
+void CaptureStats::SetTracing(bool enabled) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (enabled && !tracing_) events_.clear();
+  tracing_ = enabled;
+}
+
+bool CaptureStats::tracing() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tracing_;
+}
+
+size_t CaptureStats::trace_event_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return events_.size();
+}
+
+std::string CaptureStats::TraceJson() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::string out;
+  out.reserve(64 + events_.size() * 96);
+  out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  for (const TraceEvent& e : events_) {
+    if (!first) out += ',';
+    first = false;
+    out += "{\"name\":";
+    AppendJsonString(out, e.stage);
+    out += ",\"cat\":";
+    AppendJsonString(out, e.method.c_str());
+    out += ",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(e.tid) + ",\"ts\":" + std::to_string(e.start_us) +
+           ",\"dur\":" + std::to_string(e.duration_us) + "}";
+  }
+  out += "]}";
+  return out;
+}
+
+ScopedCaptureMethod::ScopedCaptureMethod(const std::string& method) : previous_(g_current_method) {
+  g_current_method = &method;
+}
+
+ScopedCaptureMethod::~ScopedCaptureMethod() {
+  g_current_method = previous_;
+}
+
+const std::string& ScopedCaptureMethod::Current() {
+  return g_current_method ? *g_current_method : OtherMethod();
+}
+
+ScopedStageTimer::ScopedStageTimer(CaptureStats& stats, const char* stage)
+    : stats_(stats), stage_(stage), start_(CaptureStats::Clock::now()) {}
+
+ScopedStageTimer::~ScopedStageTimer() {
+  Stop();
+}
+
+void ScopedStageTimer::Stop() {
+  if (stopped_) return;
+  stopped_ = true;
+  stats_.Record(ScopedCaptureMethod::Current(), stage_, start_, CaptureStats::Clock::now());
+}
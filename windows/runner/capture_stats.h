@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Latency histograms for the capture pipeline, plus an optional trace.
+//
+// Stages (PrintWindow, DWM fallbacks, the restore settle wait, DIB copies,
+// scaling, encoding, the channel reply, ...) are timed with
+// ScopedStageTimer and filed under the method running on the current thread
+// (see ScopedCaptureMethod). Every method keeps a histogram of whole-call
+// latency and one per stage. While tracing is on, each stage is also kept
+// as a Chrome trace event for chrome://tracing or Perfetto. Thread-safe
+// (platform-neutral).
+class CaptureStats {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // Bucket 0 holds 0 us; bucket i holds [2^(i-1), 2^i) us; the last one
+  // also takes everything longer (~67 s and up).
+  static constexpr size_t kBuckets = 28;
+  // Oldest trace events are dropped past this.
+  static constexpr size_t kMaxTraceEvents = 100000;
+
+  struct Histogram {
+    uint64_t count = 0;
+    uint64_t total_us = 0;
+    uint64_t min_us = 0;
+    uint64_t max_us = 0;
+    std::array<uint64_t, kBuckets> buckets{};
+
+    void Add(uint64_t us);
+    // Upper bound of the bucket holding quantile |q| (0..1), capped at
+    // |max_us|; 0 when empty.
+    uint64_t Percentile(double q) const;
+    // Largest value bucket |i| holds.
+    static uint64_t BucketLimit(size_t i);
+  };
+
+  struct MethodStats {
+    // Whole calls: submit to reply for captures, handler time otherwise.
+    Histogram total;
+    std::map<std::string, Histogram> stages;
+  };
+
+  CaptureStats();
+
+  CaptureStats(const CaptureStats&) = delete;
+  CaptureStats& operator=(const CaptureStats&) = delete;
+
+  // Files one stage of |method| (traced when tracing is on).
+  void Record(const std::string& method, const char* stage, Clock::time_point start, Clock::time_point end);
+  // Files one whole call of |method|.
+  void RecordTotal(const std::string& method, Clock::time_point start, Clock::time_point end);
+
+  std::map<std::string, MethodStats> Snapshot() const;
+  // Clears the histograms (not the trace).
+  void Reset();
+
+  // Turning tracing on drops any earlier events.
+  void SetTracing(bool enabled);
+  bool tracing() const;
+  size_t trace_event_count() const;
+  // {"traceEvents": [...]} with one complete ("X") event per traced stage;
+  // timestamps are microseconds since this object was created.
+  std::string TraceJson() const;
+
+ private:
+  struct TraceEvent {
+    std::string method;
+    const char* stage;
+    int64_t start_us;
+    int64_t duration_us;
+    uint32_t tid;
+  };
+
+  static uint64_t Micros(Clock::time_point start, Clock::time_point end);
+  uint32_t ThreadIndexLocked();
+
+  const Clock::time_point epoch_;
+  mutable std::mutex mutex_;
+  std::map<std::string, MethodStats> methods_;
+  bool tracing_ = false;
+  std::deque<TraceEvent> events_;
+  std::map<std::thread::id, uint32_t> thread_ids_;
+};
+
+// Names the method that stage timers on this thread are filed under until
+// it goes out of scope (scopes nest). |method| must outlive the scope.
+class ScopedCaptureMethod {
+ public:
+  explicit ScopedCaptureMethod(const std::string& method);
+  ~ScopedCaptureMethod();
+
+  ScopedCaptureMethod(const ScopedCaptureMethod&) = delete;
+  ScopedCaptureMethod& operator=(const ScopedCaptureMethod&) = delete;
+
+  // The innermost method on this thread, or "other".
+  static const std::string& Current();
+
+ private:
+  const std::string* previous_;
+};
+
+// Times the enclosing block as |stage| of ScopedCaptureMethod::Current().
+// |stage| must be a string literal (trace events keep the pointer).
+class ScopedStageTimer {
+ public:
+  ScopedStageTimer(CaptureStats& stats, const char* stage);
+  ~ScopedStageTimer();
+
+  ScopedStageTimer(const ScopedStageTimer&) = delete;
+  ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+  // Records now instead of at scope exit.
+  void Stop();
+
+ private:
+  CaptureStats& stats_;
+  const char* stage_;
+  CaptureStats::Clock::time_point start_;
+  bool stopped_ = false;
+};
@@ -0,0 +1,56 @@
+#include "capture_texture.h"
+
+#include <utility>
+
+#include "pixel_convert.h"
+
+CaptureTexture::CaptureTexture(flutter::TextureRegistrar* registrar)
+    : registrar_(registrar), buffers_(std::make_shared<Buffers>()) {
+  if (!registrar_) return;
+  std::shared_ptr<Buffers> buffers = buffers_;
+  texture_ = std::make_unique<flutter::TextureVariant>(flutter::PixelBufferTexture(
+      [buffers](size_t, size_t) -> const FlutterDesktopPixelBuffer* {
+        {
+          std::lock_guard<std::mutex> lock(buffers->swap_mutex);
+          if (buffers->has_ready) {
+            std::swap(buffers->engine, buffers->ready);
+            buffers->has_ready = false;
+          }
+        }
+        if (buffers->engine.rgba.empty()) return nullptr;
+        buffers->pixel_buffer.buffer = buffers->engine.rgba.data();
+        buffers->pixel_buffer.width = static_cast<size_t>(buffers->engine.width);
+        buffers->pixel_buffer.height = static_cast<size_t>(buffers->engine.height);
+        return &buffers->pixel_buffer;
+      }));
+  id_ = registrar_->RegisterTexture(texture_.get());
+}
+
+CaptureTexture::~CaptureTexture() {
+  if (!registrar_ || id_ < 0) return;
+  // The engine may still call the texture until unregistration completes.
+  std::shared_ptr<flutter::TextureVariant> texture(std::move(texture_));
+  registrar_->UnregisterTexture(id_, [texture]() {});
+}
+
+void CaptureTexture::Publish(const uint8_t* bgra, int width, int height, size_t stride) {
+  if (!bgra || width <= 0 || height <= 0 || id_ < 0) return;
+  if (stride == 0) stride = static_cast<size_t>(width) * 4;
+  {
+    std::lock_guard<std::mutex> write_lock(buffers_->write_mutex);
+    Frame& back = buffers_->back;
+    back.width = width;
+    back.height = height;
+    back.rgba.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+    // GDI leaves alpha undefined; previews are always opaque.
+    const size_t row_bytes = static_cast<size_t>(width) * 4;
+    for (int y = 0; y < height; y++) {
+      SwapRedBlueOpaque(bgra + static_cast<size_t>(y) * stride, back.rgba.data() + static_cast<size_t>(y) * row_bytes,
+                        static_cast<size_t>(width));
+    }
+    std::lock_guard<std::mutex> swap_lock(buffers_->swap_mutex);
+    std::swap(buffers_->ready, back);
+    buffers_->has_ready = true;
+  }
+  registrar_->MarkTextureFrameAvailable(id_);
+}
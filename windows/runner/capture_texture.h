@@ -0,0 +1,61 @@
+#pragma once
+
+#include <flutter/texture_registrar.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// A Flutter external texture showing the latest capture of one target.
+//
+// Capture workers Publish() BGRA frames straight into the texture; Dart only
+// holds the texture id, so previews skip the channel copy and the Dart-side
+// image decode. Frames are triple-buffered: writers fill a back buffer and
+// swap it in as "ready", and the engine's copy callback takes the ready one,
+// so neither side waits on the other. Create and destroy on the platform
+// thread; Publish() from any thread.
+class CaptureTexture {
+ public:
+  explicit CaptureTexture(flutter::TextureRegistrar* registrar);
+  // Unregisters; buffers stay alive until the engine lets go of them.
+  ~CaptureTexture();
+
+  CaptureTexture(const CaptureTexture&) = delete;
+  CaptureTexture& operator=(const CaptureTexture&) = delete;
+
+  // -1 if registration failed.
+  int64_t id() const { return id_; }
+
+  // Copies a top-down BGRA frame (|stride| 0 = width * 4) into the texture
+  // as opaque RGBA and tells the engine a new frame is available.
+  void Publish(const uint8_t* bgra, int width, int height, size_t stride);
+
+ private:
+  struct Frame {
+    std::vector<uint8_t> rgba;
+    int width = 0;
+    int height = 0;
+  };
+
+  // Shared with the engine callback, which can outlive this object until
+  // unregistration completes.
+  struct Buffers {
+    // Serializes writers; held while converting into |back|.
+    std::mutex write_mutex;
+    Frame back;
+    // Guards |ready| and |has_ready|.
+    std::mutex swap_mutex;
+    Frame ready;
+    bool has_ready = false;
+    // Render thread only.
+    Frame engine;
+    FlutterDesktopPixelBuffer pixel_buffer{};
+  };
+
+  flutter::TextureRegistrar* registrar_;
+  std::shared_ptr<Buffers> buffers_;
+  std::unique_ptr<flutter::TextureVariant> texture_;
+  int64_t id_ = -1;
+};
@@ -0,0 +1,450 @@
+#include "deflate.h"
+
+#include <algorithm>
+#include <array>
+#include <queue>
+#include <utility>
+
+namespace {
+
+constexpr size_t kWindowSize = 32768;
+constexpr size_t kWindowMask = kWindowSize - 1;
+constexpr int kHashBits = 15;
+constexpr size_t kHashSize = size_t{1} << kHashBits;
+constexpr size_t kMinMatch = 3;
+constexpr size_t kMaxMatch = 258;
+constexpr size_t kBlockTokens = 1 << 16;
+
+constexpr int kNumLitLen = 286;
+constexpr int kNumDist = 30;
+constexpr int kNumCodeLen = 19;
+
+constexpr uint16_t kLengthBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,
+                                      15, 17, 19, 23, 27, 31, 35, 43, 51,  59,
+                                      67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr uint8_t kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                      2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr uint16_t kDistBase[30] = {1,    2,    3,    4,    5,    7,     9,     13,
+                                    17,   25,   33,   49,   65,   97,    129,   193,
+                                    257,  385,  513,  769,  1025, 1537,  2049,  3073,
+                                    4097, 6145, 8193, 12289, 16385, 24577};
+constexpr uint8_t kDistExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+constexpr uint8_t kCodeLenOrder[kNumCodeLen] = {16, 17, 18, 0, 8,  7, 9,  6, 10, 5,
+                                                11, 4,  12, 3, 13, 2, 14, 1, 15};
+
+// Literal when |dist| == 0, otherwise a (length, distance) back-reference.
+struct Token {
+  uint16_t litlen;
+  uint16_t dist;
+};
+
+int LengthCode(size_t length) {
+  int code = 0;
+  while (code < 28 && kLengthBase[code + 1] <= length) code++;
+  return code;
+}
+
+int DistCode(size_t dist) {
+  int code = 0;
+  while (code < 29 && kDistBase[code + 1] <= dist) code++;
+  return code;
+}
+
+class BitWriter {
+ public:
+  explicit BitWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+  // LSB-first, as DEFLATE requires.
+  void Put(uint32_t bits, int count) {
+    buffer_ |= static_cast<uint64_t>(bits) << filled_;
+    filled_ += count;
+    while (filled_ >= 8) {
+      out_.push_back(static_cast<uint8_t>(buffer_));
+      buffer_ >>= 8;
+      filled_ -= 8;
+    }
+  }
+
+  void Flush() {
+    if (filled_ > 0) out_.push_back(static_cast<uint8_t>(buffer_));
+    buffer_ = 0;
+    filled_ = 0;
+  }
+
+ private:
+  std::vector<uint8_t>& out_;
+  uint64_t buffer_ = 0;
+  int filled_ = 0;
+};
+
+// Ensures at least two symbols are coded: zlib's inflate rejects incomplete
+// code-length codes, and a complete tree needs two leaves.
+void EnsureTwoSymbols(uint32_t* freq, int n) {
+  int used = 0;
+  for (int i = 0; i < n; i++) used += freq[i] ? 1 : 0;
+  for (int i = 0; i < n && used < 2; i++) {
+    if (!freq[i]) {
+      freq[i] = 1;
+      used++;
+    }
+  }
+}
+
+// Huffman code lengths limited to |max_bits|. When the optimal tree is too
+// deep, frequencies are flattened and the tree rebuilt.
+void BuildCodeLengths(const uint32_t* freq, int n, int max_bits, uint8_t* lengths) {
+  std::vector<uint32_t> f(freq, freq + n);
+  std::fill(lengths, lengths + n, static_cast<uint8_t>(0));
+  for (;;) {
+    struct Node {
+      uint64_t weight;
+      int left;
+      int right;
+    };
+    std::vector<Node> nodes;
+    using Entry = std::pair<uint64_t, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+    for (int i = 0; i < n; i++) {
+      if (f[i] == 0) continue;
+      nodes.push_back(Node{f[i], -1, i});
+      heap.push(Entry{f[i], static_cast<int>(nodes.size()) - 1});
+    }
+    if (nodes.empty()) return;
+    if (nodes.size() == 1) {
+      lengths[nodes[0].right] = 1;
+      return;
+    }
+    while (heap.size() > 1) {
+      const Entry a = heap.top();
+      heap.pop();
+      const Entry b = heap.top();
+      heap.pop();
+      nodes.push_back(Node{a.first + b.first, a.second, b.second});
+      heap.push(Entry{a.first + b.first, static_cast<int>(nodes.size()) - 1});
+    }
+
+    // Leaves have left == -1 and carry their symbol in |right|.
+    std::vector<int> depth(nodes.size(), 0);
+    int max_depth = 0;
+    for (int i = static_cast<int>(nodes.size()) - 1; i >= 0; i--) {
+      const Node& node = nodes[static_cast<size_t>(i)];
+      if (node.left < 0) {
+        lengths[node.right] = static_cast<uint8_t>(depth[static_cast<size_t>(i)]);
+        max_depth = (std::max)(max_depth, depth[static_cast<size_t>(i)]);
+      } else {
+        depth[static_cast<size_t>(node.left)] = depth[static_cast<size_t>(i)] + 1;
+        depth[static_cast<size_t>(node.right)] = depth[static_cast<size_t>(i)] + 1;
+      }
+    }
+    if (max_depth <= max_bits) return;
+    for (auto& v : f) {
+      if (v) v = (v + 1) / 2;
+    }
+  }
+}
+
+// Canonical codes, bit-reversed for the LSB-first writer.
+void BuildCodes(const uint8_t* lengths, int n, uint16_t* codes) {
+  std::array<uint16_t, 16> count{};
+  for (int i = 0; i < n; i++) count[lengths[i]]++;
+  count[0] = 0;
+  std::array<uint16_t, 16> next{};
+  uint16_t code = 0;
+  for (int bits = 1; bits < 16; bits++) {
+    code = static_cast<uint16_t>((code + count[bits - 1]) << 1);
+    next[bits] = code;
+  }
+  for (int i = 0; i < n; i++) {
+    const int len = lengths[i];
+    if (len == 0) {
+      codes[i] = 0;
+      continue;
+    }
+    uint16_t c = next[len]++;
+    uint16_t reversed = 0;
+    for (int b = 0; b < len; b++) {
+      reversed = static_cast<uint16_t>((reversed << 1) | (c & 1));
+      c >>= 1;
+    }
+    codes[i] = reversed;
+  }
+}
+
+struct CodeLenSymbol {
+  uint8_t symbol;
+  uint8_t extra;
+};
+
+// Run-length encodes the concatenated literal/length + distance code lengths
+// with symbols 16 (repeat previous), 17 and 18 (runs of zeros).
+void RunLengthEncode(const std::vector<uint8_t>& lengths, std::vector<CodeLenSymbol>& out) {
+  size_t i = 0;
+  while (i < lengths.size()) {
+    const uint8_t value = lengths[i];
+    size_t run = 1;
+    while (i + run < lengths.size() && lengths[i + run] == value) run++;
+    size_t left = run;
+    if (value == 0) {
+      while (left >= 11) {
+        const size_t r = (std::min)(left, size_t{138});
+        out.push_back(CodeLenSymbol{18, static_cast<uint8_t>(r - 11)});
+        left -= r;
+      }
+      if (left >= 3) {
+        out.push_back(CodeLenSymbol{17, static_cast<uint8_t>(left - 3)});
+        left = 0;
+      }
+    } else {
+      out.push_back(CodeLenSymbol{value, 0});
+      left--;
+      while (left >= 3) {
+        const size_t r = (std::min)(left, size_t{6});
+        out.push_back(CodeLenSymbol{16, static_cast<uint8_t>(r - 3)});
+        left -= r;
+      }
+    }
+    while (left > 0) {
+      out.push_back(CodeLenSymbol{value, 0});
+      left--;
+    }
+    i += run;
+  }
+}
+
+void WriteBlock(const std::vector<Token>& tokens, bool final_block, BitWriter& writer) {
+  uint32_t ll_freq[kNumLitLen] = {};
+  uint32_t dist_freq[kNumDist] = {};
+  for (const auto& t : tokens) {
+    if (t.dist == 0) {
+      ll_freq[t.litlen]++;
+    } else {
+      ll_freq[257 + LengthCode(t.litlen)]++;
+      dist_freq[DistCode(t.dist)]++;
+    }
+  }
+  ll_freq[256] = 1;
+  EnsureTwoSymbols(ll_freq, kNumLitLen);
+  EnsureTwoSymbols(dist_freq, kNumDist);
+
+  uint8_t ll_len[kNumLitLen];
+  uint8_t dist_len[kNumDist];
+  BuildCodeLengths(ll_freq, kNumLitLen, 15, ll_len);
+  BuildCodeLengths(dist_freq, kNumDist, 15, dist_len);
+  uint16_t ll_code[kNumLitLen];
+  uint16_t dist_code[kNumDist];
+  BuildCodes(ll_len, kNumLitLen, ll_code);
+  BuildCodes(dist_len, kNumDist, dist_code);
+
+  int hlit = kNumLitLen;
+  while (hlit > 257 && ll_len[hlit - 1] == 0) hlit--;
+  int hdist = kNumDist;
+  while (hdist > 1 && dist_len[hdist - 1] == 0) hdist--;
+
+  std::vector<uint8_t> all_lengths(ll_len, ll_len + hlit);
+  all_lengths.insert(all_lengths.end(), dist_len, dist_len + hdist);
+  std::vector<CodeLenSymbol> cl_symbols;
+  RunLengthEncode(all_lengths, cl_symbols);
+
+  uint32_t cl_freq[kNumCodeLen] = {};
+  for (const auto& s : cl_symbols) cl_freq[s.symbol]++;
+  EnsureTwoSymbols(cl_freq, kNumCodeLen);
+  uint8_t cl_len[kNumCodeLen];
+  uint16_t cl_code[kNumCodeLen];
+  BuildCodeLengths(cl_freq, kNumCodeLen, 7, cl_len);
+  BuildCodes(cl_len, kNumCodeLen, cl_code);
+  int hclen = kNumCodeLen;
+  while (hclen > 4 && cl_len[kCodeLenOrder[hclen - 1]] == 0) hclen--;
+
+  writer.Put(final_block ? 1 : 0, 1);
+  writer.Put(2, 2);  // dynamic Huffman
+  writer.Put(static_cast<uint32_t>(hlit - 257), 5);
+  writer.Put(static_cast<uint32_t>(hdist - 1), 5);
+  writer.Put(static_cast<uint32_t>(hclen - 4), 4);
+  for (int i = 0; i < hclen; i++) writer.Put(cl_len[kCodeLenOrder[i]], 3);
+  for (const auto& s : cl_symbols) {
+    writer.Put(cl_code[s.symbol], cl_len[s.symbol]);
+    if (s.symbol == 16) writer.Put(s.extra, 2);
+    else if (s.symbol == 17) writer.Put(s.extra, 3);
+    else if (s.symbol == 18) writer.Put(s.extra, 7);
+  }
+
+  for (const auto& t : tokens) {
+    if (t.dist == 0) {
+      writer.Put(ll_code[t.litlen], ll_len[t.litlen]);
+      continue;
+    }
+    const int lc = LengthCode(t.litlen);
+    writer.Put(ll_code[257 + lc], ll_len[257 + lc]);
+    if (kLengthExtra[lc]) writer.Put(t.litlen - kLengthBase[lc], kLengthExtra[lc]);
+    const int dc = DistCode(t.dist);
+    writer.Put(dist_code[dc], dist_len[dc]);
+    if (kDistExtra[dc]) writer.Put(t.dist - kDistBase[dc], kDistExtra[dc]);
+  }
+  writer.Put(ll_code[256], ll_len[256]);
+}
+
+uint32_t Hash3(const uint8_t* p) {
+  const uint32_t v = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                     (static_cast<uint32_t>(p[2]) << 16);
+  return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+}  // namespace
+
+uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc) {
+  static const std::array<uint32_t, 256> table = []() {
+    std::array<uint32_t, 256> t{};
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      t[n] = c;
+    }
+    return t;
+  }();
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+uint32_t Adler32(const uint8_t* data, size_t size, uint32_t adler) {
+  uint32_t a = adler & 0xFFFF;
+  uint32_t b = adler >> 16;
+  while (size > 0) {
+    // 5552 is the largest n with no uint32 overflow before the modulo.
+    const size_t n = (std::min)(size, size_t{5552});
+    for (size_t i = 0; i < n; i++) {
+      a += data[i];
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+    data += n;
+    size -= n;
+  }
+  return (b << 16) | a;
+}
+
+uint32_t Adler32Combine(uint32_t adler_a, uint32_t adler_b, size_t size_b) {
+  // Same arithmetic as zlib's adler32_combine.
+  constexpr uint64_t kBase = 65521;
+  const uint64_t rem = size_b % kBase;
+  uint64_t sum1 = adler_a & 0xFFFF;
+  uint64_t sum2 = (rem * sum1) % kBase;
+  sum1 += (adler_b & 0xFFFF) + kBase - 1;
+  sum2 += (adler_a >> 16) + (adler_b >> 16) + kBase - rem;
+  if (sum1 >= kBase) sum1 -= kBase;
+  if (sum1 >= kBase) sum1 -= kBase;
+  if (sum2 >= kBase * 2) sum2 -= kBase * 2;
+  if (sum2 >= kBase) sum2 -= kBase;
+  return static_cast<uint32_t>(sum1 | (sum2 << 16));
+}
+
+void DeflateSegment(const uint8_t* data, size_t dict_size, size_t size, int level, bool last,
+                    std::vector<uint8_t>& out) {
+  level = (std::max)(1, (std::min)(9, level));
+  static constexpr int kMaxChain[10] = {0, 4, 8, 16, 24, 32, 48, 96, 192, 512};
+  const int max_chain = kMaxChain[level];
+  const size_t nice_length = level >= 8 ? kMaxMatch : 128;
+
+  // Positions are relative to the start of the dictionary.
+  dict_size = (std::min)(dict_size, kWindowSize);
+  const uint8_t* base = data - dict_size;
+  const size_t end = dict_size + size;
+
+  BitWriter writer(out);
+  std::vector<int32_t> head(kHashSize, -1);
+  std::vector<int32_t> prev(kWindowSize, -1);
+  std::vector<Token> tokens;
+  tokens.reserve((std::min)(kBlockTokens, size + 1));
+
+  auto insert = [&](size_t pos) {
+    const uint32_t h = Hash3(base + pos);
+    prev[pos & kWindowMask] = head[h];
+    head[h] = static_cast<int32_t>(pos);
+  };
+  for (size_t pos = 0; pos < dict_size && pos + kMinMatch <= end; pos++) insert(pos);
+
+  bool wrote_final = false;
+  size_t pos = dict_size;
+  while (pos < end) {
+    size_t best_len = 0;
+    size_t best_dist = 0;
+    if (pos + kMinMatch <= end) {
+      const size_t limit = (std::min)(kMaxMatch, end - pos);
+      int32_t candidate = head[Hash3(base + pos)];
+      int chain = max_chain;
+      while (candidate >= 0 && chain-- > 0) {
+        const size_t cand = static_cast<size_t>(candidate);
+        if (cand >= pos || pos - cand > kWindowSize) break;
+        // Cheap reject: a longer match must agree at the current best length.
+        if (base[cand + best_len] == base[pos + best_len] || best_len == 0) {
+          size_t len = 0;
+          while (len < limit && base[cand + len] == base[pos + len]) len++;
+          if (len > best_len) {
+            best_len = len;
+            best_dist = pos - cand;
+            if (len >= nice_length || len == limit) break;
+          }
+        }
+        candidate = prev[cand & kWindowMask];
+      }
+      insert(pos);
+    }
+
+    if (best_len >= kMinMatch) {
+      tokens.push_back(Token{static_cast<uint16_t>(best_len), static_cast<uint16_t>(best_dist)});
+      for (size_t i = 1; i < best_len; i++) {
+        if (pos + i + kMinMatch <= end) insert(pos + i);
+      }
+      pos += best_len;
+    } else {
+      tokens.push_back(Token{base[pos], 0});
+      pos++;
+    }
+
+    if (tokens.size() >= kBlockTokens) {
+      wrote_final = last && pos >= end;
+      WriteBlock(tokens, wrote_final, writer);
+      tokens.clear();
+    }
+  }
+  if (last) {
+    if (!wrote_final) WriteBlock(tokens, true, writer);
+    writer.Flush();
+    return;
+  }
+  if (!tokens.empty()) WriteBlock(tokens, false, writer);
+  // Empty stored block: byte-aligns the stream like zlib's Z_SYNC_FLUSH.
+  writer.Put(0, 3);
+  writer.Flush();
+  const uint8_t kSyncMarker[4] = {0x00, 0x00, 0xFF, 0xFF};
+  out.insert(out.end(), kSyncMarker, kSyncMarker + 4);
+}
+
+void DeflateRaw(const uint8_t* data, size_t size, int level, std::vector<uint8_t>& out) {
+  DeflateSegment(data, 0, size, level, true, out);
+}
+
+void ZlibHeader(int level, std::vector<uint8_t>& out) {
+  // CMF: deflate, 32K window. FLG: level hint + check bits (CMF*256+FLG % 31 == 0).
+  const uint8_t cmf = 0x78;
+  const uint8_t flevel = level <= 1 ? 0 : (level < 6 ? 1 : (level == 6 ? 2 : 3));
+  uint8_t flg = static_cast<uint8_t>(flevel << 6);
+  flg = static_cast<uint8_t>(flg + (31 - ((cmf * 256 + flg) % 31)) % 31);
+  out.push_back(cmf);
+  out.push_back(flg);
+}
+
+void ZlibTrailer(uint32_t adler, std::vector<uint8_t>& out) {
+  out.push_back(static_cast<uint8_t>(adler >> 24));
+  out.push_back(static_cast<uint8_t>(adler >> 16));
+  out.push_back(static_cast<uint8_t>(adler >> 8));
+  out.push_back(static_cast<uint8_t>(adler));
+}
+
+void ZlibCompress(const uint8_t* data, size_t size, int level, std::vector<uint8_t>& out) {
+  ZlibHeader(level, out);
+  DeflateRaw(data, size, level, out);
+  ZlibTrailer(Adler32(data, size), out);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Minimal DEFLATE (RFC 1951) compressor with zlib (RFC 1950) framing, so the
+// runner can produce PNGs without pulling in zlib. Greedy LZ77 over hash
+// chains plus a dynamic Huffman block per ~64K tokens.
+
+uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+uint32_t Adler32(const uint8_t* data, size_t size, uint32_t adler = 1);
+
+// Adler-32 of A followed by B, from the checksums of each and B's length.
+uint32_t Adler32Combine(uint32_t adler_a, uint32_t adler_b, size_t size_b);
+
+// |level| 1..9 trades match search depth for ratio (6 ~= zlib default).
+void DeflateRaw(const uint8_t* data, size_t size, int level, std::vector<uint8_t>& out);
+
+// Compresses data[0, size) as raw DEFLATE blocks whose matches may reach
+// back into the |dict_size| bytes before |data| (up to 32 KiB), so
+// independently compressed pieces of one buffer keep most of their ratio
+// (pigz-style priming). Unless |last|, the output ends byte-aligned with an
+// empty stored block (zlib's sync flush) instead of a final block, and the
+// pieces concatenate into one valid stream. Appends to |out|.
+void DeflateSegment(const uint8_t* data, size_t dict_size, size_t size, int level, bool last,
+                    std::vector<uint8_t>& out);
+
+// The two-byte zlib header and the big-endian Adler-32 trailer.
+void ZlibHeader(int level, std::vector<uint8_t>& out);
+void ZlibTrailer(uint32_t adler, std::vector<uint8_t>& out);
+
+// DeflateRaw wrapped in a zlib header and Adler-32 trailer; appends to |out|.
+void ZlibCompress(const uint8_t* data, size_t size, int level, std::vector<uint8_t>& out);
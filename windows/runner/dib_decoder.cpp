@@ -0,0 +1,403 @@
+#include "dib_decoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "pixel_convert.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DIB_DECODER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr uint32_t kBiRgb = 0;
+constexpr uint32_t kBiBitfields = 3;
+constexpr uint32_t kBiAlphaBitfields = 6;
+
+constexpr size_t kFileHeaderSize = 14;
+constexpr size_t kInfoHeaderSize = 40;
+
+// 16384 x 16384; keeps width * height * 4 well inside size_t everywhere.
+constexpr uint64_t kMaxPixels = 1ull << 28;
+
+uint16_t ReadLe16(const uint8_t* p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t ReadLe32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Writes one pixel; |c0..c2| are already in output order.
+inline void Put(uint8_t* dst, uint8_t c0, uint8_t c1, uint8_t c2, uint8_t a) {
+  dst[0] = c0;
+  dst[1] = c1;
+  dst[2] = c2;
+  dst[3] = a;
+}
+
+// True for zero or a single run of set bits: adding the lowest set bit to
+// a run carries straight out of it.
+bool IsContiguousMask(uint32_t mask) {
+  const uint32_t low = mask & (~mask + 1u);
+  return ((mask + low) & mask) == 0;
+}
+
+// One channel of a masked pixel, widened to 8 bits by bit replication (so
+// 5-bit 31 is 255, not 248). ReadDibInfo only passes contiguous masks.
+class ChannelExpander {
+ public:
+  explicit ChannelExpander(uint32_t mask) {
+    if (mask == 0) return;
+    while (((mask >> shift_) & 1u) == 0) shift_++;
+    while (shift_ + bits_ < 32 && ((mask >> (shift_ + bits_)) & 1u) != 0) bits_++;
+    mask_ = mask;
+    max_ = bits_ < 32 ? (1u << bits_) - 1u : ~0u;
+    if (bits_ <= 8) {
+      for (uint32_t v = 0; v < (1u << bits_); v++) {
+        uint32_t x = v << (8 - bits_);
+        for (int s = bits_; s < 8; s += bits_) x |= x >> bits_;
+        lut_[v] = static_cast<uint8_t>(x);
+      }
+    }
+  }
+
+  bool present() const { return mask_ != 0; }
+
+  uint8_t Expand(uint32_t pixel) const {
+    const uint32_t v = (pixel & mask_) >> shift_;
+    // The clamp only matters for a non-contiguous mask in a hand-built
+    // DibInfo, whose bits above the first run would index past |lut_|.
+    return bits_ <= 8 ? lut_[(std::min)(v, max_)] : static_cast<uint8_t>(v >> (bits_ - 8));
+  }
+
+ private:
+  uint32_t mask_ = 0;
+  // Largest value of the channel's bits.
+  uint32_t max_ = 0;
+  int shift_ = 0;
+  int bits_ = 0;
+  uint8_t lut_[256] = {};
+};
+
+void ConvertPalettized(const uint8_t* src, int width, int bits, const uint8_t (*lut)[4], uint8_t* dst) {
+  const int per_byte = 8 / bits;
+  const unsigned index_mask = (1u << bits) - 1u;
+  for (int x = 0; x < width; x++) {
+    const int shift = 8 - bits * (1 + x % per_byte);
+    const unsigned index = (src[x / per_byte] >> shift) & index_mask;
+    memcpy(dst + static_cast<size_t>(x) * 4, lut[index], 4);
+  }
+}
+
+void Convert24(const uint8_t* src, int width, bool rgba, uint8_t* dst) {
+  for (int x = 0; x < width; x++, src += 3, dst += 4) {
+    if (rgba) {
+      Put(dst, src[2], src[1], src[0], 255);
+    } else {
+      Put(dst, src[0], src[1], src[2], 255);
+    }
+  }
+}
+
+// 0x00RRGGBB (+ optional 0xAA000000) little-endian words, i.e. BGRA bytes.
+void Convert32Standard(const uint8_t* src, int width, bool rgba, bool has_alpha, uint8_t* dst) {
+  const size_t count = static_cast<size_t>(width);
+  if (rgba && has_alpha) {
+    SwapRedBlue(src, dst, count);
+  } else if (rgba) {
+    SwapRedBlueOpaque(src, dst, count);
+  } else if (has_alpha) {
+    memcpy(dst, src, count * 4);
+  } else {
+    SetOpaque(src, dst, count);
+  }
+}
+
+// 5:6:5 (|green_bits| == 6) or x:5:5:5 words.
+void Convert16(const uint8_t* src, int width, int green_bits, bool rgba, uint8_t* dst) {
+  const int red_shift = 5 + green_bits;
+  const unsigned green_mask = (1u << green_bits) - 1u;
+  int x = 0;
+#if DIB_DECODER_SSE2
+  const __m128i five = _mm_set1_epi16(0x1F);
+  const __m128i gmask = _mm_set1_epi16(static_cast<short>(green_mask));
+  const __m128i opaque = _mm_set1_epi16(static_cast<short>(0xFF00));
+  const __m128i low_byte = _mm_set1_epi16(0x00FF);
+  const __m128i gshift = _mm_cvtsi32_si128(8 - green_bits);
+  const __m128i grshift = _mm_cvtsi32_si128(2 * green_bits - 8);
+  const __m128i rshift = _mm_cvtsi32_si128(red_shift);
+  for (; x + 8 <= width; x += 8) {
+    const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + static_cast<size_t>(x) * 2));
+    const __m128i r5 = _mm_and_si128(_mm_srl_epi16(p, rshift), five);
+    const __m128i g = _mm_and_si128(_mm_srli_epi16(p, 5), gmask);
+    const __m128i b5 = _mm_and_si128(p, five);
+    const __m128i r8 = _mm_or_si128(_mm_slli_epi16(r5, 3), _mm_srli_epi16(r5, 2));
+    const __m128i g8 = _mm_and_si128(_mm_or_si128(_mm_sll_epi16(g, gshift), _mm_srl_epi16(g, grshift)), low_byte);
+    const __m128i b8 = _mm_or_si128(_mm_slli_epi16(b5, 3), _mm_srli_epi16(b5, 2));
+    const __m128i c0 = rgba ? r8 : b8;
+    const __m128i c2 = rgba ? b8 : r8;
+    const __m128i lo = _mm_or_si128(c0, _mm_slli_epi16(g8, 8));
+    const __m128i hi = _mm_or_si128(c2, opaque);
+    uint8_t* d = dst + static_cast<size_t>(x) * 4;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(d), _mm_unpacklo_epi16(lo, hi));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(d + 16), _mm_unpackhi_epi16(lo, hi));
+  }
+#endif
+  for (; x < width; x++) {
+    const unsigned p = ReadLe16(src + static_cast<size_t>(x) * 2);
+    const unsigned r5 = (p >> red_shift) & 0x1F;
+    const unsigned g = (p >> 5) & green_mask;
+    const unsigned b5 = p & 0x1F;
+    const uint8_t r8 = static_cast<uint8_t>((r5 << 3) | (r5 >> 2));
+    const uint8_t g8 = static_cast<uint8_t>(((g << (8 - green_bits)) | (g >> (2 * green_bits - 8))) & 0xFF);
+    const uint8_t b8 = static_cast<uint8_t>((b5 << 3) | (b5 >> 2));
+    uint8_t* d = dst + static_cast<size_t>(x) * 4;
+    if (rgba) {
+      Put(d, r8, g8, b8, 255);
+    } else {
+      Put(d, b8, g8, r8, 255);
+    }
+  }
+}
+
+struct MaskedChannels {
+  ChannelExpander red;
+  ChannelExpander green;
+  ChannelExpander blue;
+  ChannelExpander alpha;
+};
+
+void ConvertMasked(const uint8_t* src, int width, int bytes_per_pixel, const MaskedChannels& ch, bool rgba,
+                   uint8_t* dst) {
+  for (int x = 0; x < width; x++, src += bytes_per_pixel, dst += 4) {
+    const uint32_t p = bytes_per_pixel == 2 ? ReadLe16(src) : ReadLe32(src);
+    const uint8_t r = ch.red.Expand(p);
+    const uint8_t g = ch.green.Expand(p);
+    const uint8_t b = ch.blue.Expand(p);
+    const uint8_t a = ch.alpha.present() ? ch.alpha.Expand(p) : 255;
+    if (rgba) {
+      Put(dst, r, g, b, a);
+    } else {
+      Put(dst, b, g, r, a);
+    }
+  }
+}
+
+// Many producers leave the fourth byte of 32 bpp pixels zero rather than
+// opaque; an all-zero alpha channel is treated as "no alpha".
+void FixUnusedAlpha(std::vector<uint8_t>& out) {
+  for (size_t i = 3; i < out.size(); i += 4) {
+    if (out[i] != 0) return;
+  }
+  SetOpaque(out.data(), out.data(), out.size() / 4);
+}
+
+}  // namespace
+
+bool ReadDibInfo(const uint8_t* data, size_t size, DibInfo& info) {
+  info = DibInfo();
+  if (!data || size < kInfoHeaderSize) return false;
+  const uint32_t header_size = ReadLe32(data);
+  // BITMAPINFOHEADER, the V2/V3 extensions, BITMAPV4HEADER, BITMAPV5HEADER.
+  if (header_size != 40 && header_size != 52 && header_size != 56 && header_size != 108 && header_size != 124) {
+    return false;
+  }
+  if (size < header_size) return false;
+
+  const int32_t width = static_cast<int32_t>(ReadLe32(data + 4));
+  const int32_t height = static_cast<int32_t>(ReadLe32(data + 8));
+  const uint16_t bit_count = ReadLe16(data + 14);
+  const uint32_t compression = ReadLe32(data + 16);
+  const uint32_t colors_used = ReadLe32(data + 32);
+  if (width <= 0 || height == 0 || height == INT32_MIN) return false;
+  const int32_t abs_height = height < 0 ? -height : height;
+  if (static_cast<uint64_t>(width) * static_cast<uint64_t>(abs_height) > kMaxPixels) return false;
+
+  const bool bitfields = compression == kBiBitfields || compression == kBiAlphaBitfields;
+  if (compression != kBiRgb && !bitfields) return false;
+  switch (bit_count) {
+    case 1:
+    case 4:
+    case 8:
+    case 24:
+      if (bitfields) return false;
+      break;
+    case 16:
+    case 32:
+      break;
+    default:
+      return false;
+  }
+
+  size_t offset = header_size;
+  if (bitfields) {
+    if (header_size >= 52) {
+      info.red_mask = ReadLe32(data + 40);
+      info.green_mask = ReadLe32(data + 44);
+      info.blue_mask = ReadLe32(data + 48);
+      if (header_size >= 56) info.alpha_mask = ReadLe32(data + 52);
+    } else {
+      const size_t mask_bytes = compression == kBiAlphaBitfields ? 16 : 12;
+      if (size < offset + mask_bytes) return false;
+      info.red_mask = ReadLe32(data + offset);
+      info.green_mask = ReadLe32(data + offset + 4);
+      info.blue_mask = ReadLe32(data + offset + 8);
+      if (mask_bytes == 16) info.alpha_mask = ReadLe32(data + offset + 12);
+      offset += mask_bytes;
+    }
+    if ((info.red_mask | info.green_mask | info.blue_mask) == 0) return false;
+  } else if (bit_count == 16) {
+    info.red_mask = 0x7C00;
+    info.green_mask = 0x03E0;
+    info.blue_mask = 0x001F;
+  } else if (bit_count >= 24) {
+    info.red_mask = 0x00FF0000;
+    info.green_mask = 0x0000FF00;
+    info.blue_mask = 0x000000FF;
+    // V4/V5 headers can declare alpha even for BI_RGB.
+    if (bit_count == 32) info.alpha_mask = header_size >= 56 ? ReadLe32(data + 52) : 0xFF000000u;
+  }
+  if (bit_count == 16) {
+    info.red_mask &= 0xFFFF;
+    info.green_mask &= 0xFFFF;
+    info.blue_mask &= 0xFFFF;
+    info.alpha_mask &= 0xFFFF;
+  }
+  // Each channel must be one run of bits, and no two may share a bit
+  // (clipboard data is untrusted).
+  if (!IsContiguousMask(info.red_mask) || !IsContiguousMask(info.green_mask) ||
+      !IsContiguousMask(info.blue_mask) || !IsContiguousMask(info.alpha_mask)) {
+    return false;
+  }
+  if ((info.red_mask & info.green_mask) != 0 || (info.red_mask & info.blue_mask) != 0 ||
+      (info.green_mask & info.blue_mask) != 0 ||
+      (info.alpha_mask & (info.red_mask | info.green_mask | info.blue_mask)) != 0) {
+    return false;
+  }
+
+  // The palette (or, above 8 bpp, an optional optimization palette).
+  if (bit_count <= 8) {
+    const uint32_t max_entries = 1u << bit_count;
+    const uint32_t entries = colors_used ? colors_used : max_entries;
+    if (entries > 256) return false;
+    info.palette_entries = static_cast<int>(entries);
+  } else if (colors_used > 256) {
+    return false;
+  }
+  info.palette_offset = offset;
+  offset += static_cast<size_t>(bit_count <= 8 ? static_cast<uint32_t>(info.palette_entries) : colors_used) * 4;
+
+  info.width = width;
+  info.height = abs_height;
+  info.bit_count = bit_count;
+  info.top_down = height < 0;
+  info.stride = ((static_cast<size_t>(width) * bit_count + 31) / 32) * 4;
+  const size_t image_bytes = info.stride * static_cast<size_t>(abs_height);
+
+  // Some producers repeat the three masks after a V4/V5 header; tell by the
+  // rows ending exactly at the end of the data.
+  if (bitfields && header_size > kInfoHeaderSize && size >= offset + 12 &&
+      size - offset - 12 == image_bytes) {
+    offset += 12;
+  }
+  if (offset > size || size - offset < image_bytes) return false;
+  info.bits_offset = offset;
+  return true;
+}
+
+bool ReadBmpFileInfo(const uint8_t* data, size_t size, DibInfo& info) {
+  info = DibInfo();
+  if (!data || size < kFileHeaderSize || data[0] != 'B' || data[1] != 'M') return false;
+  const size_t bits_offset = ReadLe32(data + 10);
+  // The file may be padded past the rows, so trust bfOffBits over the
+  // packed-DIB guess.
+  if (!ReadDibInfo(data + kFileHeaderSize, size - kFileHeaderSize, info)) return false;
+  info.palette_offset += kFileHeaderSize;
+  const size_t image_bytes = info.stride * static_cast<size_t>(info.height);
+  if (bits_offset < info.palette_offset || bits_offset > size || size - bits_offset < image_bytes) return false;
+  info.bits_offset = bits_offset;
+  return true;
+}
+
+bool DecodeDib(const uint8_t* data,
+               size_t size,
+               const DibInfo& info,
+               DibPixelOrder order,
+               std::vector<uint8_t>& out) {
+  if (!data || info.width <= 0 || info.height <= 0 || info.stride == 0) return false;
+  const size_t image_bytes = info.stride * static_cast<size_t>(info.height);
+  if (info.bits_offset > size || size - info.bits_offset < image_bytes) return false;
+  if (info.palette_offset + static_cast<size_t>(info.palette_entries) * 4 > size) return false;
+
+  const bool rgba = order == DibPixelOrder::kRgba;
+  const size_t row_bytes = static_cast<size_t>(info.width) * 4;
+  out.resize(row_bytes * static_cast<size_t>(info.height));
+
+  // Pick the row converter once.
+  enum class Path { kPalette, k24, k32, k565, k555, kMasked } path;
+  uint8_t lut[256][4] = {};
+  MaskedChannels channels{ChannelExpander(info.red_mask), ChannelExpander(info.green_mask),
+                          ChannelExpander(info.blue_mask), ChannelExpander(info.alpha_mask)};
+  const bool standard_rgb = info.red_mask == 0x00FF0000 && info.green_mask == 0x0000FF00 && info.blue_mask == 0xFF;
+  if (info.bit_count <= 8) {
+    path = Path::kPalette;
+    for (int i = 0; i < 256; i++) {
+      if (i >= info.palette_entries) {
+        Put(lut[i], 0, 0, 0, 255);
+        continue;
+      }
+      const uint8_t* q = data + info.palette_offset + static_cast<size_t>(i) * 4;  // RGBQUAD
+      if (rgba) {
+        Put(lut[i], q[2], q[1], q[0], 255);
+      } else {
+        Put(lut[i], q[0], q[1], q[2], 255);
+      }
+    }
+  } else if (info.bit_count == 24) {
+    path = Path::k24;
+  } else if (info.bit_count == 32 && standard_rgb && (info.alpha_mask == 0 || info.alpha_mask == 0xFF000000u)) {
+    path = Path::k32;
+  } else if (info.bit_count == 16 && info.alpha_mask == 0 && info.red_mask == 0xF800 && info.green_mask == 0x07E0 &&
+             info.blue_mask == 0x001F) {
+    path = Path::k565;
+  } else if (info.bit_count == 16 && info.alpha_mask == 0 && info.red_mask == 0x7C00 && info.green_mask == 0x03E0 &&
+             info.blue_mask == 0x001F) {
+    path = Path::k555;
+  } else {
+    path = Path::kMasked;
+  }
+
+  const uint8_t* bits = data + info.bits_offset;
+  for (int y = 0; y < info.height; y++) {
+    const int src_y = info.top_down ? y : info.height - 1 - y;
+    const uint8_t* src = bits + static_cast<size_t>(src_y) * info.stride;
+    uint8_t* dst = out.data() + static_cast<size_t>(y) * row_bytes;
+    switch (path) {
+      case Path::kPalette:
+        ConvertPalettized(src, info.width, info.bit_count, lut, dst);
+        break;
+      case Path::k24:
+        Convert24(src, info.width, rgba, dst);
+        break;
+      case Path::k32:
+        Convert32Standard(src, info.width, rgba, info.alpha_mask != 0, dst);
+        break;
+      case Path::k565:
+        Convert16(src, info.width, 6, rgba, dst);
+        break;
+      case Path::k555:
+        Convert16(src, info.width, 5, rgba, dst);
+        break;
+      case Path::kMasked:
+        ConvertMasked(src, info.width, info.bit_count / 8, channels, rgba, dst);
+        break;
+    }
+  }
+
+  if (info.alpha_mask != 0) FixUnusedAlpha(out);
+  return true;
+}
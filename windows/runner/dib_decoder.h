@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Channel order of decoded pixels.
+enum class DibPixelOrder {
+  kBgra,
+  kRgba,
+};
+
+// Layout of a packed DIB as parsed by ReadDibInfo.
+struct DibInfo {
+  int width = 0;
+  int height = 0;
+  int bit_count = 0;
+  bool top_down = false;
+  // Channel masks in effect (explicit BI_BITFIELDS masks or the defaults for
+  // 16/24/32 bpp); zero for palettized images.
+  uint32_t red_mask = 0;
+  uint32_t green_mask = 0;
+  uint32_t blue_mask = 0;
+  uint32_t alpha_mask = 0;
+  // Byte offsets of the palette and the pixel rows from the start of the DIB.
+  size_t palette_offset = 0;
+  int palette_entries = 0;
+  size_t bits_offset = 0;
+  // Bytes per source row (rows are padded to 4 bytes).
+  size_t stride = 0;
+};
+
+// Parses a packed DIB: a BITMAPINFOHEADER, V4 or V5 header, then optional
+// masks and palette, then the pixel rows (CF_DIB / CF_DIBV5 clipboard data).
+// Accepts 1/4/8 bpp palettes, 16 bpp (555 default or masks), 24 bpp and
+// 32 bpp (BI_RGB or masks). RLE, JPEG and PNG payloads are rejected, and so
+// are channel masks that are not one run of bits or that overlap.
+// Platform-neutral; never reads past |size|.
+bool ReadDibInfo(const uint8_t* data, size_t size, DibInfo& info);
+
+// ReadDibInfo for a .bmp file (BITMAPFILEHEADER + packed DIB); offsets in
+// |info| are then relative to the start of the file.
+bool ReadBmpFileInfo(const uint8_t* data, size_t size, DibInfo& info);
+
+// Converts the rows described by |info| (from ReadDibInfo/ReadBmpFileInfo on
+// the same |data|) into top-down, tightly packed 4-byte pixels in |order|.
+// Images without alpha decode opaque; so do 32 bpp BI_RGB images whose
+// unused fourth byte is zero everywhere. Resizes |out| to width * height * 4,
+// so a caller can hand in a pooled buffer. SSE2 row converters when
+// available, with identical output either way.
+bool DecodeDib(const uint8_t* data,
+               size_t size,
+               const DibInfo& info,
+               DibPixelOrder order,
+               std::vector<uint8_t>& out);
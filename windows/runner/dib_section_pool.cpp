@@ -0,0 +1,76 @@
+#include "dib_section_pool.h"
+
+#include <cstring>
+#include <utility>
+
+DibSectionPool::DibSectionPool(size_t max_bytes, CreateFn create, DestroyFn destroy)
+    : create_(std::move(create)), destroy_(std::move(destroy)) {
+  stats_.max_bytes = max_bytes;
+}
+
+DibSectionPool::~DibSectionPool() {
+  for (const Dib& dib : idle_) destroy_(dib);
+}
+
+DibSectionPool::Dib DibSectionPool::Acquire(int width, int height, bool clear) {
+  Dib dib;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.acquires++;
+    for (size_t i = idle_.size(); i > 0; i--) {
+      if (idle_[i - 1].width == width && idle_[i - 1].height == height) {
+        dib = idle_[i - 1];
+        idle_.erase(idle_.begin() + static_cast<std::ptrdiff_t>(i - 1));
+        stats_.hits++;
+        stats_.pooled--;
+        stats_.pooled_bytes -= dib.bytes();
+        break;
+      }
+    }
+  }
+  if (dib.bitmap) {
+    if (clear) memset(dib.bits, 0, dib.bytes());
+    return dib;
+  }
+  dib = create_(width, height);
+  if (!dib.bitmap || !dib.bits) {
+    if (dib.bitmap) destroy_(dib);
+    return Dib();
+  }
+  return dib;
+}
+
+void DibSectionPool::Release(const Dib& dib) {
+  if (!dib.bitmap) return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (dib.bytes() > stats_.max_bytes) {
+    destroy_(dib);
+    stats_.evictions++;
+    return;
+  }
+  while (!idle_.empty() && stats_.pooled_bytes + dib.bytes() > stats_.max_bytes) {
+    stats_.pooled_bytes -= idle_.front().bytes();
+    stats_.pooled--;
+    stats_.evictions++;
+    destroy_(idle_.front());
+    idle_.erase(idle_.begin());
+  }
+  idle_.push_back(dib);
+  stats_.pooled++;
+  stats_.pooled_bytes += dib.bytes();
+  if (stats_.pooled_bytes > stats_.high_water_bytes) stats_.high_water_bytes = stats_.pooled_bytes;
+}
+
+void DibSectionPool::Trim() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const Dib& dib : idle_) destroy_(dib);
+  stats_.evictions += idle_.size();
+  idle_.clear();
+  stats_.pooled = 0;
+  stats_.pooled_bytes = 0;
+}
+
+DibSectionPool::Stats DibSectionPool::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
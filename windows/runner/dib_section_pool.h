@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Reusable 32-bpp top-down DIB sections, matched by exact size. Capture paths
+// lease one per call instead of CreateDIBSection/DeleteObject every time;
+// repeated thumbnail refreshes ask for the same few sizes.
+//
+// Idle sections are capped at |max_bytes|, oldest freed first. The owner
+// supplies how sections are made and freed, so the pool itself is
+// platform-neutral. Thread-safe.
+class DibSectionPool {
+ public:
+  struct Dib {
+    // An HBITMAP on Windows.
+    void* bitmap = nullptr;
+    void* bits = nullptr;
+    int width = 0;
+    int height = 0;
+
+    size_t bytes() const { return static_cast<size_t>(width) * static_cast<size_t>(height) * 4u; }
+  };
+
+  struct Stats {
+    uint64_t acquires = 0;
+    uint64_t hits = 0;
+    uint64_t evictions = 0;
+    size_t pooled = 0;
+    size_t pooled_bytes = 0;
+    size_t high_water_bytes = 0;
+    size_t max_bytes = 0;
+  };
+
+  // |create| returns a zero-filled section (bitmap null on failure);
+  // |destroy| frees one.
+  using CreateFn = std::function<Dib(int width, int height)>;
+  using DestroyFn = std::function<void(const Dib& dib)>;
+
+  DibSectionPool(size_t max_bytes, CreateFn create, DestroyFn destroy);
+  ~DibSectionPool();
+
+  DibSectionPool(const DibSectionPool&) = delete;
+  DibSectionPool& operator=(const DibSectionPool&) = delete;
+
+  // bitmap is null on failure. A recycled section still holds its last
+  // capture; |clear| zeroes it like a new one, for renderers that may leave
+  // parts of the surface unpainted.
+  Dib Acquire(int width, int height, bool clear);
+
+  // The DIB must no longer be selected into a DC.
+  void Release(const Dib& dib);
+
+  // Frees every idle section.
+  void Trim();
+  Stats GetStats();
+
+ private:
+  CreateFn create_;
+  DestroyFn destroy_;
+  std::mutex mutex_;
+  // Oldest first.
+  std::vector<Dib> idle_;
+  Stats stats_;
+};
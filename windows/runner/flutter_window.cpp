@@ -1,10 +1,18 @@
 #include "flutter_window.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <vector>
 
 #include <flutter/encodable_value.h>
+#include <flutter/event_stream_handler_functions.h>
 #include <flutter/method_channel.h>
 #include <flutter/standard_method_codec.h>
 #include <windows.h>
@@ -12,8 +20,29 @@
 #include <dwmapi.h>
 
 #include "flutter/generated_plugin_registrant.h"
+#include "flutter/ephemeral/cpp_client_wrapper/texture_registrar_impl.h"
 #include "audio_capture.h"
+#include "audio_uplink.h"
+#include "byte_buffer_pool.h"
+#include "capture_stats.h"
+#include "capture_texture.h"
+#include "dib_decoder.h"
+#include "dib_section_pool.h"
+#include "foreground_tracker.h"
+#include "frame_differ.h"
+#include "image_scale.h"
+#include "multi_capture.h"
+#include "ocr_engine.h"
+#include "ocr_layout.h"
+#include "perceptual_hash.h"
+#include "pixel_buffer_pool.h"
+#include "pixel_convert.h"
+#include "screen_stream.h"
+#include "smart_crop.h"
+#include "upload_encoder.h"
+#include "upload_history.h"
 #include "win32_window.h"
+#include "winhttp_transport.h"
 
 #ifndef WDA_EXCLUDEFROMCAPTURE
 #define WDA_EXCLUDEFROMCAPTURE 0x00000011
@@ -25,6 +54,27 @@
 // Global audio capture instance
 std::unique_ptr<AudioCapture> g_audio_capture;
 
+// Reusable getSystemAudioFrame result buffers (polled every ~50 ms).
+ByteBufferPool g_audio_frame_pool(4);
+
+// Capture, scaling and clipboard pixel buffers, reclaimed once each reply has
+// been serialized. Sized for a few 4K frames in flight.
+PixelBufferPool g_pixel_pool(128u * 1024 * 1024);
+
+// Stage timings and per-method latency for getCaptureStats.
+CaptureStats g_capture_stats;
+
+// Fingerprints of recently uploaded captureForUpload frames per target, for
+// "same as image N" replies.
+RecentImageIndex g_recent_images(8, 16);
+
+// Native transcription socket (opt-in; see AppConfig.useNativeAudioUplink).
+std::unique_ptr<AudioUplink> g_audio_uplink;
+
+// Windows recently brought to the front other than ours, fed by the
+// EVENT_SYSTEM_FOREGROUND hook, for captures of "the active window".
+ForegroundTracker g_foreground(8);
+
 namespace {
 #ifndef PW_RENDERFULLCONTENT
 #define PW_RENDERFULLCONTENT 0x00000002
@@ -69,6 +119,52 @@ std::string WideToUtf8(const wchar_t* w) {
   return out;
 }
 
+std::wstring Utf8ToWide(const std::string& s) {
+  if (s.empty()) return std::wstring();
+  const int needed = MultiByteToWideChar(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), nullptr, 0);
+  if (needed <= 0) return std::wstring();
+  std::wstring out(static_cast<size_t>(needed), L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), out.data(), needed);
+  return out;
+}
+
+const std::string* GetStringArg(const flutter::EncodableValue* arguments, const char* key) {
+  if (!arguments || !std::holds_alternative<flutter::EncodableMap>(*arguments)) return nullptr;
+  const auto& args = std::get<flutter::EncodableMap>(*arguments);
+  auto it = args.find(flutter::EncodableValue(key));
+  if (it == args.end() || !std::holds_alternative<std::string>(it->second)) return nullptr;
+  return &std::get<std::string>(it->second);
+}
+
+bool GetInt64Arg(const flutter::EncodableMap& args, const char* key, int64_t& value) {
+  auto it = args.find(flutter::EncodableValue(key));
+  if (it == args.end()) return false;
+  if (std::holds_alternative<int32_t>(it->second)) {
+    value = std::get<int32_t>(it->second);
+    return true;
+  }
+  if (std::holds_alternative<int64_t>(it->second)) {
+    value = std::get<int64_t>(it->second);
+    return true;
+  }
+  return false;
+}
+
+bool GetBoolArg(const flutter::EncodableMap& args, const char* key, bool& value) {
+  auto it = args.find(flutter::EncodableValue(key));
+  if (it == args.end() || !std::holds_alternative<bool>(it->second)) return false;
+  value = std::get<bool>(it->second);
+  return true;
+}
+
+bool IsValidSourceName(const std::string& source) {
+  if (source.empty() || source.size() > 32) return false;
+  for (char c : source) {
+    if (!((c >= 'a' && c <= 'z') || c == '_')) return false;
+  }
+  return true;
+}
+
 void ScaleToFit(int src_w, int src_h, int max_w, int max_h, int& out_w, int& out_h) {
   if (src_w <= 0 || src_h <= 0) {
     out_w = out_h = 0;
@@ -88,6 +184,64 @@ void ScaleToFit(int src_w, int src_h, int max_w, int max_h, int& out_w, int& out
   if (out_h < 1) out_h = 1;
 }
 
+// A zero-filled 32-bpp top-down DIB section for |g_dib_pool|.
+DibSectionPool::Dib CreateDib(int width, int height) {
+  BITMAPINFO bmi{};
+  bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+  bmi.bmiHeader.biWidth = width;
+  bmi.bmiHeader.biHeight = -height;  // top-down
+  bmi.bmiHeader.biPlanes = 1;
+  bmi.bmiHeader.biBitCount = 32;
+  bmi.bmiHeader.biCompression = BI_RGB;
+  DibSectionPool::Dib dib;
+  // The DC only matters for DIB_PAL_COLORS.
+  dib.bitmap = CreateDIBSection(nullptr, &bmi, DIB_RGB_COLORS, &dib.bits, nullptr, 0);
+  dib.width = width;
+  dib.height = height;
+  return dib;
+}
+
+void DeleteDib(const DibSectionPool::Dib& dib) {
+  DeleteObject(static_cast<HBITMAP>(dib.bitmap));
+}
+
+DibSectionPool g_dib_pool(64u * 1024 * 1024, CreateDib, DeleteDib);
+
+// Leases a pooled DIB for the duration of one capture. |clear| for renderers
+// that may not paint every pixel (see DibSectionPool::Acquire).
+class ScopedDib {
+ public:
+  ScopedDib(int width, int height, bool clear) : dib_(g_dib_pool.Acquire(width, height, clear)) {}
+  ~ScopedDib() { g_dib_pool.Release(dib_); }
+  ScopedDib(const ScopedDib&) = delete;
+  ScopedDib& operator=(const ScopedDib&) = delete;
+
+  HBITMAP bitmap() const { return static_cast<HBITMAP>(dib_.bitmap); }
+  const void* bits() const { return dib_.bits; }
+
+ private:
+  DibSectionPool::Dib dib_;
+};
+
+// Returns the "bytes" of a replied capture map to |g_pixel_pool|. The codec
+// serializes the reply inside Success(), so the vector is free afterwards.
+void ReclaimPixels(flutter::EncodableValue& value) {
+  auto* map = std::get_if<flutter::EncodableMap>(&value);
+  if (!map) return;
+  auto it = map->find(flutter::EncodableValue("bytes"));
+  if (it == map->end()) return;
+  if (auto* bytes = std::get_if<std::vector<uint8_t>>(&it->second)) g_pixel_pool.Release(std::move(*bytes));
+}
+
+// Seeds |upload| with pooled storage for EncodeForUpload to write into, at
+// one byte per output pixel (well above a typical screenshot PNG). Only for
+// bytes replied at the top level, which ReclaimPixels hands back.
+void ReservePooledUploadBytes(const UploadEncodeOptions& options, int width, int height, EncodedUpload& upload) {
+  int w = 0, h = 0;
+  FitWithin(width, height, options.max_dimension, options.max_dimension, w, h);
+  upload.bytes = g_pixel_pool.Acquire(static_cast<size_t>(w) * static_cast<size_t>(h));
+}
+
 bool ReadHBitmapToBgra(HBITMAP hbmp, std::vector<uint8_t>& out, int& width, int& height) {
   if (!hbmp) return false;
 
@@ -107,91 +261,15 @@ bool ReadHBitmapToBgra(HBITMAP hbmp, std::vector<uint8_t>& out, int& width, int&
   bmi.bmiHeader.biCompression = BI_RGB;
 
   const size_t size = static_cast<size_t>(width) * static_cast<size_t>(height) * 4u;
-  out.resize(size);
+  g_pixel_pool.Reserve(out, size);
 
   HDC dc = GetDC(nullptr);
   if (!dc) return false;
+  ScopedStageTimer timer(g_capture_stats, "GetDIBits");
   const int lines = GetDIBits(dc, hbmp, 0, static_cast<UINT>(height), out.data(), &bmi, DIB_RGB_COLORS);
   ReleaseDC(nullptr, dc);
-  return lines == height;
-}
-
-bool ScaleBgraToBgraGdi(const uint8_t* src,
-                        int src_w,
-                        int src_h,
-                        int dst_w,
-                        int dst_h,
-                        std::vector<uint8_t>& out) {
-  if (!src) return false;
-  if (src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0) return false;
-
-  HDC screen_dc = GetDC(nullptr);
-  if (!screen_dc) return false;
-  HDC mem_dc = CreateCompatibleDC(screen_dc);
-  if (!mem_dc) {
-    ReleaseDC(nullptr, screen_dc);
-    return false;
-  }
-
-  BITMAPINFO bmi_dst{};
-  bmi_dst.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-  bmi_dst.bmiHeader.biWidth = dst_w;
-  bmi_dst.bmiHeader.biHeight = -dst_h;  // top-down
-  bmi_dst.bmiHeader.biPlanes = 1;
-  bmi_dst.bmiHeader.biBitCount = 32;
-  bmi_dst.bmiHeader.biCompression = BI_RGB;
-
-  void* bits_dst = nullptr;
-  HBITMAP dib_dst = CreateDIBSection(screen_dc, &bmi_dst, DIB_RGB_COLORS, &bits_dst, nullptr, 0);
-  if (!dib_dst || !bits_dst) {
-    if (dib_dst) DeleteObject(dib_dst);
-    DeleteDC(mem_dc);
-    ReleaseDC(nullptr, screen_dc);
-    return false;
-  }
-
-  HGDIOBJ old = SelectObject(mem_dc, dib_dst);
-  SetStretchBltMode(mem_dc, HALFTONE);
-
-  BITMAPINFO bmi_src{};
-  bmi_src.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-  bmi_src.bmiHeader.biWidth = src_w;
-  bmi_src.bmiHeader.biHeight = -src_h;  // top-down
-  bmi_src.bmiHeader.biPlanes = 1;
-  bmi_src.bmiHeader.biBitCount = 32;
-  bmi_src.bmiHeader.biCompression = BI_RGB;
-
-  const int res = StretchDIBits(
-      mem_dc,
-      0,
-      0,
-      dst_w,
-      dst_h,
-      0,
-      0,
-      src_w,
-      src_h,
-      src,
-      &bmi_src,
-      DIB_RGB_COLORS,
-      SRCCOPY);
-
-  if (res == 0) {
-    SelectObject(mem_dc, old);
-    DeleteObject(dib_dst);
-    DeleteDC(mem_dc);
-    ReleaseDC(nullptr, screen_dc);
-    return false;
-  }
-
-  const size_t size = static_cast<size_t>(dst_w) * static_cast<size_t>(dst_h) * 4u;
-  out.resize(size);
-  memcpy(out.data(), bits_dst, size);
-
-  SelectObject(mem_dc, old);
-  DeleteObject(dib_dst);
-  DeleteDC(mem_dc);
-  ReleaseDC(nullptr, screen_dc);
+  if (lines != height) return false;
+  SetOpaque(out.data(), out.data(), size / 4);
   return true;
 }
 
@@ -225,90 +303,9 @@ bool IsShareableTopLevelWindow(HWND hwnd, HWND self) {
   return true;
 }
 
-bool CaptureWindowBgra(HWND hwnd, std::vector<uint8_t>& out, int& width, int& height) {
-  RECT rc{};
-  if (!GetWindowRect(hwnd, &rc)) return false;
-  width = rc.right - rc.left;
-  height = rc.bottom - rc.top;
-  if (width <= 0 || height <= 0) return false;
-
-  // For some minimized apps, DWM only provides an icon-like snapshot. We'll prefer
-  // a real restored capture when possible, and only fall back to DWM if restore
-  // capture fails.
-  std::vector<uint8_t> dwm_fallback_bytes;
-  int dwm_fallback_w = 0;
-  int dwm_fallback_h = 0;
-  bool have_dwm_fallback = false;
-
-  const bool was_iconic = IsIconic(hwnd) ? true : false;
-  if (was_iconic) {
-    ForceDwmIconicBitmaps(hwnd);
-
-    // For minimized windows, PrintWindow/BitBlt often return blank.
-    // Prefer DWM "iconic" bitmaps (works for many apps even when minimized).
-    HBITMAP hbmp = nullptr;
-    if (auto live_fn = ResolveDwmGetIconicLivePreviewBitmap()) {
-      HRESULT hr = live_fn(hwnd, &hbmp, nullptr, 0);
-    if (SUCCEEDED(hr) && hbmp) {
-      int bw = 0, bh = 0;
-      if (ReadHBitmapToBgra(hbmp, dwm_fallback_bytes, bw, bh)) {
-        DeleteObject(hbmp);
-        dwm_fallback_w = bw;
-        dwm_fallback_h = bh;
-        have_dwm_fallback = true;
-      }
-      DeleteObject(hbmp);
-    }
-    }
-
-    hbmp = nullptr;
-    const UINT tw = static_cast<UINT>(width > 0 ? width : 1);
-    const UINT th = static_cast<UINT>(height > 0 ? height : 1);
-    if (auto thumb_fn = ResolveDwmGetIconicThumbnail()) {
-      for (int attempt = 0; attempt < 3; attempt++) {
-        HRESULT hr = thumb_fn(hwnd, tw, th, &hbmp, 0);
-        if (SUCCEEDED(hr) && hbmp) {
-          int bw = 0, bh = 0;
-          if (ReadHBitmapToBgra(hbmp, dwm_fallback_bytes, bw, bh)) {
-            DeleteObject(hbmp);
-            dwm_fallback_w = bw;
-            dwm_fallback_h = bh;
-            have_dwm_fallback = true;
-            // Keep trying restored capture for best fidelity.
-            break;
-          }
-          DeleteObject(hbmp);
-          hbmp = nullptr;
-        }
-        // Some apps need a tick after invalidation before DWM produces a bitmap.
-        Sleep(30);
-        ForceDwmIconicBitmaps(hwnd);
-      }
-    }
-  }
-
-  bool restored_from_iconic = false;
-  if (was_iconic) {
-    // Last resort: temporarily restore without activation and capture.
-    // This can cause a brief visual change, but avoids blank captures.
-    ShowWindowAsync(hwnd, SW_SHOWNOACTIVATE);
-    restored_from_iconic = true;
-    RedrawWindow(hwnd, nullptr, nullptr, RDW_INVALIDATE | RDW_UPDATENOW | RDW_ALLCHILDREN);
-    DwmFlush();
-    Sleep(120);
-
-    // Recompute dimensions after restore: minimized windows can report tiny rects.
-    RECT rc2{};
-    if (GetWindowRect(hwnd, &rc2)) {
-      const int w2 = rc2.right - rc2.left;
-      const int h2 = rc2.bottom - rc2.top;
-      if (w2 > 0 && h2 > 0) {
-        width = w2;
-        height = h2;
-      }
-    }
-  }
-
+// Renders |hwnd| into a width x height BGRA buffer. PrintWindow handles
+// occluded content; the window DC is a fallback.
+bool RenderWindowBgra(HWND hwnd, int width, int height, std::vector<uint8_t>& out) {
   HDC screen_dc = GetDC(nullptr);
   if (!screen_dc) return false;
   HDC mem_dc = CreateCompatibleDC(screen_dc);
@@ -317,29 +314,27 @@ bool CaptureWindowBgra(HWND hwnd, std::vector<uint8_t>& out, int& width, int& he
     return false;
   }
 
-  BITMAPINFO bmi{};
-  bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-  bmi.bmiHeader.biWidth = width;
-  bmi.bmiHeader.biHeight = -height;  // top-down
-  bmi.bmiHeader.biPlanes = 1;
-  bmi.bmiHeader.biBitCount = 32;
-  bmi.bmiHeader.biCompression = BI_RGB;
-
-  void* bits = nullptr;
-  HBITMAP dib = CreateDIBSection(screen_dc, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
-  if (!dib || !bits) {
-    if (dib) DeleteObject(dib);
+  // PrintWindow and the window-DC fallback can leave parts of the bitmap
+  // unpainted (e.g. a window smaller than requested), which must not show
+  // a previous capture of another window.
+  ScopedDib dib(width, height, true);
+  if (!dib.bitmap()) {
     DeleteDC(mem_dc);
     ReleaseDC(nullptr, screen_dc);
     return false;
   }
 
-  HGDIOBJ old = SelectObject(mem_dc, dib);
+  HGDIOBJ old = SelectObject(mem_dc, dib.bitmap());
 
   // Prefer PrintWindow for correct content even if covered.
-  BOOL ok = PrintWindow(hwnd, mem_dc, PW_RENDERFULLCONTENT);
+  BOOL ok = FALSE;
+  {
+    ScopedStageTimer timer(g_capture_stats, "PrintWindow");
+    ok = PrintWindow(hwnd, mem_dc, PW_RENDERFULLCONTENT);
+  }
   if (!ok) {
     // Fallback: try BitBlt from window DC (may miss occluded content).
+    ScopedStageTimer timer(g_capture_stats, "window DC BitBlt");
     HDC win_dc = GetWindowDC(hwnd);
     if (win_dc) {
       ok = BitBlt(mem_dc, 0, 0, width, height, win_dc, 0, 0, SRCCOPY) ? TRUE : FALSE;
@@ -347,234 +342,258 @@ bool CaptureWindowBgra(HWND hwnd, std::vector<uint8_t>& out, int& width, int& he
     }
   }
 
-  if (!ok) {
-    SelectObject(mem_dc, old);
-    DeleteObject(dib);
-    DeleteDC(mem_dc);
-    ReleaseDC(nullptr, screen_dc);
-    if (restored_from_iconic) ShowWindowAsync(hwnd, SW_MINIMIZE);
-    if (have_dwm_fallback) {
-      out = std::move(dwm_fallback_bytes);
-      width = dwm_fallback_w;
-      height = dwm_fallback_h;
-      return true;
-    }
-    return false;
+  if (ok) {
+    ScopedStageTimer timer(g_capture_stats, "DIB copy");
+    const size_t size = static_cast<size_t>(width) * static_cast<size_t>(height) * 4u;
+    g_pixel_pool.Reserve(out, size);
+    // Dart decodes these as bgra8888; GDI leaves the fourth byte undefined.
+    SetOpaque(static_cast<const uint8_t*>(dib.bits()), out.data(), size / 4);
   }
 
-  const size_t size = static_cast<size_t>(width) * static_cast<size_t>(height) * 4u;
-  out.resize(size);
-  memcpy(out.data(), bits, size);
-
   SelectObject(mem_dc, old);
-  DeleteObject(dib);
   DeleteDC(mem_dc);
   ReleaseDC(nullptr, screen_dc);
-  if (restored_from_iconic) ShowWindowAsync(hwnd, SW_MINIMIZE);
-  return true;
+  return ok ? true : false;
 }
 
-bool CaptureWindowBgraScaled(HWND hwnd,
-                             int target_w,
-                             int target_h,
-                             bool allow_restore_if_iconic,
-                             std::vector<uint8_t>& out,
-                             int& width,
-                             int& height) {
-  RECT rc{};
-  if (!GetWindowRect(hwnd, &rc)) return false;
-  int src_w = rc.right - rc.left;
-  int src_h = rc.bottom - rc.top;
-  if (src_w <= 0 || src_h <= 0) return false;
+// Renders |hwnd| at src_w x src_h and area-averages it down to dst_w x dst_h.
+bool RenderWindowBgraScaled(HWND hwnd,
+                            int src_w,
+                            int src_h,
+                            int dst_w,
+                            int dst_h,
+                            std::vector<uint8_t>& out) {
+  // PrintWindow does NOT scale; it clips to the DC size, so render full size.
+  std::vector<uint8_t> full;
+  bool ok = RenderWindowBgra(hwnd, src_w, src_h, full);
+  if (ok) {
+    ScopedStageTimer timer(g_capture_stats, "scale");
+    g_pixel_pool.Reserve(out, static_cast<size_t>(dst_w) * static_cast<size_t>(dst_h) * 4u);
+    ok = ScaleBgra(full.data(), src_w, src_h, 0, dst_w, dst_h, ScaleFilter::kBox, out, 0);
+  }
+  g_pixel_pool.Release(std::move(full));
+  return ok;
+}
 
-  width = target_w > 0 ? target_w : src_w;
-  height = target_h > 0 ? target_h : src_h;
-  if (width <= 0 || height <= 0) return false;
+// Some apps need a tick after invalidation before DWM produces a bitmap.
+constexpr std::chrono::milliseconds kDwmRetryDelay(30);
+constexpr int kDwmThumbnailAttempts = 3;
+// Time for a window restored from minimized to paint before PrintWindow.
+constexpr std::chrono::milliseconds kRestoreSettleDelay(120);
+
+// Window capture as a sequence of CaptureExecutor steps. The DWM thumbnail
+// retries and the restore-from-minimized settle time are timed continuations
+// instead of Sleep() calls.
+//
+// Full-size mode (thumb 0x0): minimized windows are briefly restored (no
+// activation) for a real capture; DWM bitmaps are only a fallback.
+// Thumbnail mode: DWM bitmaps are returned directly, and restoring is only
+// done when |allow_restore| (the selected tile).
+class WindowCaptureSteps {
+ public:
+  WindowCaptureSteps(HWND hwnd, int thumb_w, int thumb_h, bool allow_restore)
+      : hwnd_(hwnd),
+        thumb_w_(thumb_w),
+        thumb_h_(thumb_h),
+        scaled_(thumb_w > 0 && thumb_h > 0),
+        allow_restore_(scaled_ ? allow_restore : true) {}
+
+  CaptureStep Step(bool cancelled) {
+    if (cancelled) return Fail();
+    switch (stage_) {
+      case Stage::kStart:
+        return Start();
+      case Stage::kDwmThumbnail:
+        return TryDwmThumbnail();
+      case Stage::kRender:
+        return Render();
+    }
+    return Fail();
+  }
 
-  const bool was_iconic = IsIconic(hwnd) ? true : false;
-  bool restored_from_iconic = false;
+  bool succeeded() const { return succeeded_; }
+  std::vector<uint8_t>& bytes() { return bytes_; }
+  int width() const { return width_; }
+  int height() const { return height_; }
 
-  if (was_iconic) {
-    ForceDwmIconicBitmaps(hwnd);
+ private:
+  enum class Stage { kStart, kDwmThumbnail, kRender };
 
-    // Thumbnail preview for minimized windows via DWM.
-    // Prefer live preview bitmap (often more "real" than the thumbnail/icon).
+  CaptureStep Start() {
+    RECT rc{};
+    if (!GetWindowRect(hwnd_, &rc)) return Fail();
+    src_w_ = rc.right - rc.left;
+    src_h_ = rc.bottom - rc.top;
+    if (src_w_ <= 0 || src_h_ <= 0) return Fail();
+
+    if (!IsIconic(hwnd_)) {
+      stage_ = Stage::kRender;
+      return Render();
+    }
+
+    // For minimized windows, PrintWindow/BitBlt often return blank.
+    // DWM "iconic" bitmaps work for many apps even when minimized.
+    ForceDwmIconicBitmaps(hwnd_);
     if (auto live_fn = ResolveDwmGetIconicLivePreviewBitmap()) {
-      HBITMAP hbmp_live = nullptr;
-      const HRESULT hr = live_fn(hwnd, &hbmp_live, nullptr, 0);
-      if (SUCCEEDED(hr) && hbmp_live) {
+      HBITMAP hbmp = nullptr;
+      ScopedStageTimer live_timer(g_capture_stats, "DwmGetIconicLivePreviewBitmap");
+      const HRESULT hr = live_fn(hwnd_, &hbmp, nullptr, 0);
+      live_timer.Stop();
+      if (SUCCEEDED(hr) && hbmp) {
         std::vector<uint8_t> tmp;
         int bw = 0, bh = 0;
-        if (ReadHBitmapToBgra(hbmp_live, tmp, bw, bh)) {
-          DeleteObject(hbmp_live);
-          // Scale to requested size to keep payload small.
-          std::vector<uint8_t> scaled;
-          if (ScaleBgraToBgraGdi(tmp.data(), bw, bh, width, height, scaled)) {
-            out = std::move(scaled);
-            return true;
-          }
-          out = std::move(tmp);
-          width = bw;
-          height = bh;
-          return true;
+        const bool read = ReadHBitmapToBgra(hbmp, tmp, bw, bh);
+        DeleteObject(hbmp);
+        if (read) {
+          if (scaled_) {
+            // Scale to requested size to keep payload small.
+            std::vector<uint8_t> scaled;
+            ScopedStageTimer scale_timer(g_capture_stats, "scale");
+            if (ScaleBgra(tmp.data(), bw, bh, 0, thumb_w_, thumb_h_, ScaleFilter::kBox, scaled, 0)) {
+              g_pixel_pool.Release(std::move(tmp));
+              return Succeed(std::move(scaled), thumb_w_, thumb_h_);
+            }
+            return Succeed(std::move(tmp), bw, bh);
+          }
+          SetFallback(std::move(tmp), bw, bh);
         }
-        DeleteObject(hbmp_live);
       }
     }
+    stage_ = Stage::kDwmThumbnail;
+    return TryDwmThumbnail();
+  }
 
-    HBITMAP hbmp = nullptr;
-    const UINT tw = static_cast<UINT>(width);
-    const UINT th = static_cast<UINT>(height);
-    if (auto thumb_fn = ResolveDwmGetIconicThumbnail()) {
-      for (int attempt = 0; attempt < 3; attempt++) {
-        const HRESULT hr = thumb_fn(hwnd, tw, th, &hbmp, 0);
-        if (SUCCEEDED(hr) && hbmp) {
-          int bw = 0, bh = 0;
-          if (ReadHBitmapToBgra(hbmp, out, bw, bh)) {
-            DeleteObject(hbmp);
-            width = bw;
-            height = bh;
-            return true;
-          }
-          DeleteObject(hbmp);
-          hbmp = nullptr;
+  CaptureStep TryDwmThumbnail() {
+    auto thumb_fn = ResolveDwmGetIconicThumbnail();
+    if (thumb_fn && dwm_attempts_ < kDwmThumbnailAttempts) {
+      const UINT tw = static_cast<UINT>(scaled_ ? thumb_w_ : src_w_);
+      const UINT th = static_cast<UINT>(scaled_ ? thumb_h_ : src_h_);
+      HBITMAP hbmp = nullptr;
+      ScopedStageTimer thumb_timer(g_capture_stats, "DwmGetIconicThumbnail");
+      const HRESULT hr = thumb_fn(hwnd_, tw, th, &hbmp, 0);
+      thumb_timer.Stop();
+      if (SUCCEEDED(hr) && hbmp) {
+        std::vector<uint8_t> tmp;
+        int bw = 0, bh = 0;
+        const bool read = ReadHBitmapToBgra(hbmp, tmp, bw, bh);
+        DeleteObject(hbmp);
+        if (read) {
+          if (scaled_) return Succeed(std::move(tmp), bw, bh);
+          // Keep trying restored capture for best fidelity.
+          SetFallback(std::move(tmp), bw, bh);
+          return Restore();
         }
-        Sleep(30);
-        ForceDwmIconicBitmaps(hwnd);
       }
+      dwm_attempts_++;
+      ForceDwmIconicBitmaps(hwnd_);
+      if (dwm_attempts_ < kDwmThumbnailAttempts) return CaptureStep::After(kDwmRetryDelay);
     }
-    if (!allow_restore_if_iconic) {
+    return Restore();
+  }
+
+  CaptureStep Restore() {
+    if (!allow_restore_) {
       // Avoid popping windows for non-selected tiles.
-      return false;
+      return Fail();
     }
-
-    // Selected minimized window: briefly restore (no activate), capture, then minimize back.
-    ShowWindowAsync(hwnd, SW_SHOWNOACTIVATE);
-    RedrawWindow(hwnd, nullptr, nullptr, RDW_INVALIDATE | RDW_UPDATENOW | RDW_ALLCHILDREN);
+    // Temporarily restore without activation and capture. This can cause a
+    // brief visual change, but avoids blank captures.
+    ScopedStageTimer timer(g_capture_stats, "restore");
+    ShowWindowAsync(hwnd_, SW_SHOWNOACTIVATE);
+    restored_ = true;
+    RedrawWindow(hwnd_, nullptr, nullptr, RDW_INVALIDATE | RDW_UPDATENOW | RDW_ALLCHILDREN);
     DwmFlush();
-    Sleep(120);
-    restored_from_iconic = true;
-
-    // Re-read dimensions after restore (some apps report tiny rects while iconic).
-    RECT rc2{};
-    if (GetWindowRect(hwnd, &rc2)) {
-      const int w2 = rc2.right - rc2.left;
-      const int h2 = rc2.bottom - rc2.top;
-      if (w2 > 0 && h2 > 0) {
-        src_w = w2;
-        src_h = h2;
+    restore_started_ = CaptureStats::Clock::now();
+    stage_ = Stage::kRender;
+    return CaptureStep::After(kRestoreSettleDelay);
+  }
+
+  CaptureStep Render() {
+    if (restored_) {
+      // The settle wait runs on a timer, so file it as a stage of its own.
+      g_capture_stats.Record(ScopedCaptureMethod::Current(), "restore settle", restore_started_,
+                             CaptureStats::Clock::now());
+      // Minimized windows can report tiny rects; re-read after restore.
+      RECT rc{};
+      if (GetWindowRect(hwnd_, &rc)) {
+        const int w = rc.right - rc.left;
+        const int h = rc.bottom - rc.top;
+        if (w > 0 && h > 0) {
+          src_w_ = w;
+          src_h_ = h;
+        }
       }
     }
-  }
 
-  HDC screen_dc = GetDC(nullptr);
-  if (!screen_dc) return false;
-  HDC mem_full = CreateCompatibleDC(screen_dc);
-  HDC mem_thumb = CreateCompatibleDC(screen_dc);
-  if (!mem_full || !mem_thumb) {
-    if (mem_full) DeleteDC(mem_full);
-    if (mem_thumb) DeleteDC(mem_thumb);
-    ReleaseDC(nullptr, screen_dc);
-    if (restored_from_iconic) ShowWindowAsync(hwnd, SW_MINIMIZE);
-    return false;
+    std::vector<uint8_t> out;
+    if (scaled_) {
+      if (RenderWindowBgraScaled(hwnd_, src_w_, src_h_, thumb_w_, thumb_h_, out)) {
+        return Succeed(std::move(out), thumb_w_, thumb_h_);
+      }
+      return Fail();
+    }
+    if (RenderWindowBgra(hwnd_, src_w_, src_h_, out)) {
+      return Succeed(std::move(out), src_w_, src_h_);
+    }
+    if (have_fallback_) {
+      return Succeed(std::move(fallback_), fallback_w_, fallback_h_);
+    }
+    return Fail();
   }
 
-  // Full-size DIB (src_w x src_h)
-  BITMAPINFO bmi_full{};
-  bmi_full.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-  bmi_full.bmiHeader.biWidth = src_w;
-  bmi_full.bmiHeader.biHeight = -src_h;  // top-down
-  bmi_full.bmiHeader.biPlanes = 1;
-  bmi_full.bmiHeader.biBitCount = 32;
-  bmi_full.bmiHeader.biCompression = BI_RGB;
-
-  void* bits_full = nullptr;
-  HBITMAP dib_full = CreateDIBSection(screen_dc, &bmi_full, DIB_RGB_COLORS, &bits_full, nullptr, 0);
-  if (!dib_full || !bits_full) {
-    if (dib_full) DeleteObject(dib_full);
-    DeleteDC(mem_full);
-    DeleteDC(mem_thumb);
-    ReleaseDC(nullptr, screen_dc);
-    if (restored_from_iconic) ShowWindowAsync(hwnd, SW_MINIMIZE);
-    return false;
+  void SetFallback(std::vector<uint8_t>&& bytes, int w, int h) {
+    fallback_ = std::move(bytes);
+    fallback_w_ = w;
+    fallback_h_ = h;
+    have_fallback_ = true;
   }
 
-  // Thumbnail DIB (width x height)
-  BITMAPINFO bmi_thumb{};
-  bmi_thumb.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-  bmi_thumb.bmiHeader.biWidth = width;
-  bmi_thumb.bmiHeader.biHeight = -height;  // top-down
-  bmi_thumb.bmiHeader.biPlanes = 1;
-  bmi_thumb.bmiHeader.biBitCount = 32;
-  bmi_thumb.bmiHeader.biCompression = BI_RGB;
-
-  void* bits_thumb = nullptr;
-  HBITMAP dib_thumb = CreateDIBSection(screen_dc, &bmi_thumb, DIB_RGB_COLORS, &bits_thumb, nullptr, 0);
-  if (!dib_thumb || !bits_thumb) {
-    if (dib_thumb) DeleteObject(dib_thumb);
-    DeleteObject(dib_full);
-    DeleteDC(mem_full);
-    DeleteDC(mem_thumb);
-    ReleaseDC(nullptr, screen_dc);
-    if (restored_from_iconic) ShowWindowAsync(hwnd, SW_MINIMIZE);
-    return false;
+  CaptureStep Succeed(std::vector<uint8_t>&& bytes, int w, int h) {
+    bytes_ = std::move(bytes);
+    width_ = w;
+    height_ = h;
+    succeeded_ = true;
+    Finish();
+    return CaptureStep::Done();
   }
 
-  HGDIOBJ old_full = SelectObject(mem_full, dib_full);
-  HGDIOBJ old_thumb = SelectObject(mem_thumb, dib_thumb);
-
-  // Step 1: render full window (PrintWindow does NOT scale; it clips to DC size)
-  BOOL ok_full = PrintWindow(hwnd, mem_full, PW_RENDERFULLCONTENT);
-  if (!ok_full) {
-    HDC win_dc = GetWindowDC(hwnd);
-    if (win_dc) {
-      ok_full = BitBlt(mem_full, 0, 0, src_w, src_h, win_dc, 0, 0, SRCCOPY) ? TRUE : FALSE;
-      ReleaseDC(hwnd, win_dc);
-    }
+  CaptureStep Fail() {
+    Finish();
+    return CaptureStep::Done();
   }
 
-  if (!ok_full) {
-    SelectObject(mem_full, old_full);
-    SelectObject(mem_thumb, old_thumb);
-    DeleteObject(dib_full);
-    DeleteObject(dib_thumb);
-    DeleteDC(mem_full);
-    DeleteDC(mem_thumb);
-    ReleaseDC(nullptr, screen_dc);
-    if (restored_from_iconic) ShowWindowAsync(hwnd, SW_MINIMIZE);
-    return false;
+  void Finish() {
+    if (restored_) {
+      ShowWindowAsync(hwnd_, SW_MINIMIZE);
+      restored_ = false;
+    }
+    // Unused DWM fallback (a moved-from one is empty).
+    g_pixel_pool.Release(std::move(fallback_));
   }
 
-  // Step 2: scale down to thumbnail
-  SetStretchBltMode(mem_thumb, HALFTONE);
-  BOOL ok_thumb = StretchBlt(mem_thumb, 0, 0, width, height, mem_full, 0, 0, src_w, src_h, SRCCOPY) ? TRUE : FALSE;
-
-  if (!ok_thumb) {
-    SelectObject(mem_full, old_full);
-    SelectObject(mem_thumb, old_thumb);
-    DeleteObject(dib_full);
-    DeleteObject(dib_thumb);
-    DeleteDC(mem_full);
-    DeleteDC(mem_thumb);
-    ReleaseDC(nullptr, screen_dc);
-    if (restored_from_iconic) ShowWindowAsync(hwnd, SW_MINIMIZE);
-    return false;
-  }
-
-  const size_t size = static_cast<size_t>(width) * static_cast<size_t>(height) * 4u;
-  out.resize(size);
-  memcpy(out.data(), bits_thumb, size);
-
-  SelectObject(mem_full, old_full);
-  SelectObject(mem_thumb, old_thumb);
-  DeleteObject(dib_full);
-  DeleteObject(dib_thumb);
-  DeleteDC(mem_full);
-  DeleteDC(mem_thumb);
-  ReleaseDC(nullptr, screen_dc);
-  if (restored_from_iconic) ShowWindowAsync(hwnd, SW_MINIMIZE);
-  return true;
-}
+  HWND hwnd_;
+  int thumb_w_;
+  int thumb_h_;
+  bool scaled_;
+  bool allow_restore_;
+
+  Stage stage_ = Stage::kStart;
+  int src_w_ = 0;
+  int src_h_ = 0;
+  int dwm_attempts_ = 0;
+  bool restored_ = false;
+  CaptureStats::Clock::time_point restore_started_;
+
+  std::vector<uint8_t> fallback_;
+  int fallback_w_ = 0;
+  int fallback_h_ = 0;
+  bool have_fallback_ = false;
+
+  std::vector<uint8_t> bytes_;
+  int width_ = 0;
+  int height_ = 0;
+  bool succeeded_ = false;
+};
 
 bool CaptureRectBgra(int x, int y, int src_w, int src_h, std::vector<uint8_t>& out, int& width, int& height) {
   width = src_w;
@@ -589,42 +608,32 @@ bool CaptureRectBgra(int x, int y, int src_w, int src_h, std::vector<uint8_t>& o
     return false;
   }
 
-  BITMAPINFO bmi{};
-  bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-  bmi.bmiHeader.biWidth = width;
-  bmi.bmiHeader.biHeight = -height;  // top-down
-  bmi.bmiHeader.biPlanes = 1;
-  bmi.bmiHeader.biBitCount = 32;
-  bmi.bmiHeader.biCompression = BI_RGB;
-
-  void* bits = nullptr;
-  HBITMAP dib = CreateDIBSection(screen_dc, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
-  if (!dib || !bits) {
-    if (dib) DeleteObject(dib);
+  // BitBlt writes the whole rect.
+  ScopedDib dib(width, height, false);
+  if (!dib.bitmap()) {
     DeleteDC(mem_dc);
     ReleaseDC(nullptr, screen_dc);
     return false;
   }
 
-  HGDIOBJ old = SelectObject(mem_dc, dib);
-  BOOL ok = BitBlt(mem_dc, 0, 0, width, height, screen_dc, x, y, SRCCOPY | CAPTUREBLT);
-  if (!ok) {
-    SelectObject(mem_dc, old);
-    DeleteObject(dib);
-    DeleteDC(mem_dc);
-    ReleaseDC(nullptr, screen_dc);
-    return false;
+  HGDIOBJ old = SelectObject(mem_dc, dib.bitmap());
+  BOOL ok = FALSE;
+  {
+    ScopedStageTimer timer(g_capture_stats, "BitBlt");
+    ok = BitBlt(mem_dc, 0, 0, width, height, screen_dc, x, y, SRCCOPY | CAPTUREBLT);
+  }
+  if (ok) {
+    ScopedStageTimer timer(g_capture_stats, "DIB copy");
+    const size_t size = static_cast<size_t>(width) * static_cast<size_t>(height) * 4u;
+    g_pixel_pool.Reserve(out, size);
+    // Dart decodes these as bgra8888; GDI leaves the fourth byte undefined.
+    SetOpaque(static_cast<const uint8_t*>(dib.bits()), out.data(), size / 4);
   }
-
-  const size_t size = static_cast<size_t>(width) * static_cast<size_t>(height) * 4u;
-  out.resize(size);
-  memcpy(out.data(), bits, size);
 
   SelectObject(mem_dc, old);
-  DeleteObject(dib);
   DeleteDC(mem_dc);
   ReleaseDC(nullptr, screen_dc);
-  return true;
+  return ok ? true : false;
 }
 
 bool CaptureRectBgraScaled(int x, int y, int src_w, int src_h, int max_w, int max_h, std::vector<uint8_t>& out, int& width, int& height) {
@@ -634,51 +643,172 @@ bool CaptureRectBgraScaled(int x, int y, int src_w, int src_h, int max_w, int ma
   height = th;
   if (width <= 0 || height <= 0) return false;
 
-  HDC screen_dc = GetDC(nullptr);
-  if (!screen_dc) return false;
-  HDC mem_dc = CreateCompatibleDC(screen_dc);
-  if (!mem_dc) {
-    ReleaseDC(nullptr, screen_dc);
-    return false;
+  std::vector<uint8_t> full;
+  int full_w = 0, full_h = 0;
+  bool ok = CaptureRectBgra(x, y, src_w, src_h, full, full_w, full_h);
+  if (ok) {
+    ScopedStageTimer timer(g_capture_stats, "scale");
+    g_pixel_pool.Reserve(out, static_cast<size_t>(width) * static_cast<size_t>(height) * 4u);
+    ok = ScaleBgra(full.data(), full_w, full_h, 0, width, height, ScaleFilter::kBox, out, 0);
   }
+  g_pixel_pool.Release(std::move(full));
+  return ok;
+}
 
-  BITMAPINFO bmi{};
-  bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-  bmi.bmiHeader.biWidth = width;
-  bmi.bmiHeader.biHeight = -height;  // top-down
-  bmi.bmiHeader.biPlanes = 1;
-  bmi.bmiHeader.biBitCount = 32;
-  bmi.bmiHeader.biCompression = BI_RGB;
+// True when our own window (or a child) is foreground, i.e. it would be
+// captured instead of the user's target.
+bool IsSelfForeground(HWND self) {
+  HWND fg = GetForegroundWindow();
+  return self && fg && (fg == self || IsChild(self, fg));
+}
 
-  void* bits = nullptr;
-  HBITMAP dib = CreateDIBSection(screen_dc, &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
-  if (!dib || !bits) {
-    if (dib) DeleteObject(dib);
-    DeleteDC(mem_dc);
-    ReleaseDC(nullptr, screen_dc);
-    return false;
-  }
+// Whether a window coming to the front is one the user would mean by "the
+// active window": not one of ours, not the taskbar, desktop or a tool window.
+bool IsForegroundTarget(HWND hwnd) {
+  DWORD pid = 0;
+  GetWindowThreadProcessId(hwnd, &pid);
+  if (pid == GetCurrentProcessId()) return false;
+  return IsShareableTopLevelWindow(hwnd, nullptr);
+}
 
-  HGDIOBJ old = SelectObject(mem_dc, dib);
-  SetStretchBltMode(mem_dc, HALFTONE);
-  BOOL ok = StretchBlt(mem_dc, 0, 0, width, height, screen_dc, x, y, src_w, src_h, SRCCOPY | CAPTUREBLT) ? TRUE : FALSE;
-  if (!ok) {
-    SelectObject(mem_dc, old);
-    DeleteObject(dib);
-    DeleteDC(mem_dc);
-    ReleaseDC(nullptr, screen_dc);
-    return false;
+void CALLBACK ForegroundEventProc(HWINEVENTHOOK, DWORD event, HWND hwnd, LONG id_object, LONG id_child, DWORD, DWORD) {
+  if (event != EVENT_SYSTEM_FOREGROUND || !hwnd || id_object != OBJID_WINDOW || id_child != CHILDID_SELF) return;
+  g_foreground.OnForeground(reinterpret_cast<uintptr_t>(hwnd), IsForegroundTarget(hwnd));
+}
+
+// The window to capture as "active" without hiding ourselves: the current
+// foreground window when it is a target (not ours, the taskbar or the
+// desktop), else the last one the user had in front. Null when neither is
+// available.
+HWND TrackedActiveWindow(HWND self) {
+  HWND fg = GetForegroundWindow();
+  if (fg && !IsSelfForeground(self) && IsForegroundTarget(fg)) return fg;
+  const ForegroundTracker::WindowId last = g_foreground.LastTarget([](ForegroundTracker::WindowId id) {
+    HWND hwnd = reinterpret_cast<HWND>(static_cast<uintptr_t>(id));
+    return IsWindow(hwnd) && IsWindowVisible(hwnd) && !IsIconic(hwnd);
+  });
+  return reinterpret_cast<HWND>(static_cast<uintptr_t>(last));
+}
+
+// Restores our window after a capture that minimized it. Runs on the
+// platform thread once the capture job has finished.
+std::function<void()> RestoreSelfCallback(HWND self, bool minimized_self) {
+  if (!self || !minimized_self) return nullptr;
+  return [self]() {
+    ShowWindow(self, SW_RESTORE);
+    SetForegroundWindow(self);
+  };
+}
+
+// Cheap state that changes when a window is moved, resized, minimized or
+// (un)focused. A different value marks its cached thumbnail stale.
+uint64_t WindowGeneration(HWND hwnd, const RECT& rc) {
+  uint64_t g = static_cast<uint32_t>(rc.left) ^ (static_cast<uint64_t>(static_cast<uint32_t>(rc.top)) << 32);
+  g = g * 1099511628211ull ^ static_cast<uint32_t>(rc.right);
+  g = g * 1099511628211ull ^ static_cast<uint32_t>(rc.bottom);
+  g = g * 1099511628211ull ^ (IsIconic(hwnd) ? 1u : 0u) ^ (GetForegroundWindow() == hwnd ? 2u : 0u);
+  return g;
+}
+
+// Screen content mostly changes with the foreground window (switch, move).
+uint64_t MonitorGeneration() {
+  HWND fg = GetForegroundWindow();
+  RECT rc{};
+  if (fg) GetWindowRect(fg, &rc);
+  return WindowGeneration(fg, rc) ^ static_cast<uint64_t>(reinterpret_cast<uintptr_t>(fg));
+}
+
+flutter::EncodableValue ThumbnailCacheStatsValue(const ThumbnailCache::Stats& stats) {
+  flutter::EncodableMap map;
+  map[flutter::EncodableValue("entries")] = flutter::EncodableValue(static_cast<int64_t>(stats.entries));
+  map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(static_cast<int64_t>(stats.bytes));
+  map[flutter::EncodableValue("budgetBytes")] = flutter::EncodableValue(static_cast<int64_t>(stats.budget_bytes));
+  map[flutter::EncodableValue("hits")] = flutter::EncodableValue(static_cast<int64_t>(stats.hits));
+  map[flutter::EncodableValue("misses")] = flutter::EncodableValue(static_cast<int64_t>(stats.misses));
+  map[flutter::EncodableValue("evictions")] = flutter::EncodableValue(static_cast<int64_t>(stats.evictions));
+  return flutter::EncodableValue(map);
+}
+
+// getPixelPoolStats: {buffers: {...}, dibs: {...}}.
+flutter::EncodableValue PixelPoolStatsValue() {
+  const PixelBufferPool::Stats buffers = g_pixel_pool.GetStats();
+  flutter::EncodableMap buffer_map;
+  buffer_map[flutter::EncodableValue("acquires")] = flutter::EncodableValue(static_cast<int64_t>(buffers.acquires));
+  buffer_map[flutter::EncodableValue("hits")] = flutter::EncodableValue(static_cast<int64_t>(buffers.hits));
+  buffer_map[flutter::EncodableValue("releases")] = flutter::EncodableValue(static_cast<int64_t>(buffers.releases));
+  buffer_map[flutter::EncodableValue("evictions")] = flutter::EncodableValue(static_cast<int64_t>(buffers.evictions));
+  buffer_map[flutter::EncodableValue("pooled")] = flutter::EncodableValue(static_cast<int64_t>(buffers.pooled_buffers));
+  buffer_map[flutter::EncodableValue("pooledBytes")] = flutter::EncodableValue(static_cast<int64_t>(buffers.pooled_bytes));
+  buffer_map[flutter::EncodableValue("highWaterBytes")] =
+      flutter::EncodableValue(static_cast<int64_t>(buffers.high_water_bytes));
+  buffer_map[flutter::EncodableValue("maxBytes")] = flutter::EncodableValue(static_cast<int64_t>(buffers.max_bytes));
+
+  const DibSectionPool::Stats dibs = g_dib_pool.GetStats();
+  flutter::EncodableMap dib_map;
+  dib_map[flutter::EncodableValue("acquires")] = flutter::EncodableValue(static_cast<int64_t>(dibs.acquires));
+  dib_map[flutter::EncodableValue("hits")] = flutter::EncodableValue(static_cast<int64_t>(dibs.hits));
+  dib_map[flutter::EncodableValue("evictions")] = flutter::EncodableValue(static_cast<int64_t>(dibs.evictions));
+  dib_map[flutter::EncodableValue("pooled")] = flutter::EncodableValue(static_cast<int64_t>(dibs.pooled));
+  dib_map[flutter::EncodableValue("pooledBytes")] = flutter::EncodableValue(static_cast<int64_t>(dibs.pooled_bytes));
+  dib_map[flutter::EncodableValue("highWaterBytes")] = flutter::EncodableValue(static_cast<int64_t>(dibs.high_water_bytes));
+  dib_map[flutter::EncodableValue("maxBytes")] = flutter::EncodableValue(static_cast<int64_t>(dibs.max_bytes));
+
+  flutter::EncodableMap map;
+  map[flutter::EncodableValue("buffers")] = flutter::EncodableValue(buffer_map);
+  map[flutter::EncodableValue("dibs")] = flutter::EncodableValue(dib_map);
+  return flutter::EncodableValue(map);
+}
+
+flutter::EncodableMap LatencyValue(const CaptureStats::Histogram& h) {
+  auto ms = [](uint64_t us) { return flutter::EncodableValue(static_cast<double>(us) / 1000.0); };
+  flutter::EncodableMap map;
+  map[flutter::EncodableValue("count")] = flutter::EncodableValue(static_cast<int64_t>(h.count));
+  map[flutter::EncodableValue("meanMs")] = ms(h.count ? h.total_us / h.count : 0);
+  map[flutter::EncodableValue("minMs")] = ms(h.min_us);
+  map[flutter::EncodableValue("p50Ms")] = ms(h.Percentile(0.5));
+  map[flutter::EncodableValue("p90Ms")] = ms(h.Percentile(0.9));
+  map[flutter::EncodableValue("p99Ms")] = ms(h.Percentile(0.99));
+  map[flutter::EncodableValue("maxMs")] = ms(h.max_us);
+  // Non-empty buckets only: [{upToMs, count}], upToMs -1 for the last.
+  flutter::EncodableList buckets;
+  for (size_t i = 0; i < CaptureStats::kBuckets; i++) {
+    if (h.buckets[i] == 0) continue;
+    flutter::EncodableMap bucket;
+    const uint64_t limit = CaptureStats::Histogram::BucketLimit(i);
+    bucket[flutter::EncodableValue("upToMs")] =
+        limit == UINT64_MAX ? flutter::EncodableValue(-1.0) : ms(limit);
+    bucket[flutter::EncodableValue("count")] = flutter::EncodableValue(static_cast<int64_t>(h.buckets[i]));
+    buckets.push_back(flutter::EncodableValue(std::move(bucket)));
   }
+  map[flutter::EncodableValue("histogram")] = flutter::EncodableValue(std::move(buckets));
+  return map;
+}
 
-  const size_t size = static_cast<size_t>(width) * static_cast<size_t>(height) * 4u;
-  out.resize(size);
-  memcpy(out.data(), bits, size);
+// getCaptureStats: {methods: {<method>: {<latency>, stages: {<stage>:
+// <latency>}}}, tracing, traceEvents}; see LatencyValue for <latency>.
+flutter::EncodableValue CaptureStatsValue() {
+  flutter::EncodableMap methods;
+  for (const auto& entry : g_capture_stats.Snapshot()) {
+    flutter::EncodableMap method = LatencyValue(entry.second.total);
+    flutter::EncodableMap stages;
+    for (const auto& stage : entry.second.stages) {
+      stages[flutter::EncodableValue(stage.first)] = flutter::EncodableValue(LatencyValue(stage.second));
+    }
+    method[flutter::EncodableValue("stages")] = flutter::EncodableValue(std::move(stages));
+    methods[flutter::EncodableValue(entry.first)] = flutter::EncodableValue(std::move(method));
+  }
+  flutter::EncodableMap map;
+  map[flutter::EncodableValue("methods")] = flutter::EncodableValue(std::move(methods));
+  map[flutter::EncodableValue("tracing")] = flutter::EncodableValue(g_capture_stats.tracing());
+  map[flutter::EncodableValue("traceEvents")] =
+      flutter::EncodableValue(static_cast<int64_t>(g_capture_stats.trace_event_count()));
+  return flutter::EncodableValue(map);
+}
 
-  SelectObject(mem_dc, old);
-  DeleteObject(dib);
-  DeleteDC(mem_dc);
-  ReleaseDC(nullptr, screen_dc);
-  return true;
+// Optional tag callers use to cancel a group of captures (cancelCapture).
+std::string GetRequestId(const flutter::EncodableValue* arguments) {
+  const std::string* id = GetStringArg(arguments, "requestId");
+  return id ? *id : std::string();
 }
 
 bool CaptureScreenBgra(std::vector<uint8_t>& out, int& width, int& height) {
@@ -689,6 +819,752 @@ bool CaptureScreenBgra(std::vector<uint8_t>& out, int& width, int& height) {
   if (width <= 0 || height <= 0) return false;
   return CaptureRectBgra(x, y, width, height, out, width, height);
 }
+
+// Puts top-down BGRA rows on the clipboard as a 32-bpp CF_DIB. On failure
+// sets |error_code|/|error_message| for the reply.
+bool SetClipboardBgra(const uint8_t* bgra,
+                      int width,
+                      int height,
+                      size_t stride,
+                      std::string& error_code,
+                      std::string& error_message) {
+  const size_t row_bytes = static_cast<size_t>(width) * 4u;
+  const size_t data_size = sizeof(BITMAPINFOHEADER) + row_bytes * static_cast<size_t>(height);
+
+  HGLOBAL mem = GlobalAlloc(GMEM_MOVEABLE, data_size);
+  if (!mem) {
+    error_code = "ALLOC_FAILED";
+    error_message = "Failed to allocate memory for clipboard";
+    return false;
+  }
+  BYTE* data = static_cast<BYTE*>(GlobalLock(mem));
+  if (!data) {
+    GlobalFree(mem);
+    error_code = "LOCK_FAILED";
+    error_message = "Failed to lock memory";
+    return false;
+  }
+
+  // Negative height = top-down.
+  BITMAPINFOHEADER* bih = reinterpret_cast<BITMAPINFOHEADER*>(data);
+  ZeroMemory(bih, sizeof(BITMAPINFOHEADER));
+  bih->biSize = sizeof(BITMAPINFOHEADER);
+  bih->biWidth = width;
+  bih->biHeight = -height;
+  bih->biPlanes = 1;
+  bih->biBitCount = 32;
+  bih->biCompression = BI_RGB;
+  bih->biSizeImage = static_cast<DWORD>(row_bytes * static_cast<size_t>(height));
+
+  BYTE* pixels = data + sizeof(BITMAPINFOHEADER);
+  for (int y = 0; y < height; y++) {
+    memcpy(pixels + static_cast<size_t>(y) * row_bytes, bgra + static_cast<size_t>(y) * stride, row_bytes);
+  }
+  GlobalUnlock(mem);
+
+  if (!OpenClipboard(nullptr)) {
+    GlobalFree(mem);
+    error_code = "CLIPBOARD_ERROR";
+    error_message = "Failed to open clipboard";
+    return false;
+  }
+  EmptyClipboard();
+  HANDLE handle = SetClipboardData(CF_DIB, mem);
+  CloseClipboard();
+  if (!handle) {
+    GlobalFree(mem);
+    error_code = "CLIPBOARD_ERROR";
+    error_message = "Failed to set clipboard data";
+    return false;
+  }
+  return true;
+}
+
+void SetPixelsOutcome(CaptureOutcome& outcome, int width, int height, std::vector<uint8_t>&& bytes) {
+  flutter::EncodableMap map;
+  map[flutter::EncodableValue("width")] = flutter::EncodableValue(width);
+  map[flutter::EncodableValue("height")] = flutter::EncodableValue(height);
+  map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(std::move(bytes));
+  outcome.ok = true;
+  outcome.value = flutter::EncodableValue(std::move(map));
+}
+
+void SetErrorOutcome(CaptureOutcome& outcome, const std::string& code, const std::string& message) {
+  outcome.ok = false;
+  outcome.error_code = code;
+  outcome.error_message = message;
+}
+
+// Wraps a capture that finishes in one step.
+CaptureJob SingleStepJob(std::function<void(CaptureOutcome&)> run) {
+  return [run = std::move(run)](bool cancelled, CaptureOutcome& outcome) {
+    if (!cancelled) run(outcome);
+    return CaptureStep::Done();
+  };
+}
+
+CaptureJob RectCaptureJob(int x, int y, int w, int h, const std::string& failure) {
+  return SingleStepJob([x, y, w, h, failure](CaptureOutcome& outcome) {
+    std::vector<uint8_t> bytes;
+    int out_w = 0, out_h = 0;
+    if (CaptureRectBgra(x, y, w, h, bytes, out_w, out_h)) {
+      SetPixelsOutcome(outcome, out_w, out_h, std::move(bytes));
+    } else {
+      SetErrorOutcome(outcome, "CAPTURE_FAILED", failure);
+    }
+  });
+}
+
+CaptureJob RectThumbnailJob(int x, int y, int w, int h, int max_w, int max_h, const std::string& failure) {
+  return SingleStepJob([x, y, w, h, max_w, max_h, failure](CaptureOutcome& outcome) {
+    std::vector<uint8_t> bytes;
+    int out_w = 0, out_h = 0;
+    if (CaptureRectBgraScaled(x, y, w, h, max_w, max_h, bytes, out_w, out_h)) {
+      SetPixelsOutcome(outcome, out_w, out_h, std::move(bytes));
+    } else {
+      SetErrorOutcome(outcome, "CAPTURE_FAILED", failure);
+    }
+  });
+}
+
+// Captures |hwnd| (thumb_w x thumb_h when > 0, otherwise full size) and hands
+// the BGRA pixels to |deliver|.
+using PixelsHandler = std::function<void(CaptureOutcome&, int, int, std::vector<uint8_t>&&)>;
+
+CaptureJob WindowCaptureJob(HWND hwnd,
+                            int thumb_w,
+                            int thumb_h,
+                            bool allow_restore,
+                            const std::string& failure,
+                            PixelsHandler deliver = SetPixelsOutcome) {
+  auto steps = std::make_shared<WindowCaptureSteps>(hwnd, thumb_w, thumb_h, allow_restore);
+  return [steps, failure, deliver](bool cancelled, CaptureOutcome& outcome) {
+    const CaptureStep step = steps->Step(cancelled);
+    if (step.done) {
+      if (steps->succeeded()) {
+        deliver(outcome, steps->width(), steps->height(), std::move(steps->bytes()));
+      } else {
+        SetErrorOutcome(outcome, "CAPTURE_FAILED", failure);
+      }
+    }
+    return step;
+  };
+}
+
+UploadHistories g_upload_histories;
+
+std::string UploadOptionsKey(const UploadEncodeOptions& options) {
+  return std::to_string(static_cast<int>(options.format)) + ":" + std::to_string(options.max_dimension) + ":" +
+         std::to_string(options.max_bytes) + ":" + std::to_string(options.jpeg_quality) + ":" +
+         std::to_string(static_cast<int>(options.png_preset));
+}
+
+const char* FrameChangeName(FrameDiff::Kind kind) {
+  switch (kind) {
+    case FrameDiff::Kind::kUnchanged:
+      return "unchanged";
+    case FrameDiff::Kind::kDirty:
+      return "dirty";
+    case FrameDiff::Kind::kChanged:
+      return "changed";
+    default:
+      return "first";
+  }
+}
+
+flutter::EncodableMap UploadValue(const EncodedUpload& encoded, int source_w, int source_h) {
+  flutter::EncodableMap map;
+  map[flutter::EncodableValue("width")] = flutter::EncodableValue(encoded.width);
+  map[flutter::EncodableValue("height")] = flutter::EncodableValue(encoded.height);
+  map[flutter::EncodableValue("sourceWidth")] = flutter::EncodableValue(source_w);
+  map[flutter::EncodableValue("sourceHeight")] = flutter::EncodableValue(source_h);
+  map[flutter::EncodableValue("mimeType")] = flutter::EncodableValue(encoded.mime_type);
+  map[flutter::EncodableValue("quality")] = flutter::EncodableValue(encoded.quality);
+  map[flutter::EncodableValue("withinBudget")] = flutter::EncodableValue(encoded.within_budget);
+  return map;
+}
+
+flutter::EncodableValue RectValue(const DirtyRect& r) {
+  flutter::EncodableMap map;
+  map[flutter::EncodableValue("x")] = flutter::EncodableValue(r.x);
+  map[flutter::EncodableValue("y")] = flutter::EncodableValue(r.y);
+  map[flutter::EncodableValue("width")] = flutter::EncodableValue(r.width);
+  map[flutter::EncodableValue("height")] = flutter::EncodableValue(r.height);
+  return flutter::EncodableValue(std::move(map));
+}
+
+// Encodes |pixels| for upload. With a |history|, a frame identical to the
+// previous one for that target returns the cached encoding, and with
+// |crops_only| a partly changed frame is sent as its changed rectangles
+// (scaled like the full frame would be) instead of the whole image.
+void EncodeUploadOutcome(CaptureOutcome& outcome,
+                         const UploadEncodeOptions& options,
+                         const std::shared_ptr<UploadHistory>& history,
+                         bool crops_only,
+                         int w,
+                         int h,
+                         const std::vector<uint8_t>& pixels) {
+  ScopedStageTimer timer(g_capture_stats, "encode");
+  std::unique_lock<std::mutex> lock;
+  FrameDiff diff;
+  const std::string options_key = UploadOptionsKey(options);
+  if (history) {
+    lock = std::unique_lock<std::mutex>(history->mutex);
+    diff = history->differ.Update(pixels.data(), w, h, 0);
+    if (diff.kind == FrameDiff::Kind::kUnchanged && history->last && history->last_options == options_key) {
+      flutter::EncodableMap map = UploadValue(*history->last, w, h);
+      map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(history->last->bytes);
+      map[flutter::EncodableValue("change")] = flutter::EncodableValue("unchanged");
+      map[flutter::EncodableValue("cached")] = flutter::EncodableValue(true);
+      outcome.ok = true;
+      outcome.value = flutter::EncodableValue(std::move(map));
+      return;
+    }
+  }
+
+  flutter::EncodableList rects;
+  for (const DirtyRect& r : diff.rects) rects.push_back(RectValue(r));
+
+  if (history && crops_only && diff.kind == FrameDiff::Kind::kDirty) {
+    const double scale = options.max_dimension > 0 && (std::max)(w, h) > options.max_dimension
+                             ? static_cast<double>(options.max_dimension) / (std::max)(w, h)
+                             : 1.0;
+    flutter::EncodableList crops;
+    for (const DirtyRect& r : diff.rects) {
+      UploadEncodeOptions crop_options = options;
+      crop_options.max_dimension =
+          (std::max)(1, static_cast<int>(std::ceil((std::max)(r.width, r.height) * scale)));
+      EncodedUpload encoded;
+      const uint8_t* origin = pixels.data() + (static_cast<size_t>(r.y) * w + r.x) * 4;
+      if (!EncodeForUpload(origin, r.width, r.height, static_cast<size_t>(w) * 4, crop_options, encoded)) {
+        SetErrorOutcome(outcome, "ENCODE_FAILED", "Failed to encode capture.");
+        return;
+      }
+      flutter::EncodableMap crop = UploadValue(encoded, r.width, r.height);
+      crop[flutter::EncodableValue("x")] = flutter::EncodableValue(r.x);
+      crop[flutter::EncodableValue("y")] = flutter::EncodableValue(r.y);
+      crop[flutter::EncodableValue("bytes")] = flutter::EncodableValue(std::move(encoded.bytes));
+      crops.push_back(flutter::EncodableValue(std::move(crop)));
+    }
+    // The cached full frame no longer matches what the differ holds.
+    history->last.reset();
+    flutter::EncodableMap map;
+    map[flutter::EncodableValue("sourceWidth")] = flutter::EncodableValue(w);
+    map[flutter::EncodableValue("sourceHeight")] = flutter::EncodableValue(h);
+    map[flutter::EncodableValue("change")] = flutter::EncodableValue("dirty");
+    map[flutter::EncodableValue("dirtyRects")] = flutter::EncodableValue(std::move(rects));
+    map[flutter::EncodableValue("crops")] = flutter::EncodableValue(std::move(crops));
+    outcome.ok = true;
+    outcome.value = flutter::EncodableValue(std::move(map));
+    return;
+  }
+
+  auto encoded = std::make_shared<EncodedUpload>();
+  // With history the bytes are kept for reuse and the reply gets a copy.
+  if (!history) ReservePooledUploadBytes(options, w, h, *encoded);
+  if (!EncodeForUpload(pixels.data(), w, h, 0, options, *encoded)) {
+    if (history) history->differ.Reset();
+    SetErrorOutcome(outcome, "ENCODE_FAILED", "Failed to encode capture.");
+    return;
+  }
+  flutter::EncodableMap map = UploadValue(*encoded, w, h);
+  if (history) {
+    map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(encoded->bytes);
+    map[flutter::EncodableValue("change")] = flutter::EncodableValue(FrameChangeName(diff.kind));
+    if (diff.kind == FrameDiff::Kind::kDirty) {
+      map[flutter::EncodableValue("dirtyRects")] = flutter::EncodableValue(std::move(rects));
+    }
+    history->last = std::move(encoded);
+    history->last_options = options_key;
+  } else {
+    map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(std::move(encoded->bytes));
+  }
+  outcome.ok = true;
+  outcome.value = flutter::EncodableValue(std::move(map));
+}
+
+// captureForUpload's perceptual dedupe: a frame within |threshold| bits of a
+// recent upload of the same target is answered with that image's id instead
+// of being encoded again.
+struct SimilarImageOptions {
+  bool enabled = false;
+  std::string key;
+  int threshold = 4;
+  // Ids the caller can still resolve; any recent image when unset.
+  std::optional<std::vector<uint64_t>> known_ids;
+};
+
+void EncodeSimilarUploadOutcome(CaptureOutcome& outcome,
+                                const UploadEncodeOptions& options,
+                                const std::shared_ptr<UploadHistory>& history,
+                                bool crops_only,
+                                const SimilarImageOptions& similar,
+                                int w,
+                                int h,
+                                const std::vector<uint8_t>& pixels) {
+  ImageFingerprint fingerprint;
+  bool hashed = false;
+  if (similar.enabled) {
+    ScopedStageTimer timer(g_capture_stats, "perceptual hash");
+    hashed = ComputeFingerprint(pixels.data(), w, h, 0, fingerprint);
+  }
+  if (hashed) {
+    const RecentImageIndex::Match match = g_recent_images.Find(
+        similar.key, fingerprint, similar.threshold, similar.known_ids ? &*similar.known_ids : nullptr);
+    if (match.image_id != 0) {
+      flutter::EncodableMap map;
+      map[flutter::EncodableValue("sourceWidth")] = flutter::EncodableValue(w);
+      map[flutter::EncodableValue("sourceHeight")] = flutter::EncodableValue(h);
+      map[flutter::EncodableValue("change")] = flutter::EncodableValue("similar");
+      map[flutter::EncodableValue("sameAs")] = flutter::EncodableValue(static_cast<int64_t>(match.image_id));
+      map[flutter::EncodableValue("imageId")] = flutter::EncodableValue(static_cast<int64_t>(match.image_id));
+      map[flutter::EncodableValue("distance")] = flutter::EncodableValue(match.distance);
+      outcome.ok = true;
+      outcome.value = flutter::EncodableValue(std::move(map));
+      return;
+    }
+  }
+
+  EncodeUploadOutcome(outcome, options, history, crops_only, w, h, pixels);
+  if (!hashed || !outcome.ok || !std::holds_alternative<flutter::EncodableMap>(outcome.value)) return;
+  // Only whole frames can be referred to later; crops replies get no id.
+  auto& map = std::get<flutter::EncodableMap>(outcome.value);
+  if (map.find(flutter::EncodableValue("bytes")) == map.end()) return;
+  const uint64_t id = g_recent_images.Add(similar.key, fingerprint);
+  map[flutter::EncodableValue("imageId")] = flutter::EncodableValue(static_cast<int64_t>(id));
+}
+
+// smartCrop gives up when the detailed part is most of the frame anyway.
+constexpr double kSmartCropMaxKeep = 0.85;
+
+// captureForUpload's smartCrop: when |pixels| would be downscaled to fit
+// |options|, keeps only the detailed part (FindContentCrop) so small text
+// survives the downscale. Replaces |pixels| with the crop and returns true,
+// or leaves it alone when the whole frame should be sent.
+bool SmartCropForUpload(const UploadEncodeOptions& options, int w, int h, std::vector<uint8_t>& pixels, CropRect& crop) {
+  if (options.max_dimension <= 0 || (std::max)(w, h) <= options.max_dimension) return false;
+  ScopedStageTimer timer(g_capture_stats, "smart crop");
+  if (!FindContentCrop(pixels.data(), w, h, 0, kSmartCropMaxKeep, crop)) return false;
+  std::vector<uint8_t> cropped = g_pixel_pool.Acquire(static_cast<size_t>(crop.width) * crop.height * 4);
+  const size_t row_bytes = static_cast<size_t>(crop.width) * 4;
+  for (int y = 0; y < crop.height; y++) {
+    const uint8_t* src = pixels.data() + (static_cast<size_t>(crop.y + y) * w + crop.x) * 4;
+    std::copy(src, src + row_bytes, cropped.data() + y * row_bytes);
+  }
+  g_pixel_pool.Release(std::move(pixels));
+  pixels = std::move(cropped);
+  return true;
+}
+
+// Workers for recognizeText's binarization and per-band recognition, and
+// the tallest band handed to the recognizer at once.
+constexpr int kOcrThreads = 4;
+constexpr int kOcrMaxBandHeight = 1024;
+
+flutter::EncodableMap TextBoxValue(const std::string& text, int x, int y, int width, int height) {
+  flutter::EncodableMap map;
+  map[flutter::EncodableValue("text")] = flutter::EncodableValue(text);
+  map[flutter::EncodableValue("x")] = flutter::EncodableValue(x);
+  map[flutter::EncodableValue("y")] = flutter::EncodableValue(y);
+  map[flutter::EncodableValue("width")] = flutter::EncodableValue(width);
+  map[flutter::EncodableValue("height")] = flutter::EncodableValue(height);
+  return map;
+}
+
+// Recognizes the text in |pixels|: {text, lines: [{text, x, y, width,
+// height, words: [{text, x, y, width, height}]}], language, bands,
+// sourceWidth, sourceHeight}, boxes in capture pixels.
+void RecognizeTextOutcome(CaptureOutcome& outcome, int w, int h, const std::vector<uint8_t>& pixels) {
+  OcrLayout layout;
+  {
+    ScopedStageTimer timer(g_capture_stats, "text layout");
+    AnalyzeOcrLayout(pixels.data(), w, h, 0, kOcrMaxBandHeight, kOcrThreads, layout);
+  }
+  OcrText text;
+  std::string error;
+  {
+    ScopedStageTimer timer(g_capture_stats, "recognize");
+    if (!RecognizeOcrBands(layout, w, kOcrThreads, text, error)) {
+      SetErrorOutcome(outcome, "OCR_FAILED", error);
+      return;
+    }
+  }
+
+  std::string joined;
+  flutter::EncodableList lines;
+  for (const OcrLineBox& line : text.lines) {
+    if (!joined.empty()) joined += '\n';
+    joined += line.text;
+    flutter::EncodableList words;
+    for (const OcrWordBox& word : line.words) {
+      words.push_back(flutter::EncodableValue(TextBoxValue(word.text, word.x, word.y, word.width, word.height)));
+    }
+    flutter::EncodableMap value = TextBoxValue(line.text, line.x, line.y, line.width, line.height);
+    value[flutter::EncodableValue("words")] = flutter::EncodableValue(std::move(words));
+    lines.push_back(flutter::EncodableValue(std::move(value)));
+  }
+  flutter::EncodableMap map;
+  map[flutter::EncodableValue("text")] = flutter::EncodableValue(std::move(joined));
+  map[flutter::EncodableValue("lines")] = flutter::EncodableValue(std::move(lines));
+  map[flutter::EncodableValue("language")] = flutter::EncodableValue(text.language);
+  map[flutter::EncodableValue("bands")] = flutter::EncodableValue(static_cast<int>(layout.bands.size()));
+  map[flutter::EncodableValue("sourceWidth")] = flutter::EncodableValue(w);
+  map[flutter::EncodableValue("sourceHeight")] = flutter::EncodableValue(h);
+  outcome.ok = true;
+  outcome.value = flutter::EncodableValue(std::move(map));
+}
+
+// format/maxDimension/maxBytes/quality, as taken by captureForUpload and
+// startScreenStream.
+UploadEncodeOptions ParseUploadOptions(const flutter::EncodableMap& args,
+                                       PngPreset default_preset = PngPreset::kBalanced) {
+  UploadEncodeOptions options;
+  options.png_preset = default_preset;
+  int64_t v = 0;
+  if (GetInt64Arg(args, "maxDimension", v)) options.max_dimension = static_cast<int>(v);
+  if (GetInt64Arg(args, "maxBytes", v) && v > 0) options.max_bytes = static_cast<size_t>(v);
+  if (GetInt64Arg(args, "quality", v)) options.jpeg_quality = static_cast<int>(v);
+  auto it = args.find(flutter::EncodableValue("format"));
+  if (it != args.end() && std::holds_alternative<std::string>(it->second)) {
+    const std::string& format = std::get<std::string>(it->second);
+    if (format == "jpeg" || format == "webp") {
+      // No WebP encoder in the runner; JPEG is the lossy fallback and the
+      // reply's mimeType says what was produced.
+      options.format = UploadFormat::kJpeg;
+    } else if (format == "auto") {
+      options.format = UploadFormat::kAuto;
+    }
+  }
+  it = args.find(flutter::EncodableValue("pngPreset"));
+  if (it != args.end() && std::holds_alternative<std::string>(it->second)) {
+    const std::string& preset = std::get<std::string>(it->second);
+    if (preset == "fast") {
+      options.png_preset = PngPreset::kFast;
+    } else if (preset == "balanced") {
+      options.png_preset = PngPreset::kBalanced;
+    } else if (preset == "smallest") {
+      options.png_preset = PngPreset::kSmallest;
+    }
+  }
+  return options;
+}
+
+// Screen rectangle for a "rect" (x/y/width/height) or "monitor" (monitorId)
+// target. On failure sets |error_code|/|error_message| for the reply.
+bool ParseTargetRect(const flutter::EncodableMap& args,
+                     const std::string& kind,
+                     RECT& rect,
+                     std::string& error_code,
+                     std::string& error_message) {
+  if (kind == "rect") {
+    int64_t x = 0, y = 0, w = 0, h = 0;
+    GetInt64Arg(args, "x", x);
+    GetInt64Arg(args, "y", y);
+    GetInt64Arg(args, "width", w);
+    GetInt64Arg(args, "height", h);
+    if (w <= 0 || h <= 0) {
+      error_code = "BAD_ARGS";
+      error_message = "Invalid or missing width/height";
+      return false;
+    }
+    rect = RECT{static_cast<LONG>(x), static_cast<LONG>(y), static_cast<LONG>(x + w), static_cast<LONG>(y + h)};
+    return true;
+  }
+  int64_t id = 0;
+  GetInt64Arg(args, "monitorId", id);
+  MONITORINFO mi{};
+  mi.cbSize = sizeof(mi);
+  if (id == 0 || !GetMonitorInfoW(reinterpret_cast<HMONITOR>(static_cast<intptr_t>(id)), &mi)) {
+    error_code = "NO_MONITOR";
+    error_message = "Monitor not found";
+    return false;
+  }
+  rect = mi.rcMonitor;
+  return true;
+}
+
+// Frozen captures kept for the region selector; each full virtual-screen
+// snapshot can be 100+ MB on multi-4K setups.
+constexpr size_t kMaxScreenSnapshots = 2;
+
+// The x/y/width/height screen rectangle in |args|, clipped to |snapshot|;
+// the whole snapshot when width/height are absent.
+bool SnapshotRectArg(const flutter::EncodableMap& args, const ScreenSnapshot& snapshot, SnapshotRect& rect) {
+  int64_t x = snapshot.left(), y = snapshot.top(), w = 0, h = 0;
+  if (!GetInt64Arg(args, "width", w) || !GetInt64Arg(args, "height", h)) {
+    return snapshot.Clip(snapshot.left(), snapshot.top(), snapshot.width(), snapshot.height(), rect);
+  }
+  GetInt64Arg(args, "x", x);
+  GetInt64Arg(args, "y", y);
+  return snapshot.Clip(static_cast<int>(x), static_cast<int>(y), static_cast<int>(w), static_cast<int>(h), rect);
+}
+
+// A monitor taking part in captureMonitorsForUpload.
+struct MonitorTarget {
+  int64_t id = 0;
+  RECT rect{};
+};
+
+// Threads capturing monitors at once; GDI serializes some of the work, so
+// more than this rarely helps.
+constexpr size_t kMonitorCaptureThreads = 4;
+
+// Pixels between monitors on a composite.
+constexpr int kCompositeGap = 8;
+
+// |ids| in the given order, or every monitor top to bottom, then left to
+// right. Unknown ids are skipped.
+std::vector<MonitorTarget> ResolveMonitors(const std::vector<int64_t>& ids) {
+  std::vector<MonitorTarget> monitors;
+  if (ids.empty()) {
+    EnumDisplayMonitors(
+        nullptr, nullptr,
+        [](HMONITOR hmon, HDC, LPRECT, LPARAM lparam) -> BOOL {
+          MONITORINFO mi{};
+          mi.cbSize = sizeof(mi);
+          if (GetMonitorInfoW(hmon, &mi) && mi.rcMonitor.right > mi.rcMonitor.left &&
+              mi.rcMonitor.bottom > mi.rcMonitor.top) {
+            reinterpret_cast<std::vector<MonitorTarget>*>(lparam)->push_back(
+                MonitorTarget{static_cast<int64_t>(reinterpret_cast<intptr_t>(hmon)), mi.rcMonitor});
+          }
+          return TRUE;
+        },
+        reinterpret_cast<LPARAM>(&monitors));
+    std::sort(monitors.begin(), monitors.end(), [](const MonitorTarget& a, const MonitorTarget& b) {
+      return a.rect.top != b.rect.top ? a.rect.top < b.rect.top : a.rect.left < b.rect.left;
+    });
+    return monitors;
+  }
+  for (int64_t id : ids) {
+    MONITORINFO mi{};
+    mi.cbSize = sizeof(mi);
+    if (id != 0 && GetMonitorInfoW(reinterpret_cast<HMONITOR>(static_cast<intptr_t>(id)), &mi)) {
+      monitors.push_back(MonitorTarget{id, mi.rcMonitor});
+    }
+  }
+  return monitors;
+}
+
+// Captures every monitor concurrently, each downscaled on its own to its
+// share of |options.max_dimension|, then either encodes one composite grid
+// or (|separate|) encodes each monitor in parallel with an equal share of
+// |options.max_bytes|.
+CaptureJob MonitorsUploadJob(std::vector<MonitorTarget> monitors, UploadEncodeOptions options, bool separate) {
+  return SingleStepJob([monitors = std::move(monitors), options, separate](CaptureOutcome& outcome) {
+    const size_t n = monitors.size();
+    const int columns = separate ? 1 : CompositeColumns(n);
+    int box = options.max_dimension;
+    if (box > 0 && !separate) box = (std::max)(1, (box - kCompositeGap * (columns - 1)) / columns);
+    UploadEncodeOptions each = options;
+    if (separate && options.max_bytes > 0) each.max_bytes = (std::max)(size_t{1}, options.max_bytes / n);
+
+    struct Shot {
+      std::vector<uint8_t> bgra;
+      int width = 0;
+      int height = 0;
+      bool ok = false;
+      EncodedUpload encoded;
+    };
+    std::vector<Shot> shots(n);
+    const std::string& method = ScopedCaptureMethod::Current();
+    RunParallel(n, kMonitorCaptureThreads, [&](size_t i) {
+      ScopedCaptureMethod method_scope(method);
+      const RECT& r = monitors[i].rect;
+      const int sw = r.right - r.left;
+      const int sh = r.bottom - r.top;
+      Shot& shot = shots[i];
+      int tw = 0, th = 0;
+      ScaleToFit(sw, sh, box, box, tw, th);
+      shot.ok = tw == sw && th == sh
+                    ? CaptureRectBgra(r.left, r.top, sw, sh, shot.bgra, shot.width, shot.height)
+                    : CaptureRectBgraScaled(r.left, r.top, sw, sh, box, box, shot.bgra, shot.width, shot.height);
+      if (shot.ok && separate) {
+        shot.ok = EncodeForUpload(shot.bgra.data(), shot.width, shot.height, 0, each, shot.encoded);
+        g_pixel_pool.Release(std::move(shot.bgra));
+      }
+    });
+
+    auto monitor_value = [&](size_t i) {
+      const RECT& r = monitors[i].rect;
+      flutter::EncodableMap map;
+      map[flutter::EncodableValue("monitorId")] = flutter::EncodableValue(monitors[i].id);
+      map[flutter::EncodableValue("x")] = flutter::EncodableValue(static_cast<int>(r.left));
+      map[flutter::EncodableValue("y")] = flutter::EncodableValue(static_cast<int>(r.top));
+      map[flutter::EncodableValue("sourceWidth")] = flutter::EncodableValue(static_cast<int>(r.right - r.left));
+      map[flutter::EncodableValue("sourceHeight")] = flutter::EncodableValue(static_cast<int>(r.bottom - r.top));
+      return map;
+    };
+
+    if (separate) {
+      flutter::EncodableList images;
+      bool any = false;
+      for (size_t i = 0; i < n; i++) {
+        flutter::EncodableMap map = monitor_value(i);
+        if (shots[i].ok) {
+          any = true;
+          const EncodedUpload& e = shots[i].encoded;
+          for (auto& kv : UploadValue(e, static_cast<int>(monitors[i].rect.right - monitors[i].rect.left),
+                                      static_cast<int>(monitors[i].rect.bottom - monitors[i].rect.top))) {
+            map[kv.first] = kv.second;
+          }
+          map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(std::move(shots[i].encoded.bytes));
+        } else {
+          map[flutter::EncodableValue("error")] = flutter::EncodableValue("Failed to capture monitor.");
+        }
+        images.push_back(flutter::EncodableValue(std::move(map)));
+      }
+      if (!any) {
+        SetErrorOutcome(outcome, "CAPTURE_FAILED", "Failed to capture monitors.");
+        return;
+      }
+      flutter::EncodableMap map;
+      map[flutter::EncodableValue("layout")] = flutter::EncodableValue("separate");
+      map[flutter::EncodableValue("images")] = flutter::EncodableValue(std::move(images));
+      outcome.ok = true;
+      outcome.value = flutter::EncodableValue(std::move(map));
+      return;
+    }
+
+    std::vector<CompositeSource> sources;
+    std::vector<size_t> placed;
+    for (size_t i = 0; i < n; i++) {
+      if (!shots[i].ok) continue;
+      sources.push_back(CompositeSource{shots[i].bgra.data(), shots[i].width, shots[i].height});
+      placed.push_back(i);
+    }
+    std::vector<uint8_t> canvas;
+    int cw = 0, ch = 0;
+    std::vector<CompositePlacement> placements;
+    const bool composed =
+        !sources.empty() && ComposeGrid(sources, CompositeColumns(sources.size()), kCompositeGap, canvas, cw, ch, placements);
+    for (Shot& shot : shots) g_pixel_pool.Release(std::move(shot.bgra));
+    EncodedUpload encoded;
+    if (composed) ReservePooledUploadBytes(options, cw, ch, encoded);
+    const bool encoded_ok = composed && EncodeForUpload(canvas.data(), cw, ch, 0, options, encoded);
+    g_pixel_pool.Release(std::move(canvas));
+    if (!encoded_ok) {
+      SetErrorOutcome(outcome, "CAPTURE_FAILED", "Failed to capture monitors.");
+      return;
+    }
+
+    // Tile rectangles in the encoded image, which the encoder may have
+    // shrunk further to meet the byte budget.
+    const double scale = static_cast<double>(encoded.width) / static_cast<double>(cw);
+    auto scaled = [scale](int v) { return static_cast<int>(std::lround(v * scale)); };
+    flutter::EncodableList tiles;
+    for (size_t k = 0; k < placed.size(); k++) {
+      flutter::EncodableMap map = monitor_value(placed[k]);
+      map[flutter::EncodableValue("tileX")] = flutter::EncodableValue(scaled(placements[k].x));
+      map[flutter::EncodableValue("tileY")] = flutter::EncodableValue(scaled(placements[k].y));
+      map[flutter::EncodableValue("tileWidth")] = flutter::EncodableValue(scaled(placements[k].width));
+      map[flutter::EncodableValue("tileHeight")] = flutter::EncodableValue(scaled(placements[k].height));
+      tiles.push_back(flutter::EncodableValue(std::move(map)));
+    }
+    flutter::EncodableMap map = UploadValue(encoded, cw, ch);
+    map[flutter::EncodableValue("layout")] = flutter::EncodableValue("composite");
+    map[flutter::EncodableValue("monitors")] = flutter::EncodableValue(std::move(tiles));
+    map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(std::move(encoded.bytes));
+    outcome.ok = true;
+    outcome.value = flutter::EncodableValue(std::move(map));
+  });
+}
+
+// Offers captured pixels to |stream|. A published frame leaves its change
+// notification in |outcome.value|; an unchanged one leaves it null.
+PixelsHandler StreamFrameHandler(std::shared_ptr<ScreenStream> stream) {
+  return [stream](CaptureOutcome& outcome, int w, int h, std::vector<uint8_t>&& pixels) {
+    outcome.ok = true;
+    FrameDiff diff;
+    const bool published = stream->Offer(pixels.data(), w, h, 0, diff);
+    g_pixel_pool.Release(std::move(pixels));
+    if (!published) return;
+    const StreamFrame frame = stream->Latest();
+    flutter::EncodableMap map = UploadValue(*frame.upload, w, h);
+    map[flutter::EncodableValue("sequence")] = flutter::EncodableValue(static_cast<int64_t>(frame.sequence));
+    map[flutter::EncodableValue("change")] = flutter::EncodableValue(FrameChangeName(diff.kind));
+    if (diff.kind == FrameDiff::Kind::kDirty) {
+      flutter::EncodableList rects;
+      for (const DirtyRect& r : diff.rects) rects.push_back(RectValue(r));
+      map[flutter::EncodableValue("dirtyRects")] = flutter::EncodableValue(std::move(rects));
+    }
+    outcome.value = flutter::EncodableValue(std::move(map));
+  };
+}
+
+// Runs a fresh |make_frame| capture at |stream|'s pace until cancelled.
+// |on_frame| sees each frame's outcome on the worker thread and returns
+// false to end the stream.
+CaptureExecutor::Step ScreenStreamJob(std::function<CaptureJob()> make_frame,
+                                      std::shared_ptr<ScreenStream> stream,
+                                      std::function<bool(const CaptureOutcome&)> on_frame) {
+  struct State {
+    CaptureJob frame;
+    CaptureOutcome outcome;
+    CaptureStats::Clock::time_point started;
+  };
+  static const std::string kMethod("screenStream");
+  auto state = std::make_shared<State>();
+  return [make_frame, stream, on_frame, state](bool cancelled) {
+    ScopedCaptureMethod method_scope(kMethod);
+    if (!state->frame) {
+      if (cancelled) return CaptureStep::Done();
+      state->frame = make_frame();
+      state->outcome = CaptureOutcome();
+      state->started = CaptureStats::Clock::now();
+    }
+    const CaptureStep step = state->frame(cancelled, state->outcome);
+    if (!step.done && !cancelled) return step;
+    state->frame = nullptr;
+    g_capture_stats.RecordTotal(kMethod, state->started, CaptureStats::Clock::now());
+    if (cancelled || !on_frame(state->outcome)) return CaptureStep::Done();
+    return CaptureStep::After(stream->NextDelay(ScreenStream::Clock::now()));
+  };
+}
+
+// Stream captures run on their own pool so encoding never delays on-demand
+// captures.
+constexpr size_t kStreamThreads = 2;
+
+// captureThumbnails pool size; bounds concurrent PrintWindow/DWM work.
+constexpr size_t kThumbnailThreads = 4;
+
+// After minimizing ourselves, Windows needs a moment to bring the previous
+// window forward; poll for it instead of sleeping.
+constexpr std::chrono::milliseconds kSelfMinimizeDelay(120);
+constexpr std::chrono::milliseconds kForegroundPollInterval(50);
+constexpr int kForegroundPolls = 10;
+
+// Waits for a window other than |self| to be foreground, then runs the job
+// |make_capture| builds for it.
+CaptureJob ForegroundWindowJob(HWND self, std::function<CaptureJob(HWND)> make_capture) {
+  struct State {
+    int polls = 0;
+    CaptureJob capture;
+  };
+  auto state = std::make_shared<State>();
+  return [self, state, make_capture](bool cancelled, CaptureOutcome& outcome) {
+    if (state->capture) return state->capture(cancelled, outcome);
+    if (cancelled) return CaptureStep::Done();
+    HWND fg = GetForegroundWindow();
+    if (!fg || (self && (fg == self || IsChild(self, fg)))) {
+      if (++state->polls < kForegroundPolls) return CaptureStep::After(kForegroundPollInterval);
+      SetErrorOutcome(outcome, "NO_TARGET", "No active window to capture (focus another window and try again).");
+      return CaptureStep::Done();
+    }
+    state->capture = make_capture(fg);
+    return state->capture(false, outcome);
+  };
+}
+
+// Captures the active window (see TrackedActiveWindow) right away. Only when
+// nothing has been tracked yet does it fall back to ForegroundWindowJob,
+// setting |minimize_self| if the caller must first minimize our window.
+CaptureJob ActiveWindowJob(HWND self, std::function<CaptureJob(HWND)> make_capture, bool& minimize_self) {
+  minimize_self = false;
+  if (HWND target = TrackedActiveWindow(self)) return make_capture(target);
+  minimize_self = IsSelfForeground(self);
+  return ForegroundWindowJob(self, std::move(make_capture));
+}
 }  // namespace
 
 FlutterWindow::FlutterWindow(const flutter::DartProject& project)
@@ -712,8 +1588,82 @@ bool FlutterWindow::OnCreate() {
     return false;
   }
   RegisterPlugins(flutter_controller_->engine());
+  // Registrar for the runner's own external textures (capture previews).
+  // The wrapper's TextureRegistrarImpl is built into flutter_wrapper_app.
+  texture_registrar_ = std::make_unique<flutter::TextureRegistrarImpl>(FlutterDesktopRegistrarGetTextureRegistrar(
+      flutter_controller_->engine()->GetRegistrarForPlugin("CaptureTextures")));
   SetChildContent(flutter_controller_->view()->GetNativeWindow());
 
+  task_runner_ = std::make_unique<PlatformTaskRunner>(GetHandle());
+  capture_executor_ = std::make_unique<CaptureExecutor>();
+  // Out-of-context events are delivered on this thread's message loop.
+  foreground_hook_ = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr, ForegroundEventProc, 0,
+                                     0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+  if (HWND fg = GetForegroundWindow()) {
+    g_foreground.OnForeground(reinterpret_cast<uintptr_t>(fg), IsForegroundTarget(fg));
+  }
+  thumbnail_executor_ = std::make_unique<CaptureExecutor>(kThumbnailThreads);
+  stream_executor_ = std::make_unique<CaptureExecutor>(kStreamThreads);
+
+  // Tiles from captureThumbnails, streamed as each one is ready.
+  thumbnail_channel_ =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          flutter_controller_->engine()->messenger(), "com.finalround/thumbnails",
+          &flutter::StandardMethodCodec::GetInstance());
+  thumbnail_channel_->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [this](const flutter::EncodableValue* arguments,
+                 std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&& events)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            thumbnail_sink_ = std::move(events);
+            return nullptr;
+          },
+          [this](const flutter::EncodableValue* arguments)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            thumbnail_sink_ = nullptr;
+            return nullptr;
+          }));
+
+  // Change notifications from startScreenStream.
+  stream_channel_ =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          flutter_controller_->engine()->messenger(), "com.finalround/screen_stream",
+          &flutter::StandardMethodCodec::GetInstance());
+  stream_channel_->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [this](const flutter::EncodableValue* arguments,
+                 std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&& events)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            stream_sink_ = std::move(events);
+            return nullptr;
+          },
+          [this](const flutter::EncodableValue* arguments)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            stream_sink_ = nullptr;
+            return nullptr;
+          }));
+
+  // Event channel for system audio levels (RMS, peak, min/max waveform).
+  audio_level_channel_ =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          flutter_controller_->engine()->messenger(), "com.finalround/audio_levels",
+          &flutter::StandardMethodCodec::GetInstance());
+  audio_level_channel_->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [this](const flutter::EncodableValue* arguments,
+                 std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&& events)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            audio_level_sink_ = std::move(events);
+            UpdateAudioLevelCallback();
+            return nullptr;
+          },
+          [this](const flutter::EncodableValue* arguments)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            audio_level_sink_ = nullptr;
+            UpdateAudioLevelCallback();
+            return nullptr;
+          }));
+
   // Setup method channel for audio
   auto audioChannel =
       std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
@@ -721,12 +1671,13 @@ bool FlutterWindow::OnCreate() {
           &flutter::StandardMethodCodec::GetInstance());
 
   audioChannel->SetMethodCallHandler(
-      [](const flutter::MethodCall<flutter::EncodableValue>& call,
+      [this](const flutter::MethodCall<flutter::EncodableValue>& call,
          std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>
              result) {
         if (call.method_name().compare("startSystemAudio") == 0) {
           if (!g_audio_capture) {
             g_audio_capture = std::make_unique<AudioCapture>();
+            UpdateAudioLevelCallback();
           }
           bool success = g_audio_capture->StartSystemAudio();
           result->Success(flutter::EncodableValue(success));
@@ -737,30 +1688,182 @@ bool FlutterWindow::OnCreate() {
           result->Success();
         } else if (call.method_name().compare("getSystemAudioFrame") == 0) {
           if (g_audio_capture) {
-            size_t requested = 0;
+            int32_t length = 0;
             if (call.arguments()) {
               // Expect either an int directly or a map {"length": int}
               if (std::holds_alternative<int32_t>(*call.arguments())) {
-                requested = static_cast<size_t>(std::get<int32_t>(*call.arguments()));
+                length = std::get<int32_t>(*call.arguments());
               } else if (std::holds_alternative<flutter::EncodableMap>(*call.arguments())) {
                 const auto& args = std::get<flutter::EncodableMap>(*call.arguments());
                 auto it = args.find(flutter::EncodableValue("length"));
                 if (it != args.end() && std::holds_alternative<int32_t>(it->second)) {
-                  requested = static_cast<size_t>(std::get<int32_t>(it->second));
+                  length = std::get<int32_t>(it->second);
                 }
               }
             }
 
-            if (requested == 0) {
-              // Default to 1280 bytes (~40ms @ 16k mono PCM16) if caller doesn't specify.
-              requested = 1280;
-            }
-
-            auto frame = g_audio_capture->GetSystemAudioFrame(requested);
-            result->Success(flutter::EncodableValue(frame));
+            // Default to 1280 bytes (~40ms @ 16k mono PCM16) if caller doesn't
+            // specify, or asks for a nonsensical length. Nothing past the
+            // queue's capacity can be returned, so don't allocate for it.
+            const size_t requested =
+                length <= 0 ? size_t{1280}
+                            : (std::min)(static_cast<size_t>(length), AudioCapture::kSystemAudioBufferBytes);
+
+            // Dequeue straight into a pooled buffer, move it into the reply,
+            // and reclaim it once the codec has serialized the envelope.
+            std::vector<uint8_t> frame = g_audio_frame_pool.Acquire(requested);
+            frame.resize(g_audio_capture->ReadSystemAudioFrame(frame.data(), requested));
+            flutter::EncodableValue value(std::move(frame));
+            result->Success(value);
+            g_audio_frame_pool.Release(std::move(std::get<std::vector<uint8_t>>(value)));
           } else {
             result->Success(flutter::EncodableValue(std::vector<uint8_t>()));
           }
+        } else if (call.method_name().compare("getSystemAudioGaps") == 0) {
+          // Silence runs compacted out of the system audio stream, as
+          // [{startSample, length}] on the 16kHz sample timeline.
+          flutter::EncodableList list;
+          if (g_audio_capture) {
+            for (const auto& gap : g_audio_capture->TakeSystemAudioGaps()) {
+              flutter::EncodableMap m;
+              m[flutter::EncodableValue("startSample")] =
+                  flutter::EncodableValue(static_cast<int64_t>(gap.start_sample));
+              m[flutter::EncodableValue("length")] =
+                  flutter::EncodableValue(static_cast<int64_t>(gap.length));
+              list.push_back(flutter::EncodableValue(m));
+            }
+          }
+          result->Success(flutter::EncodableValue(list));
+        } else {
+          result->NotImplemented();
+        }
+      });
+
+  // Event channel for server messages / closure of the native uplink socket.
+  uplink_event_channel_ =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          flutter_controller_->engine()->messenger(), "com.finalround/uplink_events",
+          &flutter::StandardMethodCodec::GetInstance());
+  uplink_event_channel_->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [this](const flutter::EncodableValue* arguments,
+                 std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&& events)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            uplink_event_sink_ = std::move(events);
+            return nullptr;
+          },
+          [this](const flutter::EncodableValue* arguments)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            uplink_event_sink_ = nullptr;
+            return nullptr;
+          }));
+
+  // Setup method channel for the native transcription uplink. System audio is
+  // read from the capture ring on the uplink thread; Dart only sends control
+  // messages and mic audio.
+  auto uplinkChannel =
+      std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+          flutter_controller_->engine()->messenger(), "com.finalround/uplink",
+          &flutter::StandardMethodCodec::GetInstance());
+
+  uplinkChannel->SetMethodCallHandler(
+      [this](const flutter::MethodCall<flutter::EncodableValue>& call,
+         std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>
+             result) {
+        if (call.method_name().compare("connect") == 0) {
+          const std::string* url = GetStringArg(call.arguments(), "url");
+          if (!url || url->empty()) {
+            result->Error("bad_args", "Expected {url}");
+            return;
+          }
+          if (!g_audio_uplink) {
+            PlatformTaskRunner* runner = task_runner_.get();
+            auto post = [this, runner](std::string type, std::string payload) {
+              runner->PostTask([this, type = std::move(type), payload = std::move(payload)]() {
+                if (!uplink_event_sink_) return;
+                flutter::EncodableMap map;
+                map[flutter::EncodableValue("type")] = flutter::EncodableValue(type);
+                map[flutter::EncodableValue(type == "message" ? "data" : "error")] =
+                    flutter::EncodableValue(payload);
+                uplink_event_sink_->Success(flutter::EncodableValue(map));
+              });
+            };
+            g_audio_uplink = std::make_unique<AudioUplink>(
+                []() { return std::make_unique<WinHttpTransport>(); },
+                [post](std::string message) { post("message", std::move(message)); },
+                [post](const std::string& error) { post("closed", error); });
+          }
+          // The uplink reads system audio straight from the capture instance,
+          // so create it now to give the reader a stable target.
+          if (!g_audio_capture) {
+            g_audio_capture = std::make_unique<AudioCapture>();
+            UpdateAudioLevelCallback();
+          }
+          AudioCapture* capture = g_audio_capture.get();
+          g_audio_uplink->SetSystemAudioSource(
+              [capture](uint8_t* out, size_t capacity) {
+                return capture->ReadSystemAudioFrame(out, capacity);
+              },
+              [capture]() { return capture->TakeSystemAudioGaps(); });
+          result->Success(flutter::EncodableValue(g_audio_uplink->Connect(Utf8ToWide(*url))));
+        } else if (call.method_name().compare("send") == 0) {
+          const std::string* text = GetStringArg(call.arguments(), "text");
+          if (!text) {
+            result->Error("bad_args", "Expected {text}");
+            return;
+          }
+          if (g_audio_uplink) {
+            g_audio_uplink->SendText(*text);
+          }
+          result->Success();
+        } else if (call.method_name().compare("sendAudio") == 0) {
+          const std::string* source = GetStringArg(call.arguments(), "source");
+          const std::vector<uint8_t>* bytes = nullptr;
+          if (call.arguments() && std::holds_alternative<flutter::EncodableMap>(*call.arguments())) {
+            const auto& args = std::get<flutter::EncodableMap>(*call.arguments());
+            auto it = args.find(flutter::EncodableValue("bytes"));
+            if (it != args.end() && std::holds_alternative<std::vector<uint8_t>>(it->second)) {
+              bytes = &std::get<std::vector<uint8_t>>(it->second);
+            }
+          }
+          // |source| is spliced into JSON unescaped, so keep it to [a-z_].
+          if (!source || !IsValidSourceName(*source) || !bytes) {
+            result->Error("bad_args", "Expected {source: [a-z_]+, bytes: Uint8List}");
+            return;
+          }
+          if (g_audio_uplink) {
+            g_audio_uplink->SendAudio(*source, bytes->data(), bytes->size());
+          }
+          result->Success();
+        } else if (call.method_name().compare("disconnect") == 0) {
+          if (g_audio_uplink) {
+            g_audio_uplink->Disconnect();
+          }
+          result->Success();
+        } else if (call.method_name().compare("getStats") == 0) {
+          const UplinkStats stats = g_audio_uplink ? g_audio_uplink->GetStats() : UplinkStats();
+          flutter::EncodableMap m;
+          m[flutter::EncodableValue("connected")] = flutter::EncodableValue(stats.connected);
+          m[flutter::EncodableValue("stalled")] = flutter::EncodableValue(stats.stalled);
+          m[flutter::EncodableValue("handshakeMs")] = flutter::EncodableValue(stats.handshake_ms);
+          m[flutter::EncodableValue("sendLatencyMs")] = flutter::EncodableValue(stats.send_latency_ms);
+          m[flutter::EncodableValue("queueDepth")] =
+              flutter::EncodableValue(static_cast<int64_t>(stats.queue_depth));
+          m[flutter::EncodableValue("queuedBytes")] =
+              flutter::EncodableValue(static_cast<int64_t>(stats.queued_bytes));
+          m[flutter::EncodableValue("framesSent")] =
+              flutter::EncodableValue(static_cast<int64_t>(stats.frames_sent));
+          m[flutter::EncodableValue("bytesSent")] =
+              flutter::EncodableValue(static_cast<int64_t>(stats.bytes_sent));
+          m[flutter::EncodableValue("audioBytesSent")] =
+              flutter::EncodableValue(static_cast<int64_t>(stats.audio_bytes_sent));
+          m[flutter::EncodableValue("droppedBytes")] =
+              flutter::EncodableValue(static_cast<int64_t>(stats.dropped_bytes));
+          m[flutter::EncodableValue("systemBytes")] =
+              flutter::EncodableValue(static_cast<int64_t>(stats.system_bytes_read));
+          m[flutter::EncodableValue("gapSamples")] =
+              flutter::EncodableValue(static_cast<int64_t>(stats.gap_samples));
+          result->Success(flutter::EncodableValue(m));
         } else {
           result->NotImplemented();
         }
@@ -772,7 +1875,7 @@ bool FlutterWindow::OnCreate() {
           flutter_controller_->engine()->messenger(), "com.finalround/window",
           &flutter::StandardMethodCodec::GetInstance());
 
-  windowChannel->SetMethodCallHandler(
+  auto handle_window_call =
       [this](const flutter::MethodCall<flutter::EncodableValue>& call,
          std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>
              result) {
@@ -806,56 +1909,33 @@ bool FlutterWindow::OnCreate() {
           if (!hDib) hDib = GetClipboardData(CF_DIB);
           
           if (hDib) {
-            BITMAPINFOHEADER* bi = static_cast<BITMAPINFOHEADER*>(GlobalLock(hDib));
-            if (bi) {
-              int width = bi->biWidth;
-              int height = abs(bi->biHeight);
-              int bpp = bi->biBitCount;
-              bool topDown = bi->biHeight < 0;
-
-              // Calculate the offset to pixel data
-              int paletteSize = 0;
-              if (bpp <= 8) {
-                paletteSize = (bi->biClrUsed ? bi->biClrUsed : (1 << bpp)) * sizeof(RGBQUAD);
-              } else if (bi->biCompression == BI_BITFIELDS) {
-                paletteSize = 3 * sizeof(DWORD);
-              }
-
-              BYTE* srcBits = reinterpret_cast<BYTE*>(bi) + bi->biSize + paletteSize;
-
-              // Convert to 32-bit BGRA
-              std::vector<uint8_t> bgraData(width * height * 4);
-              int srcStride = ((width * bpp + 31) / 32) * 4;
-
-              for (int y = 0; y < height; y++) {
-                int srcY = topDown ? y : (height - 1 - y);
-                BYTE* srcRow = srcBits + srcY * srcStride;
-                uint8_t* dstRow = bgraData.data() + y * width * 4;
-
-                for (int x = 0; x < width; x++) {
-                  if (bpp == 32) {
-                    dstRow[x * 4 + 0] = srcRow[x * 4 + 0]; // B
-                    dstRow[x * 4 + 1] = srcRow[x * 4 + 1]; // G
-                    dstRow[x * 4 + 2] = srcRow[x * 4 + 2]; // R
-                    dstRow[x * 4 + 3] = srcRow[x * 4 + 3]; // A
-                  } else if (bpp == 24) {
-                    dstRow[x * 4 + 0] = srcRow[x * 3 + 0]; // B
-                    dstRow[x * 4 + 1] = srcRow[x * 3 + 1]; // G
-                    dstRow[x * 4 + 2] = srcRow[x * 3 + 2]; // R
-                    dstRow[x * 4 + 3] = 255; // A
-                  }
-                }
+            const uint8_t* dib = static_cast<const uint8_t*>(GlobalLock(hDib));
+            if (dib) {
+              // Decode straight from the clipboard's memory into a pooled
+              // buffer; covers palettes, 16 bpp and BI_BITFIELDS masks too.
+              DibInfo info;
+              std::vector<uint8_t> bgra;
+              bool decoded = false;
+              if (ReadDibInfo(dib, GlobalSize(hDib), info)) {
+                g_pixel_pool.Reserve(bgra, static_cast<size_t>(info.width) * static_cast<size_t>(info.height) * 4u);
+                decoded = DecodeDib(dib, GlobalSize(hDib), info, DibPixelOrder::kBgra, bgra);
               }
-
               GlobalUnlock(hDib);
+              CloseClipboard();
+              if (!decoded) {
+                g_pixel_pool.Release(std::move(bgra));
+                result->Success(flutter::EncodableValue());
+                return;
+              }
 
               // Return BGRA bytes (Flutter will convert to PNG)
               flutter::EncodableMap map;
-              map[flutter::EncodableValue("width")] = flutter::EncodableValue(width);
-              map[flutter::EncodableValue("height")] = flutter::EncodableValue(height);
-              map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(bgraData);
-              CloseClipboard();
-              result->Success(flutter::EncodableValue(map));
+              map[flutter::EncodableValue("width")] = flutter::EncodableValue(info.width);
+              map[flutter::EncodableValue("height")] = flutter::EncodableValue(info.height);
+              map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(std::move(bgra));
+              flutter::EncodableValue value(std::move(map));
+              result->Success(value);
+              ReclaimPixels(value);
               return;
             }
           }
@@ -911,56 +1991,16 @@ bool FlutterWindow::OnCreate() {
             return;
           }
           
-          // Create DIB for clipboard (32-bit BGRA)
-          int stride = width * 4;
-          size_t dataSize = sizeof(BITMAPINFOHEADER) + (stride * height);
-          
-          HGLOBAL hMem = GlobalAlloc(GMEM_MOVEABLE, dataSize);
-          if (!hMem) {
-            result->Error("ALLOC_FAILED", "Failed to allocate memory for clipboard");
-            return;
-          }
-          
-          BYTE* pMem = static_cast<BYTE*>(GlobalLock(hMem));
-          if (!pMem) {
-            GlobalFree(hMem);
-            result->Error("LOCK_FAILED", "Failed to lock memory");
-            return;
-          }
-          
-          // Fill BITMAPINFOHEADER (negative height for top-down DIB)
-          BITMAPINFOHEADER* bih = reinterpret_cast<BITMAPINFOHEADER*>(pMem);
-          ZeroMemory(bih, sizeof(BITMAPINFOHEADER));
-          bih->biSize = sizeof(BITMAPINFOHEADER);
-          bih->biWidth = width;
-          bih->biHeight = -height; // negative = top-down
-          bih->biPlanes = 1;
-          bih->biBitCount = 32;
-          bih->biCompression = BI_RGB;
-          bih->biSizeImage = stride * height;
-          
-          // Copy BGRA data
-          BYTE* pPixels = pMem + sizeof(BITMAPINFOHEADER);
-          memcpy(pPixels, bytes.data(), bytes.size());
-          
-          GlobalUnlock(hMem);
-          
-          if (!OpenClipboard(nullptr)) {
-            GlobalFree(hMem);
-            result->Error("CLIPBOARD_ERROR", "Failed to open clipboard");
+          if (bytes.size() < static_cast<size_t>(width) * static_cast<size_t>(height) * 4u) {
+            result->Error("BAD_ARGS", "bytes is smaller than width * height * 4");
             return;
           }
-          
-          EmptyClipboard();
-          HANDLE hData = SetClipboardData(CF_DIB, hMem);
-          CloseClipboard();
-          
-          if (!hData) {
-            GlobalFree(hMem);
-            result->Error("CLIPBOARD_ERROR", "Failed to set clipboard data");
+
+          std::string code, message;
+          if (!SetClipboardBgra(bytes.data(), width, height, static_cast<size_t>(width) * 4u, code, message)) {
+            result->Error(code, message);
             return;
           }
-          
           result->Success(flutter::EncodableValue(true));
         } else if (call.method_name().compare("getVirtualScreenBounds") == 0) {
           // Return virtual screen bounds (covers all monitors)
@@ -1066,50 +2106,20 @@ bool FlutterWindow::OnCreate() {
             result->Error("NO_WINDOW", "Window handle not available");
           }
         } else if (call.method_name().compare("captureActiveWindowPixels") == 0) {
+          // Captures the window the user last had in front. Only if none has
+          // been seen yet and our app is foreground do we minimize it so the
+          // previous window comes forward; the job then waits for that on
+          // timers and we restore ourselves once the capture is done.
           HWND self = GetHandle();
-          HWND fg = GetForegroundWindow();
           bool minimized_self = false;
-
-          // If our app is foreground, minimize briefly so the real target becomes foreground.
-          if (self && (fg == self || IsChild(self, fg))) {
-            minimized_self = true;
-            ShowWindow(self, SW_MINIMIZE);
-            Sleep(120);
-            for (int i = 0; i < 10; i++) {
-              fg = GetForegroundWindow();
-              if (fg && fg != self && !IsChild(self, fg)) break;
-              Sleep(50);
-            }
-          }
-
-          if (!fg || (self && (fg == self || IsChild(self, fg)))) {
-            if (minimized_self && self) {
-              ShowWindow(self, SW_RESTORE);
-              SetForegroundWindow(self);
-            }
-            result->Error("NO_TARGET", "No active window to capture (focus another window and try again).");
-            return;
-          }
-
-          std::vector<uint8_t> bytes;
-          int w = 0, h = 0;
-          const bool ok = CaptureWindowBgra(fg, bytes, w, h);
-
-          if (minimized_self && self) {
-            ShowWindow(self, SW_RESTORE);
-            SetForegroundWindow(self);
-          }
-
-          if (!ok) {
-            result->Error("CAPTURE_FAILED", "Failed to capture active window.");
-            return;
-          }
-
-          flutter::EncodableMap map;
-          map[flutter::EncodableValue("width")] = flutter::EncodableValue(w);
-          map[flutter::EncodableValue("height")] = flutter::EncodableValue(h);
-          map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(bytes);
-          result->Success(flutter::EncodableValue(map));
+          CaptureJob job = ActiveWindowJob(
+              self,
+              [](HWND fg) { return WindowCaptureJob(fg, 0, 0, true, "Failed to capture active window."); },
+              minimized_self);
+          if (minimized_self) ShowWindow(self, SW_MINIMIZE);
+          SubmitCapture(std::move(result), GetRequestId(call.arguments()), std::string(), std::move(job),
+                        minimized_self ? kSelfMinimizeDelay : std::chrono::milliseconds(0),
+                        RestoreSelfCallback(self, minimized_self));
         } else if (call.method_name().compare("listShareableWindows") == 0) {
           HWND self = GetHandle();
           flutter::EncodableList list;
@@ -1172,18 +2182,8 @@ bool FlutterWindow::OnCreate() {
             return;
           }
 
-          std::vector<uint8_t> bytes;
-          int w = 0, h = 0;
-          const bool ok = CaptureWindowBgra(target, bytes, w, h);
-          if (!ok) {
-            result->Error("CAPTURE_FAILED", "Failed to capture window.");
-            return;
-          }
-          flutter::EncodableMap map;
-          map[flutter::EncodableValue("width")] = flutter::EncodableValue(w);
-          map[flutter::EncodableValue("height")] = flutter::EncodableValue(h);
-          map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(bytes);
-          result->Success(flutter::EncodableValue(map));
+          SubmitCapture(std::move(result), GetRequestId(call.arguments()), std::string(),
+                        WindowCaptureJob(target, 0, 0, true, "Failed to capture window."));
         } else if (call.method_name().compare("captureWindowThumbnailPixels") == 0) {
           int64_t hwnd_val = 0;
           int max_w = 320;
@@ -1236,49 +2236,30 @@ bool FlutterWindow::OnCreate() {
           int tw = 0, th = 0;
           ScaleToFit(src_w, src_h, max_w, max_h, tw, th);
 
-          std::vector<uint8_t> bytes;
-          int w = 0, h = 0;
-          const bool ok = CaptureWindowBgraScaled(target, tw, th, allow_restore, bytes, w, h);
-          if (!ok) {
-            result->Error("CAPTURE_FAILED", "Failed to capture window thumbnail.");
-            return;
-          }
-          flutter::EncodableMap map;
-          map[flutter::EncodableValue("width")] = flutter::EncodableValue(w);
-          map[flutter::EncodableValue("height")] = flutter::EncodableValue(h);
-          map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(bytes);
-          result->Success(flutter::EncodableValue(map));
+          // Pickers re-request tiles while earlier requests are in flight;
+          // identical requests share one capture.
+          const std::string key = "window-thumb:" + std::to_string(hwnd_val) + ":" + std::to_string(tw) + "x" +
+                                  std::to_string(th) + (allow_restore ? ":restore" : "");
+          SubmitCapture(std::move(result), GetRequestId(call.arguments()), key,
+                        WindowCaptureJob(target, tw, th, allow_restore, "Failed to capture window thumbnail."));
         } else if (call.method_name().compare("captureScreenPixels") == 0) {
-          HWND self = GetHandle();
-          bool minimized_self = false;
-
           // If our app is foreground, minimize briefly so it doesn't appear in the capture.
-          HWND fg = GetForegroundWindow();
-          if (self && (fg == self || IsChild(self, fg))) {
-            minimized_self = true;
-            ShowWindow(self, SW_MINIMIZE);
-            Sleep(120);
-          }
-
-          std::vector<uint8_t> bytes;
-          int w = 0, h = 0;
-          const bool ok = CaptureScreenBgra(bytes, w, h);
-
-          if (minimized_self && self) {
-            ShowWindow(self, SW_RESTORE);
-            SetForegroundWindow(self);
-          }
-
-          if (!ok) {
-            result->Error("CAPTURE_FAILED", "Failed to capture screen.");
-            return;
-          }
-
-          flutter::EncodableMap map;
-          map[flutter::EncodableValue("width")] = flutter::EncodableValue(w);
-          map[flutter::EncodableValue("height")] = flutter::EncodableValue(h);
-          map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(bytes);
-          result->Success(flutter::EncodableValue(map));
+          HWND self = GetHandle();
+          const bool minimized_self = IsSelfForeground(self);
+          if (minimized_self) ShowWindow(self, SW_MINIMIZE);
+          SubmitCapture(
+              std::move(result), GetRequestId(call.arguments()), std::string(),
+              SingleStepJob([](CaptureOutcome& outcome) {
+                std::vector<uint8_t> bytes;
+                int w = 0, h = 0;
+                if (CaptureScreenBgra(bytes, w, h)) {
+                  SetPixelsOutcome(outcome, w, h, std::move(bytes));
+                } else {
+                  SetErrorOutcome(outcome, "CAPTURE_FAILED", "Failed to capture screen.");
+                }
+              }),
+              minimized_self ? kSelfMinimizeDelay : std::chrono::milliseconds(0),
+              RestoreSelfCallback(self, minimized_self));
         } else if (call.method_name().compare("captureScreenThumbnailPixels") == 0) {
           int max_w = 320;
           int max_h = 200;
@@ -1305,18 +2286,9 @@ bool FlutterWindow::OnCreate() {
             return;
           }
 
-          std::vector<uint8_t> bytes;
-          int w = 0, h = 0;
-          const bool ok = CaptureRectBgraScaled(x, y, sw, sh, max_w, max_h, bytes, w, h);
-          if (!ok) {
-            result->Error("CAPTURE_FAILED", "Failed to capture screen thumbnail.");
-            return;
-          }
-          flutter::EncodableMap map;
-          map[flutter::EncodableValue("width")] = flutter::EncodableValue(w);
-          map[flutter::EncodableValue("height")] = flutter::EncodableValue(h);
-          map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(bytes);
-          result->Success(flutter::EncodableValue(map));
+          const std::string key = "screen-thumb:" + std::to_string(max_w) + "x" + std::to_string(max_h);
+          SubmitCapture(std::move(result), GetRequestId(call.arguments()), key,
+                        RectThumbnailJob(x, y, sw, sh, max_w, max_h, "Failed to capture screen thumbnail."));
         } else if (call.method_name().compare("listMonitors") == 0) {
           flutter::EncodableList list;
           struct MonCtx {
@@ -1353,6 +2325,34 @@ bool FlutterWindow::OnCreate() {
               },
               reinterpret_cast<LPARAM>(&ctx));
           result->Success(flutter::EncodableValue(list));
+        } else if (call.method_name().compare("captureMonitorsForUpload") == 0) {
+          // {monitorIds?, layout: composite|separate, format/maxDimension/
+          // maxBytes/quality}: every monitor (or those listed) captured in
+          // parallel instead of one virtual-screen BitBlt. "composite"
+          // replies like captureForUpload plus monitors[{monitorId, x, y,
+          // sourceWidth, sourceHeight, tileX, tileY, tileWidth, tileHeight}];
+          // "separate" replies images[] with one encode per monitor.
+          flutter::EncodableMap args;
+          if (call.arguments() && std::holds_alternative<flutter::EncodableMap>(*call.arguments())) {
+            args = std::get<flutter::EncodableMap>(*call.arguments());
+          }
+          std::vector<int64_t> ids;
+          auto ids_it = args.find(flutter::EncodableValue("monitorIds"));
+          if (ids_it != args.end() && std::holds_alternative<flutter::EncodableList>(ids_it->second)) {
+            for (const auto& v : std::get<flutter::EncodableList>(ids_it->second)) {
+              if (std::holds_alternative<int64_t>(v)) ids.push_back(std::get<int64_t>(v));
+              else if (std::holds_alternative<int32_t>(v)) ids.push_back(std::get<int32_t>(v));
+            }
+          }
+          const std::string* layout = GetStringArg(call.arguments(), "layout");
+          const bool separate = layout && *layout == "separate";
+          std::vector<MonitorTarget> monitors = ResolveMonitors(ids);
+          if (monitors.empty()) {
+            result->Error("NO_MONITOR", "Monitor not found");
+            return;
+          }
+          SubmitCapture(std::move(result), GetRequestId(call.arguments()), std::string(),
+                        MonitorsUploadJob(std::move(monitors), ParseUploadOptions(args), separate));
         } else if (call.method_name().compare("captureRectPixels") == 0) {
           // Capture a specific rectangle of the screen (for region selection)
           int x = 0, y = 0, sw = 0, sh = 0;
@@ -1383,18 +2383,161 @@ bool FlutterWindow::OnCreate() {
             result->Error("BAD_ARGS", "Invalid or missing width/height");
             return;
           }
-          std::vector<uint8_t> bytes;
-          int w = 0, h = 0;
-          const bool ok = CaptureRectBgra(x, y, sw, sh, bytes, w, h);
-          if (!ok) {
-            result->Error("CAPTURE_FAILED", "Failed to capture screen region.");
+          SubmitCapture(std::move(result), GetRequestId(call.arguments()), std::string(),
+                        RectCaptureJob(x, y, sw, sh, "Failed to capture screen region."));
+        } else if (call.method_name().compare("createScreenSnapshot") == 0) {
+          // {x?, y?, width?, height?, previewMaxWidth?, previewMaxHeight?,
+          // includePixels?}: one capture (default: the whole virtual screen)
+          // kept under a snapshotId until releaseScreenSnapshot. Replies
+          // {snapshotId, x, y, width, height} plus, when asked for, a preview
+          // {previewWidth, previewHeight, bytes} scaled from the same pixels.
+          flutter::EncodableMap args;
+          if (call.arguments() && std::holds_alternative<flutter::EncodableMap>(*call.arguments())) {
+            args = std::get<flutter::EncodableMap>(*call.arguments());
+          }
+          int64_t x = GetSystemMetrics(SM_XVIRTUALSCREEN), y = GetSystemMetrics(SM_YVIRTUALSCREEN);
+          int64_t w = GetSystemMetrics(SM_CXVIRTUALSCREEN), h = GetSystemMetrics(SM_CYVIRTUALSCREEN);
+          GetInt64Arg(args, "x", x);
+          GetInt64Arg(args, "y", y);
+          GetInt64Arg(args, "width", w);
+          GetInt64Arg(args, "height", h);
+          if (w <= 0 || h <= 0) {
+            result->Error("BAD_ARGS", "Invalid or missing width/height");
             return;
           }
-          flutter::EncodableMap map;
-          map[flutter::EncodableValue("width")] = flutter::EncodableValue(w);
-          map[flutter::EncodableValue("height")] = flutter::EncodableValue(h);
-          map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(bytes);
-          result->Success(flutter::EncodableValue(map));
+          int64_t preview_w = 0, preview_h = 0;
+          bool include_pixels = false;
+          GetInt64Arg(args, "previewMaxWidth", preview_w);
+          GetInt64Arg(args, "previewMaxHeight", preview_h);
+          GetBoolArg(args, "includePixels", include_pixels);
+          const bool preview = include_pixels || preview_w > 0 || preview_h > 0;
+
+          const int64_t id = next_snapshot_id_++;
+          auto captured = std::make_shared<std::shared_ptr<const ScreenSnapshot>>();
+          CaptureJob job = SingleStepJob([x, y, w, h, preview, preview_w, preview_h, id, captured](CaptureOutcome& outcome) {
+            std::vector<uint8_t> bytes;
+            int out_w = 0, out_h = 0;
+            if (!CaptureRectBgra(static_cast<int>(x), static_cast<int>(y), static_cast<int>(w), static_cast<int>(h),
+                                 bytes, out_w, out_h)) {
+              SetErrorOutcome(outcome, "CAPTURE_FAILED", "Failed to capture screen.");
+              return;
+            }
+            auto snapshot = std::make_shared<const ScreenSnapshot>(static_cast<int>(x), static_cast<int>(y), out_w,
+                                                                   out_h, std::move(bytes));
+            flutter::EncodableMap map;
+            map[flutter::EncodableValue("snapshotId")] = flutter::EncodableValue(id);
+            map[flutter::EncodableValue("x")] = flutter::EncodableValue(snapshot->left());
+            map[flutter::EncodableValue("y")] = flutter::EncodableValue(snapshot->top());
+            map[flutter::EncodableValue("width")] = flutter::EncodableValue(snapshot->width());
+            map[flutter::EncodableValue("height")] = flutter::EncodableValue(snapshot->height());
+            SnapshotRect all;
+            if (preview && snapshot->Clip(snapshot->left(), snapshot->top(), snapshot->width(), snapshot->height(), all)) {
+              std::vector<uint8_t> pixels;
+              int pw = 0, ph = 0;
+              FitWithin(all.width, all.height, static_cast<int>(preview_w), static_cast<int>(preview_h), pw, ph);
+              g_pixel_pool.Reserve(pixels, static_cast<size_t>(pw) * static_cast<size_t>(ph) * 4u);
+              if (snapshot->Crop(all, pw, ph, pixels, pw, ph)) {
+                map[flutter::EncodableValue("previewWidth")] = flutter::EncodableValue(pw);
+                map[flutter::EncodableValue("previewHeight")] = flutter::EncodableValue(ph);
+                map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(std::move(pixels));
+              }
+            }
+            *captured = std::move(snapshot);
+            outcome.ok = true;
+            outcome.value = flutter::EncodableValue(std::move(map));
+          });
+          SubmitCapture(std::move(result), GetRequestId(call.arguments()), std::string(), std::move(job),
+                        std::chrono::milliseconds(0), [this, id, captured]() {
+                          if (!*captured) return;
+                          snapshots_[id] = *captured;
+                          // Oldest first (ids only grow).
+                          while (snapshots_.size() > kMaxScreenSnapshots) snapshots_.erase(snapshots_.begin());
+                        });
+        } else if (call.method_name().compare("getScreenSnapshotPixels") == 0 ||
+                   call.method_name().compare("encodeScreenSnapshot") == 0 ||
+                   call.method_name().compare("copyScreenSnapshotToClipboard") == 0) {
+          // {snapshotId, x?, y?, width?, height?} in screen coordinates
+          // (default: the whole snapshot), clipped to the snapshot.
+          //   getScreenSnapshotPixels (+maxWidth/maxHeight): {width, height,
+          //     bytes, sourceX, sourceY, sourceWidth, sourceHeight}.
+          //   encodeScreenSnapshot (+captureForUpload's format options): as
+          //     captureForUpload, plus bytes.
+          //   copyScreenSnapshotToClipboard: CF_DIB of the crop; true.
+          if (!call.arguments() || !std::holds_alternative<flutter::EncodableMap>(*call.arguments())) {
+            result->Error("BAD_ARGS", "Expected a map");
+            return;
+          }
+          const auto& args = std::get<flutter::EncodableMap>(*call.arguments());
+          int64_t id = 0;
+          GetInt64Arg(args, "snapshotId", id);
+          auto it = snapshots_.find(id);
+          if (it == snapshots_.end()) {
+            result->Error("NO_SNAPSHOT", "Snapshot not found or already released");
+            return;
+          }
+          std::shared_ptr<const ScreenSnapshot> snapshot = it->second;
+          SnapshotRect rect;
+          if (!SnapshotRectArg(args, *snapshot, rect)) {
+            result->Error("BAD_ARGS", "Rectangle is outside the snapshot");
+            return;
+          }
+
+          if (call.method_name().compare("copyScreenSnapshotToClipboard") == 0) {
+            // One crop copied straight into clipboard memory; no worker hop.
+            std::string code, message;
+            if (!SetClipboardBgra(snapshot->At(rect), rect.width, rect.height, snapshot->stride(), code, message)) {
+              result->Error(code, message);
+              return;
+            }
+            result->Success(flutter::EncodableValue(true));
+          } else if (call.method_name().compare("encodeScreenSnapshot") == 0) {
+            const UploadEncodeOptions options = ParseUploadOptions(args);
+            SubmitCapture(std::move(result), GetRequestId(call.arguments()), std::string(),
+                          SingleStepJob([snapshot, rect, options](CaptureOutcome& outcome) {
+                            auto encoded = std::make_shared<EncodedUpload>();
+                            if (!snapshot->Encode(rect, options, *encoded)) {
+                              SetErrorOutcome(outcome, "ENCODE_FAILED", "Failed to encode snapshot.");
+                              return;
+                            }
+                            flutter::EncodableMap map = UploadValue(*encoded, rect.width, rect.height);
+                            map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(std::move(encoded->bytes));
+                            outcome.ok = true;
+                            outcome.value = flutter::EncodableValue(std::move(map));
+                          }));
+          } else {
+            int64_t max_w = 0, max_h = 0;
+            GetInt64Arg(args, "maxWidth", max_w);
+            GetInt64Arg(args, "maxHeight", max_h);
+            SubmitCapture(std::move(result), GetRequestId(call.arguments()), std::string(),
+                          SingleStepJob([snapshot, rect, max_w, max_h](CaptureOutcome& outcome) {
+                            std::vector<uint8_t> pixels;
+                            int w = 0, h = 0;
+                            FitWithin(rect.width, rect.height, static_cast<int>(max_w), static_cast<int>(max_h), w, h);
+                            g_pixel_pool.Reserve(pixels, static_cast<size_t>(w) * static_cast<size_t>(h) * 4u);
+                            if (!snapshot->Crop(rect, w, h, pixels, w, h)) {
+                              SetErrorOutcome(outcome, "CAPTURE_FAILED", "Failed to crop snapshot.");
+                              return;
+                            }
+                            SetPixelsOutcome(outcome, w, h, std::move(pixels));
+                            auto& map = std::get<flutter::EncodableMap>(outcome.value);
+                            map[flutter::EncodableValue("sourceX")] = flutter::EncodableValue(snapshot->left() + rect.x);
+                            map[flutter::EncodableValue("sourceY")] = flutter::EncodableValue(snapshot->top() + rect.y);
+                            map[flutter::EncodableValue("sourceWidth")] = flutter::EncodableValue(rect.width);
+                            map[flutter::EncodableValue("sourceHeight")] = flutter::EncodableValue(rect.height);
+                          }));
+          }
+        } else if (call.method_name().compare("releaseScreenSnapshot") == 0) {
+          // {snapshotId?}; every snapshot when omitted. Replies the count.
+          int64_t id = 0;
+          int released = 0;
+          if (call.arguments() && std::holds_alternative<flutter::EncodableMap>(*call.arguments()) &&
+              GetInt64Arg(std::get<flutter::EncodableMap>(*call.arguments()), "snapshotId", id)) {
+            released = static_cast<int>(snapshots_.erase(id));
+          } else {
+            released = static_cast<int>(snapshots_.size());
+            snapshots_.clear();
+          }
+          result->Success(flutter::EncodableValue(released));
         } else if (call.method_name().compare("captureMonitorPixels") == 0) {
           int64_t id = 0;
           if (call.arguments() && std::holds_alternative<flutter::EncodableMap>(*call.arguments())) {
@@ -1419,18 +2562,439 @@ bool FlutterWindow::OnCreate() {
           const RECT r = mi.rcMonitor;
           const int sw = r.right - r.left;
           const int sh = r.bottom - r.top;
-          std::vector<uint8_t> bytes;
-          int w = 0, h = 0;
-          const bool ok = CaptureRectBgra(r.left, r.top, sw, sh, bytes, w, h);
-          if (!ok) {
-            result->Error("CAPTURE_FAILED", "Failed to capture monitor.");
+          SubmitCapture(std::move(result), GetRequestId(call.arguments()), std::string(),
+                        RectCaptureJob(r.left, r.top, sw, sh, "Failed to capture monitor."));
+        } else if (call.method_name().compare("captureForUpload") == 0 ||
+                   call.method_name().compare("recognizeText") == 0) {
+          // Capture + downscale + encode for AI uploads. Only the compressed
+          // image crosses the channel; capture and encoding both run on
+          // |capture_executor_|. recognizeText takes the same targets and
+          // replies with on-device OCR of the capture instead (see
+          // RecognizeTextOutcome); the upload options don't apply to it.
+          if (!call.arguments() || !std::holds_alternative<flutter::EncodableMap>(*call.arguments())) {
+            result->Error("BAD_ARGS", "Expected a map");
+            return;
+          }
+          const auto& args = std::get<flutter::EncodableMap>(*call.arguments());
+          const std::string* target = GetStringArg(call.arguments(), "target");
+          const std::string request_id = GetRequestId(call.arguments());
+          const UploadEncodeOptions options = ParseUploadOptions(args);
+          const bool ocr = call.method_name().compare("recognizeText") == 0;
+          int64_t v = 0;
+
+          // Frames are diffed per target (64x64 tile hashes) unless
+          // dedupe is false; |diffKey| overrides the derived target key.
+          bool dedupe = true, crops_only = false;
+          GetBoolArg(args, "dedupe", dedupe);
+          GetBoolArg(args, "cropsOnly", crops_only);
+          const std::string kind = target ? *target : std::string("active");
+          std::string diff_key = kind;
+          if (const std::string* key = GetStringArg(call.arguments(), "diffKey")) {
+            diff_key = *key;
+          } else {
+            for (const char* name : {"monitorId", "hwnd", "x", "y", "width", "height"}) {
+              if (GetInt64Arg(args, name, v)) diff_key += ":" + std::to_string(v);
+            }
+          }
+          std::shared_ptr<UploadHistory> history = dedupe && !ocr ? g_upload_histories.Get(diff_key) : nullptr;
+
+          // perceptualDedupe: true answers a frame within similarityThreshold
+          // bits (default 4 of 64) of a recent upload of this target with
+          // {sameAs, imageId, distance, change: "similar"} and no bytes;
+          // other full-frame replies carry a new imageId. knownImageIds
+          // limits matches to images the caller still has.
+          SimilarImageOptions similar;
+          GetBoolArg(args, "perceptualDedupe", similar.enabled);
+          similar.key = diff_key;
+          if (GetInt64Arg(args, "similarityThreshold", v)) {
+            similar.threshold = static_cast<int>((std::min)((std::max)(v, int64_t{0}), int64_t{64}));
+          }
+          auto known_it = args.find(flutter::EncodableValue("knownImageIds"));
+          if (known_it != args.end() && std::holds_alternative<flutter::EncodableList>(known_it->second)) {
+            similar.known_ids.emplace();
+            for (const auto& id : std::get<flutter::EncodableList>(known_it->second)) {
+              if (std::holds_alternative<int64_t>(id)) similar.known_ids->push_back(static_cast<uint64_t>(std::get<int64_t>(id)));
+              else if (std::holds_alternative<int32_t>(id)) similar.known_ids->push_back(static_cast<uint64_t>(std::get<int32_t>(id)));
+            }
+          }
+
+          // smartCrop: true crops a frame that would be downscaled to its
+          // text and detail first (see SmartCropForUpload); the reply then
+          // has crop {x, y, width, height} and frameWidth/frameHeight, and
+          // sourceWidth/sourceHeight describe the crop.
+          bool smart_crop = false;
+          GetBoolArg(args, "smartCrop", smart_crop);
+
+          PixelsHandler encode = [options, history, crops_only, similar, smart_crop](
+                                     CaptureOutcome& outcome, int w, int h, std::vector<uint8_t>&& pixels) {
+            CropRect crop;
+            const bool cropped = smart_crop && SmartCropForUpload(options, w, h, pixels, crop);
+            EncodeSimilarUploadOutcome(outcome, options, history, crops_only, similar, cropped ? crop.width : w,
+                                       cropped ? crop.height : h, pixels);
+            g_pixel_pool.Release(std::move(pixels));
+            if (!cropped || !outcome.ok || !std::holds_alternative<flutter::EncodableMap>(outcome.value)) return;
+            auto& map = std::get<flutter::EncodableMap>(outcome.value);
+            map[flutter::EncodableValue("crop")] =
+                RectValue(DirtyRect{crop.x, crop.y, crop.width, crop.height});
+            map[flutter::EncodableValue("frameWidth")] = flutter::EncodableValue(w);
+            map[flutter::EncodableValue("frameHeight")] = flutter::EncodableValue(h);
+          };
+          if (ocr) {
+            encode = [](CaptureOutcome& outcome, int w, int h, std::vector<uint8_t>&& pixels) {
+              RecognizeTextOutcome(outcome, w, h, pixels);
+              g_pixel_pool.Release(std::move(pixels));
+            };
+          }
+
+          const std::string failure = "Failed to capture " + kind + ".";
+          RECT rect{};
+          if (kind == "rect" || kind == "monitor") {
+            std::string code, message;
+            if (!ParseTargetRect(args, kind, rect, code, message)) {
+              result->Error(code, message);
+              return;
+            }
+          } else if (kind == "window") {
+            HWND self = GetHandle();
+            int64_t hwnd_val = 0;
+            GetInt64Arg(args, "hwnd", hwnd_val);
+            HWND target_hwnd = reinterpret_cast<HWND>(static_cast<intptr_t>(hwnd_val));
+            if (hwnd_val == 0 || !IsWindow(target_hwnd)) {
+              result->Error("NO_WINDOW", "Window no longer exists");
+              return;
+            }
+            if (self && (target_hwnd == self || IsChild(self, target_hwnd))) {
+              result->Error("BAD_TARGET", "Cannot capture this app window");
+              return;
+            }
+            SubmitCapture(std::move(result), request_id, std::string(),
+                          WindowCaptureJob(target_hwnd, 0, 0, true, failure, encode));
+            return;
+          } else {
+            HWND self = GetHandle();
+            bool minimized_self = false;
+            CaptureJob job = ActiveWindowJob(
+                self,
+                [failure, encode](HWND fg) { return WindowCaptureJob(fg, 0, 0, true, failure, encode); },
+                minimized_self);
+            if (minimized_self) ShowWindow(self, SW_MINIMIZE);
+            SubmitCapture(std::move(result), request_id, std::string(), std::move(job),
+                          minimized_self ? kSelfMinimizeDelay : std::chrono::milliseconds(0),
+                          RestoreSelfCallback(self, minimized_self));
+            return;
+          }
+
+          SubmitCapture(std::move(result), request_id, std::string(),
+                        SingleStepJob([rect, failure, encode](CaptureOutcome& outcome) {
+                          std::vector<uint8_t> bytes;
+                          int w = 0, h = 0;
+                          if (CaptureRectBgra(rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top,
+                                              bytes, w, h)) {
+                            encode(outcome, w, h, std::move(bytes));
+                          } else {
+                            SetErrorOutcome(outcome, "CAPTURE_FAILED", failure);
+                          }
+                        }));
+        } else if (call.method_name().compare("startScreenStream") == 0) {
+          // Captures a monitor, window or region at |fps| on
+          // |stream_executor_|, keeping the latest changed frame encoded
+          // for getScreenStreamFrame. Changes are announced on
+          // com.finalround/screen_stream; unchanged frames are dropped.
+          if (!call.arguments() || !std::holds_alternative<flutter::EncodableMap>(*call.arguments())) {
+            result->Error("BAD_ARGS", "Expected a map");
+            return;
+          }
+          const auto& args = std::get<flutter::EncodableMap>(*call.arguments());
+          const std::string* target = GetStringArg(call.arguments(), "target");
+          const std::string kind = target ? *target : std::string("monitor");
+          const std::string failure = "Failed to capture " + kind + ".";
+          double fps = 2.0;
+          auto fps_it = args.find(flutter::EncodableValue("fps"));
+          if (fps_it != args.end() && std::holds_alternative<double>(fps_it->second)) {
+            fps = std::get<double>(fps_it->second);
+          } else {
+            int64_t fps_int = 0;
+            if (GetInt64Arg(args, "fps", fps_int)) fps = static_cast<double>(fps_int);
+          }
+          // Streams encode every changed frame; favour speed unless asked.
+          auto stream = std::make_shared<ScreenStream>(fps, ParseUploadOptions(args, PngPreset::kFast));
+          const PixelsHandler deliver = StreamFrameHandler(stream);
+
+          std::function<CaptureJob()> make_frame;
+          HWND target_hwnd = nullptr;
+          if (kind == "window") {
+            HWND self = GetHandle();
+            int64_t hwnd_val = 0;
+            GetInt64Arg(args, "hwnd", hwnd_val);
+            target_hwnd = reinterpret_cast<HWND>(static_cast<intptr_t>(hwnd_val));
+            if (hwnd_val == 0 || !IsWindow(target_hwnd)) {
+              result->Error("NO_WINDOW", "Window no longer exists");
+              return;
+            }
+            if (self && (target_hwnd == self || IsChild(self, target_hwnd))) {
+              result->Error("BAD_TARGET", "Cannot capture this app window");
+              return;
+            }
+            // Never restore a minimized window behind the user's back; DWM's
+            // iconic bitmap is used instead.
+            make_frame = [target_hwnd, failure, deliver]() {
+              return WindowCaptureJob(target_hwnd, 0, 0, false, failure, deliver);
+            };
+          } else if (kind == "rect" || kind == "monitor") {
+            RECT rect{};
+            std::string code, message;
+            if (!ParseTargetRect(args, kind, rect, code, message)) {
+              result->Error(code, message);
+              return;
+            }
+            make_frame = [rect, failure, deliver]() {
+              return SingleStepJob([rect, failure, deliver](CaptureOutcome& outcome) {
+                std::vector<uint8_t> bytes;
+                int w = 0, h = 0;
+                if (CaptureRectBgra(rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top, bytes, w,
+                                    h)) {
+                  deliver(outcome, w, h, std::move(bytes));
+                } else {
+                  SetErrorOutcome(outcome, "CAPTURE_FAILED", failure);
+                }
+              });
+            };
+          } else {
+            result->Error("BAD_ARGS", "target must be monitor, window or rect");
+            return;
+          }
+
+          const int64_t stream_id = next_stream_id_++;
+          PlatformTaskRunner* runner = task_runner_.get();
+          // Errors are reported when they start, not on every failed frame;
+          // a closed target window ends the stream.
+          auto failing = std::make_shared<bool>(false);
+          auto on_frame = [this, runner, stream, stream_id, target_hwnd, failing](const CaptureOutcome& outcome) {
+            flutter::EncodableMap event;
+            bool ended = false;
+            if (outcome.ok) {
+              *failing = false;
+              if (!std::holds_alternative<flutter::EncodableMap>(outcome.value)) return true;
+              event = std::get<flutter::EncodableMap>(outcome.value);
+              // Notifications only; the bytes stay native until asked for.
+              event.erase(flutter::EncodableValue("bytes"));
+            } else {
+              stream->OfferFailed();
+              ended = target_hwnd && !IsWindow(target_hwnd);
+              if (*failing && !ended) return true;
+              *failing = true;
+              event[flutter::EncodableValue("error")] = flutter::EncodableValue(outcome.error_message);
+              if (ended) event[flutter::EncodableValue("ended")] = flutter::EncodableValue(true);
+            }
+            event[flutter::EncodableValue("streamId")] = flutter::EncodableValue(stream_id);
+            runner->PostTask([this, stream_id, event = std::move(event), ended]() {
+              auto it = streams_.find(stream_id);
+              if (it == streams_.end()) return;  // Stopped.
+              if (ended) streams_.erase(it);
+              EmitStreamEvent(event);
+            });
+            return !ended;
+          };
+          const CaptureExecutor::JobId job_id =
+              stream_executor_->Submit(ScreenStreamJob(std::move(make_frame), stream, std::move(on_frame)));
+          if (job_id == 0) {
+            result->Error("CANCELLED", "Capture was cancelled.");
             return;
           }
+          streams_[stream_id] = ActiveStream{stream, job_id};
+          flutter::EncodableMap reply;
+          reply[flutter::EncodableValue("streamId")] = flutter::EncodableValue(stream_id);
+          reply[flutter::EncodableValue("fps")] = flutter::EncodableValue(stream->fps());
+          result->Success(flutter::EncodableValue(std::move(reply)));
+        } else if (call.method_name().compare("stopScreenStream") == 0) {
+          // {streamId}; without one, stops every stream.
+          int64_t stream_id = 0;
+          if (call.arguments() && std::holds_alternative<flutter::EncodableMap>(*call.arguments())) {
+            GetInt64Arg(std::get<flutter::EncodableMap>(*call.arguments()), "streamId", stream_id);
+          }
+          result->Success(flutter::EncodableValue(StopScreenStreams(stream_id)));
+        } else if (call.method_name().compare("getScreenStreamFrame") == 0) {
+          // Latest encoded frame of a stream (null until the first one).
+          int64_t stream_id = 0;
+          if (call.arguments() && std::holds_alternative<flutter::EncodableMap>(*call.arguments())) {
+            GetInt64Arg(std::get<flutter::EncodableMap>(*call.arguments()), "streamId", stream_id);
+          }
+          auto it = streams_.find(stream_id);
+          if (it == streams_.end()) {
+            result->Error("NO_STREAM", "Stream not found");
+            return;
+          }
+          const StreamFrame frame = it->second.stream->Latest();
+          if (!frame.upload) {
+            result->Success();
+            return;
+          }
+          const ScreenStream::Stats stats = it->second.stream->GetStats();
+          flutter::EncodableMap map = UploadValue(*frame.upload, frame.source_width, frame.source_height);
+          map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(frame.upload->bytes);
+          map[flutter::EncodableValue("streamId")] = flutter::EncodableValue(stream_id);
+          map[flutter::EncodableValue("sequence")] = flutter::EncodableValue(static_cast<int64_t>(frame.sequence));
+          // ageMs: since a capture last confirmed the frame is current.
+          const ScreenStream::Clock::time_point now = ScreenStream::Clock::now();
+          map[flutter::EncodableValue("ageMs")] = flutter::EncodableValue(static_cast<int64_t>(
+              std::chrono::duration_cast<std::chrono::milliseconds>(now - frame.checked_at).count()));
+          map[flutter::EncodableValue("changedAgoMs")] = flutter::EncodableValue(static_cast<int64_t>(
+              std::chrono::duration_cast<std::chrono::milliseconds>(now - frame.captured_at).count()));
+          map[flutter::EncodableValue("framesCaptured")] = flutter::EncodableValue(static_cast<int64_t>(stats.captured));
+          map[flutter::EncodableValue("framesUnchanged")] =
+              flutter::EncodableValue(static_cast<int64_t>(stats.unchanged));
+          result->Success(flutter::EncodableValue(std::move(map)));
+        } else if (call.method_name().compare("captureThumbnails") == 0) {
+          // Captures every target on |thumbnail_executor_| and streams tiles
+          // over com.finalround/thumbnails as they finish; replies at once.
+          if (!call.arguments() || !std::holds_alternative<flutter::EncodableMap>(*call.arguments())) {
+            result->Error("BAD_ARGS", "Expected a map");
+            return;
+          }
+          const auto& args = std::get<flutter::EncodableMap>(*call.arguments());
+          auto targets_it = args.find(flutter::EncodableValue("targets"));
+          if (targets_it == args.end() || !std::holds_alternative<flutter::EncodableList>(targets_it->second)) {
+            result->Error("BAD_ARGS", "Missing targets");
+            return;
+          }
+          int64_t max_w = 320, max_h = 200, batch_id = 0, max_age_ms = 2000;
+          GetInt64Arg(args, "maxWidth", max_w);
+          GetInt64Arg(args, "maxHeight", max_h);
+          GetInt64Arg(args, "maxAgeMs", max_age_ms);
+          bool use_cache = true, use_textures = false;
+          auto cache_it = args.find(flutter::EncodableValue("useCache"));
+          if (cache_it != args.end() && std::holds_alternative<bool>(cache_it->second)) {
+            use_cache = std::get<bool>(cache_it->second);
+          }
+          // Tiles go to one external texture per target instead of carrying
+          // their pixels; see CaptureTextureFor.
+          GetBoolArg(args, "useTextures", use_textures);
+          const std::string size_key = std::to_string(max_w) + "x" + std::to_string(max_h);
+          if (!GetInt64Arg(args, "batchId", batch_id) || batch_id <= 0 ||
+              thumbnail_batches_.count(batch_id) != 0) {
+            batch_id = next_thumbnail_batch_id_;
+          }
+          next_thumbnail_batch_id_ = (std::max)(next_thumbnail_batch_id_, batch_id + 1);
+
+          ThumbnailBatch& batch = thumbnail_batches_[batch_id];
+          batch.request_id = GetRequestId(call.arguments());
+          HWND self = GetHandle();
+          int count = 0;
+          for (const auto& entry : std::get<flutter::EncodableList>(targets_it->second)) {
+            if (!std::holds_alternative<flutter::EncodableMap>(entry)) continue;
+            const auto& target = std::get<flutter::EncodableMap>(entry);
+            const std::string* type = GetStringArg(&entry, "type");
+            int64_t id = 0;
+            GetInt64Arg(target, "id", id);
+            if (!type || id == 0) continue;
+            count++;
+
+            ThumbnailTileRequest tile;
+            tile.type = *type;
+            tile.id = id;
+            CaptureJob job;
+            std::string error;
+            if (*type == "window") {
+              HWND hwnd = reinterpret_cast<HWND>(static_cast<intptr_t>(id));
+              RECT rc{};
+              if (!IsWindow(hwnd) || (self && (hwnd == self || IsChild(self, hwnd)))) {
+                error = "NO_WINDOW";
+              } else if (!GetWindowRect(hwnd, &rc)) {
+                error = "CAPTURE_FAILED";
+              } else {
+                int tw = 0, th = 0;
+                ScaleToFit(rc.right - rc.left, rc.bottom - rc.top, static_cast<int>(max_w),
+                           static_cast<int>(max_h), tw, th);
+                // Never pop minimized windows for a grid of tiles.
+                job = WindowCaptureJob(hwnd, tw, th, false, "Failed to capture window thumbnail.");
+                tile.generation = WindowGeneration(hwnd, rc);
+              }
+            } else if (*type == "monitor") {
+              MONITORINFO mi{};
+              mi.cbSize = sizeof(mi);
+              if (!GetMonitorInfoW(reinterpret_cast<HMONITOR>(static_cast<intptr_t>(id)), &mi)) {
+                error = "NO_MONITOR";
+              } else {
+                const RECT r = mi.rcMonitor;
+                job = RectThumbnailJob(r.left, r.top, r.right - r.left, r.bottom - r.top,
+                                       static_cast<int>(max_w), static_cast<int>(max_h),
+                                       "Failed to capture monitor thumbnail.");
+                tile.generation = MonitorGeneration();
+              }
+            } else {
+              error = "BAD_ARGS";
+            }
+            if (job && use_textures) tile.texture = CaptureTextureFor(tile.type + ":" + std::to_string(id));
+
+            if (job && use_cache) {
+              // Stale while revalidate: a cached tile is sent right away and
+              // only recaptured once its target changed or it got too old.
+              tile.cache_key = tile.type + ":" + std::to_string(id) + ":" + size_key;
+              ThumbnailCache::Entry cached;
+              if (thumbnail_cache_.Lookup(tile.cache_key, cached)) {
+                const auto age = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    ThumbnailCache::Clock::now() - cached.captured_at);
+                const bool fresh = cached.generation == tile.generation && age.count() <= max_age_ms;
+                EmitThumbnail(batch_id, tile, cached.width, cached.height, std::move(cached.bytes),
+                              fresh ? "fresh" : "stale");
+                if (fresh) continue;
+                tile.has_cached = true;
+                tile.cached_hash = cached.content_hash;
+              }
+            }
+            SubmitThumbnail(batch_id, tile, std::move(job), error);
+          }
+          if (batch.remaining == 0) {
+            // Nothing queued (empty or all invalid): finish after the reply.
+            PostThumbnailBatchDone(batch_id);
+          }
+
           flutter::EncodableMap map;
-          map[flutter::EncodableValue("width")] = flutter::EncodableValue(w);
-          map[flutter::EncodableValue("height")] = flutter::EncodableValue(h);
-          map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(bytes);
+          map[flutter::EncodableValue("batchId")] = flutter::EncodableValue(batch_id);
+          map[flutter::EncodableValue("count")] = flutter::EncodableValue(count);
           result->Success(flutter::EncodableValue(map));
+        } else if (call.method_name().compare("releaseCaptureTextures") == 0) {
+          // Unregisters the textures handed out by captureThumbnails
+          // (useTextures); call when the previews are gone.
+          const int released = static_cast<int>(capture_textures_.size());
+          capture_textures_.clear();
+          result->Success(flutter::EncodableValue(released));
+        } else if (call.method_name().compare("configureThumbnailCache") == 0) {
+          // {budgetBytes?, clear?}; replies with getThumbnailCacheStats.
+          if (call.arguments() && std::holds_alternative<flutter::EncodableMap>(*call.arguments())) {
+            const auto& args = std::get<flutter::EncodableMap>(*call.arguments());
+            int64_t budget = 0;
+            if (GetInt64Arg(args, "budgetBytes", budget) && budget >= 0) {
+              thumbnail_cache_.SetBudget(static_cast<size_t>(budget));
+            }
+            auto clear_it = args.find(flutter::EncodableValue("clear"));
+            if (clear_it != args.end() && std::holds_alternative<bool>(clear_it->second) &&
+                std::get<bool>(clear_it->second)) {
+              thumbnail_cache_.Clear();
+            }
+          }
+          result->Success(ThumbnailCacheStatsValue(thumbnail_cache_.GetStats()));
+        } else if (call.method_name().compare("getThumbnailCacheStats") == 0) {
+          result->Success(ThumbnailCacheStatsValue(thumbnail_cache_.GetStats()));
+        } else if (call.method_name().compare("getPixelPoolStats") == 0) {
+          result->Success(PixelPoolStatsValue());
+        } else if (call.method_name().compare("trimPixelPools") == 0) {
+          // Frees idle capture buffers and DIB sections (e.g. when the app is
+          // backgrounded); replies with getPixelPoolStats.
+          g_pixel_pool.Trim();
+          g_dib_pool.Trim();
+          result->Success(PixelPoolStatsValue());
+        } else if (call.method_name().compare("cancelCapture") == 0) {
+          // Replies CANCELLED to pending captures tagged with |requestId| and
+          // stops jobs nobody is waiting on any more.
+          const std::string* request_id = GetStringArg(call.arguments(), "requestId");
+          if (!request_id) {
+            result->Error("BAD_ARGS", "Missing requestId");
+            return;
+          }
+          result->Success(flutter::EncodableValue(CancelCaptures(request_id)));
+        } else if (call.method_name().compare("cancelAllCaptures") == 0) {
+          result->Success(flutter::EncodableValue(CancelCaptures(nullptr)));
         } else if (call.method_name().compare("captureMonitorThumbnailPixels") == 0) {
           int64_t id = 0;
           int max_w = 320;
@@ -1467,21 +3031,77 @@ bool FlutterWindow::OnCreate() {
           const RECT r = mi.rcMonitor;
           const int sw = r.right - r.left;
           const int sh = r.bottom - r.top;
-          std::vector<uint8_t> bytes;
-          int w = 0, h = 0;
-          const bool ok = CaptureRectBgraScaled(r.left, r.top, sw, sh, max_w, max_h, bytes, w, h);
-          if (!ok) {
-            result->Error("CAPTURE_FAILED", "Failed to capture monitor thumbnail.");
+          const std::string key = "monitor-thumb:" + std::to_string(id) + ":" + std::to_string(max_w) + "x" +
+                                  std::to_string(max_h);
+          SubmitCapture(std::move(result), GetRequestId(call.arguments()), key,
+                        RectThumbnailJob(r.left, r.top, sw, sh, max_w, max_h, "Failed to capture monitor thumbnail."));
+        } else if (call.method_name().compare("getCaptureStats") == 0) {
+          // {reset?}: per-method latency histograms with a stage breakdown
+          // (see CaptureStatsValue); reset clears them after replying.
+          bool reset = false;
+          if (call.arguments() && std::holds_alternative<flutter::EncodableMap>(*call.arguments())) {
+            GetBoolArg(std::get<flutter::EncodableMap>(*call.arguments()), "reset", reset);
+          }
+          result->Success(CaptureStatsValue());
+          if (reset) g_capture_stats.Reset();
+        } else if (call.method_name().compare("setCaptureTracing") == 0) {
+          // {enabled}: keeps every timed stage for dumpCaptureTrace.
+          // Enabling starts a fresh trace.
+          bool enabled = false;
+          if (call.arguments() && std::holds_alternative<bool>(*call.arguments())) {
+            enabled = std::get<bool>(*call.arguments());
+          } else if (call.arguments() && std::holds_alternative<flutter::EncodableMap>(*call.arguments())) {
+            GetBoolArg(std::get<flutter::EncodableMap>(*call.arguments()), "enabled", enabled);
+          }
+          g_capture_stats.SetTracing(enabled);
+          result->Success(flutter::EncodableValue(enabled));
+        } else if (call.method_name().compare("dumpCaptureTrace") == 0) {
+          // {path?}: writes the trace as Chrome trace JSON (default
+          // %TEMP%\finalround_capture_trace.json); replies {path, events}.
+          std::wstring path;
+          if (const std::string* arg = GetStringArg(call.arguments(), "path")) {
+            path = Utf8ToWide(*arg);
+          } else {
+            wchar_t temp[MAX_PATH + 1];
+            const DWORD len = GetTempPathW(MAX_PATH + 1, temp);
+            if (len == 0 || len > MAX_PATH) {
+              result->Error("WRITE_FAILED", "No temp directory");
+              return;
+            }
+            path = std::wstring(temp, len) + L"finalround_capture_trace.json";
+          }
+          const size_t events = g_capture_stats.trace_event_count();
+          const std::string json = g_capture_stats.TraceJson();
+          std::ofstream file(path, std::ios::binary | std::ios::trunc);
+          file.write(json.data(), static_cast<std::streamsize>(json.size()));
+          file.close();
+          if (!file) {
+            result->Error("WRITE_FAILED", "Could not write the trace file");
             return;
           }
           flutter::EncodableMap map;
-          map[flutter::EncodableValue("width")] = flutter::EncodableValue(w);
-          map[flutter::EncodableValue("height")] = flutter::EncodableValue(h);
-          map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(bytes);
+          map[flutter::EncodableValue("path")] = flutter::EncodableValue(WideToUtf8(path.c_str()));
+          map[flutter::EncodableValue("events")] = flutter::EncodableValue(static_cast<int64_t>(events));
           result->Success(flutter::EncodableValue(map));
         } else {
           result->NotImplemented();
         }
+      };
+
+  windowChannel->SetMethodCallHandler(
+      [this, handle_window_call](const flutter::MethodCall<flutter::EncodableValue>& call,
+                                 std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        // The synchronous part of every call is its "handler" stage. Calls
+        // that queued a capture record their whole latency when it
+        // completes; the rest record the handler time.
+        active_method_ = call.method_name();
+        ScopedCaptureMethod method_scope(active_method_);
+        capture_submitted_ = false;
+        const CaptureStats::Clock::time_point start = CaptureStats::Clock::now();
+        handle_window_call(call, std::move(result));
+        const CaptureStats::Clock::time_point end = CaptureStats::Clock::now();
+        g_capture_stats.Record(active_method_, "handler", start, end);
+        if (!capture_submitted_) g_capture_stats.RecordTotal(active_method_, start, end);
       });
 
   flutter_controller_->engine()->SetNextFrameCallback([&]() {
@@ -1496,7 +3116,349 @@ bool FlutterWindow::OnCreate() {
   return true;
 }
 
+void FlutterWindow::SubmitCapture(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result,
+                                  const std::string& request_id,
+                                  const std::string& coalesce_key,
+                                  CaptureJob job,
+                                  std::chrono::milliseconds delay,
+                                  std::function<void()> on_complete) {
+  capture_submitted_ = true;
+  std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> shared_result(std::move(result));
+  if (!coalesce_key.empty()) {
+    auto in_flight = capture_jobs_by_key_.find(coalesce_key);
+    if (in_flight != capture_jobs_by_key_.end()) {
+      pending_captures_[in_flight->second].waiters.emplace_back(request_id, shared_result);
+      return;
+    }
+  }
+
+  // |job_id| is written below, before the platform thread can run the reply.
+  auto job_id = std::make_shared<CaptureExecutor::JobId>(0);
+  auto outcome = std::make_shared<CaptureOutcome>();
+  PlatformTaskRunner* runner = task_runner_.get();
+  // Steps are filed under the calling method; the first one also records
+  // how long the job waited to start (including |delay|).
+  auto method = std::make_shared<const std::string>(active_method_);
+  const CaptureStats::Clock::time_point submitted = CaptureStats::Clock::now();
+  auto started = std::make_shared<bool>(false);
+  const CaptureExecutor::JobId id = capture_executor_->Submit(
+      [this, job = std::move(job), outcome, job_id, runner, on_complete, method, submitted, started](bool cancelled) {
+        ScopedCaptureMethod method_scope(*method);
+        if (!*started) {
+          *started = true;
+          g_capture_stats.Record(*method, "queue", submitted, CaptureStats::Clock::now());
+        }
+        const CaptureStep step = job(cancelled, *outcome);
+        if (!step.done && !cancelled) return step;
+        if (cancelled) SetErrorOutcome(*outcome, "CANCELLED", "Capture was cancelled.");
+        runner->PostTask([this, outcome, job_id, on_complete]() {
+          if (on_complete) on_complete();
+          CompleteCapture(*job_id, *outcome);
+        });
+        return CaptureStep::Done();
+      },
+      delay);
+  if (id == 0) {
+    if (on_complete) on_complete();
+    shared_result->Error("CANCELLED", "Capture was cancelled.");
+    return;
+  }
+  *job_id = id;
+
+  PendingCapture& pending = pending_captures_[id];
+  pending.key = coalesce_key;
+  pending.method = *method;
+  pending.submitted = submitted;
+  pending.waiters.emplace_back(request_id, shared_result);
+  if (!coalesce_key.empty()) capture_jobs_by_key_[coalesce_key] = id;
+}
+
+void FlutterWindow::CompleteCapture(CaptureExecutor::JobId id, CaptureOutcome& outcome) {
+  auto it = pending_captures_.find(id);
+  if (it == pending_captures_.end()) return;  // Every waiter was cancelled.
+  PendingCapture pending = std::move(it->second);
+  pending_captures_.erase(it);
+  auto in_flight = capture_jobs_by_key_.find(pending.key);
+  if (in_flight != capture_jobs_by_key_.end() && in_flight->second == id) {
+    capture_jobs_by_key_.erase(in_flight);
+  }
+
+  {
+    // Success() serializes the reply, so this is the channel encode.
+    ScopedCaptureMethod method_scope(pending.method);
+    ScopedStageTimer timer(g_capture_stats, "reply");
+    for (auto& waiter : pending.waiters) {
+      if (outcome.ok) {
+        waiter.second->Success(outcome.value);
+      } else {
+        waiter.second->Error(outcome.error_code, outcome.error_message);
+      }
+    }
+  }
+  g_capture_stats.RecordTotal(pending.method, pending.submitted, CaptureStats::Clock::now());
+  ReclaimPixels(outcome.value);
+}
+
+int FlutterWindow::CancelCaptures(const std::string* request_id) {
+  int cancelled = 0;
+  for (auto it = pending_captures_.begin(); it != pending_captures_.end();) {
+    auto& waiters = it->second.waiters;
+    for (auto waiter = waiters.begin(); waiter != waiters.end();) {
+      if (!request_id || waiter->first == *request_id) {
+        waiter->second->Error("CANCELLED", "Capture was cancelled.");
+        waiter = waiters.erase(waiter);
+        cancelled++;
+      } else {
+        ++waiter;
+      }
+    }
+    if (!waiters.empty()) {
+      ++it;
+      continue;
+    }
+    // Nobody is waiting: stop the job (it still undoes any restore/minimize)
+    // and let a new request for the same key start fresh.
+    capture_executor_->Cancel(it->first);
+    auto in_flight = capture_jobs_by_key_.find(it->second.key);
+    if (in_flight != capture_jobs_by_key_.end() && in_flight->second == it->first) {
+      capture_jobs_by_key_.erase(in_flight);
+    }
+    it = pending_captures_.erase(it);
+  }
+
+  for (auto it = thumbnail_batches_.begin(); it != thumbnail_batches_.end();) {
+    if (request_id && it->second.request_id != *request_id) {
+      ++it;
+      continue;
+    }
+    for (CaptureExecutor::JobId job : it->second.jobs) {
+      if (thumbnail_executor_->Cancel(job)) cancelled++;
+    }
+    const int64_t batch_id = it->first;
+    it = thumbnail_batches_.erase(it);
+    if (thumbnail_sink_) {
+      flutter::EncodableMap map;
+      map[flutter::EncodableValue("batchId")] = flutter::EncodableValue(batch_id);
+      map[flutter::EncodableValue("done")] = flutter::EncodableValue(true);
+      map[flutter::EncodableValue("cancelled")] = flutter::EncodableValue(true);
+      thumbnail_sink_->Success(flutter::EncodableValue(map));
+    }
+  }
+  return cancelled;
+}
+
+void FlutterWindow::SubmitThumbnail(int64_t batch_id,
+                                    const ThumbnailTileRequest& tile,
+                                    CaptureJob job,
+                                    const std::string& error) {
+  ThumbnailBatch& batch = thumbnail_batches_[batch_id];
+  auto outcome = std::make_shared<CaptureOutcome>();
+  if (!job) {
+    SetErrorOutcome(*outcome, error, error);
+  } else {
+    static const std::string kMethod("captureThumbnails");
+    PlatformTaskRunner* runner = task_runner_.get();
+    const CaptureStats::Clock::time_point submitted = CaptureStats::Clock::now();
+    const CaptureExecutor::JobId job_id = thumbnail_executor_->Submit(
+        [this, job = std::move(job), outcome, runner, batch_id, tile, submitted](bool cancelled) {
+          ScopedCaptureMethod method_scope(kMethod);
+          const CaptureStep step = job(cancelled, *outcome);
+          if (!step.done && !cancelled) return step;
+          // Per tile, from queueing to pixels ready.
+          g_capture_stats.RecordTotal(kMethod, submitted, CaptureStats::Clock::now());
+          if (cancelled) return CaptureStep::Done();
+          // releaseCaptureTextures may drop the platform's reference while
+          // this runs; the locked one rides along to the platform thread so
+          // the texture is never destroyed (unregistered) here.
+          std::shared_ptr<CaptureTexture> texture = tile.texture.lock();
+          if (texture && outcome->ok) {
+            // Fill the texture here; only the cache keeps the pixels.
+            auto& pixels = std::get<flutter::EncodableMap>(outcome->value);
+            texture->Publish(std::get<std::vector<uint8_t>>(pixels[flutter::EncodableValue("bytes")]).data(),
+                             std::get<int32_t>(pixels[flutter::EncodableValue("width")]),
+                             std::get<int32_t>(pixels[flutter::EncodableValue("height")]), 0);
+          }
+          runner->PostTask([this, outcome, batch_id, tile, texture = std::move(texture)]() {
+            CompleteThumbnail(batch_id, tile, *outcome);
+          });
+          return CaptureStep::Done();
+        });
+    if (job_id != 0) {
+      batch.jobs.push_back(job_id);
+      batch.remaining++;
+      return;
+    }
+    SetErrorOutcome(*outcome, "CANCELLED", "Capture was cancelled.");
+  }
+  // Invalid target: report it in order with the others.
+  batch.remaining++;
+  task_runner_->PostTask([this, outcome, batch_id, tile]() {
+    CompleteThumbnail(batch_id, tile, *outcome);
+  });
+}
+
+void FlutterWindow::CompleteThumbnail(int64_t batch_id,
+                                      const ThumbnailTileRequest& tile,
+                                      CaptureOutcome& outcome) {
+  auto it = thumbnail_batches_.find(batch_id);
+  if (it == thumbnail_batches_.end()) return;  // Cancelled.
+  if (it->second.remaining > 0) it->second.remaining--;
+  if (it->second.remaining == 0) PostThumbnailBatchDone(batch_id);
+
+  if (!outcome.ok || !std::holds_alternative<flutter::EncodableMap>(outcome.value)) {
+    if (thumbnail_sink_) {
+      flutter::EncodableMap map;
+      map[flutter::EncodableValue("batchId")] = flutter::EncodableValue(batch_id);
+      map[flutter::EncodableValue("type")] = flutter::EncodableValue(tile.type);
+      map[flutter::EncodableValue("id")] = flutter::EncodableValue(tile.id);
+      map[flutter::EncodableValue("error")] = flutter::EncodableValue(outcome.error_code);
+      thumbnail_sink_->Success(flutter::EncodableValue(map));
+    }
+    return;
+  }
+
+  auto& pixels = std::get<flutter::EncodableMap>(outcome.value);
+  const int width = std::get<int32_t>(pixels[flutter::EncodableValue("width")]);
+  const int height = std::get<int32_t>(pixels[flutter::EncodableValue("height")]);
+  auto& bytes = std::get<std::vector<uint8_t>>(pixels[flutter::EncodableValue("bytes")]);
+  // Revalidated and unchanged: the cached tile Dart already has stands.
+  if (!tile.cache_key.empty() &&
+      !thumbnail_cache_.PutCapture(tile.cache_key, bytes.data(), width, height, 0, tile.generation,
+                                   tile.has_cached ? &tile.cached_hash : nullptr)) {
+    return;
+  }
+  // With a live texture the worker has already published the pixels.
+  EmitThumbnail(batch_id, tile, width, height, tile.texture.expired() ? std::move(bytes) : std::vector<uint8_t>(),
+                "captured");
+}
+
+void FlutterWindow::EmitThumbnail(int64_t batch_id,
+                                  const ThumbnailTileRequest& tile,
+                                  int width,
+                                  int height,
+                                  std::vector<uint8_t>&& bytes,
+                                  const char* source) {
+  if (!thumbnail_sink_) return;
+  flutter::EncodableMap map;
+  map[flutter::EncodableValue("batchId")] = flutter::EncodableValue(batch_id);
+  map[flutter::EncodableValue("type")] = flutter::EncodableValue(tile.type);
+  map[flutter::EncodableValue("id")] = flutter::EncodableValue(tile.id);
+  map[flutter::EncodableValue("width")] = flutter::EncodableValue(width);
+  map[flutter::EncodableValue("height")] = flutter::EncodableValue(height);
+  map[flutter::EncodableValue("source")] = flutter::EncodableValue(source);
+  // A texture released since the tile was queued falls back to bytes.
+  if (std::shared_ptr<CaptureTexture> texture = tile.texture.lock()) {
+    if (!bytes.empty()) texture->Publish(bytes.data(), width, height, 0);
+    map[flutter::EncodableValue("textureId")] = flutter::EncodableValue(texture->id());
+  } else {
+    map[flutter::EncodableValue("bytes")] = flutter::EncodableValue(std::move(bytes));
+  }
+  flutter::EncodableValue event(std::move(map));
+  thumbnail_sink_->Success(event);
+  ReclaimPixels(event);
+}
+
+std::shared_ptr<CaptureTexture> FlutterWindow::CaptureTextureFor(const std::string& key) {
+  auto& texture = capture_textures_[key];
+  if (!texture && texture_registrar_) {
+    texture = std::make_shared<CaptureTexture>(texture_registrar_.get());
+  }
+  if (!texture || texture->id() < 0) {
+    capture_textures_.erase(key);
+    return nullptr;
+  }
+  return texture;
+}
+
+void FlutterWindow::PostThumbnailBatchDone(int64_t batch_id) {
+  task_runner_->PostTask([this, batch_id]() {
+    auto it = thumbnail_batches_.find(batch_id);
+    if (it == thumbnail_batches_.end() || it->second.remaining != 0) return;
+    thumbnail_batches_.erase(it);
+    if (!thumbnail_sink_) return;
+    flutter::EncodableMap map;
+    map[flutter::EncodableValue("batchId")] = flutter::EncodableValue(batch_id);
+    map[flutter::EncodableValue("done")] = flutter::EncodableValue(true);
+    thumbnail_sink_->Success(flutter::EncodableValue(map));
+  });
+}
+
+void FlutterWindow::UpdateAudioLevelCallback() {
+  if (!g_audio_capture) return;
+  if (!audio_level_sink_ || !task_runner_) {
+    g_audio_capture->SetLevelCallback(nullptr);
+    return;
+  }
+  PlatformTaskRunner* runner = task_runner_.get();
+  g_audio_capture->SetLevelCallback([this, runner](const AudioLevelSnapshot& level) {
+    // Capture thread: build nothing heavier than a copy, send on the platform thread.
+    runner->PostTask([this, level]() {
+      if (!audio_level_sink_) return;
+      flutter::EncodableMap map;
+      map[flutter::EncodableValue("source")] = flutter::EncodableValue("system");
+      map[flutter::EncodableValue("rms")] = flutter::EncodableValue(static_cast<double>(level.rms));
+      map[flutter::EncodableValue("peak")] = flutter::EncodableValue(static_cast<double>(level.peak));
+      map[flutter::EncodableValue("waveform")] = flutter::EncodableValue(level.waveform);
+      map[flutter::EncodableValue("endSample")] =
+          flutter::EncodableValue(static_cast<int64_t>(level.end_sample));
+      audio_level_sink_->Success(flutter::EncodableValue(map));
+    });
+  });
+}
+
+void FlutterWindow::EmitStreamEvent(const flutter::EncodableMap& event) {
+  if (stream_sink_) stream_sink_->Success(flutter::EncodableValue(event));
+}
+
+int FlutterWindow::StopScreenStreams(int64_t stream_id) {
+  int stopped = 0;
+  for (auto it = streams_.begin(); it != streams_.end();) {
+    if (stream_id != 0 && it->first != stream_id) {
+      ++it;
+      continue;
+    }
+    if (stream_executor_) stream_executor_->Cancel(it->second.job);
+    it = streams_.erase(it);
+    stopped++;
+  }
+  return stopped;
+}
+
 void FlutterWindow::OnDestroy() {
+  if (foreground_hook_) {
+    UnhookWinEvent(foreground_hook_);
+    foreground_hook_ = nullptr;
+  }
+  // Stop background producers before the runner and sinks go away.
+  g_audio_uplink = nullptr;
+  // Cancelled captures post their (dropped) replies and restore this window
+  // before the runner shuts down.
+  capture_executor_ = nullptr;
+  thumbnail_executor_ = nullptr;
+  stream_executor_ = nullptr;
+  pending_captures_.clear();
+  capture_jobs_by_key_.clear();
+  thumbnail_batches_.clear();
+  streams_.clear();
+  snapshots_.clear();
+  if (g_audio_capture) {
+    g_audio_capture->SetLevelCallback(nullptr);
+  }
+  if (task_runner_) {
+    task_runner_->Shutdown();
+  }
+  audio_level_sink_ = nullptr;
+  audio_level_channel_ = nullptr;
+  uplink_event_sink_ = nullptr;
+  uplink_event_channel_ = nullptr;
+  thumbnail_sink_ = nullptr;
+  thumbnail_channel_ = nullptr;
+  stream_sink_ = nullptr;
+  stream_channel_ = nullptr;
+  // Jobs holding textures are gone; unregister before the engine goes.
+  capture_textures_.clear();
+  texture_registrar_ = nullptr;
+
   if (flutter_controller_) {
     flutter_controller_ = nullptr;
   }
@@ -1522,6 +3484,11 @@ FlutterWindow::MessageHandler(HWND hwnd, UINT const message,
     case WM_FONTCHANGE:
       flutter_controller_->engine()->ReloadSystemFonts();
       break;
+    case PlatformTaskRunner::kRunTasksMessage:
+      if (task_runner_) {
+        task_runner_->RunPendingTasks();
+      }
+      return 0;
   }
 
   return Win32Window::MessageHandler(hwnd, message, wparam, lparam);
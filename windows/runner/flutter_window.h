@@ -2,12 +2,40 @@
 #define RUNNER_FLUTTER_WINDOW_H_
 
 #include <flutter/dart_project.h>
+#include <flutter/encodable_value.h>
+#include <flutter/event_channel.h>
 #include <flutter/flutter_view_controller.h>
+#include <flutter/method_result.h>
+#include <flutter/texture_registrar.h>
 
+#include <chrono>
+#include <functional>
+#include <map>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "capture_executor.h"
+#include "capture_texture.h"
+#include "platform_task_runner.h"
+#include "screen_snapshot.h"
+#include "screen_stream.h"
+#include "thumbnail_cache.h"
 #include "win32_window.h"
 
+// Result of a capture job, filled on a CaptureExecutor thread and delivered
+// to the waiting MethodResults on the platform thread.
+struct CaptureOutcome {
+  bool ok = false;
+  std::string error_code;
+  std::string error_message;
+  flutter::EncodableValue value;
+};
+
+// One step of a capture job; see CaptureExecutor::Step.
+using CaptureJob = std::function<CaptureStep(bool cancelled, CaptureOutcome& outcome)>;
+
 // A window that does nothing but host a Flutter view.
 class FlutterWindow : public Win32Window {
  public:
@@ -29,6 +57,144 @@ class FlutterWindow : public Win32Window {
   // The Flutter instance hosted by this window.
   std::unique_ptr<flutter::FlutterViewController> flutter_controller_;
 
+  // Runs work posted from background threads on the platform thread.
+  std::unique_ptr<PlatformTaskRunner> task_runner_;
+
+  // EVENT_SYSTEM_FOREGROUND hook feeding the active-window tracker.
+  HWINEVENTHOOK foreground_hook_ = nullptr;
+
+  // Runs window-channel captures (and captureForUpload encoding) off the
+  // platform thread.
+  std::unique_ptr<CaptureExecutor> capture_executor_;
+
+  // Method results waiting on an in-flight capture job, tagged with the
+  // caller's requestId. Platform thread only.
+  struct PendingCapture {
+    std::string key;
+    // For getCaptureStats.
+    std::string method;
+    std::chrono::steady_clock::time_point submitted;
+    std::vector<std::pair<std::string, std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>>>> waiters;
+  };
+  std::map<CaptureExecutor::JobId, PendingCapture> pending_captures_;
+  // In-flight job per coalescing key (thumbnail requests for one target).
+  std::map<std::string, CaptureExecutor::JobId> capture_jobs_by_key_;
+  // Window-channel method being handled, and whether it queued a capture;
+  // SubmitCapture files the job's stage timings under it.
+  std::string active_method_;
+  bool capture_submitted_ = false;
+
+  // Bounded pool for captureThumbnails; tiles are streamed on
+  // |thumbnail_sink_| as each job finishes.
+  std::unique_ptr<CaptureExecutor> thumbnail_executor_;
+  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>> thumbnail_channel_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> thumbnail_sink_;
+  struct ThumbnailBatch {
+    std::string request_id;
+    std::vector<CaptureExecutor::JobId> jobs;
+    size_t remaining = 0;
+  };
+  std::map<int64_t, ThumbnailBatch> thumbnail_batches_;
+  int64_t next_thumbnail_batch_id_ = 1;
+  // One captureThumbnails tile; |cache_key| is empty when not cached.
+  struct ThumbnailTileRequest {
+    std::string type;
+    int64_t id = 0;
+    std::string cache_key;
+    uint64_t generation = 0;
+    bool has_cached = false;
+    uint64_t cached_hash = 0;
+    // Set for useTextures batches: pixels go here, not into the event.
+    // Weak so a worker never holds the last reference; see
+    // |capture_textures_|.
+    std::weak_ptr<CaptureTexture> texture;
+  };
+  // Tiles from earlier captureThumbnails calls. Platform thread only.
+  ThumbnailCache thumbnail_cache_;
+
+  // startScreenStream: paced captures on |stream_executor_|. Each stream
+  // keeps its latest encoded frame; changes go to |stream_sink_|.
+  std::unique_ptr<CaptureExecutor> stream_executor_;
+  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>> stream_channel_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> stream_sink_;
+  struct ActiveStream {
+    std::shared_ptr<ScreenStream> stream;
+    CaptureExecutor::JobId job = 0;
+  };
+  std::map<int64_t, ActiveStream> streams_;
+  int64_t next_stream_id_ = 1;
+
+  // createScreenSnapshot: frozen captures served to the region selector
+  // (crops, previews, encodes) without going back to GDI. Platform thread
+  // only; jobs hold their own references.
+  std::map<int64_t, std::shared_ptr<const ScreenSnapshot>> snapshots_;
+  int64_t next_snapshot_id_ = 1;
+
+  // External textures for captureThumbnails(useTextures), one per target
+  // ("window:<hwnd>", "monitor:<id>"), kept until releaseCaptureTextures.
+  // Platform thread only. Capture jobs hold weak references and pass a
+  // locked one back in their completion task, so the final release (which
+  // unregisters the texture) always happens on the platform thread.
+  std::unique_ptr<flutter::TextureRegistrar> texture_registrar_;
+  std::map<std::string, std::shared_ptr<CaptureTexture>> capture_textures_;
+
+  // Low-rate system audio level/waveform feed for UI meters.
+  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>> audio_level_channel_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> audio_level_sink_;
+
+  // Server messages and close notifications from the native uplink.
+  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>> uplink_event_channel_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> uplink_event_sink_;
+
+  // (Re)attaches or detaches the level callback on the global AudioCapture to
+  // match whether Dart is listening.
+  void UpdateAudioLevelCallback();
+
+  // Runs |job| on |capture_executor_| after |delay| and replies to |result| on
+  // the platform thread. A request whose non-empty |coalesce_key| matches an
+  // in-flight job waits for that job instead of capturing again.
+  // |on_complete| runs on the platform thread before the reply.
+  void SubmitCapture(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result,
+                     const std::string& request_id,
+                     const std::string& coalesce_key,
+                     CaptureJob job,
+                     std::chrono::milliseconds delay = std::chrono::milliseconds(0),
+                     std::function<void()> on_complete = nullptr);
+  // Replies to every waiter, then returns the pixels to the buffer pool.
+  void CompleteCapture(CaptureExecutor::JobId id, CaptureOutcome& outcome);
+  // Replies CANCELLED to waiters tagged |request_id| (all waiters if null)
+  // and cancels jobs left without waiters, plus matching captureThumbnails
+  // batches. Returns the number cancelled.
+  int CancelCaptures(const std::string* request_id);
+
+  // Queues one captureThumbnails tile. A null |job| reports |error| for it.
+  void SubmitThumbnail(int64_t batch_id,
+                       const ThumbnailTileRequest& tile,
+                       CaptureJob job,
+                       const std::string& error);
+  // Caches and emits a captured tile, unless revalidation found it unchanged.
+  void CompleteThumbnail(int64_t batch_id,
+                         const ThumbnailTileRequest& tile,
+                         CaptureOutcome& outcome);
+  // |source| is "captured", or "fresh"/"stale" for tiles served from cache.
+  void EmitThumbnail(int64_t batch_id,
+                     const ThumbnailTileRequest& tile,
+                     int width,
+                     int height,
+                     std::vector<uint8_t>&& bytes,
+                     const char* source);
+  // Texture for |key|, registered on first use; null if unavailable.
+  std::shared_ptr<CaptureTexture> CaptureTextureFor(const std::string& key);
+
+  // Emits {batchId, done: true} once the batch has no tiles left.
+  void PostThumbnailBatchDone(int64_t batch_id);
+
+  void EmitStreamEvent(const flutter::EncodableMap& event);
+
+  // Cancels stream |stream_id| (every stream if 0). Returns the number
+  // stopped.
+  int StopScreenStreams(int64_t stream_id);
+
   // Region selector mode state
   bool region_selector_active_ = false;
   RECT saved_window_rect_ = {0, 0, 0, 0};
@@ -0,0 +1,24 @@
+#include "foreground_tracker.h"
+
+#include <algorithm>
+
+ForegroundTracker::ForegroundTracker(size_t max_history) : max_history_((std::max)(size_t{1}, max_history)) {}
+
+void ForegroundTracker::OnForeground(WindowId window, bool target) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!target || window == 0) return;
+  auto it = std::find(history_.begin(), history_.end(), window);
+  if (it != history_.end()) history_.erase(it);
+  history_.push_front(window);
+  if (history_.size() > max_history_) history_.pop_back();
+}
+
+ForegroundTracker::WindowId ForegroundTracker::LastTarget(const std::function<bool(WindowId)>& usable) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  while (!history_.empty()) {
+    const WindowId window = history_.front();
+    if (!usable || usable(window)) return window;
+    history_.pop_front();
+  }
+  return 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+// Remembers which windows the user last had in front, other than our own,
+// so "capture the active window" can target the right one without first
+// hiding ourselves (platform-neutral).
+//
+// A platform event source reports each foreground change: on Windows a
+// SetWinEventHook(EVENT_SYSTEM_FOREGROUND) hook, on X11 PropertyNotify on
+// the root window's _NET_ACTIVE_WINDOW. Windows are opaque ids (HWND or X
+// Window; 0 = none). Thread-safe: events arrive on the UI thread while
+// capture workers query.
+class ForegroundTracker {
+ public:
+  using WindowId = uint64_t;
+
+  explicit ForegroundTracker(size_t max_history);
+
+  // |window| became foreground. |target| says whether it is something the
+  // user would mean by "the active window" (not ours, not the taskbar or
+  // desktop); only targets enter the history.
+  void OnForeground(WindowId window, bool target);
+
+  // The most recent target for which |usable| holds (it still exists, is
+  // visible, ...), or 0. Entries that fail are dropped, so closed windows
+  // need no separate notification.
+  WindowId LastTarget(const std::function<bool(WindowId)>& usable);
+
+ private:
+  const size_t max_history_;
+  std::mutex mutex_;
+  // Most recent first, no duplicates.
+  std::deque<WindowId> history_;
+};
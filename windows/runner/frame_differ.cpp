@@ -0,0 +1,128 @@
+#include "frame_differ.h"
+
+#include <cstring>
+
+namespace {
+
+constexpr uint64_t kMul = 0x9E3779B97F4A7C15ull;
+
+inline uint64_t MixWord(uint64_t h, uint64_t v) {
+  h ^= v;
+  h *= kMul;
+  return h ^ (h >> 29);
+}
+
+}  // namespace
+
+uint64_t HashBgraBlock(const uint8_t* bgra, int width, int height, size_t stride) {
+  uint64_t h = MixWord(static_cast<uint64_t>(width) << 32 | static_cast<uint32_t>(height), kMul);
+  if (!bgra || width <= 0 || height <= 0) return h;
+  const size_t row_bytes = static_cast<size_t>(width) * 4;
+  for (int y = 0; y < height; y++) {
+    const uint8_t* p = bgra + static_cast<size_t>(y) * stride;
+    size_t i = 0;
+    for (; i + 8 <= row_bytes; i += 8) {
+      uint64_t v;
+      std::memcpy(&v, p + i, 8);
+      h = MixWord(h, v);
+    }
+    if (i < row_bytes) {
+      uint32_t v;
+      std::memcpy(&v, p + i, 4);  // Rows are whole pixels, so 4 bytes remain.
+      h = MixWord(h, v);
+    }
+  }
+  return h;
+}
+
+FrameDiffer::FrameDiffer(double max_changed_fraction, size_t max_rects)
+    : max_changed_fraction_(max_changed_fraction), max_rects_(max_rects) {}
+
+void FrameDiffer::Reset() {
+  width_ = height_ = 0;
+  hashes_.clear();
+}
+
+FrameDiff FrameDiffer::Update(const uint8_t* bgra, int width, int height, size_t stride) {
+  FrameDiff diff;
+  if (!bgra || width <= 0 || height <= 0) {
+    Reset();
+    return diff;
+  }
+  if (stride == 0) stride = static_cast<size_t>(width) * 4;
+
+  const int cols = (width + kTileSize - 1) / kTileSize;
+  const int rows = (height + kTileSize - 1) / kTileSize;
+  std::vector<uint64_t> hashes(static_cast<size_t>(cols) * static_cast<size_t>(rows));
+  for (int ty = 0; ty < rows; ty++) {
+    const int y = ty * kTileSize;
+    const int th = (height - y) < kTileSize ? (height - y) : kTileSize;
+    for (int tx = 0; tx < cols; tx++) {
+      const int x = tx * kTileSize;
+      const int tw = (width - x) < kTileSize ? (width - x) : kTileSize;
+      hashes[static_cast<size_t>(ty) * static_cast<size_t>(cols) + static_cast<size_t>(tx)] =
+          HashBgraBlock(bgra + static_cast<size_t>(y) * stride + static_cast<size_t>(x) * 4, tw, th, stride);
+    }
+  }
+
+  const bool comparable = width == width_ && height == height_ && hashes_.size() == hashes.size();
+  hashes_.swap(hashes);
+  width_ = width;
+  height_ = height;
+  if (!comparable) return diff;
+
+  // Runs of changed tiles per tile row, merged downwards with identical runs
+  // of the row above.
+  size_t changed = 0;
+  std::vector<DirtyRect> open;
+  for (int ty = 0; ty < rows; ty++) {
+    std::vector<DirtyRect> runs;
+    for (int tx = 0; tx < cols; tx++) {
+      const size_t i = static_cast<size_t>(ty) * static_cast<size_t>(cols) + static_cast<size_t>(tx);
+      if (hashes_[i] == hashes[i]) continue;
+      changed++;
+      if (!runs.empty() && runs.back().x + runs.back().width == tx) {
+        runs.back().width++;
+      } else {
+        runs.push_back(DirtyRect{tx, ty, 1, 1});
+      }
+    }
+    std::vector<DirtyRect> next;
+    for (const DirtyRect& run : runs) {
+      bool merged = false;
+      for (DirtyRect& o : open) {
+        if (o.x == run.x && o.width == run.width && o.y + o.height == ty) {
+          o.height++;
+          next.push_back(o);
+          o.width = 0;  // Moved to |next|.
+          merged = true;
+          break;
+        }
+      }
+      if (!merged) next.push_back(run);
+    }
+    for (const DirtyRect& o : open) {
+      if (o.width > 0) diff.rects.push_back(o);
+    }
+    open.swap(next);
+  }
+  for (const DirtyRect& o : open) diff.rects.push_back(o);
+
+  // Tile units to pixels, clipped to the frame.
+  for (DirtyRect& r : diff.rects) {
+    r.x *= kTileSize;
+    r.y *= kTileSize;
+    r.width = (r.x + r.width * kTileSize > width ? width - r.x : r.width * kTileSize);
+    r.height = (r.y + r.height * kTileSize > height ? height - r.y : r.height * kTileSize);
+  }
+
+  diff.changed_fraction = static_cast<double>(changed) / static_cast<double>(hashes.size());
+  if (changed == 0) {
+    diff.kind = FrameDiff::Kind::kUnchanged;
+  } else if (diff.changed_fraction > max_changed_fraction_ || diff.rects.size() > max_rects_) {
+    diff.kind = FrameDiff::Kind::kChanged;
+  } else {
+    diff.kind = FrameDiff::Kind::kDirty;
+  }
+  return diff;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct DirtyRect {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+};
+
+struct FrameDiff {
+  enum class Kind {
+    // No previous frame (or its size differed): treat as all new.
+    kFirst,
+    kUnchanged,
+    // Only |rects| changed.
+    kDirty,
+    // Too much changed for crops to be worth it.
+    kChanged,
+  };
+  Kind kind = Kind::kFirst;
+  // Merged dirty tiles in frame pixels; set for kDirty (and kChanged).
+  std::vector<DirtyRect> rects;
+  // Share of tiles that changed, 0..1.
+  double changed_fraction = 1.0;
+};
+
+// 64-bit non-cryptographic hash of a w x h BGRA block (|stride| bytes/row).
+uint64_t HashBgraBlock(const uint8_t* bgra, int width, int height, size_t stride);
+
+// Compares successive captures of one target tile by tile.
+//
+// Each frame is split into kTileSize x kTileSize tiles (edge tiles are
+// smaller) whose hashes are kept for the next call; changed tiles are merged
+// into a short list of rectangles. Not thread-safe.
+class FrameDiffer {
+ public:
+  static constexpr int kTileSize = 64;
+
+  // Above |max_changed_fraction| of tiles, or more than |max_rects|
+  // rectangles, a frame is reported as kChanged.
+  explicit FrameDiffer(double max_changed_fraction = 0.5, size_t max_rects = 16);
+
+  // Diffs |bgra| against the previous frame and remembers it. |stride| 0
+  // means width * 4.
+  FrameDiff Update(const uint8_t* bgra, int width, int height, size_t stride);
+
+  void Reset();
+
+ private:
+  double max_changed_fraction_;
+  size_t max_rects_;
+  int width_ = 0;
+  int height_ = 0;
+  std::vector<uint64_t> hashes_;
+};
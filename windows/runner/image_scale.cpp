@@ -0,0 +1,351 @@
+#include "image_scale.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_SCALE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr int kWeightBits = 14;
+constexpr int32_t kWeightOne = 1 << kWeightBits;
+// Fractional bits kept in the 16-bit intermediate row. 255 << 6 leaves
+// headroom for Lanczos overshoot without saturating int16.
+constexpr int kMidBits = 6;
+constexpr int kVerticalShift = kWeightBits - kMidBits;
+constexpr int kHorizontalShift = kWeightBits + kMidBits;
+
+// Don't split work smaller than this many output rows per thread.
+constexpr int kMinRowsPerBand = 32;
+constexpr int kMaxAutoThreads = 4;
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Source span and per-pixel weights (summing to kWeightOne) for one output
+// coordinate.
+struct Contribution {
+  int first = 0;
+  std::vector<int16_t> weights;
+};
+
+// Quantizes |taps| into |c| by rounding the running sum rather than each
+// tap, so the weights sum to exactly one and each stays within one step of
+// its exact value. (Rounding taps one by one and handing the residue to one
+// of them overflowed int16 once a pixel had thousands of taps: downscales
+// beyond about 16384:1.) Tiny box taps become an even 0/1 pattern, i.e. a
+// uniform subsample of the span.
+void Quantize(const std::vector<double>& taps, double total, Contribution& c) {
+  c.weights.resize(taps.size());
+  double running = 0.0;
+  int32_t previous = 0;
+  for (size_t k = 0; k < taps.size(); k++) {
+    running += taps[k];
+    const int32_t next = k + 1 == taps.size()
+                             ? kWeightOne
+                             : static_cast<int32_t>(std::lround(running / total * kWeightOne));
+    c.weights[k] = static_cast<int16_t>(next - previous);
+    previous = next;
+  }
+}
+
+std::vector<Contribution> BuildBoxContributions(int src, int dst) {
+  std::vector<Contribution> table(static_cast<size_t>(dst));
+  const double scale = static_cast<double>(src) / static_cast<double>(dst);
+  for (int i = 0; i < dst; i++) {
+    const double start = i * scale;
+    const double end = (std::min)(static_cast<double>(src), (i + 1) * scale);
+    const int first = (std::min)(src - 1, static_cast<int>(std::floor(start)));
+    const int last = (std::max)(first, (std::min)(src - 1, static_cast<int>(std::ceil(end)) - 1));
+    Contribution& c = table[static_cast<size_t>(i)];
+    c.first = first;
+
+    std::vector<double> cover;
+    double total = 0.0;
+    for (int s = first; s <= last; s++) {
+      const double lo = (std::max)(start, static_cast<double>(s));
+      const double hi = (std::min)(end, static_cast<double>(s + 1));
+      const double w = (std::max)(0.0, hi - lo);
+      cover.push_back(w);
+      total += w;
+    }
+    if (total <= 0.0) {
+      c.weights.assign(1, static_cast<int16_t>(kWeightOne));
+      continue;
+    }
+    Quantize(cover, total, c);
+  }
+  return table;
+}
+
+double Triangle(double x) {
+  x = std::fabs(x);
+  return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+double Sinc(double x) {
+  if (x == 0.0) return 1.0;
+  x *= kPi;
+  return std::sin(x) / x;
+}
+
+double Lanczos3(double x) {
+  if (x <= -3.0 || x >= 3.0) return 0.0;
+  return Sinc(x) * Sinc(x / 3.0);
+}
+
+// Kernel-based table: the kernel is stretched by the scale factor when
+// downscaling so every source pixel contributes (no aliasing).
+std::vector<Contribution> BuildKernelContributions(int src,
+                                                   int dst,
+                                                   double (*kernel)(double),
+                                                   double radius) {
+  std::vector<Contribution> table(static_cast<size_t>(dst));
+  const double scale = static_cast<double>(src) / static_cast<double>(dst);
+  const double filter_scale = (std::max)(1.0, scale);
+  const double support = radius * filter_scale;
+  for (int i = 0; i < dst; i++) {
+    const double center = (i + 0.5) * scale;
+    const int first = (std::max)(0, static_cast<int>(std::floor(center - support + 0.5)));
+    const int last = (std::min)(src - 1, static_cast<int>(std::floor(center + support + 0.5)) - 1);
+    Contribution& c = table[static_cast<size_t>(i)];
+    c.first = first;
+
+    std::vector<double> taps;
+    double total = 0.0;
+    for (int s = first; s <= last; s++) {
+      const double w = kernel((s + 0.5 - center) / filter_scale);
+      taps.push_back(w);
+      total += w;
+    }
+    if (taps.empty() || total == 0.0) {
+      c.first = (std::min)(src - 1, (std::max)(0, static_cast<int>(center)));
+      c.weights.assign(1, static_cast<int16_t>(kWeightOne));
+      continue;
+    }
+    Quantize(taps, total, c);
+  }
+  return table;
+}
+
+std::vector<Contribution> BuildContributions(int src, int dst, ScaleFilter filter) {
+  switch (filter) {
+    case ScaleFilter::kBilinear:
+      return BuildKernelContributions(src, dst, Triangle, 1.0);
+    case ScaleFilter::kLanczos3:
+      return BuildKernelContributions(src, dst, Lanczos3, 3.0);
+    case ScaleFilter::kBox:
+      break;
+  }
+  return BuildBoxContributions(src, dst);
+}
+
+int16_t ClampInt16(int32_t v) {
+  return static_cast<int16_t>(v < -32768 ? -32768 : (v > 32767 ? 32767 : v));
+}
+
+#if !IMAGE_SCALE_SSE2
+uint8_t ClampByte(int32_t v) {
+  return static_cast<uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+#endif
+
+// Vertical pass for one output row: mid[i] = sum_k line_k[i] * w_k, for the
+// |bytes| channel values of a source row.
+void VerticalPass(const uint8_t* src,
+                  size_t src_stride,
+                  const Contribution& c,
+                  size_t bytes,
+                  int16_t* mid) {
+  const size_t taps = c.weights.size();
+  const uint8_t* base = src + static_cast<size_t>(c.first) * src_stride;
+  size_t i = 0;
+#if IMAGE_SCALE_SSE2
+  // Two source rows per multiply-add: interleaving their 16-bit values lets
+  // _mm_madd_epi16 apply both weights at once.
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i round = _mm_set1_epi32(1 << (kVerticalShift - 1));
+  for (; i + 16 <= bytes; i += 16) {
+    __m128i acc0 = round, acc1 = round, acc2 = round, acc3 = round;
+    size_t k = 0;
+    for (; k + 1 < taps; k += 2) {
+      const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + k * src_stride + i));
+      const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + (k + 1) * src_stride + i));
+      const __m128i w = _mm_set1_epi32(static_cast<int32_t>(
+          (static_cast<uint32_t>(static_cast<uint16_t>(c.weights[k + 1])) << 16) |
+          static_cast<uint16_t>(c.weights[k])));
+      const __m128i a_lo = _mm_unpacklo_epi8(a, zero), a_hi = _mm_unpackhi_epi8(a, zero);
+      const __m128i b_lo = _mm_unpacklo_epi8(b, zero), b_hi = _mm_unpackhi_epi8(b, zero);
+      acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(a_lo, b_lo), w));
+      acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(a_lo, b_lo), w));
+      acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(a_hi, b_hi), w));
+      acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(a_hi, b_hi), w));
+    }
+    if (k < taps) {
+      const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + k * src_stride + i));
+      const __m128i w = _mm_set1_epi32(static_cast<uint16_t>(c.weights[k]));
+      const __m128i a_lo = _mm_unpacklo_epi8(a, zero), a_hi = _mm_unpackhi_epi8(a, zero);
+      acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(a_lo, zero), w));
+      acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(a_lo, zero), w));
+      acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(a_hi, zero), w));
+      acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(a_hi, zero), w));
+    }
+    acc0 = _mm_srai_epi32(acc0, kVerticalShift);
+    acc1 = _mm_srai_epi32(acc1, kVerticalShift);
+    acc2 = _mm_srai_epi32(acc2, kVerticalShift);
+    acc3 = _mm_srai_epi32(acc3, kVerticalShift);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(mid + i), _mm_packs_epi32(acc0, acc1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(mid + i + 8), _mm_packs_epi32(acc2, acc3));
+  }
+#endif
+  for (; i < bytes; i++) {
+    int32_t acc = 1 << (kVerticalShift - 1);
+    for (size_t k = 0; k < taps; k++) acc += base[k * src_stride + i] * c.weights[k];
+    mid[i] = ClampInt16(acc >> kVerticalShift);
+  }
+}
+
+// Horizontal pass: one BGRA output pixel per contribution.
+void HorizontalPass(const int16_t* mid,
+                    const std::vector<Contribution>& cols,
+                    uint8_t* dst) {
+  const size_t dst_w = cols.size();
+  for (size_t x = 0; x < dst_w; x++) {
+    const Contribution& c = cols[x];
+    const int16_t* p = mid + static_cast<size_t>(c.first) * 4;
+    const size_t taps = c.weights.size();
+#if IMAGE_SCALE_SSE2
+    // Pixels k and k+1 (8 int16) interleaved per channel, so one madd
+    // applies both weights to all four channels.
+    __m128i acc = _mm_set1_epi32(1 << (kHorizontalShift - 1));
+    size_t k = 0;
+    for (; k + 1 < taps; k += 2) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + k * 4));
+      const __m128i w = _mm_set1_epi32(static_cast<int32_t>(
+          (static_cast<uint32_t>(static_cast<uint16_t>(c.weights[k + 1])) << 16) |
+          static_cast<uint16_t>(c.weights[k])));
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi16(v, _mm_srli_si128(v, 8)), w));
+    }
+    if (k < taps) {
+      const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + k * 4));
+      const __m128i w = _mm_set1_epi32(static_cast<uint16_t>(c.weights[k]));
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi16(v, _mm_setzero_si128()), w));
+    }
+    acc = _mm_srai_epi32(acc, kHorizontalShift);
+    const __m128i packed = _mm_packs_epi32(acc, acc);
+    const int32_t bgra = _mm_cvtsi128_si32(_mm_packus_epi16(packed, packed));
+    std::memcpy(dst + x * 4, &bgra, 4);
+#else
+    int32_t acc[4] = {1 << (kHorizontalShift - 1), 1 << (kHorizontalShift - 1),
+                      1 << (kHorizontalShift - 1), 1 << (kHorizontalShift - 1)};
+    for (size_t k = 0; k < taps; k++) {
+      const int32_t w = c.weights[k];
+      acc[0] += p[k * 4 + 0] * w;
+      acc[1] += p[k * 4 + 1] * w;
+      acc[2] += p[k * 4 + 2] * w;
+      acc[3] += p[k * 4 + 3] * w;
+    }
+    for (int ch = 0; ch < 4; ch++) dst[x * 4 + ch] = ClampByte(acc[ch] >> kHorizontalShift);
+#endif
+  }
+}
+
+void ScaleRows(const uint8_t* src,
+               size_t src_stride,
+               int src_w,
+               const std::vector<Contribution>& cols,
+               const std::vector<Contribution>& rows,
+               int row_begin,
+               int row_end,
+               uint8_t* out) {
+  const size_t src_bytes = static_cast<size_t>(src_w) * 4;
+  const size_t dst_row = cols.size() * 4;
+  std::vector<int16_t> mid(src_bytes);
+  for (int y = row_begin; y < row_end; y++) {
+    VerticalPass(src, src_stride, rows[static_cast<size_t>(y)], src_bytes, mid.data());
+    HorizontalPass(mid.data(), cols, out + static_cast<size_t>(y) * dst_row);
+  }
+}
+
+int PickThreadCount(int requested, int dst_h) {
+  int threads = requested;
+  if (threads <= 0) {
+    const unsigned hw = std::thread::hardware_concurrency();
+    threads = (std::min)(kMaxAutoThreads, hw == 0 ? 1 : static_cast<int>(hw));
+  }
+  return (std::max)(1, (std::min)(threads, dst_h / kMinRowsPerBand));
+}
+
+}  // namespace
+
+void FitWithin(int src_w, int src_h, int max_w, int max_h, int& out_w, int& out_h) {
+  if (src_w <= 0 || src_h <= 0) {
+    out_w = out_h = 0;
+    return;
+  }
+  if (max_w <= 0) max_w = src_w;
+  if (max_h <= 0) max_h = src_h;
+  double scale = 1.0;
+  if (src_w > max_w || src_h > max_h) {
+    const double sx = static_cast<double>(max_w) / static_cast<double>(src_w);
+    const double sy = static_cast<double>(max_h) / static_cast<double>(src_h);
+    scale = sx < sy ? sx : sy;
+  }
+  out_w = (std::max)(1, static_cast<int>(std::lround(src_w * scale)));
+  out_h = (std::max)(1, static_cast<int>(std::lround(src_h * scale)));
+  out_w = (std::min)(out_w, src_w);
+  out_h = (std::min)(out_h, src_h);
+}
+
+bool ScaleBgra(const uint8_t* src,
+               int src_w,
+               int src_h,
+               size_t src_stride,
+               int dst_w,
+               int dst_h,
+               ScaleFilter filter,
+               std::vector<uint8_t>& out,
+               int threads) {
+  if (!src || src_w <= 0 || src_h <= 0 || dst_w <= 0 || dst_h <= 0) return false;
+  if (src_stride == 0) src_stride = static_cast<size_t>(src_w) * 4;
+
+  out.resize(static_cast<size_t>(dst_w) * 4 * static_cast<size_t>(dst_h));
+
+  const auto cols = BuildContributions(src_w, dst_w, filter);
+  const auto rows = BuildContributions(src_h, dst_h, filter);
+
+  const int bands = PickThreadCount(threads, dst_h);
+  if (bands <= 1) {
+    ScaleRows(src, src_stride, src_w, cols, rows, 0, dst_h, out.data());
+    return true;
+  }
+
+  // Bands write disjoint output rows; the caller's thread takes the last one.
+  std::vector<std::thread> workers;
+  workers.reserve(static_cast<size_t>(bands - 1));
+  const int per_band = (dst_h + bands - 1) / bands;
+  for (int b = 0; b + 1 < bands; b++) {
+    const int begin = b * per_band;
+    const int end = (std::min)(dst_h, begin + per_band);
+    workers.emplace_back([&, begin, end]() {
+      ScaleRows(src, src_stride, src_w, cols, rows, begin, end, out.data());
+    });
+  }
+  ScaleRows(src, src_stride, src_w, cols, rows, (bands - 1) * per_band, dst_h, out.data());
+  for (auto& worker : workers) worker.join();
+  return true;
+}
+
+bool ScaleBgraBox(const uint8_t* src,
+                  int src_w,
+                  int src_h,
+                  size_t src_stride,
+                  int dst_w,
+                  int dst_h,
+                  std::vector<uint8_t>& out) {
+  return ScaleBgra(src, src_w, src_h, src_stride, dst_w, dst_h, ScaleFilter::kBox, out, 1);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Largest size with the source aspect ratio that fits in max_w x max_h
+// (<= 0 means unbounded). Never upscales; never returns 0.
+void FitWithin(int src_w, int src_h, int max_w, int max_h, int& out_w, int& out_h);
+
+enum class ScaleFilter {
+  // Exact coverage-weighted mean of the source pixels under each output
+  // pixel; closest to GDI HALFTONE.
+  kBox,
+  // Triangle kernel, widened by the scale factor when downscaling.
+  kBilinear,
+  // Sharper windowed sinc (3 lobes); may ring slightly on hard edges.
+  kLanczos3,
+};
+
+// Separable BGRA resampler (platform-neutral, SSE2 when available).
+//
+// Coefficient tables for both axes are built once per call, in 14-bit fixed
+// point; the vertical pass writes a 16-bit intermediate row and the
+// horizontal pass produces the output, so results are identical with and
+// without SIMD. |src_stride| is bytes per source row (0 = src_w * 4).
+// Output rows are split into bands across |threads| threads (<= 0 picks a
+// count from the output size). Replaces |out| with tightly packed
+// dst_w x dst_h BGRA.
+bool ScaleBgra(const uint8_t* src,
+               int src_w,
+               int src_h,
+               size_t src_stride,
+               int dst_w,
+               int dst_h,
+               ScaleFilter filter,
+               std::vector<uint8_t>& out,
+               int threads = 1);
+
+// ScaleBgra with ScaleFilter::kBox on the calling thread.
+bool ScaleBgraBox(const uint8_t* src,
+                  int src_w,
+                  int src_h,
+                  size_t src_stride,
+                  int dst_w,
+                  int dst_h,
+                  std::vector<uint8_t>& out);
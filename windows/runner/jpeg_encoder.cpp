@@ -0,0 +1,321 @@
+#include "jpeg_encoder.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr uint8_t kZigZag[64] = {0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18,
+                                 11, 4,  5,  12, 19, 26, 33, 40, 48, 41, 34, 27, 20,
+                                 13, 6,  7,  14, 21, 28, 35, 42, 49, 56, 57, 50, 43,
+                                 36, 29, 22, 15, 23, 30, 37, 44, 51, 58, 59, 52, 45,
+                                 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+// Annex K.1, natural (row-major) order.
+constexpr uint8_t kLumaQuant[64] = {16, 11, 10, 16, 24,  40,  51,  61,  12, 12, 14, 19, 26,
+                                    58, 60, 55, 14, 13,  16,  24,  40,  57, 69, 56, 14, 17,
+                                    22, 29, 51, 87, 80,  62,  18,  22,  37, 56, 68, 109, 103,
+                                    77, 24, 35, 55, 64,  81,  104, 113, 92, 49, 64, 78, 87,
+                                    103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99};
+constexpr uint8_t kChromaQuant[64] = {17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99,
+                                      99, 99, 99, 24, 26, 56, 99, 99, 99, 99, 99, 47, 66,
+                                      99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+                                      99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+                                      99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99};
+
+// Annex K.3 Huffman tables: code counts per length 1..16, then symbols.
+constexpr uint8_t kDcLumaBits[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+constexpr uint8_t kDcChromaBits[16] = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+constexpr uint8_t kDcValues[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+constexpr uint8_t kAcLumaBits[16] = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+constexpr uint8_t kAcLumaValues[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51,
+    0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1,
+    0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18,
+    0x19, 0x1a, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39,
+    0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57,
+    0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75,
+    0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x92,
+    0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8,
+    0xd9, 0xda, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2,
+    0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa};
+constexpr uint8_t kAcChromaBits[16] = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+constexpr uint8_t kAcChromaValues[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07,
+    0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09,
+    0x23, 0x33, 0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25,
+    0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38,
+    0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56,
+    0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74,
+    0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba,
+    0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6,
+    0xd7, 0xd8, 0xd9, 0xda, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2,
+    0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa};
+
+struct HuffmanTable {
+  uint16_t code[256] = {};
+  uint8_t length[256] = {};
+};
+
+HuffmanTable BuildTable(const uint8_t bits[16], const uint8_t* values) {
+  HuffmanTable table;
+  uint16_t code = 0;
+  int k = 0;
+  for (int len = 1; len <= 16; len++) {
+    for (int i = 0; i < bits[len - 1]; i++) {
+      table.code[values[k]] = code++;
+      table.length[values[k]] = static_cast<uint8_t>(len);
+      k++;
+    }
+    code = static_cast<uint16_t>(code << 1);
+  }
+  return table;
+}
+
+class JpegBitWriter {
+ public:
+  explicit JpegBitWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+  // MSB-first with 0xFF byte stuffing.
+  void Put(uint32_t bits, int count) {
+    buffer_ = (buffer_ << count) | (bits & ((1u << count) - 1));
+    filled_ += count;
+    while (filled_ >= 8) {
+      const uint8_t byte = static_cast<uint8_t>(buffer_ >> (filled_ - 8));
+      out_.push_back(byte);
+      if (byte == 0xFF) out_.push_back(0);
+      filled_ -= 8;
+    }
+  }
+
+  void Flush() {
+    if (filled_ > 0) Put(0x7F, 8 - filled_);  // pad with 1-bits
+  }
+
+ private:
+  std::vector<uint8_t>& out_;
+  uint32_t buffer_ = 0;
+  int filled_ = 0;
+};
+
+void PutMarker(std::vector<uint8_t>& out, uint8_t marker) {
+  out.push_back(0xFF);
+  out.push_back(marker);
+}
+
+void PutU16(std::vector<uint8_t>& out, uint32_t v) {
+  out.push_back(static_cast<uint8_t>(v >> 8));
+  out.push_back(static_cast<uint8_t>(v));
+}
+
+void BuildQuant(const uint8_t* base, int quality, uint8_t* out) {
+  quality = (std::max)(1, (std::min)(100, quality));
+  const int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+  for (int i = 0; i < 64; i++) {
+    const int q = (base[i] * scale + 50) / 100;
+    out[i] = static_cast<uint8_t>((std::max)(1, (std::min)(255, q)));
+  }
+}
+
+// Separable float DCT-II on an 8x8 block of level-shifted samples.
+class Dct8x8 {
+ public:
+  Dct8x8() {
+    const double pi = 3.14159265358979323846;
+    for (int u = 0; u < 8; u++) {
+      const double cu = u == 0 ? std::sqrt(0.125) : 0.5;
+      for (int x = 0; x < 8; x++) {
+        basis_[u][x] = static_cast<float>(cu * std::cos((2.0 * x + 1.0) * u * pi / 16.0));
+      }
+    }
+  }
+
+  void Forward(const float in[64], float out[64]) const {
+    float tmp[64];
+    for (int y = 0; y < 8; y++) {
+      for (int u = 0; u < 8; u++) {
+        float s = 0.0f;
+        for (int x = 0; x < 8; x++) s += basis_[u][x] * in[y * 8 + x];
+        tmp[y * 8 + u] = s;
+      }
+    }
+    for (int u = 0; u < 8; u++) {
+      for (int v = 0; v < 8; v++) {
+        float s = 0.0f;
+        for (int y = 0; y < 8; y++) s += basis_[v][y] * tmp[y * 8 + u];
+        out[v * 8 + u] = s;
+      }
+    }
+  }
+
+ private:
+  float basis_[8][8];
+};
+
+int BitLength(int v) {
+  int n = 0;
+  for (unsigned a = static_cast<unsigned>(v < 0 ? -v : v); a; a >>= 1) n++;
+  return n;
+}
+
+void EncodeBlock(const float block[64],
+                 const uint8_t quant[64],
+                 const Dct8x8& dct,
+                 const HuffmanTable& dc,
+                 const HuffmanTable& ac,
+                 int& prev_dc,
+                 JpegBitWriter& writer) {
+  float coef[64];
+  dct.Forward(block, coef);
+  int q[64];
+  for (int k = 0; k < 64; k++) {
+    const int n = kZigZag[k];
+    q[k] = static_cast<int>(std::lround(coef[n] / quant[n]));
+  }
+
+  const int diff = q[0] - prev_dc;
+  prev_dc = q[0];
+  const int dc_size = BitLength(diff);
+  writer.Put(dc.code[dc_size], dc.length[dc_size]);
+  if (dc_size) writer.Put(static_cast<uint32_t>(diff < 0 ? diff - 1 : diff), dc_size);
+
+  int run = 0;
+  for (int k = 1; k < 64; k++) {
+    if (q[k] == 0) {
+      run++;
+      continue;
+    }
+    while (run >= 16) {
+      writer.Put(ac.code[0xF0], ac.length[0xF0]);
+      run -= 16;
+    }
+    const int size = BitLength(q[k]);
+    const int symbol = (run << 4) | size;
+    writer.Put(ac.code[symbol], ac.length[symbol]);
+    writer.Put(static_cast<uint32_t>(q[k] < 0 ? q[k] - 1 : q[k]), size);
+    run = 0;
+  }
+  if (run > 0) writer.Put(ac.code[0x00], ac.length[0x00]);
+}
+
+void WriteHuffmanSegment(std::vector<uint8_t>& out,
+                         uint8_t table_class_id,
+                         const uint8_t bits[16],
+                         const uint8_t* values,
+                         size_t count) {
+  PutMarker(out, 0xC4);
+  PutU16(out, static_cast<uint32_t>(2 + 1 + 16 + count));
+  out.push_back(table_class_id);
+  out.insert(out.end(), bits, bits + 16);
+  out.insert(out.end(), values, values + count);
+}
+
+}  // namespace
+
+bool EncodeJpegBgra(const uint8_t* bgra,
+                    int width,
+                    int height,
+                    size_t stride,
+                    int quality,
+                    std::vector<uint8_t>& out) {
+  out.clear();
+  if (!bgra || width <= 0 || height <= 0 || width > 65535 || height > 65535) return false;
+  if (stride == 0) stride = static_cast<size_t>(width) * 4;
+
+  uint8_t luma_q[64];
+  uint8_t chroma_q[64];
+  BuildQuant(kLumaQuant, quality, luma_q);
+  BuildQuant(kChromaQuant, quality, chroma_q);
+
+  static const HuffmanTable dc_luma = BuildTable(kDcLumaBits, kDcValues);
+  static const HuffmanTable dc_chroma = BuildTable(kDcChromaBits, kDcValues);
+  static const HuffmanTable ac_luma = BuildTable(kAcLumaBits, kAcLumaValues);
+  static const HuffmanTable ac_chroma = BuildTable(kAcChromaBits, kAcChromaValues);
+  static const Dct8x8 dct;
+
+  out.reserve(static_cast<size_t>(width) * static_cast<size_t>(height) / 4 + 1024);
+
+  PutMarker(out, 0xD8);  // SOI
+  PutMarker(out, 0xE0);  // APP0 JFIF 1.01, no density
+  PutU16(out, 16);
+  static const uint8_t kJfif[] = {'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0};
+  out.insert(out.end(), kJfif, kJfif + sizeof(kJfif));
+
+  PutMarker(out, 0xDB);  // DQT, both tables, zigzag order
+  PutU16(out, 2 + 2 * 65);
+  out.push_back(0);
+  for (int k = 0; k < 64; k++) out.push_back(luma_q[kZigZag[k]]);
+  out.push_back(1);
+  for (int k = 0; k < 64; k++) out.push_back(chroma_q[kZigZag[k]]);
+
+  PutMarker(out, 0xC0);  // SOF0
+  PutU16(out, 17);
+  out.push_back(8);
+  PutU16(out, static_cast<uint32_t>(height));
+  PutU16(out, static_cast<uint32_t>(width));
+  out.push_back(3);
+  static const uint8_t kComponents[] = {1, 0x22, 0, 2, 0x11, 1, 3, 0x11, 1};
+  out.insert(out.end(), kComponents, kComponents + sizeof(kComponents));
+
+  WriteHuffmanSegment(out, 0x00, kDcLumaBits, kDcValues, sizeof(kDcValues));
+  WriteHuffmanSegment(out, 0x10, kAcLumaBits, kAcLumaValues, sizeof(kAcLumaValues));
+  WriteHuffmanSegment(out, 0x01, kDcChromaBits, kDcValues, sizeof(kDcValues));
+  WriteHuffmanSegment(out, 0x11, kAcChromaBits, kAcChromaValues, sizeof(kAcChromaValues));
+
+  PutMarker(out, 0xDA);  // SOS
+  PutU16(out, 12);
+  out.push_back(3);
+  static const uint8_t kScan[] = {1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0};
+  out.insert(out.end(), kScan, kScan + sizeof(kScan));
+
+  JpegBitWriter writer(out);
+  int prev_y = 0;
+  int prev_cb = 0;
+  int prev_cr = 0;
+  float y_blocks[4][64];
+  float cb_block[64];
+  float cr_block[64];
+
+  for (int my = 0; my < height; my += 16) {
+    for (int mx = 0; mx < width; mx += 16) {
+      float cb_full[16 * 16];
+      float cr_full[16 * 16];
+      for (int py = 0; py < 16; py++) {
+        // Edge MCUs replicate the last row/column.
+        const int sy = (std::min)(my + py, height - 1);
+        const uint8_t* row = bgra + static_cast<size_t>(sy) * stride;
+        for (int px = 0; px < 16; px++) {
+          const int sx = (std::min)(mx + px, width - 1);
+          const float b = row[sx * 4 + 0];
+          const float g = row[sx * 4 + 1];
+          const float r = row[sx * 4 + 2];
+          const int block = (py >> 3) * 2 + (px >> 3);
+          y_blocks[block][(py & 7) * 8 + (px & 7)] = 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+          cb_full[py * 16 + px] = -0.168736f * r - 0.331264f * g + 0.5f * b;
+          cr_full[py * 16 + px] = 0.5f * r - 0.418688f * g - 0.081312f * b;
+        }
+      }
+      for (int cy = 0; cy < 8; cy++) {
+        for (int cx = 0; cx < 8; cx++) {
+          const int i = cy * 2 * 16 + cx * 2;
+          cb_block[cy * 8 + cx] =
+              0.25f * (cb_full[i] + cb_full[i + 1] + cb_full[i + 16] + cb_full[i + 17]);
+          cr_block[cy * 8 + cx] =
+              0.25f * (cr_full[i] + cr_full[i + 1] + cr_full[i + 16] + cr_full[i + 17]);
+        }
+      }
+      for (int b = 0; b < 4; b++) {
+        EncodeBlock(y_blocks[b], luma_q, dct, dc_luma, ac_luma, prev_y, writer);
+      }
+      EncodeBlock(cb_block, chroma_q, dct, dc_chroma, ac_chroma, prev_cb, writer);
+      EncodeBlock(cr_block, chroma_q, dct, dc_chroma, ac_chroma, prev_cr, writer);
+    }
+  }
+  writer.Flush();
+  PutMarker(out, 0xD9);  // EOI
+  return true;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Baseline JFIF encoder for top-down BGRA (alpha ignored): YCbCr 4:2:0,
+// Annex K quantization tables scaled IJG-style by |quality| (1..100) and the
+// standard Huffman tables. |stride| is bytes per source row (0 = width * 4).
+// Replaces |out|.
+bool EncodeJpegBgra(const uint8_t* bgra,
+                    int width,
+                    int height,
+                    size_t stride,
+                    int quality,
+                    std::vector<uint8_t>& out);
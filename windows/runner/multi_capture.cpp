@@ -0,0 +1,86 @@
+#include "multi_capture.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+void RunParallel(size_t count, size_t threads, const std::function<void(size_t)>& fn) {
+  if (count == 0) return;
+  threads = (std::max)(size_t{1}, (std::min)(threads, count));
+  if (threads == 1) {
+    for (size_t i = 0; i < count; i++) fn(i);
+    return;
+  }
+
+  // Work is claimed one item at a time so a slow monitor doesn't hold up a
+  // fixed share of the others.
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t i = next++; i < count; i = next++) fn(i);
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for (size_t t = 0; t + 1 < threads; t++) workers.emplace_back(worker);
+  worker();
+  for (auto& w : workers) w.join();
+}
+
+int CompositeColumns(size_t count) {
+  if (count <= 1) return 1;
+  return static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
+}
+
+bool ComposeGrid(const std::vector<CompositeSource>& sources,
+                 int columns,
+                 int gap,
+                 std::vector<uint8_t>& out,
+                 int& width,
+                 int& height,
+                 std::vector<CompositePlacement>& placements) {
+  width = 0;
+  height = 0;
+  placements.assign(sources.size(), CompositePlacement());
+  if (sources.empty() || columns <= 0) return false;
+  gap = (std::max)(gap, 0);
+  for (const CompositeSource& s : sources) {
+    if (!s.bgra || s.width <= 0 || s.height <= 0) return false;
+  }
+
+  // Lay out row by row.
+  int y = 0;
+  for (size_t row_start = 0; row_start < sources.size(); row_start += static_cast<size_t>(columns)) {
+    const size_t row_end = (std::min)(sources.size(), row_start + static_cast<size_t>(columns));
+    int x = 0;
+    int row_height = 0;
+    for (size_t i = row_start; i < row_end; i++) {
+      placements[i] = CompositePlacement{x, y, sources[i].width, sources[i].height};
+      x += sources[i].width + gap;
+      row_height = (std::max)(row_height, sources[i].height);
+    }
+    width = (std::max)(width, x - gap);
+    y += row_height + gap;
+  }
+  height = y - gap;
+
+  const size_t stride = static_cast<size_t>(width) * 4u;
+  out.resize(stride * static_cast<size_t>(height));
+  // Opaque black: B, G, R = 0 and A = 255.
+  for (size_t i = 0; i < out.size(); i += 4) {
+    out[i] = 0;
+    out[i + 1] = 0;
+    out[i + 2] = 0;
+    out[i + 3] = 255;
+  }
+  for (size_t i = 0; i < sources.size(); i++) {
+    const CompositeSource& s = sources[i];
+    const CompositePlacement& p = placements[i];
+    const size_t row_bytes = static_cast<size_t>(s.width) * 4u;
+    for (int r = 0; r < s.height; r++) {
+      memcpy(out.data() + static_cast<size_t>(p.y + r) * stride + static_cast<size_t>(p.x) * 4u,
+             s.bgra + static_cast<size_t>(r) * row_bytes, row_bytes);
+    }
+  }
+  return true;
+}
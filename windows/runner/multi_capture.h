@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Runs fn(0) .. fn(count - 1) on up to |threads| threads, the caller's
+// included, and returns when all have finished (platform-neutral). Used to
+// capture and encode several monitors at once instead of one huge
+// virtual-screen grab.
+void RunParallel(size_t count, size_t threads, const std::function<void(size_t)>& fn);
+
+// One image to place on a composite; tightly packed top-down BGRA.
+struct CompositeSource {
+  const uint8_t* bgra = nullptr;
+  int width = 0;
+  int height = 0;
+};
+
+// Where a source landed on the composite.
+struct CompositePlacement {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+};
+
+// Columns ComposeGrid uses for |count| images: ceil(sqrt(count)), so two
+// monitors sit side by side and three or four make a 2x2 grid.
+int CompositeColumns(size_t count);
+
+// Packs |sources| row-major into a grid of |columns|, |gap| pixels apart.
+// Each row is as tall as its tallest image and each image keeps its own
+// width, so monitors of different sizes leave little empty space. The
+// background is opaque black. Replaces |out|; |placements| matches
+// |sources|.
+bool ComposeGrid(const std::vector<CompositeSource>& sources,
+                 int columns,
+                 int gap,
+                 std::vector<uint8_t>& out,
+                 int& width,
+                 int& height,
+                 std::vector<CompositePlacement>& placements);
@@ -0,0 +1,256 @@
+#include "ocr_engine.h"
+
+#include <windows.h>
+#include <MemoryBuffer.h>
+#include <roapi.h>
+#include <winstring.h>
+#include <windows.foundation.h>
+#include <windows.foundation.collections.h>
+#include <windows.globalization.h>
+#include <windows.graphics.imaging.h>
+#include <windows.media.ocr.h>
+#include <wrl/client.h>
+#include <wrl/event.h>
+#include <wrl/wrappers/corewrappers.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <memory>
+
+#include "image_scale.h"
+#include "multi_capture.h"
+
+namespace {
+
+using ABI::Windows::Foundation::AsyncStatus;
+using ABI::Windows::Foundation::IAsyncInfo;
+using ABI::Windows::Foundation::IAsyncOperation;
+using ABI::Windows::Foundation::IAsyncOperationCompletedHandler;
+using ABI::Windows::Foundation::IClosable;
+using ABI::Windows::Foundation::IMemoryBuffer;
+using ABI::Windows::Foundation::IMemoryBufferReference;
+using ABI::Windows::Foundation::Collections::IVectorView;
+using Microsoft::WRL::Callback;
+using Microsoft::WRL::ComPtr;
+using Microsoft::WRL::Wrappers::HString;
+using Microsoft::WRL::Wrappers::HStringReference;
+using Microsoft::WRL::Wrappers::RoInitializeWrapper;
+
+namespace Imaging = ABI::Windows::Graphics::Imaging;
+namespace MediaOcr = ABI::Windows::Media::Ocr;
+
+// Gives up on a band the engine hasn't finished by then.
+constexpr DWORD kRecognizeTimeoutMs = 10000;
+
+std::string Utf8FromHString(HSTRING value) {
+  UINT32 length = 0;
+  const wchar_t* raw = WindowsGetStringRawBuffer(value, &length);
+  if (!raw || length == 0) return std::string();
+  const int size = WideCharToMultiByte(CP_UTF8, 0, raw, static_cast<int>(length), nullptr, 0, nullptr, nullptr);
+  if (size <= 0) return std::string();
+  std::string out(static_cast<size_t>(size), '\0');
+  WideCharToMultiByte(CP_UTF8, 0, raw, static_cast<int>(length), &out[0], size, nullptr, nullptr);
+  return out;
+}
+
+// Opaque BGRA SoftwareBitmap holding |gray|.
+bool CreateGrayBitmap(const std::vector<uint8_t>& gray, int width, int height, ComPtr<Imaging::ISoftwareBitmap>& out) {
+  ComPtr<Imaging::ISoftwareBitmapFactory> factory;
+  HRESULT hr = RoGetActivationFactory(HStringReference(RuntimeClass_Windows_Graphics_Imaging_SoftwareBitmap).Get(),
+                                      IID_PPV_ARGS(&factory));
+  if (FAILED(hr)) return false;
+  ComPtr<Imaging::ISoftwareBitmap> bitmap;
+  hr = factory->CreateWithAlpha(Imaging::BitmapPixelFormat_Bgra8, width, height, Imaging::BitmapAlphaMode_Premultiplied,
+                                &bitmap);
+  if (FAILED(hr)) return false;
+
+  ComPtr<Imaging::IBitmapBuffer> buffer;
+  if (FAILED(bitmap->LockBuffer(Imaging::BitmapBufferAccessMode_Write, &buffer))) return false;
+  Imaging::BitmapPlaneDescription plane{};
+  ComPtr<IMemoryBuffer> memory;
+  ComPtr<IMemoryBufferReference> reference;
+  ComPtr<Windows::Foundation::IMemoryBufferByteAccess> access;
+  BYTE* data = nullptr;
+  UINT32 capacity = 0;
+  bool ok = SUCCEEDED(buffer->GetPlaneDescription(0, &plane)) && SUCCEEDED(buffer.As(&memory)) &&
+            SUCCEEDED(memory->CreateReference(&reference)) && SUCCEEDED(reference.As(&access)) &&
+            SUCCEEDED(access->GetBuffer(&data, &capacity)) && data &&
+            static_cast<uint64_t>(plane.StartIndex) + static_cast<uint64_t>(plane.Stride) * (height - 1) +
+                    static_cast<uint64_t>(width) * 4 <=
+                capacity;
+  if (ok) {
+    for (int y = 0; y < height; y++) {
+      const uint8_t* src = gray.data() + static_cast<size_t>(y) * width;
+      uint8_t* dst = data + plane.StartIndex + static_cast<size_t>(y) * plane.Stride;
+      for (int x = 0; x < width; x++, dst += 4) {
+        dst[0] = dst[1] = dst[2] = src[x];
+        dst[3] = 255;
+      }
+    }
+  }
+  ComPtr<IClosable> closable;
+  if (reference && SUCCEEDED(reference.As(&closable))) closable->Close();
+  if (SUCCEEDED(buffer.As(&closable))) closable->Close();
+  if (ok) out = bitmap;
+  return ok;
+}
+
+// Runs RecognizeAsync to completion on the calling thread.
+bool Recognize(MediaOcr::IOcrEngine* engine, Imaging::ISoftwareBitmap* bitmap, ComPtr<MediaOcr::IOcrResult>& out) {
+  ComPtr<IAsyncOperation<MediaOcr::OcrResult*>> operation;
+  if (FAILED(engine->RecognizeAsync(bitmap, &operation))) return false;
+  // Shared with the completion handler, which may still run after a timeout.
+  std::shared_ptr<void> done(CreateEventW(nullptr, TRUE, FALSE, nullptr), [](HANDLE h) {
+    if (h) CloseHandle(h);
+  });
+  if (!done.get()) return false;
+  HRESULT hr = operation->put_Completed(
+      Callback<IAsyncOperationCompletedHandler<MediaOcr::OcrResult*>>(
+          [done](IAsyncOperation<MediaOcr::OcrResult*>*, AsyncStatus) -> HRESULT {
+            SetEvent(done.get());
+            return S_OK;
+          })
+          .Get());
+  if (FAILED(hr)) return false;
+  ComPtr<IAsyncInfo> info;
+  if (WaitForSingleObject(done.get(), kRecognizeTimeoutMs) != WAIT_OBJECT_0) {
+    if (SUCCEEDED(operation.As(&info))) info->Cancel();
+    return false;
+  }
+  AsyncStatus status = AsyncStatus::Error;
+  if (FAILED(operation.As(&info)) || FAILED(info->get_Status(&status)) || status != AsyncStatus::Completed) {
+    return false;
+  }
+  return SUCCEEDED(operation->GetResults(&out)) && out;
+}
+
+// Appends the lines of |result| for a band at (left, top), scaled by |scale|
+// back to image pixels.
+void CollectLines(MediaOcr::IOcrResult* result, int left, int top, double scale, std::vector<OcrLineBox>& out) {
+  ComPtr<IVectorView<MediaOcr::OcrLine*>> lines;
+  unsigned line_count = 0;
+  if (FAILED(result->get_Lines(&lines)) || FAILED(lines->get_Size(&line_count))) return;
+  for (unsigned i = 0; i < line_count; i++) {
+    ComPtr<MediaOcr::IOcrLine> line;
+    if (FAILED(lines->GetAt(i, &line))) continue;
+    OcrLineBox box;
+    HString text;
+    if (SUCCEEDED(line->get_Text(text.GetAddressOf()))) box.text = Utf8FromHString(text.Get());
+    ComPtr<IVectorView<MediaOcr::OcrWord*>> words;
+    unsigned word_count = 0;
+    if (SUCCEEDED(line->get_Words(&words)) && SUCCEEDED(words->get_Size(&word_count))) {
+      int x0 = INT_MAX, y0 = INT_MAX, x1 = INT_MIN, y1 = INT_MIN;
+      for (unsigned j = 0; j < word_count; j++) {
+        ComPtr<MediaOcr::IOcrWord> word;
+        ABI::Windows::Foundation::Rect rect{};
+        if (FAILED(words->GetAt(j, &word)) || FAILED(word->get_BoundingRect(&rect))) continue;
+        OcrWordBox w;
+        HString word_text;
+        if (SUCCEEDED(word->get_Text(word_text.GetAddressOf()))) w.text = Utf8FromHString(word_text.Get());
+        w.x = left + static_cast<int>(std::floor(rect.X * scale));
+        w.y = top + static_cast<int>(std::floor(rect.Y * scale));
+        w.width = static_cast<int>(std::ceil(rect.Width * scale));
+        w.height = static_cast<int>(std::ceil(rect.Height * scale));
+        x0 = (std::min)(x0, w.x);
+        y0 = (std::min)(y0, w.y);
+        x1 = (std::max)(x1, w.x + w.width);
+        y1 = (std::max)(y1, w.y + w.height);
+        box.words.push_back(std::move(w));
+      }
+      if (!box.words.empty()) {
+        box.x = x0;
+        box.y = y0;
+        box.width = x1 - x0;
+        box.height = y1 - y0;
+      }
+    }
+    if (!box.text.empty()) out.push_back(std::move(box));
+  }
+}
+
+}  // namespace
+
+bool RecognizeOcrBands(const OcrLayout& layout, int width, int threads, OcrText& out, std::string& error) {
+  out = OcrText{};
+  RoInitializeWrapper init(RO_INIT_MULTITHREADED);
+  if (FAILED(init) && static_cast<HRESULT>(init) != RPC_E_CHANGED_MODE) {
+    error = "Failed to initialize the Windows Runtime.";
+    return false;
+  }
+
+  ComPtr<MediaOcr::IOcrEngineStatics> statics;
+  if (FAILED(RoGetActivationFactory(HStringReference(RuntimeClass_Windows_Media_Ocr_OcrEngine).Get(),
+                                    IID_PPV_ARGS(&statics)))) {
+    error = "Windows OCR is not available.";
+    return false;
+  }
+  // OcrEngine is agile, so one instance serves every band worker.
+  ComPtr<MediaOcr::IOcrEngine> engine;
+  if (FAILED(statics->TryCreateFromUserProfileLanguages(&engine)) || !engine) {
+    error = "No OCR language is installed for the user's languages.";
+    return false;
+  }
+  UINT32 max_dimension = 0;
+  statics->get_MaxImageDimension(&max_dimension);
+  if (max_dimension == 0) max_dimension = 2600;
+
+  ComPtr<ABI::Windows::Globalization::ILanguage> language;
+  HString tag;
+  if (SUCCEEDED(engine->get_RecognizerLanguage(&language)) && language &&
+      SUCCEEDED(language->get_LanguageTag(tag.GetAddressOf()))) {
+    out.language = Utf8FromHString(tag.Get());
+  }
+
+  // Bands are planned top to bottom, so concatenating them keeps reading
+  // order.
+  const size_t count = layout.bands.size();
+  std::vector<std::vector<OcrLineBox>> band_lines(count);
+  std::vector<char> band_ok(count, 0);
+  RunParallel(count, static_cast<size_t>((std::max)(1, threads)), [&](size_t i) {
+    RoInitializeWrapper band_init(RO_INIT_MULTITHREADED);
+    const OcrBand& band = layout.bands[i];
+    std::vector<uint8_t> gray;
+    ExtractOcrBand(layout.luma.data(), width, band, gray);
+
+    int w = band.width, h = band.height;
+    double scale = 1.0;
+    if (static_cast<UINT32>((std::max)(w, h)) > max_dimension) {
+      const double factor = static_cast<double>(max_dimension) / (std::max)(w, h);
+      const int sw = (std::max)(1, static_cast<int>(w * factor));
+      const int sh = (std::max)(1, static_cast<int>(h * factor));
+      std::vector<uint8_t> bgra(static_cast<size_t>(w) * h * 4);
+      for (size_t p = 0; p < gray.size(); p++) {
+        bgra[p * 4] = bgra[p * 4 + 1] = bgra[p * 4 + 2] = gray[p];
+        bgra[p * 4 + 3] = 255;
+      }
+      std::vector<uint8_t> scaled;
+      if (!ScaleBgraBox(bgra.data(), w, h, 0, sw, sh, scaled)) return;
+      gray.resize(static_cast<size_t>(sw) * sh);
+      for (size_t p = 0; p < gray.size(); p++) gray[p] = scaled[p * 4 + 1];
+      scale = static_cast<double>(w) / sw;
+      w = sw;
+      h = sh;
+    }
+
+    ComPtr<Imaging::ISoftwareBitmap> bitmap;
+    ComPtr<MediaOcr::IOcrResult> result;
+    if (!CreateGrayBitmap(gray, w, h, bitmap) || !Recognize(engine.Get(), bitmap.Get(), result)) return;
+    CollectLines(result.Get(), band.x, band.y, scale, band_lines[i]);
+    band_ok[i] = 1;
+    ComPtr<IClosable> closable;
+    if (SUCCEEDED(bitmap.As(&closable))) closable->Close();
+  });
+
+  bool any_ok = count == 0;
+  for (size_t i = 0; i < count; i++) {
+    if (!band_ok[i]) continue;
+    any_ok = true;
+    for (OcrLineBox& line : band_lines[i]) out.lines.push_back(std::move(line));
+  }
+  if (!any_ok) {
+    error = "Text recognition failed.";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ocr_layout.h"
+
+struct OcrWordBox {
+  std::string text;
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+};
+
+struct OcrLineBox {
+  std::string text;
+  // Union of the words' boxes.
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+  std::vector<OcrWordBox> words;
+};
+
+struct OcrText {
+  // Lines top to bottom, boxes in image pixels.
+  std::vector<OcrLineBox> lines;
+  // BCP-47 tag of the recognizer language.
+  std::string language;
+};
+
+// On-device text recognition with Windows.Media.Ocr (CPU, no network).
+//
+// Each band of |layout| is recognized separately, on up to |threads|
+// workers, and the results are put back in image coordinates. Bands wider
+// than the engine's limit are downscaled first. Callable from any non-STA
+// thread. Returns false with |error| set when no OCR language is installed
+// or the engine fails.
+bool RecognizeOcrBands(const OcrLayout& layout, int width, int threads, OcrText& out, std::string& error);
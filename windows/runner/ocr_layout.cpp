@@ -0,0 +1,263 @@
+#include "ocr_layout.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "multi_capture.h"
+
+namespace {
+
+// Around two lines of typical UI text; wide enough that a glyph's interior
+// still sees the surrounding background.
+constexpr int kSauvolaWindow = 31;
+constexpr double kSauvolaK = 0.2;
+
+// Neighbourhood (in Sauvola windows) whose mean decides the local polarity.
+constexpr int kPolarityScale = 4;
+
+// Bands darker than this on average are treated as light-on-dark.
+constexpr int kDarkBandMean = 100;
+
+// Vertical ink runs longer than this are borders and rules, not glyphs.
+constexpr int kMaxGlyphHeight = 96;
+
+}  // namespace
+
+void LumaPlane(const uint8_t* bgra, int width, int height, size_t stride, std::vector<uint8_t>& out) {
+  const size_t row_bytes = stride ? stride : static_cast<size_t>(width) * 4;
+  out.resize(static_cast<size_t>(width) * height);
+  for (int y = 0; y < height; y++) {
+    const uint8_t* src = bgra + y * row_bytes;
+    uint8_t* dst = out.data() + static_cast<size_t>(y) * width;
+    for (int x = 0; x < width; x++, src += 4) {
+      dst[x] = static_cast<uint8_t>((29 * src[0] + 150 * src[1] + 77 * src[2] + 128) >> 8);
+    }
+  }
+}
+
+void BinarizeSauvola(const uint8_t* luma,
+                     int width,
+                     int height,
+                     int window,
+                     double k,
+                     int threads,
+                     std::vector<uint8_t>& out) {
+  out.assign(static_cast<size_t>(width) * height, 255);
+  if (width <= 0 || height <= 0) return;
+
+  // Integral images of values and squares, one extra leading row/column.
+  const size_t iw = static_cast<size_t>(width) + 1;
+  std::vector<uint32_t> sum(iw * (height + 1), 0);
+  std::vector<uint64_t> sq(iw * (height + 1), 0);
+  for (int y = 0; y < height; y++) {
+    uint32_t row_sum = 0;
+    uint64_t row_sq = 0;
+    const uint8_t* src = luma + static_cast<size_t>(y) * width;
+    for (int x = 0; x < width; x++) {
+      row_sum += src[x];
+      row_sq += static_cast<uint64_t>(src[x]) * src[x];
+      sum[(y + 1) * iw + x + 1] = sum[y * iw + x + 1] + row_sum;
+      sq[(y + 1) * iw + x + 1] = sq[y * iw + x + 1] + row_sq;
+    }
+  }
+
+  const int radius = (std::max)(1, window / 2);
+  const int polarity_radius = radius * kPolarityScale;
+  auto box_sum = [&](int x0, int y0, int x1, int y1) {
+    return sum[y1 * iw + x1] - sum[y0 * iw + x1] - sum[y1 * iw + x0] + sum[y0 * iw + x0];
+  };
+  const int bands = (std::max)(1, threads);
+  const int rows_per_band = (height + bands - 1) / bands;
+  RunParallel(static_cast<size_t>(bands), static_cast<size_t>(bands), [&](size_t band) {
+    const int y_begin = static_cast<int>(band) * rows_per_band;
+    const int y_end = (std::min)(height, y_begin + rows_per_band);
+    for (int y = y_begin; y < y_end; y++) {
+      const int y0 = (std::max)(0, y - radius);
+      const int y1 = (std::min)(height, y + radius + 1);
+      const uint8_t* src = luma + static_cast<size_t>(y) * width;
+      uint8_t* dst = out.data() + static_cast<size_t>(y) * width;
+      for (int x = 0; x < width; x++) {
+        const int x0 = (std::max)(0, x - radius);
+        const int x1 = (std::min)(width, x + radius + 1);
+        const double area = static_cast<double>((x1 - x0) * (y1 - y0));
+        const double s = static_cast<double>(box_sum(x0, y0, x1, y1));
+        const double s2 =
+            static_cast<double>(sq[y1 * iw + x1] - sq[y0 * iw + x1] - sq[y1 * iw + x0] + sq[y0 * iw + x0]);
+        double mean = s / area;
+        const double stddev = std::sqrt((std::max)(0.0, s2 / area - mean * mean));
+        // Light text on a dark background: threshold the inverted pixel, so
+        // ink is always the glyphs rather than the background around them.
+        const int px0 = (std::max)(0, x - polarity_radius), px1 = (std::min)(width, x + polarity_radius + 1);
+        const int py0 = (std::max)(0, y - polarity_radius), py1 = (std::min)(height, y + polarity_radius + 1);
+        const bool dark = box_sum(px0, py0, px1, py1) < static_cast<uint32_t>(128 * (px1 - px0) * (py1 - py0));
+        double value = src[x];
+        if (dark) {
+          mean = 255.0 - mean;
+          value = 255.0 - value;
+        }
+        const double threshold = mean * (1.0 + k * (stddev / 128.0 - 1.0));
+        if (value < threshold) dst[x] = 0;
+      }
+    }
+  });
+}
+
+std::vector<TextLine> FindTextLines(const uint8_t* binary, int width, int height) {
+  std::vector<TextLine> lines;
+  if (width <= 0 || height <= 0) return lines;
+  const int min_ink = (std::max)(2, width / 400);
+
+  // Window borders and panel edges run through every row and would chain
+  // all lines together; drop vertical runs taller than any glyph.
+  std::vector<int> run(static_cast<size_t>(width), 0);
+  std::vector<uint8_t> ink_map(static_cast<size_t>(width) * height, 0);
+  for (int y = 0; y <= height; y++) {
+    const uint8_t* row = y < height ? binary + static_cast<size_t>(y) * width : nullptr;
+    for (int x = 0; x < width; x++) {
+      if (row && row[x] == 0) {
+        run[x]++;
+        continue;
+      }
+      if (run[x] > 0 && run[x] <= kMaxGlyphHeight) {
+        for (int r = y - run[x]; r < y; r++) ink_map[static_cast<size_t>(r) * width + x] = 1;
+      }
+      run[x] = 0;
+    }
+  }
+
+  TextLine current;
+  int left = width, right = -1;
+  bool open = false;
+  int blank_run = 0;
+  auto close = [&](int end) {
+    const int h = end - current.y;
+    if (h >= 3 && right >= left) {
+      current.height = h;
+      current.x = left;
+      current.width = right - left + 1;
+      lines.push_back(current);
+    }
+    open = false;
+    left = width;
+    right = -1;
+  };
+
+  for (int y = 0; y < height; y++) {
+    const uint8_t* row = ink_map.data() + static_cast<size_t>(y) * width;
+    int ink = 0, first = -1, last = -1;
+    for (int x = 0; x < width; x++) {
+      if (row[x] != 0) {
+        if (first < 0) first = x;
+        last = x;
+        ink++;
+      }
+    }
+    if (ink >= min_ink) {
+      if (!open) {
+        current = TextLine{};
+        current.y = y;
+        open = true;
+      }
+      left = (std::min)(left, first);
+      right = (std::max)(right, last);
+      blank_run = 0;
+    } else if (open && ++blank_run > 1) {
+      close(y - blank_run + 1);
+    }
+  }
+  if (open) close(height - blank_run);
+  return lines;
+}
+
+std::vector<OcrBand> PlanOcrBands(const std::vector<TextLine>& lines,
+                                  const uint8_t* luma,
+                                  int width,
+                                  int height,
+                                  int max_height,
+                                  int target_bands) {
+  std::vector<OcrBand> bands;
+  if (lines.empty() || width <= 0 || height <= 0) return bands;
+  max_height = (std::max)(16, max_height);
+
+  // Pad each line so descenders and antialiasing aren't clipped; split
+  // anything taller than a band.
+  std::vector<TextLine> padded;
+  int text_rows = 0;
+  for (const TextLine& line : lines) {
+    const int pad = (std::min)(8, (std::max)(2, line.height / 3));
+    const int x0 = (std::max)(0, line.x - pad);
+    const int x1 = (std::min)(width, line.x + line.width + pad);
+    const int y0 = (std::max)(0, line.y - pad);
+    const int y1 = (std::min)(height, line.y + line.height + pad);
+    for (int y = y0; y < y1; y += max_height) {
+      TextLine piece;
+      piece.x = x0;
+      piece.width = x1 - x0;
+      piece.y = y;
+      piece.height = (std::min)(max_height, y1 - y);
+      padded.push_back(piece);
+      text_rows += piece.height;
+    }
+  }
+
+  const int target =
+      (std::min)(max_height, (std::max)(48, (text_rows + (std::max)(1, target_bands) - 1) / (std::max)(1, target_bands)));
+  const int max_gap = target / 2;
+  OcrBand band;
+  bool open = false;
+  for (const TextLine& line : padded) {
+    const int bottom = line.y + line.height;
+    if (open && bottom - band.y <= target && line.y - (band.y + band.height) <= max_gap) {
+      const int x0 = (std::min)(band.x, line.x);
+      const int x1 = (std::max)(band.x + band.width, line.x + line.width);
+      band.x = x0;
+      band.width = x1 - x0;
+      band.height = (std::max)(band.height, bottom - band.y);
+      continue;
+    }
+    if (open) bands.push_back(band);
+    band = OcrBand{line.x, line.y, line.width, line.height, false};
+    open = true;
+  }
+  if (open) bands.push_back(band);
+
+  for (OcrBand& b : bands) {
+    uint64_t total = 0;
+    for (int y = b.y; y < b.y + b.height; y++) {
+      const uint8_t* row = luma + static_cast<size_t>(y) * width + b.x;
+      for (int x = 0; x < b.width; x++) total += row[x];
+    }
+    const uint64_t pixels = static_cast<uint64_t>(b.width) * b.height;
+    b.light_on_dark = pixels > 0 && total < pixels * kDarkBandMean;
+  }
+  return bands;
+}
+
+void ExtractOcrBand(const uint8_t* luma, int width, const OcrBand& band, std::vector<uint8_t>& out) {
+  out.resize(static_cast<size_t>(band.width) * band.height);
+  for (int y = 0; y < band.height; y++) {
+    const uint8_t* src = luma + static_cast<size_t>(band.y + y) * width + band.x;
+    uint8_t* dst = out.data() + static_cast<size_t>(y) * band.width;
+    if (band.light_on_dark) {
+      for (int x = 0; x < band.width; x++) dst[x] = static_cast<uint8_t>(255 - src[x]);
+    } else {
+      std::copy(src, src + band.width, dst);
+    }
+  }
+}
+
+bool AnalyzeOcrLayout(const uint8_t* bgra,
+                      int width,
+                      int height,
+                      size_t stride,
+                      int max_band_height,
+                      int threads,
+                      OcrLayout& out) {
+  if (!bgra || width <= 0 || height <= 0) return false;
+  LumaPlane(bgra, width, height, stride, out.luma);
+  std::vector<uint8_t> binary;
+  BinarizeSauvola(out.luma.data(), width, height, kSauvolaWindow, kSauvolaK, threads, binary);
+  out.lines = FindTextLines(binary.data(), width, height);
+  out.bands = PlanOcrBands(out.lines, out.luma.data(), width, height, max_band_height, threads);
+  return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Text-layout analysis ahead of OCR (platform-neutral).
+//
+// The capture is binarized (Sauvola, so dark and light themes both work),
+// rows holding ink are grouped into text lines, and the lines are packed
+// into a few horizontal bands that never cut through a line. The recognizer
+// then only sees the parts of the screen with text, one band per worker.
+
+// BT.601 luma of a top-down BGRA image (|stride| 0 = width * 4). Replaces
+// |out| with width x height bytes.
+void LumaPlane(const uint8_t* bgra, int width, int height, size_t stride, std::vector<uint8_t>& out);
+
+// Sauvola thresholding of |luma| over a |window| x |window| neighbourhood:
+// 0 (ink) where a pixel is darker than mean * (1 + k * (stddev / 128 - 1)),
+// 255 otherwise. Flat areas come out as paper whatever their brightness.
+// Rows are split over |threads|. Replaces |out|.
+void BinarizeSauvola(const uint8_t* luma,
+                     int width,
+                     int height,
+                     int window,
+                     double k,
+                     int threads,
+                     std::vector<uint8_t>& out);
+
+// A run of rows with ink, and the columns the ink spans.
+struct TextLine {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+};
+
+// Lines of |binary| (0 = ink), top to bottom. A row counts as ink when it
+// holds a few ink pixels; single blank rows inside a line are bridged and
+// runs under 3 rows are dropped as noise.
+std::vector<TextLine> FindTextLines(const uint8_t* binary, int width, int height);
+
+// One piece of the image to recognize, in image pixels.
+struct OcrBand {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+  // Mostly light text on a dark background (dark themes); recognizers do
+  // better on the inverted band.
+  bool light_on_dark = false;
+};
+
+// Packs |lines| (padded by a few pixels) into about |target_bands| bands of
+// at most |max_height| rows. A new band starts at a large vertical gap, so
+// blank screen between text blocks is skipped; lines taller than
+// |max_height| (pictures, mostly) are cut into pieces.
+std::vector<OcrBand> PlanOcrBands(const std::vector<TextLine>& lines,
+                                  const uint8_t* luma,
+                                  int width,
+                                  int height,
+                                  int max_height,
+                                  int target_bands);
+
+// Grayscale pixels of |band| from |luma|, inverted for light_on_dark bands.
+// Replaces |out| with band.width x band.height bytes.
+void ExtractOcrBand(const uint8_t* luma, int width, const OcrBand& band, std::vector<uint8_t>& out);
+
+// LumaPlane + BinarizeSauvola + FindTextLines + PlanOcrBands for a capture.
+struct OcrLayout {
+  std::vector<uint8_t> luma;
+  std::vector<TextLine> lines;
+  std::vector<OcrBand> bands;
+};
+
+bool AnalyzeOcrLayout(const uint8_t* bgra,
+                      int width,
+                      int height,
+                      size_t stride,
+                      int max_band_height,
+                      int threads,
+                      OcrLayout& out);
@@ -0,0 +1,164 @@
+#include "pcm16_pipeline.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Keep the passband slightly inside Nyquist of the lower rate.
+constexpr double kCutoffScale = 0.92;
+
+inline int16_t SaturateToInt16(int32_t v) {
+  if (v > 32767) return 32767;
+  if (v < -32768) return -32768;
+  return static_cast<int16_t>(v);
+}
+
+}  // namespace
+
+void DownmixPcm16ToMono(const int16_t* in,
+                        size_t frames,
+                        uint16_t channels,
+                        int16_t* out) {
+  if (!in || !out || channels == 0) return;
+  if (channels == 1) {
+    memcpy(out, in, frames * sizeof(int16_t));
+    return;
+  }
+  if (channels == 2) {
+    for (size_t i = 0; i < frames; i++) {
+      const int32_t sum = static_cast<int32_t>(in[i * 2]) + in[i * 2 + 1];
+      out[i] = static_cast<int16_t>(sum / 2);
+    }
+    return;
+  }
+  for (size_t i = 0; i < frames; i++) {
+    const int16_t* frame = in + i * channels;
+    int32_t sum = 0;
+    for (uint16_t ch = 0; ch < channels; ch++) {
+      sum += frame[ch];
+    }
+    out[i] = static_cast<int16_t>(sum / channels);
+  }
+}
+
+Pcm16Decimator::Pcm16Decimator(uint32_t in_rate, uint32_t out_rate, uint32_t taps_per_phase) {
+  if (in_rate == 0 || out_rate == 0) return;
+
+  const uint32_t g = std::gcd(in_rate, out_rate);
+  up_ = out_rate / g;
+  down_ = in_rate / g;
+  if (up_ == down_) {
+    passthrough_ = true;
+    return;
+  }
+  if (taps_per_phase == 0) {
+    const uint32_t ratio = (in_rate + out_rate - 1) / out_rate;
+    taps_per_phase = (std::max)(16u, 8u * ratio);
+  }
+  taps_ = taps_per_phase;
+
+  // Windowed-sinc prototype at the upsampled rate (in_rate * up_).
+  const size_t proto_len = static_cast<size_t>(up_) * taps_;
+  const double fc = 0.5 * kCutoffScale * static_cast<double>((std::min)(in_rate, out_rate)) /
+                    (static_cast<double>(in_rate) * up_);
+  const double center = static_cast<double>(proto_len - 1) / 2.0;
+  std::vector<double> proto(proto_len);
+  const double span = static_cast<double>(proto_len - 1);
+  for (size_t n = 0; n < proto_len; n++) {
+    const double t = static_cast<double>(n) - center;
+    const double x = 2.0 * fc * t;
+    const double sinc = (std::abs(x) < 1e-12) ? 1.0 : std::sin(kPi * x) / (kPi * x);
+    // Blackman window.
+    const double r = static_cast<double>(n) / span;
+    const double w = 0.42 - 0.5 * std::cos(2.0 * kPi * r) + 0.08 * std::cos(4.0 * kPi * r);
+    proto[n] = 2.0 * fc * sinc * w;
+  }
+
+  // Split into phases, normalize each to unity DC gain, quantize to Q15.
+  // Every phase has an L1 norm well under 2.0, so a tap-sum of
+  // |32768 * 32767| products stays inside int32.
+  coeffs_.assign(static_cast<size_t>(up_) * taps_, 0);
+  for (uint32_t p = 0; p < up_; p++) {
+    double sum = 0.0;
+    for (uint32_t k = 0; k < taps_; k++) {
+      sum += proto[p + static_cast<size_t>(k) * up_];
+    }
+    if (sum == 0.0) sum = 1.0;
+    int16_t* h = coeffs_.data() + static_cast<size_t>(p) * taps_;
+    long q_sum = 0;
+    uint32_t peak = 0;
+    for (uint32_t k = 0; k < taps_; k++) {
+      const double v = proto[p + static_cast<size_t>(k) * up_] / sum;
+      const long q = std::lround(v * 32768.0);
+      h[k] = static_cast<int16_t>((std::max)(-32768L, (std::min)(32767L, q)));
+      q_sum += h[k];
+      if (std::abs(h[k]) > std::abs(h[peak])) peak = k;
+    }
+    // Rounding leaves the taps summing to a few counts off 32768; fold the
+    // residue into the largest tap so a DC input comes out exactly.
+    const long fixed = (std::max)(-32768L, (std::min)(32767L, h[peak] + 32768L - q_sum));
+    h[peak] = static_cast<int16_t>(fixed);
+  }
+  Reset();
+}
+
+void Pcm16Decimator::Reset() {
+  acc_ = 0;
+  work_.assign(taps_ > 0 ? taps_ - 1 : 0, 0);
+}
+
+void Pcm16Decimator::Process(const int16_t* in, size_t count, std::vector<int16_t>& out) {
+  if (!valid() || !in || count == 0) return;
+  if (passthrough_) {
+    out.insert(out.end(), in, in + count);
+    return;
+  }
+
+  const size_t history = taps_ - 1;
+  work_.resize(history);
+  work_.insert(work_.end(), in, in + count);
+
+  const uint64_t end = static_cast<uint64_t>(count) * up_;
+  out.reserve(out.size() + static_cast<size_t>((end - (std::min)(acc_, end)) / down_ + 1));
+  while (acc_ < end) {
+    const size_t i = static_cast<size_t>(acc_ / up_);
+    const uint32_t phase = static_cast<uint32_t>(acc_ % up_);
+    const int16_t* h = coeffs_.data() + static_cast<size_t>(phase) * taps_;
+    // Newest sample x[i] sits at work_[i + history].
+    const int16_t* x = work_.data() + i + history;
+    int32_t sum = 0;
+    for (uint32_t k = 0; k < taps_; k++) {
+      sum += static_cast<int32_t>(h[k]) * x[-static_cast<std::ptrdiff_t>(k)];
+    }
+    out.push_back(SaturateToInt16((sum + (1 << 14)) >> 15));
+    acc_ += down_;
+  }
+  acc_ -= end;
+
+  // Keep the tail as history for the next packet.
+  work_.erase(work_.begin(), work_.end() - static_cast<std::ptrdiff_t>(history));
+}
+
+size_t Pcm16Decimator::Skip(size_t count) {
+  if (!valid() || count == 0) return 0;
+  if (passthrough_) return count;
+
+  const uint64_t end = static_cast<uint64_t>(count) * up_;
+  size_t produced = 0;
+  if (acc_ < end) {
+    produced = static_cast<size_t>((end - acc_ + down_ - 1) / down_);
+    acc_ += static_cast<uint64_t>(produced) * down_;
+  }
+  acc_ -= end;
+  // The skipped zeros enter the history like processed ones would; a
+  // packet shorter than the filter leaves older samples in place.
+  const size_t shift = (std::min)(count, work_.size());
+  std::copy(work_.begin() + static_cast<std::ptrdiff_t>(shift), work_.end(), work_.begin());
+  std::fill(work_.end() - static_cast<std::ptrdiff_t>(shift), work_.end(), static_cast<int16_t>(0));
+  return produced;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-point conversion path for endpoints whose shared-mode mix format is
+// already 16-bit PCM, so loopback audio never round-trips through float.
+
+// Averages interleaved |channels| PCM16 frames into mono with an int32
+// accumulator. |out| must hold |frames| samples.
+void DownmixPcm16ToMono(const int16_t* in,
+                        size_t frames,
+                        uint16_t channels,
+                        int16_t* out);
+
+// Streaming rational resampler (in_rate -> out_rate) built as a polyphase FIR
+// with Q15 coefficients, int32 accumulation and a saturating narrow back to
+// int16. Keeps filter history across packets, so packet boundaries do not
+// produce discontinuities.
+class Pcm16Decimator {
+ public:
+  // |taps_per_phase| == 0 picks a length proportional to the decimation
+  // ratio (8 taps per input/output ratio, at least 16).
+  Pcm16Decimator(uint32_t in_rate, uint32_t out_rate, uint32_t taps_per_phase = 0);
+
+  bool valid() const { return up_ != 0 && down_ != 0; }
+
+  void Reset();
+
+  // Resamples |count| input samples and appends the output to |out|.
+  void Process(const int16_t* in, size_t count, std::vector<int16_t>& out);
+
+  // Advances the stream by |count| input samples of digital silence without
+  // filtering them. Returns how many output samples Process would have made.
+  size_t Skip(size_t count);
+
+ private:
+  uint32_t up_ = 0;
+  uint32_t down_ = 0;
+  uint32_t taps_ = 0;
+  bool passthrough_ = false;
+  // |taps_| coefficients per phase, stored newest-sample-first.
+  std::vector<int16_t> coeffs_;
+  // Last |taps_| - 1 input samples followed by the current packet.
+  std::vector<int16_t> work_;
+  // Position of the next output in units of 1/up_ input samples, relative to
+  // the first sample of the current packet.
+  uint64_t acc_ = 0;
+};
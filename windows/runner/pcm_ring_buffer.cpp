@@ -0,0 +1,55 @@
+#include "pcm_ring_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+PcmRingBuffer::PcmRingBuffer(size_t capacity) : buffer_(capacity) {}
+
+void PcmRingBuffer::Clear() {
+  head_ = 0;
+  size_ = 0;
+}
+
+size_t PcmRingBuffer::Write(const uint8_t* data, size_t count) {
+  const size_t cap = buffer_.size();
+  if (!data || count == 0) return 0;
+  if (cap == 0) return count;
+
+  // Only the newest |cap| bytes can survive; skip the rest up front.
+  if (count >= cap) {
+    const size_t dropped = size_ + count - cap;
+    memcpy(buffer_.data(), data + (count - cap), cap);
+    head_ = 0;
+    size_ = cap;
+    return dropped;
+  }
+
+  const size_t overflow = (size_ + count > cap) ? (size_ + count - cap) : 0;
+  head_ = (head_ + overflow) % cap;
+  size_ -= overflow;
+
+  const size_t tail = (head_ + size_) % cap;
+  const size_t first = (std::min)(count, cap - tail);
+  memcpy(buffer_.data() + tail, data, first);
+  if (count > first) {
+    memcpy(buffer_.data(), data + first, count - first);
+  }
+  size_ += count;
+  return overflow;
+}
+
+size_t PcmRingBuffer::Read(uint8_t* out, size_t capacity) {
+  const size_t cap = buffer_.size();
+  if (!out || size_ == 0) return 0;
+
+  const size_t to_copy = (std::min)(capacity, size_);
+  const size_t first = (std::min)(to_copy, cap - head_);
+  memcpy(out, buffer_.data() + head_, first);
+  if (to_copy > first) {
+    memcpy(out + first, buffer_.data(), to_copy - first);
+  }
+  head_ = (head_ + to_copy) % cap;
+  size_ -= to_copy;
+  if (size_ == 0) head_ = 0;
+  return to_copy;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-capacity byte FIFO for the PCM16 capture queue.
+//
+// Writes past capacity overwrite the oldest bytes (the queue only ever needs
+// the most recent audio), and reads copy out in at most two contiguous
+// memcpy calls. Not synchronized; callers hold their own lock.
+class PcmRingBuffer {
+ public:
+  explicit PcmRingBuffer(size_t capacity);
+
+  void Clear();
+
+  // Appends |count| bytes, dropping the oldest queued bytes on overflow.
+  // Returns how many were dropped (old or, past capacity, new).
+  size_t Write(const uint8_t* data, size_t count);
+
+  // Moves up to |capacity| bytes into |out|; returns the number copied.
+  size_t Read(uint8_t* out, size_t capacity);
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return buffer_.size(); }
+
+ private:
+  std::vector<uint8_t> buffer_;
+  size_t head_ = 0;  // Index of the oldest byte.
+  size_t size_ = 0;
+};
@@ -0,0 +1,160 @@
+#include "perceptual_hash.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "image_scale.h"
+
+namespace {
+
+constexpr int kPlane = 32;
+constexpr int kLow = 8;
+
+void LumaOf(const std::vector<uint8_t>& bgra, size_t pixels, float* out) {
+  for (size_t i = 0; i < pixels; i++) {
+    const uint8_t* p = bgra.data() + i * 4;
+    out[i] = 0.114f * p[0] + 0.587f * p[1] + 0.299f * p[2];
+  }
+}
+
+// cos((2x + 1) * u * pi / 64) for the 8 lowest frequencies u.
+const std::array<float, kLow * kPlane>& DctTable() {
+  static const std::array<float, kLow * kPlane> table = [] {
+    std::array<float, kLow * kPlane> t{};
+    const double pi = std::acos(-1.0);
+    for (int u = 0; u < kLow; u++) {
+      for (int x = 0; x < kPlane; x++) {
+        t[static_cast<size_t>(u * kPlane + x)] =
+            static_cast<float>(std::cos((2.0 * x + 1.0) * u * pi / (2.0 * kPlane)));
+      }
+    }
+    return t;
+  }();
+  return table;
+}
+
+}  // namespace
+
+bool ComputeFingerprint(const uint8_t* bgra, int width, int height, size_t stride, ImageFingerprint& out) {
+  if (!bgra || width <= 0 || height <= 0) return false;
+
+  std::vector<uint8_t> small;
+  if (!ScaleBgraBox(bgra, width, height, stride, kPlane, kPlane, small)) return false;
+  float luma[kPlane * kPlane];
+  LumaOf(small, kPlane * kPlane, luma);
+
+  // dHash: 9x8 from the 32x32 plane, each bit "left brighter than right".
+  std::vector<uint8_t> grid;
+  if (!ScaleBgraBox(small.data(), kPlane, kPlane, 0, kLow + 1, kLow, grid)) return false;
+  float grid_luma[(kLow + 1) * kLow];
+  LumaOf(grid, (kLow + 1) * kLow, grid_luma);
+  uint64_t dhash = 0;
+  for (int y = 0; y < kLow; y++) {
+    for (int x = 0; x < kLow; x++) {
+      const float* row = grid_luma + y * (kLow + 1);
+      dhash = (dhash << 1) | (row[x] > row[x + 1] ? 1u : 0u);
+    }
+  }
+
+  // pHash: separable 2-D DCT-II, keeping only the 8x8 lowest frequencies.
+  const auto& table = DctTable();
+  float rows[kPlane * kLow];
+  for (int y = 0; y < kPlane; y++) {
+    for (int u = 0; u < kLow; u++) {
+      float sum = 0.0f;
+      for (int x = 0; x < kPlane; x++) sum += luma[y * kPlane + x] * table[static_cast<size_t>(u * kPlane + x)];
+      rows[y * kLow + u] = sum;
+    }
+  }
+  float coeffs[kLow * kLow];
+  for (int v = 0; v < kLow; v++) {
+    for (int u = 0; u < kLow; u++) {
+      float sum = 0.0f;
+      for (int y = 0; y < kPlane; y++) sum += rows[y * kLow + u] * table[static_cast<size_t>(v * kPlane + y)];
+      coeffs[v * kLow + u] = sum;
+    }
+  }
+  // The DC term only tracks overall brightness; leave it out of the median.
+  float ac[kLow * kLow - 1];
+  std::copy(coeffs + 1, coeffs + kLow * kLow, ac);
+  std::nth_element(ac, ac + (kLow * kLow - 1) / 2, ac + kLow * kLow - 1);
+  const float median = ac[(kLow * kLow - 1) / 2];
+  uint64_t phash = 0;
+  for (int i = 0; i < kLow * kLow; i++) phash = (phash << 1) | (coeffs[i] > median ? 1u : 0u);
+
+  out.dhash = dhash;
+  out.phash = phash;
+  out.width = width;
+  out.height = height;
+  return true;
+}
+
+int HammingDistance(uint64_t a, uint64_t b) {
+  uint64_t x = a ^ b;
+  int bits = 0;
+  for (; x != 0; x &= x - 1) bits++;
+  return bits;
+}
+
+int FingerprintDistance(const ImageFingerprint& a, const ImageFingerprint& b) {
+  if (a.width != b.width || a.height != b.height) return -1;
+  return (std::max)(HammingDistance(a.dhash, b.dhash), HammingDistance(a.phash, b.phash));
+}
+
+RecentImageIndex::RecentImageIndex(size_t per_target, size_t max_targets)
+    : per_target_((std::max)(per_target, size_t{1})), max_targets_((std::max)(max_targets, size_t{1})) {}
+
+RecentImageIndex::Target& RecentImageIndex::TouchLocked(const std::string& target) {
+  auto it = targets_.find(target);
+  if (it == targets_.end()) {
+    if (targets_.size() >= max_targets_) {
+      auto oldest = targets_.begin();
+      for (auto t = targets_.begin(); t != targets_.end(); ++t) {
+        if (t->second.last_used < oldest->second.last_used) oldest = t;
+      }
+      targets_.erase(oldest);
+    }
+    it = targets_.emplace(target, Target{}).first;
+  }
+  it->second.last_used = ++use_seq_;
+  return it->second;
+}
+
+RecentImageIndex::Match RecentImageIndex::Find(const std::string& target,
+                                               const ImageFingerprint& fingerprint,
+                                               int threshold,
+                                               const std::vector<uint64_t>* allowed) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = targets_.find(target);
+  if (it == targets_.end() || threshold < 0) return Match{};
+  Target& t = TouchLocked(target);
+  auto best = t.entries.end();
+  int best_distance = threshold + 1;
+  for (auto e = t.entries.begin(); e != t.entries.end(); ++e) {
+    if (allowed && std::find(allowed->begin(), allowed->end(), e->id) == allowed->end()) continue;
+    const int d = FingerprintDistance(e->fingerprint, fingerprint);
+    if (d >= 0 && d < best_distance) {
+      best = e;
+      best_distance = d;
+      if (d == 0) break;
+    }
+  }
+  if (best == t.entries.end()) return Match{};
+  t.entries.splice(t.entries.begin(), t.entries, best);
+  return Match{best->id, best_distance};
+}
+
+uint64_t RecentImageIndex::Add(const std::string& target, const ImageFingerprint& fingerprint) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Target& t = TouchLocked(target);
+  const uint64_t id = next_id_++;
+  t.entries.push_front(Entry{id, fingerprint});
+  while (t.entries.size() > per_target_) t.entries.pop_back();
+  return id;
+}
+
+void RecentImageIndex::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  targets_.clear();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 64-bit perceptual hashes of one image; near-identical screens differ in
+// only a few bits.
+struct ImageFingerprint {
+  // Signs of horizontal luma gradients on a 9x8 grid.
+  uint64_t dhash = 0;
+  // Signs of the 8x8 lowest DCT-II frequencies of a 32x32 luma plane
+  // against their median (DC excluded from the median).
+  uint64_t phash = 0;
+  int width = 0;
+  int height = 0;
+};
+
+// Both hashes of a top-down BGRA image (|stride| 0 = width * 4), from a
+// 32x32 area-averaged BT.601 luma plane (platform-neutral).
+bool ComputeFingerprint(const uint8_t* bgra, int width, int height, size_t stride, ImageFingerprint& out);
+
+int HammingDistance(uint64_t a, uint64_t b);
+
+// The larger of the dHash and pHash distances (0..64), so both have to
+// agree that two images are close; -1 for different source sizes.
+int FingerprintDistance(const ImageFingerprint& a, const ImageFingerprint& b);
+
+// Recently uploaded images per capture target, so a near-identical capture
+// can be answered with "same as image N" instead of being encoded and sent
+// again.
+//
+// Each target keeps its |per_target| most recently used images; the least
+// recently used target is dropped past |max_targets|. Image ids are unique
+// for the process and never 0. Thread-safe (platform-neutral).
+class RecentImageIndex {
+ public:
+  struct Match {
+    uint64_t image_id = 0;
+    int distance = -1;
+  };
+
+  RecentImageIndex(size_t per_target, size_t max_targets);
+
+  // Closest image of |target| at most |threshold| away, restricted to
+  // |allowed| ids when non-null; image_id 0 when there is none. A match
+  // becomes the target's most recently used image.
+  Match Find(const std::string& target,
+             const ImageFingerprint& fingerprint,
+             int threshold,
+             const std::vector<uint64_t>* allowed);
+
+  // Records an image just uploaded for |target| and returns its new id.
+  uint64_t Add(const std::string& target, const ImageFingerprint& fingerprint);
+
+  void Clear();
+
+ private:
+  struct Entry {
+    uint64_t id;
+    ImageFingerprint fingerprint;
+  };
+  struct Target {
+    // Most recently used first.
+    std::list<Entry> entries;
+    uint64_t last_used = 0;
+  };
+
+  Target& TouchLocked(const std::string& target);
+
+  const size_t per_target_;
+  const size_t max_targets_;
+  std::mutex mutex_;
+  std::map<std::string, Target> targets_;
+  uint64_t next_id_ = 1;
+  uint64_t use_seq_ = 0;
+};
@@ -0,0 +1,115 @@
+#include "pixel_buffer_pool.h"
+
+#include <utility>
+
+PixelBufferPool::PixelBufferPool(size_t max_bytes) {
+  stats_.max_bytes = max_bytes;
+}
+
+size_t PixelBufferPool::SizeClass(size_t size) {
+  if (size <= kMinPooledBytes) return kMinPooledBytes;
+  size_t top = 1;
+  while ((top << 1) <= size) top <<= 1;
+  const size_t step = top / 4;
+  return (size + step - 1) / step * step;
+}
+
+namespace {
+
+// Largest size class <= |capacity| (classes in [2^n, 2^(n+1)) are multiples
+// of 2^n / 4).
+size_t FloorClass(size_t capacity) {
+  size_t top = 1;
+  while ((top << 1) <= capacity) top <<= 1;
+  const size_t step = top / 4 > 0 ? top / 4 : 1;
+  return capacity / step * step;
+}
+
+}  // namespace
+
+std::vector<uint8_t> PixelBufferPool::Acquire(size_t size) {
+  std::vector<uint8_t> buffer;
+  if (size >= kMinPooledBytes) {
+    const size_t size_class = SizeClass(size);
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.acquires++;
+    auto it = idle_.find(size_class);
+    if (it != idle_.end() && !it->second.empty()) {
+      // Most recently released: likeliest to still be warm in cache.
+      buffer = std::move(it->second.back().buffer);
+      it->second.pop_back();
+      if (it->second.empty()) idle_.erase(it);
+      stats_.hits++;
+      stats_.pooled_buffers--;
+      stats_.pooled_bytes -= buffer.capacity();
+    } else {
+      buffer.reserve(size_class);
+    }
+  }
+  // Pooled buffers are kept at their class size, so this only shrinks them
+  // (no zero fill).
+  buffer.resize(size);
+  return buffer;
+}
+
+void PixelBufferPool::Reserve(std::vector<uint8_t>& buffer, size_t size) {
+  if (buffer.capacity() < size) {
+    Release(std::move(buffer));
+    buffer = Acquire(size);
+    return;
+  }
+  buffer.resize(size);
+}
+
+void PixelBufferPool::Release(std::vector<uint8_t>&& buffer) {
+  const size_t capacity = buffer.capacity();
+  if (capacity == 0) return;
+  std::vector<uint8_t> owned(std::move(buffer));
+  buffer = std::vector<uint8_t>();
+
+  // File under the largest class the buffer can serve without growing.
+  const size_t size_class = FloorClass(capacity);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.releases++;
+  if (capacity < kMinPooledBytes || capacity > stats_.max_bytes) {
+    stats_.evictions++;
+    return;
+  }
+  EvictLocked(stats_.max_bytes - capacity);
+  owned.resize(size_class);
+  idle_[size_class].push_back(Idle{next_seq_++, std::move(owned)});
+  stats_.pooled_buffers++;
+  stats_.pooled_bytes += capacity;
+  if (stats_.pooled_bytes > stats_.high_water_bytes) stats_.high_water_bytes = stats_.pooled_bytes;
+}
+
+void PixelBufferPool::EvictLocked(size_t max_bytes) {
+  while (stats_.pooled_bytes > max_bytes && !idle_.empty()) {
+    auto oldest = idle_.begin();
+    for (auto it = idle_.begin(); it != idle_.end(); ++it) {
+      if (it->second.front().released_seq < oldest->second.front().released_seq) oldest = it;
+    }
+    stats_.pooled_bytes -= oldest->second.front().buffer.capacity();
+    stats_.pooled_buffers--;
+    stats_.evictions++;
+    oldest->second.erase(oldest->second.begin());
+    if (oldest->second.empty()) idle_.erase(oldest);
+  }
+}
+
+void PixelBufferPool::SetMaxBytes(size_t max_bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.max_bytes = max_bytes;
+  EvictLocked(max_bytes);
+}
+
+void PixelBufferPool::Trim() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  EvictLocked(0);
+}
+
+PixelBufferPool::Stats PixelBufferPool::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// Size-class pool for large pixel buffers (BGRA captures, scaler output).
+//
+// Requests are rounded up to one of four classes per power of two (at most
+// 25% slack), so a 3840x2160 capture and a slightly different one share
+// storage. Idle buffers are capped at |max_bytes|; the least recently
+// released ones are freed first. Buffers below kMinPooledBytes are left to
+// the heap. Thread-safe (platform-neutral).
+class PixelBufferPool {
+ public:
+  static constexpr size_t kMinPooledBytes = 64 * 1024;
+
+  struct Stats {
+    uint64_t acquires = 0;
+    uint64_t hits = 0;
+    uint64_t releases = 0;
+    // Released buffers freed by the cap (or too small to keep).
+    uint64_t evictions = 0;
+    size_t pooled_buffers = 0;
+    size_t pooled_bytes = 0;
+    // Largest |pooled_bytes| seen.
+    size_t high_water_bytes = 0;
+    size_t max_bytes = 0;
+  };
+
+  explicit PixelBufferPool(size_t max_bytes);
+
+  // A buffer of |size| bytes; contents are unspecified.
+  std::vector<uint8_t> Acquire(size_t size);
+
+  // Resizes |buffer| to |size|, swapping it for a pooled one first if its
+  // capacity is too small. For output parameters that may arrive empty.
+  void Reserve(std::vector<uint8_t>& buffer, size_t size);
+
+  // Returns a buffer for reuse (no-op for empty ones).
+  void Release(std::vector<uint8_t>&& buffer);
+
+  void SetMaxBytes(size_t max_bytes);
+  // Frees every idle buffer.
+  void Trim();
+  Stats GetStats() const;
+
+  // Class a request of |size| bytes is served from.
+  static size_t SizeClass(size_t size);
+
+ private:
+  struct Idle {
+    uint64_t released_seq;
+    std::vector<uint8_t> buffer;
+  };
+
+  void EvictLocked(size_t max_bytes);
+
+  mutable std::mutex mutex_;
+  // Size class -> idle buffers, oldest first.
+  std::map<size_t, std::vector<Idle>> idle_;
+  uint64_t next_seq_ = 0;
+  Stats stats_;
+};
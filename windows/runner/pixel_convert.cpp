@@ -0,0 +1,225 @@
+#include "pixel_convert.h"
+
+#include <cstring>
+
+// PIXEL_CONVERT_NO_SIMD builds the scalar paths alone, which the native
+// tests compare the SSE2 ones against.
+#if !defined(PIXEL_CONVERT_NO_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define PIXEL_CONVERT_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+inline uint8_t Div255(unsigned v) {
+  // Exact round(v / 255) for v <= 255 * 255.
+  v += 128;
+  return static_cast<uint8_t>((v + (v >> 8)) >> 8);
+}
+
+#if PIXEL_CONVERT_SSE2
+inline __m128i Load(const uint8_t* p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+inline void Store(uint8_t* p, __m128i v) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+
+inline __m128i SwapRb(__m128i p) {
+  const __m128i rb_mask = _mm_set1_epi32(0x00FF00FF);
+  const __m128i ga_mask = _mm_set1_epi32(static_cast<int>(0xFF00FF00u));
+  const __m128i rb = _mm_and_si128(p, rb_mask);
+  const __m128i swapped = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+  return _mm_or_si128(_mm_and_si128(p, ga_mask), _mm_and_si128(swapped, rb_mask));
+}
+
+// Div255 on 16-bit lanes.
+inline __m128i Div255Epi16(__m128i v) {
+  v = _mm_add_epi16(v, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+}
+
+// Two pixels widened to 16-bit lanes, premultiplied; alpha kept.
+inline __m128i PremultiplyTwo(__m128i px16) {
+  __m128i alpha = _mm_shufflelo_epi16(px16, _MM_SHUFFLE(3, 3, 3, 3));
+  alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+  const __m128i alpha_lanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+  const __m128i product = Div255Epi16(_mm_mullo_epi16(px16, alpha));
+  return _mm_or_si128(_mm_andnot_si128(alpha_lanes, product), _mm_and_si128(alpha_lanes, px16));
+}
+
+// B, G and R of four pixels in the low byte of 32-bit lanes.
+inline void SplitChannels(__m128i p, __m128i& b, __m128i& g, __m128i& r) {
+  const __m128i low = _mm_set1_epi32(0xFF);
+  b = _mm_and_si128(p, low);
+  g = _mm_and_si128(_mm_srli_epi32(p, 8), low);
+  r = _mm_and_si128(_mm_srli_epi32(p, 16), low);
+}
+#endif
+
+}  // namespace
+
+void SwapRedBlue(const uint8_t* src, uint8_t* dst, size_t count) {
+  size_t i = 0;
+#if PIXEL_CONVERT_SSE2
+  for (; i + 4 <= count; i += 4) Store(dst + i * 4, SwapRb(Load(src + i * 4)));
+#endif
+  for (; i < count; i++) {
+    const uint8_t* s = src + i * 4;
+    uint8_t* d = dst + i * 4;
+    const uint8_t c0 = s[0], c1 = s[1], c2 = s[2], c3 = s[3];
+    d[0] = c2;
+    d[1] = c1;
+    d[2] = c0;
+    d[3] = c3;
+  }
+}
+
+void SwapRedBlueOpaque(const uint8_t* src, uint8_t* dst, size_t count) {
+  size_t i = 0;
+#if PIXEL_CONVERT_SSE2
+  const __m128i opaque = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+  for (; i + 4 <= count; i += 4) Store(dst + i * 4, _mm_or_si128(SwapRb(Load(src + i * 4)), opaque));
+#endif
+  for (; i < count; i++) {
+    const uint8_t* s = src + i * 4;
+    uint8_t* d = dst + i * 4;
+    const uint8_t c0 = s[0], c1 = s[1], c2 = s[2];
+    d[0] = c2;
+    d[1] = c1;
+    d[2] = c0;
+    d[3] = 255;
+  }
+}
+
+void SetOpaque(const uint8_t* src, uint8_t* dst, size_t count) {
+  size_t i = 0;
+#if PIXEL_CONVERT_SSE2
+  const __m128i opaque = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+  for (; i + 4 <= count; i += 4) Store(dst + i * 4, _mm_or_si128(Load(src + i * 4), opaque));
+#endif
+  for (; i < count; i++) {
+    if (dst != src) memcpy(dst + i * 4, src + i * 4, 3);
+    dst[i * 4 + 3] = 255;
+  }
+}
+
+void PremultiplyAlpha(const uint8_t* src, uint8_t* dst, size_t count) {
+  size_t i = 0;
+#if PIXEL_CONVERT_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 4 <= count; i += 4) {
+    const __m128i p = Load(src + i * 4);
+    const __m128i lo = PremultiplyTwo(_mm_unpacklo_epi8(p, zero));
+    const __m128i hi = PremultiplyTwo(_mm_unpackhi_epi8(p, zero));
+    Store(dst + i * 4, _mm_packus_epi16(lo, hi));
+  }
+#endif
+  for (; i < count; i++) {
+    const uint8_t* s = src + i * 4;
+    uint8_t* d = dst + i * 4;
+    const unsigned a = s[3];
+    d[0] = Div255(s[0] * a);
+    d[1] = Div255(s[1] * a);
+    d[2] = Div255(s[2] * a);
+    d[3] = static_cast<uint8_t>(a);
+  }
+}
+
+void UnpremultiplyAlpha(const uint8_t* src, uint8_t* dst, size_t count) {
+  // Integer division has no SSE2 form. Opaque pixels, the common case for
+  // captures, skip it.
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t* s = src + i * 4;
+    uint8_t* d = dst + i * 4;
+    const uint8_t a = s[3];
+    if (a == 255) {
+      if (d != s) memcpy(d, s, 4);
+      continue;
+    }
+    for (int c = 0; c < 3; c++) {
+      const unsigned v = a ? (s[c] * 255u + a / 2u) / a : 0u;
+      d[c] = static_cast<uint8_t>(v > 255 ? 255 : v);
+    }
+    d[3] = a;
+  }
+}
+
+void BgraToGray(const uint8_t* src, uint8_t* dst, size_t count) {
+  size_t i = 0;
+#if PIXEL_CONVERT_SSE2
+  const __m128i wb = _mm_set1_epi16(29);
+  const __m128i wg = _mm_set1_epi16(150);
+  const __m128i wr = _mm_set1_epi16(77);
+  const __m128i round = _mm_set1_epi16(128);
+  for (; i + 8 <= count; i += 8) {
+    __m128i b0, g0, r0, b1, g1, r1;
+    SplitChannels(Load(src + i * 4), b0, g0, r0);
+    SplitChannels(Load(src + i * 4 + 16), b1, g1, r1);
+    // Channels are <= 255, so the signed packs don't saturate, and the sum
+    // stays below 65536 in unsigned 16-bit lanes.
+    const __m128i b = _mm_packs_epi32(b0, b1);
+    const __m128i g = _mm_packs_epi32(g0, g1);
+    const __m128i r = _mm_packs_epi32(r0, r1);
+    __m128i y = _mm_add_epi16(_mm_mullo_epi16(b, wb), _mm_mullo_epi16(g, wg));
+    y = _mm_add_epi16(_mm_add_epi16(y, _mm_mullo_epi16(r, wr)), round);
+    y = _mm_srli_epi16(y, 8);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(y, y));
+  }
+#endif
+  for (; i < count; i++) {
+    const uint8_t* s = src + i * 4;
+    dst[i] = static_cast<uint8_t>((29u * s[0] + 150u * s[1] + 77u * s[2] + 128u) >> 8);
+  }
+}
+
+void BgraToRgb565(const uint8_t* src, uint8_t* dst, size_t count) {
+  size_t i = 0;
+#if PIXEL_CONVERT_SSE2
+  const __m128i red = _mm_set1_epi32(0xF800);
+  const __m128i green = _mm_set1_epi32(0x07E0);
+  const __m128i blue = _mm_set1_epi32(0x001F);
+  // packs_epi32 saturates signed values; bias into range and back.
+  const __m128i bias32 = _mm_set1_epi32(0x8000);
+  const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+  for (; i + 8 <= count; i += 8) {
+    __m128i words[2];
+    for (int half = 0; half < 2; half++) {
+      const __m128i p = Load(src + i * 4 + half * 16);
+      const __m128i v = _mm_or_si128(
+          _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 8), red), _mm_and_si128(_mm_srli_epi32(p, 5), green)),
+          _mm_and_si128(_mm_srli_epi32(p, 3), blue));
+      words[half] = _mm_sub_epi32(v, bias32);
+    }
+    Store(dst + i * 2, _mm_add_epi16(_mm_packs_epi32(words[0], words[1]), bias16));
+  }
+#endif
+  for (; i < count; i++) {
+    const uint8_t* s = src + i * 4;
+    const unsigned v = ((s[2] & 0xF8u) << 8) | ((s[1] & 0xFCu) << 3) | (s[0] >> 3);
+    dst[i * 2] = static_cast<uint8_t>(v);
+    dst[i * 2 + 1] = static_cast<uint8_t>(v >> 8);
+  }
+}
+
+void BgraToRgb24(const uint8_t* src, uint8_t* dst, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t* s = src + i * 4;
+    const uint8_t b = s[0], g = s[1], r = s[2];
+    dst[i * 3] = r;
+    dst[i * 3 + 1] = g;
+    dst[i * 3 + 2] = b;
+  }
+}
+
+void BgraToBgr24(const uint8_t* src, uint8_t* dst, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t* s = src + i * 4;
+    const uint8_t b = s[0], g = s[1], r = s[2];
+    dst[i * 3] = b;
+    dst[i * 3 + 1] = g;
+    dst[i * 3 + 2] = r;
+  }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Pixel-format conversions for capture buffers (platform-neutral, SSE2 when
+// available, with identical output either way).
+//
+// Each function converts |count| 4-byte pixels from |src| to |dst|. |dst|
+// may equal |src| to convert a (pooled) buffer in place; packed outputs are
+// smaller, so in place they fill the front of the buffer. Strided images are
+// converted a row at a time.
+
+// BGRA <-> RGBA (the conversion is its own inverse).
+void SwapRedBlue(const uint8_t* src, uint8_t* dst, size_t count);
+
+// SwapRedBlue with alpha forced to 255: GDI captures leave the fourth byte
+// undefined.
+void SwapRedBlueOpaque(const uint8_t* src, uint8_t* dst, size_t count);
+
+// Copies with alpha forced to 255.
+void SetOpaque(const uint8_t* src, uint8_t* dst, size_t count);
+
+// Straight <-> premultiplied alpha in either channel order (alpha is the
+// fourth byte). Rounded to nearest; unpremultiplying a pixel with alpha 0
+// gives 0.
+void PremultiplyAlpha(const uint8_t* src, uint8_t* dst, size_t count);
+void UnpremultiplyAlpha(const uint8_t* src, uint8_t* dst, size_t count);
+
+// BT.601 luma, one byte per pixel: (29 B + 150 G + 77 R + 128) >> 8.
+void BgraToGray(const uint8_t* src, uint8_t* dst, size_t count);
+
+// 16-bit little-endian 5:6:5 (red in the high bits), truncating.
+void BgraToRgb565(const uint8_t* src, uint8_t* dst, size_t count);
+
+// Three bytes per pixel, R G B or B G R (24 bpp DIB order).
+void BgraToRgb24(const uint8_t* src, uint8_t* dst, size_t count);
+void BgraToBgr24(const uint8_t* src, uint8_t* dst, size_t count);
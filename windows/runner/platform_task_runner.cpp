@@ -0,0 +1,46 @@
+#include "platform_task_runner.h"
+
+#include <utility>
+
+PlatformTaskRunner::PlatformTaskRunner(HWND window) : window_(window) {}
+
+PlatformTaskRunner::~PlatformTaskRunner() {
+  Shutdown();
+}
+
+void PlatformTaskRunner::PostTask(std::function<void()> task) {
+  if (!task) return;
+  bool post = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (shut_down_) return;
+    tasks_.push_back(std::move(task));
+    // One outstanding message drains everything queued before it runs.
+    if (!message_posted_) {
+      message_posted_ = true;
+      post = true;
+    }
+  }
+  if (post && !PostMessage(window_, kRunTasksMessage, 0, 0)) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    message_posted_ = false;
+  }
+}
+
+void PlatformTaskRunner::RunPendingTasks() {
+  std::deque<std::function<void()>> tasks;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks.swap(tasks_);
+    message_posted_ = false;
+  }
+  for (auto& task : tasks) {
+    task();
+  }
+}
+
+void PlatformTaskRunner::Shutdown() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  shut_down_ = true;
+  tasks_.clear();
+}
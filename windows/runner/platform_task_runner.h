@@ -0,0 +1,37 @@
+#pragma once
+
+#include <windows.h>
+
+#include <deque>
+#include <functional>
+#include <mutex>
+
+// Marshals work from background threads (audio capture, capture workers)
+// onto the platform thread, where Flutter channel results and event sinks
+// must be completed.
+//
+// Tasks are queued and the owning window is poked with a single
+// kRunTasksMessage; the window's message handler calls RunPendingTasks().
+class PlatformTaskRunner {
+ public:
+  static constexpr UINT kRunTasksMessage = WM_APP + 0x51;
+
+  explicit PlatformTaskRunner(HWND window);
+  ~PlatformTaskRunner();
+
+  // Thread-safe. Tasks posted after Shutdown() are dropped.
+  void PostTask(std::function<void()> task);
+
+  // Platform thread only.
+  void RunPendingTasks();
+
+  // Drops pending tasks and stops accepting new ones.
+  void Shutdown();
+
+ private:
+  HWND window_;
+  std::mutex mutex_;
+  std::deque<std::function<void()>> tasks_;
+  bool message_posted_ = false;
+  bool shut_down_ = false;
+};
@@ -0,0 +1,339 @@
+#include "png_encoder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "deflate.h"
+#include "multi_capture.h"
+#include "pixel_convert.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PNG_ENCODER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t kBpp = 3;
+// Filtered bytes per independently deflated segment. Big enough that the
+// per-segment Huffman tables and priming cost well under 1% of the output.
+constexpr size_t kSegmentBytes = 512 * 1024;
+constexpr size_t kDictBytes = 32 * 1024;
+constexpr int kMaxAutoThreads = 4;
+
+enum FilterType : uint8_t { kNone = 0, kSub = 1, kUp = 2, kAverage = 3, kPaeth = 4 };
+
+void PutU32(std::vector<uint8_t>& out, uint32_t v) {
+  out.push_back(static_cast<uint8_t>(v >> 24));
+  out.push_back(static_cast<uint8_t>(v >> 16));
+  out.push_back(static_cast<uint8_t>(v >> 8));
+  out.push_back(static_cast<uint8_t>(v));
+}
+
+void WriteChunk(std::vector<uint8_t>& out, const char type[4], const uint8_t* data, size_t size) {
+  PutU32(out, static_cast<uint32_t>(size));
+  const size_t type_pos = out.size();
+  out.insert(out.end(), type, type + 4);
+  if (size > 0) out.insert(out.end(), data, data + size);
+  PutU32(out, Crc32(out.data() + type_pos, size + 4));
+}
+
+uint8_t Paeth(int a, int b, int c) {
+  const int p = a + b - c;
+  const int pa = std::abs(p - a);
+  const int pb = std::abs(p - b);
+  const int pc = std::abs(p - c);
+  if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+  if (pb <= pc) return static_cast<uint8_t>(b);
+  return static_cast<uint8_t>(c);
+}
+
+// Filtered bytes are judged as signed: 0xFF is as cheap as 0x01.
+inline uint32_t Cost(uint8_t v) {
+  return v < 128 ? v : 256u - v;
+}
+
+#if PNG_ENCODER_SSE2
+inline __m128i Load(const uint8_t* p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+inline void Store(uint8_t* p, __m128i v) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+
+// Adds the Cost of 16 bytes to the two 64-bit lanes of |sum|.
+inline __m128i AddCost(__m128i sum, __m128i v) {
+  const __m128i zero = _mm_setzero_si128();
+  return _mm_add_epi64(sum, _mm_sad_epu8(_mm_min_epu8(v, _mm_sub_epi8(zero, v)), zero));
+}
+
+inline uint32_t CostTotal(__m128i sum) {
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(sum)) + static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(sum, 8)));
+}
+
+inline __m128i Abs16(__m128i v) {
+  return _mm_max_epi16(v, _mm_sub_epi16(_mm_setzero_si128(), v));
+}
+
+// Paeth predictor on 16-bit lanes, with the scalar version's tie order.
+inline __m128i PaethLanes(__m128i a, __m128i b, __m128i c) {
+  const __m128i pa = Abs16(_mm_sub_epi16(b, c));
+  const __m128i pb = Abs16(_mm_sub_epi16(a, c));
+  const __m128i pc = Abs16(_mm_sub_epi16(_mm_add_epi16(a, b), _mm_add_epi16(c, c)));
+  const __m128i not_a = _mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc));
+  const __m128i not_b = _mm_cmpgt_epi16(pb, pc);
+  const __m128i b_or_c = _mm_or_si128(_mm_and_si128(not_b, c), _mm_andnot_si128(not_b, b));
+  return _mm_or_si128(_mm_and_si128(not_a, b_or_c), _mm_andnot_si128(not_a, a));
+}
+
+inline __m128i PaethPredict(__m128i a, __m128i b, __m128i c) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i lo = PaethLanes(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(c, zero));
+  const __m128i hi = PaethLanes(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(c, zero));
+  return _mm_packus_epi16(lo, hi);
+}
+#endif
+
+// Converts BGRA rows to RGB and applies PNG scanline filters. Filtering
+// reads only unfiltered bytes, so every position is independent and the
+// candidates are computed 16 bytes at a time.
+class RowFilter {
+ public:
+  RowFilter(int width, bool adaptive)
+      : width_(static_cast<size_t>(width)),
+        row_bytes_(width_ * kBpp),
+        adaptive_(adaptive),
+        candidates_(adaptive ? row_bytes_ * 4 : 0) {
+    // kBpp zero bytes before each row stand in for the pixel left of x = 0.
+    for (auto& row : rows_) row.assign(kBpp + row_bytes_, 0);
+  }
+
+  // Makes |bgra| the row above the next one filtered (default: zeros).
+  void SetPrevious(const uint8_t* bgra) {
+    BgraToRgb24(bgra, rows_[prev_].data() + kBpp, width_);
+  }
+
+  // Writes the filter type and filtered bytes of |bgra| to |out|
+  // (row_bytes + 1 bytes).
+  void Filter(const uint8_t* bgra, uint8_t* out) {
+    const int cur = 1 - prev_;
+    BgraToRgb24(bgra, rows_[cur].data() + kBpp, width_);
+    const uint8_t* row = rows_[cur].data() + kBpp;
+    const uint8_t* up = rows_[prev_].data() + kBpp;
+    if (adaptive_) {
+      FilterAdaptive(row, up, out);
+    } else {
+      out[0] = kPaeth;
+      FilterPaeth(row, up, out + 1);
+    }
+    prev_ = cur;
+  }
+
+ private:
+  void FilterPaeth(const uint8_t* row, const uint8_t* up, uint8_t* out) const {
+    size_t i = 0;
+#if PNG_ENCODER_SSE2
+    for (; i + 16 <= row_bytes_; i += 16) {
+      const __m128i x = Load(row + i);
+      const __m128i pred = PaethPredict(Load(row + i - kBpp), Load(up + i), Load(up + i - kBpp));
+      Store(out + i, _mm_sub_epi8(x, pred));
+    }
+#endif
+    for (; i < row_bytes_; i++) {
+      out[i] = static_cast<uint8_t>(row[i] - Paeth(row[i - kBpp], up[i], up[i - kBpp]));
+    }
+  }
+
+  void FilterAdaptive(const uint8_t* row, const uint8_t* up, uint8_t* out) {
+    uint8_t* sub = candidates_.data();
+    uint8_t* vert = sub + row_bytes_;
+    uint8_t* avg = vert + row_bytes_;
+    uint8_t* paeth = avg + row_bytes_;
+    uint32_t cost[5] = {0, 0, 0, 0, 0};
+    size_t i = 0;
+#if PNG_ENCODER_SSE2
+    __m128i sums[5];
+    for (auto& s : sums) s = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    for (; i + 16 <= row_bytes_; i += 16) {
+      const __m128i x = Load(row + i);
+      const __m128i a = Load(row + i - kBpp);
+      const __m128i b = Load(up + i);
+      const __m128i c = Load(up + i - kBpp);
+      // floor((a + b) / 2); avg_epu8 rounds up.
+      const __m128i mean = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+      const __m128i fs = _mm_sub_epi8(x, a);
+      const __m128i fu = _mm_sub_epi8(x, b);
+      const __m128i fa = _mm_sub_epi8(x, mean);
+      const __m128i fp = _mm_sub_epi8(x, PaethPredict(a, b, c));
+      Store(sub + i, fs);
+      Store(vert + i, fu);
+      Store(avg + i, fa);
+      Store(paeth + i, fp);
+      sums[kNone] = AddCost(sums[kNone], x);
+      sums[kSub] = AddCost(sums[kSub], fs);
+      sums[kUp] = AddCost(sums[kUp], fu);
+      sums[kAverage] = AddCost(sums[kAverage], fa);
+      sums[kPaeth] = AddCost(sums[kPaeth], fp);
+    }
+    for (int f = 0; f < 5; f++) cost[f] = CostTotal(sums[f]);
+#endif
+    for (; i < row_bytes_; i++) {
+      const uint8_t x = row[i], a = row[i - kBpp], b = up[i], c = up[i - kBpp];
+      sub[i] = static_cast<uint8_t>(x - a);
+      vert[i] = static_cast<uint8_t>(x - b);
+      avg[i] = static_cast<uint8_t>(x - ((a + b) >> 1));
+      paeth[i] = static_cast<uint8_t>(x - Paeth(a, b, c));
+      cost[kNone] += Cost(x);
+      cost[kSub] += Cost(sub[i]);
+      cost[kUp] += Cost(vert[i]);
+      cost[kAverage] += Cost(avg[i]);
+      cost[kPaeth] += Cost(paeth[i]);
+    }
+
+    int best = kNone;
+    for (int f = kSub; f <= kPaeth; f++) {
+      if (cost[f] < cost[best]) best = f;
+    }
+    out[0] = static_cast<uint8_t>(best);
+    const uint8_t* chosen = best == kNone ? row : candidates_.data() + static_cast<size_t>(best - 1) * row_bytes_;
+    memcpy(out + 1, chosen, row_bytes_);
+  }
+
+  const size_t width_;
+  const size_t row_bytes_;
+  const bool adaptive_;
+  std::vector<uint8_t> rows_[2];
+  int prev_ = 0;
+  // Sub, Up, Average and Paeth output for the current row.
+  std::vector<uint8_t> candidates_;
+};
+
+struct Segment {
+  int row_begin = 0;
+  int row_end = 0;
+  // One complete IDAT chunk (the first also carries the zlib header).
+  std::vector<uint8_t> chunk;
+  uint32_t adler = 1;
+  size_t filtered_size = 0;
+};
+
+// Filters and deflates rows [row_begin, row_end), re-filtering the rows
+// before it that feed the dictionary.
+void EncodeSegment(const uint8_t* bgra,
+                   size_t stride,
+                   int width,
+                   const PngOptions& options,
+                   bool first,
+                   bool last,
+                   Segment& segment) {
+  const size_t filtered_row = static_cast<size_t>(width) * kBpp + 1;
+  const int dict_rows = static_cast<int>((kDictBytes + filtered_row - 1) / filtered_row);
+  const int dict_begin = (std::max)(0, segment.row_begin - dict_rows);
+
+  RowFilter filter(width, options.adaptive_filter);
+  if (dict_begin > 0) filter.SetPrevious(bgra + static_cast<size_t>(dict_begin - 1) * stride);
+  std::vector<uint8_t> filtered(static_cast<size_t>(segment.row_end - dict_begin) * filtered_row);
+  for (int y = dict_begin; y < segment.row_end; y++) {
+    filter.Filter(bgra + static_cast<size_t>(y) * stride, filtered.data() + static_cast<size_t>(y - dict_begin) * filtered_row);
+  }
+
+  const size_t dict_size = static_cast<size_t>(segment.row_begin - dict_begin) * filtered_row;
+  const uint8_t* data = filtered.data() + dict_size;
+  segment.filtered_size = filtered.size() - dict_size;
+  segment.adler = Adler32(data, segment.filtered_size);
+
+  std::vector<uint8_t>& chunk = segment.chunk;
+  chunk.reserve(segment.filtered_size / 4 + 64);
+  PutU32(chunk, 0);  // length, patched below
+  static const char kIdat[4] = {'I', 'D', 'A', 'T'};
+  chunk.insert(chunk.end(), kIdat, kIdat + 4);
+  if (first) ZlibHeader(options.level, chunk);
+  DeflateSegment(data, (std::min)(dict_size, kDictBytes), segment.filtered_size, options.level, last, chunk);
+  const uint32_t length = static_cast<uint32_t>(chunk.size() - 8);
+  for (int i = 0; i < 4; i++) chunk[static_cast<size_t>(i)] = static_cast<uint8_t>(length >> (24 - 8 * i));
+  PutU32(chunk, Crc32(chunk.data() + 4, chunk.size() - 4));
+}
+
+int PickThreadCount(int requested, size_t segments) {
+  int threads = requested;
+  if (threads <= 0) {
+    const unsigned hw = std::thread::hardware_concurrency();
+    threads = (std::min)(kMaxAutoThreads, hw == 0 ? 1 : static_cast<int>(hw));
+  }
+  return static_cast<int>((std::min)(static_cast<size_t>((std::max)(1, threads)), segments));
+}
+
+}  // namespace
+
+PngOptions PngPresetOptions(PngPreset preset) {
+  PngOptions options;
+  switch (preset) {
+    case PngPreset::kFast:
+      options.level = 1;
+      options.adaptive_filter = false;
+      break;
+    case PngPreset::kBalanced:
+      options.level = 4;
+      break;
+    case PngPreset::kSmallest:
+      options.level = 9;
+      break;
+  }
+  return options;
+}
+
+bool EncodePngBgra(const uint8_t* bgra,
+                   int width,
+                   int height,
+                   size_t stride,
+                   const PngOptions& options,
+                   std::vector<uint8_t>& out) {
+  out.clear();
+  if (!bgra || width <= 0 || height <= 0) return false;
+  if (stride == 0) stride = static_cast<size_t>(width) * 4;
+
+  const size_t filtered_row = static_cast<size_t>(width) * kBpp + 1;
+  const int rows_per_segment = static_cast<int>((std::max)(size_t{1}, kSegmentBytes / filtered_row));
+  std::vector<Segment> segments(static_cast<size_t>((height + rows_per_segment - 1) / rows_per_segment));
+  for (size_t i = 0; i < segments.size(); i++) {
+    segments[i].row_begin = static_cast<int>(i) * rows_per_segment;
+    segments[i].row_end = (std::min)(height, segments[i].row_begin + rows_per_segment);
+  }
+  RunParallel(segments.size(), static_cast<size_t>(PickThreadCount(options.threads, segments.size())), [&](size_t i) {
+    EncodeSegment(bgra, stride, width, options, i == 0, i + 1 == segments.size(), segments[i]);
+  });
+
+  size_t total = 0;
+  uint32_t adler = 1;
+  for (const Segment& segment : segments) {
+    total += segment.chunk.size();
+    adler = Adler32Combine(adler, segment.adler, segment.filtered_size);
+  }
+
+  static const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  out.reserve(total + 64);
+  out.insert(out.end(), kSignature, kSignature + 8);
+
+  uint8_t ihdr[13];
+  for (int i = 0; i < 4; i++) {
+    ihdr[i] = static_cast<uint8_t>(static_cast<uint32_t>(width) >> (24 - 8 * i));
+    ihdr[4 + i] = static_cast<uint8_t>(static_cast<uint32_t>(height) >> (24 - 8 * i));
+  }
+  ihdr[8] = 8;   // bit depth
+  ihdr[9] = 2;   // truecolor
+  ihdr[10] = 0;  // deflate
+  ihdr[11] = 0;  // adaptive filtering
+  ihdr[12] = 0;  // no interlace
+  WriteChunk(out, "IHDR", ihdr, sizeof(ihdr));
+  for (const Segment& segment : segments) out.insert(out.end(), segment.chunk.begin(), segment.chunk.end());
+  // The zlib trailer needs every segment's checksum, so it gets its own IDAT.
+  std::vector<uint8_t> trailer;
+  ZlibTrailer(adler, trailer);
+  WriteChunk(out, "IDAT", trailer.data(), trailer.size());
+  WriteChunk(out, "IEND", nullptr, 0);
+  return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Speed/ratio trade-offs for EncodePngBgra.
+enum class PngPreset {
+  // Shallow match search and a fixed Paeth filter: previews and streams.
+  kFast,
+  // Per-row filter choice and a moderate match search: uploads.
+  kBalanced,
+  // Per-row filter choice and the deepest match search.
+  kSmallest,
+};
+
+struct PngOptions {
+  // Deflate level (1..9).
+  int level = 6;
+  // Pick each row's filter by the smallest sum of absolute filtered bytes
+  // (libpng's heuristic); otherwise every row uses Paeth.
+  bool adaptive_filter = true;
+  // Segments deflated in parallel; <= 0 picks a count from the image size.
+  int threads = 0;
+};
+
+PngOptions PngPresetOptions(PngPreset preset);
+
+// Encodes top-down BGRA (GDI/DIB layout) as an 8-bit RGB PNG. Alpha is
+// dropped: GDI captures leave it undefined and screenshots are opaque.
+// |stride| is bytes per source row (0 = width * 4).
+//
+// Rows are filtered and deflated in independent segments of about 512 KiB,
+// each primed with the 32 KiB before it and written as its own IDAT chunk,
+// so segments run in parallel and nothing holds the whole filtered image.
+// Segment boundaries don't depend on the thread count, so neither do the
+// bytes. Replaces |out|, reusing its capacity (pass a pooled buffer).
+bool EncodePngBgra(const uint8_t* bgra,
+                   int width,
+                   int height,
+                   size_t stride,
+                   const PngOptions& options,
+                   std::vector<uint8_t>& out);
@@ -0,0 +1,59 @@
+#include "sample_timeline.h"
+
+#include <algorithm>
+
+void SampleTimeline::Clear() {
+  runs_.clear();
+  queued_ = 0;
+}
+
+void SampleTimeline::Append(uint64_t start, uint64_t count) {
+  if (count == 0) return;
+  queued_ += count;
+  if (!runs_.empty()) {
+    AudioGap& last = runs_.back();
+    if (last.start_sample + last.length == start) {
+      last.length += count;
+      return;
+    }
+  }
+  runs_.push_back(AudioGap{start, count});
+}
+
+void SampleTimeline::PopFront(uint64_t count, std::vector<AudioGap>* dropped) {
+  while (count > 0 && !runs_.empty()) {
+    AudioGap& run = runs_.front();
+    const uint64_t n = (std::min)(count, run.length);
+    if (dropped) InsertGap(*dropped, AudioGap{run.start_sample, n});
+    run.start_sample += n;
+    run.length -= n;
+    queued_ -= n;
+    count -= n;
+    if (run.length == 0) runs_.pop_front();
+  }
+}
+
+void InsertGap(std::vector<AudioGap>& gaps, const AudioGap& gap) {
+  if (gap.length == 0) return;
+  auto it = std::upper_bound(gaps.begin(), gaps.end(), gap.start_sample,
+                             [](uint64_t start, const AudioGap& g) { return start < g.start_sample; });
+  // Merge into the previous gap when it reaches |gap|.
+  if (it != gaps.begin()) {
+    AudioGap& prev = *(it - 1);
+    if (prev.start_sample + prev.length >= gap.start_sample) {
+      prev.length = (std::max)(prev.length, gap.start_sample + gap.length - prev.start_sample);
+      it = it - 1;
+    } else {
+      it = gaps.insert(it, gap);
+    }
+  } else {
+    it = gaps.insert(it, gap);
+  }
+  // Absorb following gaps the merged one now reaches.
+  auto next = it + 1;
+  while (next != gaps.end() && it->start_sample + it->length >= next->start_sample) {
+    it->length = (std::max)(it->length, next->start_sample + next->length - it->start_sample);
+    next = gaps.erase(next);
+    it = next - 1;
+  }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "silence_compactor.h"
+
+// Where each queued PCM16 sample sits on the 16kHz capture timeline.
+//
+// The capture ring holds only the audio the SilenceCompactor kept, so its
+// samples are not contiguous on the timeline. Tracking the runs lets audio
+// the ring drops on overflow be reported as a gap at its real position
+// instead of silently shifting everything after it. Not synchronized;
+// callers hold the ring's lock.
+class SampleTimeline {
+ public:
+  void Clear();
+
+  // Samples [start, start + count) were queued after everything already
+  // queued.
+  void Append(uint64_t start, uint64_t count);
+
+  // Removes the oldest |count| queued samples. When |dropped| is given, the
+  // ranges they covered are appended to it as gaps.
+  void PopFront(uint64_t count, std::vector<AudioGap>* dropped = nullptr);
+
+  uint64_t queued_samples() const { return queued_; }
+
+ private:
+  // Contiguous, non-adjacent runs, oldest first.
+  std::deque<AudioGap> runs_;
+  uint64_t queued_ = 0;
+};
+
+// Inserts |gap| into |gaps| (sorted by start, non-overlapping), merging it
+// with the neighbours it touches.
+void InsertGap(std::vector<AudioGap>& gaps, const AudioGap& gap);
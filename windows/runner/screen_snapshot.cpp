@@ -0,0 +1,58 @@
+#include "screen_snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "image_scale.h"
+
+ScreenSnapshot::ScreenSnapshot(int left, int top, int width, int height, std::vector<uint8_t>&& bgra)
+    : left_(left), top_(top), width_(width), height_(height), pixels_(std::move(bgra)) {
+  if (width_ < 0 || height_ < 0 || pixels_.size() < stride() * static_cast<size_t>(height_)) {
+    width_ = 0;
+    height_ = 0;
+  }
+}
+
+bool ScreenSnapshot::Clip(int x, int y, int w, int h, SnapshotRect& out) const {
+  if (w <= 0 || h <= 0) return false;
+  // 64-bit so far-off rectangles can't overflow.
+  const int64_t x0 = (std::max)(static_cast<int64_t>(x) - left_, int64_t{0});
+  const int64_t y0 = (std::max)(static_cast<int64_t>(y) - top_, int64_t{0});
+  const int64_t x1 = (std::min)(static_cast<int64_t>(x) + w - left_, static_cast<int64_t>(width_));
+  const int64_t y1 = (std::min)(static_cast<int64_t>(y) + h - top_, static_cast<int64_t>(height_));
+  if (x1 <= x0 || y1 <= y0) return false;
+  out.x = static_cast<int>(x0);
+  out.y = static_cast<int>(y0);
+  out.width = static_cast<int>(x1 - x0);
+  out.height = static_cast<int>(y1 - y0);
+  return true;
+}
+
+const uint8_t* ScreenSnapshot::At(const SnapshotRect& rect) const {
+  return pixels_.data() + static_cast<size_t>(rect.y) * stride() + static_cast<size_t>(rect.x) * 4u;
+}
+
+bool ScreenSnapshot::Crop(const SnapshotRect& rect,
+                          int max_w,
+                          int max_h,
+                          std::vector<uint8_t>& out,
+                          int& out_w,
+                          int& out_h) const {
+  if (rect.width <= 0 || rect.height <= 0) return false;
+  FitWithin(rect.width, rect.height, max_w, max_h, out_w, out_h);
+  if (out_w != rect.width || out_h != rect.height) {
+    return ScaleBgra(At(rect), rect.width, rect.height, stride(), out_w, out_h, ScaleFilter::kBox, out, 0);
+  }
+  const size_t row_bytes = static_cast<size_t>(rect.width) * 4u;
+  out.resize(row_bytes * static_cast<size_t>(rect.height));
+  const uint8_t* src = At(rect);
+  for (int y = 0; y < rect.height; y++) {
+    memcpy(out.data() + static_cast<size_t>(y) * row_bytes, src + static_cast<size_t>(y) * stride(), row_bytes);
+  }
+  return true;
+}
+
+bool ScreenSnapshot::Encode(const SnapshotRect& rect, const UploadEncodeOptions& options, EncodedUpload& out) const {
+  if (rect.width <= 0 || rect.height <= 0) return false;
+  return EncodeForUpload(At(rect), rect.width, rect.height, stride(), options, out);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "upload_encoder.h"
+
+// Part of a ScreenSnapshot, in snapshot pixels (0,0 = top-left).
+struct SnapshotRect {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+};
+
+// One frozen BGRA capture of a screen area (usually the whole virtual
+// screen), addressed in screen coordinates.
+//
+// Crops, scaled previews and upload encodes are all served from the same
+// pixels, so what a selection UI showed is exactly what gets cropped and no
+// second capture is taken. Immutable after construction, so any number of
+// worker threads may read it at once (platform-neutral).
+class ScreenSnapshot {
+ public:
+  // |bgra| is top-down, tightly packed |width| x |height|.
+  ScreenSnapshot(int left, int top, int width, int height, std::vector<uint8_t>&& bgra);
+
+  int left() const { return left_; }
+  int top() const { return top_; }
+  int width() const { return width_; }
+  int height() const { return height_; }
+  size_t stride() const { return static_cast<size_t>(width_) * 4u; }
+  const std::vector<uint8_t>& pixels() const { return pixels_; }
+
+  // Intersects the screen rectangle x,y,w,h with the snapshot; false when
+  // nothing is left.
+  bool Clip(int x, int y, int w, int h, SnapshotRect& out) const;
+
+  // First byte of |rect|'s top-left pixel; rows are stride() apart.
+  const uint8_t* At(const SnapshotRect& rect) const;
+
+  // Copies |rect| into tightly packed BGRA, area-averaged down to fit
+  // max_w x max_h (<= 0 = unbounded; never upscales). Replaces |out|.
+  bool Crop(const SnapshotRect& rect,
+            int max_w,
+            int max_h,
+            std::vector<uint8_t>& out,
+            int& out_w,
+            int& out_h) const;
+
+  // EncodeForUpload of |rect| straight from the snapshot rows.
+  bool Encode(const SnapshotRect& rect, const UploadEncodeOptions& options, EncodedUpload& out) const;
+
+ private:
+  int left_;
+  int top_;
+  int width_;
+  int height_;
+  std::vector<uint8_t> pixels_;
+};
@@ -0,0 +1,67 @@
+#include "screen_stream.h"
+
+#include <algorithm>
+
+ScreenStream::ScreenStream(double fps, const UploadEncodeOptions& options)
+    : fps_((std::min)((std::max)(fps, kMinFps), kMaxFps)),
+      period_(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps_))),
+      options_(options) {}
+
+bool ScreenStream::Offer(const uint8_t* bgra, int width, int height, size_t stride, FrameDiff& diff) {
+  diff = differ_.Update(bgra, width, height, stride);
+  const Clock::time_point now = Clock::now();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.captured++;
+    if (diff.kind == FrameDiff::Kind::kUnchanged && latest_.upload) {
+      latest_.checked_at = now;
+      stats_.unchanged++;
+      return false;
+    }
+  }
+
+  auto encoded = std::make_shared<EncodedUpload>();
+  if (!EncodeForUpload(bgra, width, height, stride, options_, *encoded)) {
+    // Make the next capture publish even if it matches this one.
+    differ_.Reset();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.failed++;
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  latest_.upload = std::move(encoded);
+  latest_.source_width = width;
+  latest_.source_height = height;
+  latest_.sequence++;
+  latest_.captured_at = now;
+  latest_.checked_at = now;
+  stats_.encoded++;
+  return true;
+}
+
+void ScreenStream::OfferFailed() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.failed++;
+}
+
+std::chrono::milliseconds ScreenStream::NextDelay(Clock::time_point now) {
+  if (next_due_ == Clock::time_point{}) next_due_ = now;
+  next_due_ += period_;
+  if (next_due_ <= now) {
+    const auto missed = (now - next_due_) / period_ + 1;
+    next_due_ += missed * period_;
+  }
+  // Round up so the timer never fires just before the slot.
+  return std::chrono::ceil<std::chrono::milliseconds>(next_due_ - now);
+}
+
+StreamFrame ScreenStream::Latest() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return latest_;
+}
+
+ScreenStream::Stats ScreenStream::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "frame_differ.h"
+#include "upload_encoder.h"
+
+// Most recent encoded frame of a ScreenStream.
+struct StreamFrame {
+  std::shared_ptr<const EncodedUpload> upload;
+  int source_width = 0;
+  int source_height = 0;
+  // 1 for the first published frame; 0 while there is none.
+  uint64_t sequence = 0;
+  std::chrono::steady_clock::time_point captured_at;
+  // Last capture that matched this frame (unchanged frames refresh it).
+  std::chrono::steady_clock::time_point checked_at;
+};
+
+// Paced capture stream for one target (platform-neutral).
+//
+// The capture job feeds every frame to Offer(); frames the differ reports
+// unchanged are dropped before encoding, the rest are encoded for upload and
+// become Latest(), so a reader always has a ready frame without capturing.
+// Offer() and NextDelay() are called by one job at a time; Latest() and
+// GetStats() may be called from any thread.
+class ScreenStream {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Stats {
+    uint64_t captured = 0;
+    uint64_t unchanged = 0;
+    uint64_t encoded = 0;
+    uint64_t failed = 0;
+  };
+
+  // |fps| is clamped to [kMinFps, kMaxFps].
+  ScreenStream(double fps, const UploadEncodeOptions& options);
+
+  static constexpr double kMinFps = 0.2;
+  static constexpr double kMaxFps = 10.0;
+
+  // Diffs a top-down BGRA capture (|stride| 0 = width * 4) against the
+  // previous one and publishes it unless unchanged. Returns true when a new
+  // frame was published; |diff| says what changed.
+  bool Offer(const uint8_t* bgra, int width, int height, size_t stride, FrameDiff& diff);
+
+  // Counts a capture that produced no pixels.
+  void OfferFailed();
+
+  // Time until the next capture should start. Captures are kept on a fixed
+  // 1/fps grid from the first call; when a capture overruns its slot the
+  // missed slots are skipped rather than captured back to back.
+  std::chrono::milliseconds NextDelay(Clock::time_point now);
+
+  StreamFrame Latest() const;
+  Stats GetStats() const;
+  double fps() const { return fps_; }
+
+ private:
+  double fps_;
+  Clock::duration period_;
+  UploadEncodeOptions options_;
+
+  // Capture job only.
+  FrameDiffer differ_;
+  Clock::time_point next_due_{};
+
+  mutable std::mutex mutex_;
+  StreamFrame latest_;
+  Stats stats_;
+};
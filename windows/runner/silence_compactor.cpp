@@ -0,0 +1,91 @@
+#include "silence_compactor.h"
+
+#include <algorithm>
+
+namespace {
+
+// Silence is judged per 10 ms block so a single quiet sample in the middle of
+// speech never splits the stream.
+constexpr size_t kBlockSamples = 160;
+
+bool IsBlockSilent(const int16_t* samples, size_t count, int16_t threshold) {
+  for (size_t i = 0; i < count; i++) {
+    const int32_t s = samples[i];
+    if (s > threshold || s < -threshold) return false;
+  }
+  return true;
+}
+
+void AppendGap(uint64_t start, uint64_t length, std::vector<AudioGap>& gaps) {
+  if (length == 0) return;
+  if (!gaps.empty()) {
+    AudioGap& last = gaps.back();
+    if (last.start_sample + last.length == start) {
+      last.length += length;
+      return;
+    }
+  }
+  gaps.push_back(AudioGap{start, length});
+}
+
+}  // namespace
+
+SilenceCompactor::SilenceCompactor(int16_t threshold, uint32_t hangover_samples)
+    : threshold_(threshold < 0 ? 0 : threshold),
+      hangover_samples_(hangover_samples) {}
+
+void SilenceCompactor::Reset() {
+  next_sample_ = 0;
+  silent_run_ = 0;
+}
+
+void SilenceCompactor::Process(const int16_t* samples,
+                               size_t count,
+                               std::vector<int16_t>& audio_out,
+                               std::vector<AudioGap>& gaps_out) {
+  if (!samples) return;
+  size_t pos = 0;
+  while (pos < count) {
+    const size_t n = (std::min)(kBlockSamples, count - pos);
+    const int16_t* block = samples + pos;
+    if (IsBlockSilent(block, n, threshold_)) {
+      EmitSilence(n, block, audio_out, gaps_out);
+    } else {
+      silent_run_ = 0;
+      audio_out.insert(audio_out.end(), block, block + n);
+      next_sample_ += n;
+    }
+    pos += n;
+  }
+}
+
+void SilenceCompactor::AddSilence(size_t count,
+                                  std::vector<int16_t>& audio_out,
+                                  std::vector<AudioGap>& gaps_out) {
+  EmitSilence(count, nullptr, audio_out, gaps_out);
+}
+
+void SilenceCompactor::EmitSilence(size_t count,
+                                   const int16_t* samples,
+                                   std::vector<int16_t>& audio_out,
+                                   std::vector<AudioGap>& gaps_out) {
+  if (count == 0) return;
+
+  // Pass through whatever is left of the hangover window as real audio.
+  size_t keep = 0;
+  if (silent_run_ < hangover_samples_) {
+    keep = static_cast<size_t>(
+        (std::min)(static_cast<uint64_t>(count), hangover_samples_ - silent_run_));
+  }
+  if (keep > 0) {
+    if (samples) {
+      audio_out.insert(audio_out.end(), samples, samples + keep);
+    } else {
+      audio_out.insert(audio_out.end(), keep, static_cast<int16_t>(0));
+    }
+  }
+
+  AppendGap(next_sample_ + keep, count - keep, gaps_out);
+  silent_run_ += count;
+  next_sample_ += count;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A run of silence removed from the 16kHz mono PCM16 loopback stream.
+// |start_sample| is on the same continuous sample timeline as the audio that
+// is still queued, so the receiver can re-insert the gap without drift.
+struct AudioGap {
+  uint64_t start_sample = 0;
+  uint64_t length = 0;
+};
+
+// Collapses runs of digital silence and near-silence into AudioGap records.
+//
+// The first |hangover_samples| of every silent run are still passed through as
+// audio so recognizers see a natural end of utterance; only the remainder of
+// the run is compacted. Pure logic (no WASAPI), so it can be reused by other
+// capture backends.
+class SilenceCompactor {
+ public:
+  // Samples with |s| <= |threshold| count as silent (32 ~= -60 dBFS).
+  // Default hangover is 200 ms at 16kHz.
+  explicit SilenceCompactor(int16_t threshold = 32,
+                            uint32_t hangover_samples = 3200);
+
+  void Reset();
+
+  // Splits |count| samples into audio to keep (appended to |audio_out|) and
+  // compacted silence (appended to, or merged into the tail of, |gaps_out|).
+  void Process(const int16_t* samples,
+               size_t count,
+               std::vector<int16_t>& audio_out,
+               std::vector<AudioGap>& gaps_out);
+
+  // Advances the timeline by |count| samples known to be silent (e.g. packets
+  // flagged AUDCLNT_BUFFERFLAGS_SILENT) without materializing them.
+  void AddSilence(size_t count,
+                  std::vector<int16_t>& audio_out,
+                  std::vector<AudioGap>& gaps_out);
+
+  // Sample index the next processed sample will receive.
+  uint64_t next_sample() const { return next_sample_; }
+
+ private:
+  void EmitSilence(size_t count,
+                   const int16_t* samples,
+                   std::vector<int16_t>& audio_out,
+                   std::vector<AudioGap>& gaps_out);
+
+  int16_t threshold_;
+  uint32_t hangover_samples_;
+  uint64_t next_sample_ = 0;
+  uint64_t silent_run_ = 0;
+};
@@ -0,0 +1,132 @@
+#include "smart_crop.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+// Analysis runs on 1/kLevel of the capture in each direction.
+constexpr int kLevel = 4;
+constexpr int kCell = kCropBlockSize / kLevel;
+
+// Luma step between neighbouring quarter-resolution pixels that counts as
+// an edge; text survives the 4x4 averaging as steps well above this.
+constexpr int kEdgeThreshold = 24;
+
+// Share of a block's pixels on edges for it to count as detailed.
+constexpr double kDetailFraction = 0.06;
+
+// Inclusive block range of a cluster.
+struct BlockBounds {
+  int x0, y0, x1, y1;
+};
+
+}  // namespace
+
+bool FindContentCrop(const uint8_t* bgra, int width, int height, size_t stride, double max_keep, CropRect& out) {
+  if (!bgra || width < 2 * kCropBlockSize || height < 2 * kCropBlockSize) return false;
+  const size_t row_bytes = stride ? stride : static_cast<size_t>(width) * 4;
+
+  // Quarter-resolution luma: mean of each 4x4 block.
+  const int lw = width / kLevel;
+  const int lh = height / kLevel;
+  std::vector<uint32_t> sums(static_cast<size_t>(lw));
+  std::vector<uint8_t> luma(static_cast<size_t>(lw) * lh);
+  for (int ly = 0; ly < lh; ly++) {
+    std::fill(sums.begin(), sums.end(), 0u);
+    for (int dy = 0; dy < kLevel; dy++) {
+      const uint8_t* p = bgra + static_cast<size_t>(ly * kLevel + dy) * row_bytes;
+      for (int lx = 0; lx < lw; lx++) {
+        uint32_t s = 0;
+        for (int dx = 0; dx < kLevel; dx++, p += 4) s += 29u * p[0] + 150u * p[1] + 77u * p[2];
+        sums[lx] += s;
+      }
+    }
+    uint8_t* dst = luma.data() + static_cast<size_t>(ly) * lw;
+    for (int lx = 0; lx < lw; lx++) dst[lx] = static_cast<uint8_t>(sums[lx] / (256u * kLevel * kLevel));
+  }
+
+  // Edge pixels per block.
+  const int bw = (lw + kCell - 1) / kCell;
+  const int bh = (lh + kCell - 1) / kCell;
+  std::vector<int> edges(static_cast<size_t>(bw) * bh, 0);
+  for (int y = 0; y + 1 < lh; y++) {
+    const uint8_t* row = luma.data() + static_cast<size_t>(y) * lw;
+    const uint8_t* below = row + lw;
+    int* block_row = edges.data() + static_cast<size_t>(y / kCell) * bw;
+    for (int x = 0; x + 1 < lw; x++) {
+      const int gradient = std::abs(row[x + 1] - row[x]) + std::abs(below[x] - row[x]);
+      if (gradient >= kEdgeThreshold) block_row[x / kCell]++;
+    }
+  }
+  std::vector<uint8_t> detailed(edges.size(), 0);
+  for (int by = 0; by < bh; by++) {
+    const int cells_y = (std::min)(kCell, lh - by * kCell);
+    for (int bx = 0; bx < bw; bx++) {
+      const int cells_x = (std::min)(kCell, lw - bx * kCell);
+      const size_t i = static_cast<size_t>(by) * bw + bx;
+      detailed[i] = edges[i] >= kDetailFraction * cells_x * cells_y ? 1 : 0;
+    }
+  }
+
+  // Group detailed blocks into 8-connected clusters; the crop covers the
+  // largest one and any at least a quarter its size, so a lone icon or
+  // clock doesn't stretch it across the screen.
+  std::vector<int> label(detailed.size(), -1);
+  std::vector<int> sizes;
+  std::vector<BlockBounds> boxes;
+  std::vector<int> stack;
+  for (size_t start = 0; start < detailed.size(); start++) {
+    if (!detailed[start] || label[start] >= 0) continue;
+    const int id = static_cast<int>(sizes.size());
+    BlockBounds box{bw, bh, -1, -1};
+    int size = 0;
+    label[start] = id;
+    stack.push_back(static_cast<int>(start));
+    while (!stack.empty()) {
+      const int i = stack.back();
+      stack.pop_back();
+      const int bx = i % bw, by = i / bw;
+      size++;
+      box.x0 = (std::min)(box.x0, bx);
+      box.y0 = (std::min)(box.y0, by);
+      box.x1 = (std::max)(box.x1, bx);
+      box.y1 = (std::max)(box.y1, by);
+      for (int ny = (std::max)(0, by - 1); ny <= (std::min)(bh - 1, by + 1); ny++) {
+        for (int nx = (std::max)(0, bx - 1); nx <= (std::min)(bw - 1, bx + 1); nx++) {
+          const size_t n = static_cast<size_t>(ny) * bw + nx;
+          if (detailed[n] && label[n] < 0) {
+            label[n] = id;
+            stack.push_back(static_cast<int>(n));
+          }
+        }
+      }
+    }
+    sizes.push_back(size);
+    boxes.push_back(box);
+  }
+  const int largest = sizes.empty() ? 0 : *std::max_element(sizes.begin(), sizes.end());
+  if (largest < 2) return false;
+  int bx0 = bw, by0 = bh, bx1 = -1, by1 = -1;
+  for (size_t c = 0; c < sizes.size(); c++) {
+    if (sizes[c] * 4 < largest) continue;
+    bx0 = (std::min)(bx0, boxes[c].x0);
+    by0 = (std::min)(by0, boxes[c].y0);
+    bx1 = (std::max)(bx1, boxes[c].x1);
+    by1 = (std::max)(by1, boxes[c].y1);
+  }
+  if (bx1 < 0) return false;
+
+  CropRect crop;
+  crop.x = (std::max)(0, bx0 - 1) * kCropBlockSize;
+  crop.y = (std::max)(0, by0 - 1) * kCropBlockSize;
+  crop.width = (std::min)(width, (bx1 + 2) * kCropBlockSize) - crop.x;
+  crop.height = (std::min)(height, (by1 + 2) * kCropBlockSize) - crop.y;
+  // The last block row/column may not reach the image edge (width % 4).
+  if (bx1 + 1 >= bw) crop.width = width - crop.x;
+  if (by1 + 1 >= bh) crop.height = height - crop.y;
+  if (static_cast<double>(crop.width) * crop.height > max_keep * width * height) return false;
+  out = crop;
+  return true;
+}
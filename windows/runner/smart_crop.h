@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// A crop in image pixels.
+struct CropRect {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+};
+
+// Finds the part of a capture worth spending an upload's pixels on, so
+// small text on a large monitor survives the downscale (platform-neutral).
+//
+// Edge density is measured on a quarter-resolution luma plane in
+// kCropBlockSize blocks; blocks with enough strong gradients are text,
+// code or other detail, flat UI and empty desktop are not. The crop is the
+// bounding box of the detailed blocks (isolated ones, like a lone icon,
+// are ignored), padded by one block and aligned to the block grid so it
+// stays put between similar frames.
+//
+// Returns false, leaving |out| alone, when there's nothing to gain: no
+// detail at all, or the crop would keep more than |max_keep| (0..1) of the
+// image area.
+constexpr int kCropBlockSize = 32;
+
+bool FindContentCrop(const uint8_t* bgra, int width, int height, size_t stride, double max_keep, CropRect& out);
@@ -0,0 +1,141 @@
+#include "thumbnail_cache.h"
+
+#include <cstring>
+#include <utility>
+
+namespace {
+
+// 32 x 32 samples: enough to catch typical UI changes in a tile while
+// reading only ~1k pixels.
+constexpr int kSampleGrid = 32;
+
+constexpr uint64_t kFnvOffset = 1469598103934665603ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+uint64_t Mix(uint64_t hash, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    hash ^= (value >> (i * 8)) & 0xffu;
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+}  // namespace
+
+uint64_t SampledContentHash(const uint8_t* bgra, int width, int height, size_t stride) {
+  uint64_t hash = Mix(Mix(kFnvOffset, static_cast<uint32_t>(width)), static_cast<uint32_t>(height));
+  if (!bgra || width <= 0 || height <= 0) return hash;
+  if (stride == 0) stride = static_cast<size_t>(width) * 4;
+
+  const int cols = width < kSampleGrid ? width : kSampleGrid;
+  const int rows = height < kSampleGrid ? height : kSampleGrid;
+  for (int gy = 0; gy < rows; gy++) {
+    // Sample cell centers so a 1px border doesn't dominate.
+    const int y = static_cast<int>((static_cast<int64_t>(2 * gy + 1) * height) / (2 * rows));
+    const uint8_t* line = bgra + static_cast<size_t>(y) * stride;
+    for (int gx = 0; gx < cols; gx++) {
+      const int x = static_cast<int>((static_cast<int64_t>(2 * gx + 1) * width) / (2 * cols));
+      const uint8_t* p = line + static_cast<size_t>(x) * 4;
+      hash = Mix(hash, static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24));
+    }
+  }
+  return hash;
+}
+
+ThumbnailCache::ThumbnailCache(size_t budget_bytes) : budget_bytes_(budget_bytes) {}
+
+bool ThumbnailCache::Lookup(const std::string& key, Entry& out) {
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    misses_++;
+    return false;
+  }
+  hits_++;
+  lru_.splice(lru_.begin(), lru_, it->second);
+  out = it->second->entry;
+  return true;
+}
+
+void ThumbnailCache::Put(const std::string& key, Entry entry) {
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    bytes_ -= it->second->entry.bytes.size();
+    lru_.erase(it->second);
+    index_.erase(it);
+  }
+  if (entry.bytes.size() > budget_bytes_) return;
+
+  bytes_ += entry.bytes.size();
+  lru_.push_front(Node{key, std::move(entry)});
+  index_[key] = lru_.begin();
+  EvictToBudget();
+}
+
+void ThumbnailCache::Touch(const std::string& key, uint64_t generation) {
+  auto it = index_.find(key);
+  if (it == index_.end()) return;
+  it->second->entry.generation = generation;
+  it->second->entry.captured_at = Clock::now();
+  lru_.splice(lru_.begin(), lru_, it->second);
+}
+
+bool ThumbnailCache::PutCapture(const std::string& key,
+                                const uint8_t* bgra,
+                                int width,
+                                int height,
+                                size_t stride,
+                                uint64_t generation,
+                                const uint64_t* shown_hash) {
+  const uint64_t hash = SampledContentHash(bgra, width, height, stride);
+  if (shown_hash && *shown_hash == hash) {
+    Touch(key, generation);
+    return false;
+  }
+  if (stride == 0) stride = static_cast<size_t>(width) * 4;
+  Entry entry;
+  entry.width = width;
+  entry.height = height;
+  const size_t row_bytes = static_cast<size_t>(width) * 4;
+  entry.bytes.resize(row_bytes * static_cast<size_t>(height));
+  for (int y = 0; y < height; y++) {
+    std::memcpy(entry.bytes.data() + static_cast<size_t>(y) * row_bytes, bgra + static_cast<size_t>(y) * stride,
+                row_bytes);
+  }
+  entry.generation = generation;
+  entry.content_hash = hash;
+  entry.captured_at = Clock::now();
+  Put(key, std::move(entry));
+  return true;
+}
+
+void ThumbnailCache::SetBudget(size_t budget_bytes) {
+  budget_bytes_ = budget_bytes;
+  EvictToBudget();
+}
+
+void ThumbnailCache::Clear() {
+  lru_.clear();
+  index_.clear();
+  bytes_ = 0;
+}
+
+ThumbnailCache::Stats ThumbnailCache::GetStats() const {
+  Stats stats;
+  stats.entries = lru_.size();
+  stats.bytes = bytes_;
+  stats.budget_bytes = budget_bytes_;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.evictions = evictions_;
+  return stats;
+}
+
+void ThumbnailCache::EvictToBudget() {
+  while (bytes_ > budget_bytes_ && !lru_.empty()) {
+    bytes_ -= lru_.back().entry.bytes.size();
+    index_.erase(lru_.back().key);
+    lru_.pop_back();
+    evictions_++;
+  }
+}
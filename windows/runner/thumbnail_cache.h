@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Cheap content fingerprint of a BGRA image: dimensions plus a fixed grid of
+// sampled pixels. Used to tell whether a recaptured thumbnail changed
+// without comparing every byte. |stride| 0 means width * 4.
+uint64_t SampledContentHash(const uint8_t* bgra, int width, int height, size_t stride);
+
+// LRU cache of BGRA thumbnails bounded by a byte budget.
+//
+// Keys are caller-defined (target + tile size). Each entry records the
+// |generation| the caller derived from cheap target state when it was
+// captured (window rect, foreground window, ...), so a lookup can tell a
+// fresh tile from one to show immediately but recapture (stale while
+// revalidate). Not thread-safe; the runner uses it on the platform thread.
+class ThumbnailCache {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> bytes;
+    uint64_t generation = 0;
+    uint64_t content_hash = 0;
+    Clock::time_point captured_at;
+  };
+
+  struct Stats {
+    size_t entries = 0;
+    size_t bytes = 0;
+    size_t budget_bytes = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+  };
+
+  explicit ThumbnailCache(size_t budget_bytes = 32u << 20);
+
+  // Copies the entry for |key| into |out| and marks it most recently used.
+  bool Lookup(const std::string& key, Entry& out);
+
+  // Inserts or replaces |key|, then evicts least recently used entries until
+  // the cache fits the budget. Entries larger than the budget are not kept.
+  void Put(const std::string& key, Entry entry);
+
+  // Refreshes generation and capture time of an unchanged entry.
+  void Touch(const std::string& key, uint64_t generation);
+
+  // Caches a new capture of |key| (|stride| 0 = width * 4). When the tile
+  // was already shown from the cache as stale, |shown_hash| is its content
+  // hash; if the capture still matches it the entry is only touched and
+  // false is returned, as there is nothing new to send.
+  bool PutCapture(const std::string& key,
+                  const uint8_t* bgra,
+                  int width,
+                  int height,
+                  size_t stride,
+                  uint64_t generation,
+                  const uint64_t* shown_hash);
+
+  void SetBudget(size_t budget_bytes);
+  void Clear();
+  Stats GetStats() const;
+
+ private:
+  struct Node {
+    std::string key;
+    Entry entry;
+  };
+
+  void EvictToBudget();
+
+  size_t budget_bytes_;
+  size_t bytes_ = 0;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+  uint64_t evictions_ = 0;
+  // Front = most recently used.
+  std::list<Node> lru_;
+  std::unordered_map<std::string, std::list<Node>::iterator> index_;
+};
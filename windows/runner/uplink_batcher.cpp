@@ -0,0 +1,136 @@
+#include "uplink_batcher.h"
+
+#include <algorithm>
+#include <utility>
+
+std::string Base64Encode(const uint8_t* data, size_t size) {
+  static const char kAlphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  if (!data || size == 0) return out;
+  out.resize(((size + 2) / 3) * 4);
+
+  char* dst = &out[0];
+  size_t i = 0;
+  for (; i + 3 <= size; i += 3) {
+    const uint32_t v = (static_cast<uint32_t>(data[i]) << 16) |
+                       (static_cast<uint32_t>(data[i + 1]) << 8) | data[i + 2];
+    *dst++ = kAlphabet[(v >> 18) & 0x3F];
+    *dst++ = kAlphabet[(v >> 12) & 0x3F];
+    *dst++ = kAlphabet[(v >> 6) & 0x3F];
+    *dst++ = kAlphabet[v & 0x3F];
+  }
+  const size_t rest = size - i;
+  if (rest > 0) {
+    uint32_t v = static_cast<uint32_t>(data[i]) << 16;
+    if (rest == 2) v |= static_cast<uint32_t>(data[i + 1]) << 8;
+    *dst++ = kAlphabet[(v >> 18) & 0x3F];
+    *dst++ = kAlphabet[(v >> 12) & 0x3F];
+    *dst++ = rest == 2 ? kAlphabet[(v >> 6) & 0x3F] : '=';
+    *dst++ = '=';
+  }
+  return out;
+}
+
+UplinkBatcher::UplinkBatcher(uint32_t latency_budget_ms,
+                             size_t max_frame_bytes,
+                             size_t max_pending_bytes)
+    : latency_budget_ms_(latency_budget_ms),
+      max_frame_bytes_(max_frame_bytes > 0 ? max_frame_bytes : 1),
+      max_pending_bytes_((std::max)(max_pending_bytes, max_frame_bytes)) {}
+
+void UplinkBatcher::AddAudio(const std::string& source,
+                             const uint8_t* data,
+                             size_t size,
+                             uint64_t now_ms) {
+  if (!data || size == 0) return;
+  Batch& batch = batches_[source];
+  if (batch.bytes.empty()) batch.first_ms = now_ms;
+  batch.bytes.insert(batch.bytes.end(), data, data + size);
+
+  // Split off full frames right away.
+  while (batch.bytes.size() >= max_frame_bytes_) {
+    Batch head;
+    head.bytes.assign(batch.bytes.begin(),
+                      batch.bytes.begin() + static_cast<std::ptrdiff_t>(max_frame_bytes_));
+    batch.bytes.erase(batch.bytes.begin(),
+                      batch.bytes.begin() + static_cast<std::ptrdiff_t>(max_frame_bytes_));
+    FlushBatch(source, head);
+    batch.first_ms = now_ms;
+  }
+
+  // Backlog cap: keep the newest audio (PCM16, so drop whole samples).
+  if (batch.bytes.size() > max_pending_bytes_) {
+    size_t drop = batch.bytes.size() - max_pending_bytes_;
+    drop += drop & 1;
+    batch.bytes.erase(batch.bytes.begin(), batch.bytes.begin() + static_cast<std::ptrdiff_t>(drop));
+    dropped_bytes_ += drop;
+  }
+}
+
+void UplinkBatcher::AddControl(std::string text) {
+  FlushAll();
+  UplinkFrame frame;
+  frame.text = std::move(text);
+  ready_.push_back(std::move(frame));
+}
+
+void UplinkBatcher::TakeReady(uint64_t now_ms, bool flush_all, std::vector<UplinkFrame>& out) {
+  if (flush_all) {
+    FlushAll();
+  } else {
+    for (auto& entry : batches_) {
+      Batch& batch = entry.second;
+      if (!batch.bytes.empty() && now_ms - batch.first_ms >= latency_budget_ms_) {
+        FlushBatch(entry.first, batch);
+      }
+    }
+  }
+  while (!ready_.empty()) {
+    out.push_back(std::move(ready_.front()));
+    ready_.pop_front();
+  }
+}
+
+void UplinkBatcher::TrimReadyAudio(size_t max_frames) {
+  for (auto it = ready_.begin(); ready_.size() > max_frames && it != ready_.end();) {
+    if (it->audio_bytes > 0) {
+      dropped_bytes_ += it->audio_bytes;
+      it = ready_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void UplinkBatcher::Clear() {
+  batches_.clear();
+  ready_.clear();
+}
+
+size_t UplinkBatcher::pending_bytes() const {
+  size_t total = 0;
+  for (const auto& entry : batches_) total += entry.second.bytes.size();
+  for (const auto& frame : ready_) total += frame.audio_bytes;
+  return total;
+}
+
+void UplinkBatcher::FlushBatch(const std::string& source, Batch& batch) {
+  if (batch.bytes.empty()) return;
+  UplinkFrame frame;
+  frame.audio_bytes = batch.bytes.size();
+  frame.text.reserve(48 + source.size() + (batch.bytes.size() + 2) / 3 * 4);
+  frame.text += "{\"type\":\"audio\",\"source\":\"";
+  frame.text += source;
+  frame.text += "\",\"audio\":\"";
+  frame.text += Base64Encode(batch.bytes.data(), batch.bytes.size());
+  frame.text += "\"}";
+  ready_.push_back(std::move(frame));
+  batch.bytes.clear();
+}
+
+void UplinkBatcher::FlushAll() {
+  for (auto& entry : batches_) {
+    FlushBatch(entry.first, entry.second);
+  }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+// Standard (RFC 4648) base64 with padding.
+std::string Base64Encode(const uint8_t* data, size_t size);
+
+// A text frame ready to be written to the transcription socket.
+struct UplinkFrame {
+  std::string text;
+  // PCM bytes carried by this frame (0 for control messages).
+  size_t audio_bytes = 0;
+};
+
+// Coalesces small PCM chunks per source into larger
+// {"type":"audio","source":...,"audio":base64} frames.
+//
+// A source's batch is flushed once its oldest byte has waited
+// |latency_budget_ms| or it reaches |max_frame_bytes|. Control messages
+// flush pending audio first so ordering relative to audio is preserved.
+// Pending audio beyond |max_pending_bytes| per source drops the oldest bytes.
+// Not synchronized; the owner serializes access.
+class UplinkBatcher {
+ public:
+  UplinkBatcher(uint32_t latency_budget_ms = 200,
+                size_t max_frame_bytes = 16000,
+                size_t max_pending_bytes = 64000);
+
+  void AddAudio(const std::string& source,
+                const uint8_t* data,
+                size_t size,
+                uint64_t now_ms);
+
+  void AddControl(std::string text);
+
+  // Moves every frame that is due at |now_ms| (all of them when |flush_all|)
+  // into |out|, in send order.
+  void TakeReady(uint64_t now_ms, bool flush_all, std::vector<UplinkFrame>& out);
+
+  // Drops the oldest queued audio frames (never control messages) until at
+  // most |max_frames| frames are queued.
+  void TrimReadyAudio(size_t max_frames);
+
+  void Clear();
+
+  size_t pending_bytes() const;
+  size_t queued_frames() const { return ready_.size(); }
+  uint64_t dropped_bytes() const { return dropped_bytes_; }
+
+ private:
+  struct Batch {
+    std::vector<uint8_t> bytes;
+    uint64_t first_ms = 0;
+  };
+
+  void FlushBatch(const std::string& source, Batch& batch);
+  void FlushAll();
+
+  uint32_t latency_budget_ms_;
+  size_t max_frame_bytes_;
+  size_t max_pending_bytes_;
+  std::map<std::string, Batch> batches_;
+  std::deque<UplinkFrame> ready_;
+  uint64_t dropped_bytes_ = 0;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+// One WebSocket connection as AudioUplink drives it: a blocking open and
+// text sends from the uplink thread, blocking receives from the receive
+// thread. Abort() may be called from any thread; it cancels whatever call
+// is blocked, and every call after it fails. A transport is used for one
+// session only.
+class UplinkTransport {
+ public:
+  enum class ReceiveStatus { kMessage, kClosed, kFailed };
+
+  virtual ~UplinkTransport() = default;
+
+  // Connects to |url| (ws:// or wss://) and completes the upgrade.
+  // |handshake_ms| is the upgrade round trip (request sent -> 101 received).
+  virtual bool Open(const std::wstring& url, double& handshake_ms, std::string& error) = 0;
+
+  // Sends one text message, blocking while the socket is backed up.
+  virtual bool SendText(const std::string& text, std::string& error) = 0;
+
+  // Blocks for the next complete text message; binary messages are skipped.
+  // kClosed is a close frame from the server; kFailed sets |error|.
+  virtual ReceiveStatus Receive(std::string& message, std::string& error) = 0;
+
+  // Sends a close frame (best effort) and releases the connection, which
+  // also ends a blocked Receive.
+  virtual void Close() = 0;
+
+  virtual void Abort() = 0;
+};
@@ -0,0 +1,117 @@
+#include "upload_encoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "image_scale.h"
+#include "jpeg_encoder.h"
+#include "png_encoder.h"
+
+namespace {
+
+constexpr int kMinJpegQuality = 40;
+// Below this we stop shrinking and return the best attempt.
+constexpr int kMinDimension = 320;
+constexpr int kMaxDownscaleSteps = 3;
+
+// Scale factor that should bring |size| under |budget|, assuming bytes grow
+// with area; 0.9 leaves headroom so one step usually suffices.
+double ShrinkFactor(size_t size, size_t budget) {
+  const double f = std::sqrt(static_cast<double>(budget) / static_cast<double>(size)) * 0.9;
+  return (std::max)(0.25, (std::min)(0.9, f));
+}
+
+// Binary-searches JPEG quality in [kMinJpegQuality, start] for the highest
+// quality that fits |budget|; falls back to the lowest quality tried.
+void EncodeJpegToBudget(const uint8_t* bgra,
+                        int w,
+                        int h,
+                        int start_quality,
+                        size_t budget,
+                        std::vector<uint8_t>& out,
+                        int& quality) {
+  start_quality = (std::max)(kMinJpegQuality, (std::min)(100, start_quality));
+  EncodeJpegBgra(bgra, w, h, 0, start_quality, out);
+  quality = start_quality;
+  if (budget == 0 || out.size() <= budget) return;
+
+  std::vector<uint8_t> attempt;
+  int lo = kMinJpegQuality;
+  int hi = start_quality - 1;
+  bool found = false;
+  while (lo <= hi) {
+    const int mid = (lo + hi) / 2;
+    EncodeJpegBgra(bgra, w, h, 0, mid, attempt);
+    if (attempt.size() <= budget) {
+      out.swap(attempt);
+      quality = mid;
+      found = true;
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  if (!found) {
+    EncodeJpegBgra(bgra, w, h, 0, kMinJpegQuality, out);
+    quality = kMinJpegQuality;
+  }
+}
+
+}  // namespace
+
+bool EncodeForUpload(const uint8_t* bgra,
+                     int width,
+                     int height,
+                     size_t stride,
+                     const UploadEncodeOptions& options,
+                     EncodedUpload& out) {
+  std::vector<uint8_t> encoded = std::move(out.bytes);
+  out = EncodedUpload();
+  if (!bgra || width <= 0 || height <= 0) return false;
+  if (stride == 0) stride = static_cast<size_t>(width) * 4;
+
+  int w = 0, h = 0;
+  FitWithin(width, height, options.max_dimension, options.max_dimension, w, h);
+  std::vector<uint8_t> pixels;
+  if (w != width || h != height || stride != static_cast<size_t>(width) * 4) {
+    if (!ScaleBgra(bgra, width, height, stride, w, h, ScaleFilter::kBox, pixels, 0)) return false;
+  } else {
+    pixels.assign(bgra, bgra + stride * static_cast<size_t>(height));
+  }
+
+  const size_t budget = options.max_bytes;
+  const PngOptions png = PngPresetOptions(options.png_preset);
+  for (int step = 0;; step++) {
+    bool use_jpeg = options.format == UploadFormat::kJpeg;
+    if (!use_jpeg) {
+      EncodePngBgra(pixels.data(), w, h, 0, png, encoded);
+      out.quality = 0;
+      if (options.format == UploadFormat::kAuto && budget > 0 && encoded.size() > budget) {
+        use_jpeg = true;
+      }
+    }
+    if (use_jpeg) {
+      EncodeJpegToBudget(pixels.data(), w, h, options.jpeg_quality, budget, encoded, out.quality);
+    }
+    out.mime_type = use_jpeg ? "image/jpeg" : "image/png";
+    out.width = w;
+    out.height = h;
+
+    const bool fits = budget == 0 || encoded.size() <= budget;
+    if (fits || step >= kMaxDownscaleSteps || (std::max)(w, h) <= kMinDimension) {
+      out.within_budget = fits;
+      out.bytes = std::move(encoded);
+      return !out.bytes.empty();
+    }
+
+    const double f = ShrinkFactor(encoded.size(), budget);
+    const int nw = (std::max)(1, static_cast<int>(w * f));
+    const int nh = (std::max)(1, static_cast<int>(h * f));
+    std::vector<uint8_t> smaller;
+    if (!ScaleBgraBox(pixels.data(), w, h, 0, nw, nh, smaller)) return false;
+    pixels.swap(smaller);
+    w = nw;
+    h = nh;
+  }
+}
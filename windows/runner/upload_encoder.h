@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "png_encoder.h"
+
+enum class UploadFormat {
+  kPng,
+  kJpeg,
+  // PNG when it fits the byte budget, otherwise JPEG.
+  kAuto,
+};
+
+struct UploadEncodeOptions {
+  UploadFormat format = UploadFormat::kPng;
+  // Longest edge after downscaling (<= 0 keeps the capture size).
+  int max_dimension = 1600;
+  // Target size of the encoded bytes (0 = no budget).
+  size_t max_bytes = 0;
+  // Starting JPEG quality; lowered (down to kMinJpegQuality) to meet the budget.
+  int jpeg_quality = 85;
+  PngPreset png_preset = PngPreset::kBalanced;
+};
+
+struct EncodedUpload {
+  std::vector<uint8_t> bytes;
+  std::string mime_type;
+  int width = 0;
+  int height = 0;
+  // JPEG quality actually used (0 for PNG).
+  int quality = 0;
+  // False when nothing tried fit |max_bytes|; |bytes| is then the smallest
+  // attempt.
+  bool within_budget = true;
+};
+
+// Downscales a top-down BGRA capture and encodes it for upload, shrinking
+// quality and then dimensions until the result fits the byte budget.
+// Platform-neutral; runs on a worker thread. The encoded bytes reuse the
+// capacity of |out.bytes|, so callers can seed it from a pool.
+bool EncodeForUpload(const uint8_t* bgra,
+                     int width,
+                     int height,
+                     size_t stride,
+                     const UploadEncodeOptions& options,
+                     EncodedUpload& out);
@@ -0,0 +1,23 @@
+#include "upload_history.h"
+
+UploadHistories::UploadHistories(size_t max_histories) : max_histories_(max_histories) {}
+
+std::shared_ptr<UploadHistory> UploadHistories::Get(const std::string& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& history = histories_[key];
+  if (!history) {
+    // Targets come and go with the user's picks; start over rather than
+    // tracking recency.
+    if (histories_.size() > max_histories_) {
+      histories_.clear();
+      return histories_[key] = std::make_shared<UploadHistory>();
+    }
+    history = std::make_shared<UploadHistory>();
+  }
+  return history;
+}
+
+size_t UploadHistories::size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return histories_.size();
+}
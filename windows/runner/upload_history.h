@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "frame_differ.h"
+#include "upload_encoder.h"
+
+// Last captureForUpload frame of one target, so an unchanged screen reuses
+// the previous encoding and small changes can be sent as crops.
+struct UploadHistory {
+  // Held while diffing and encoding; same-target captures run one at a time.
+  std::mutex mutex;
+  FrameDiffer differ;
+  // Full-frame encoding of the differ's current frame (null after a
+  // crops-only reply) and the options it was made with.
+  std::shared_ptr<const EncodedUpload> last;
+  std::string last_options;
+};
+
+// UploadHistory per target key. Thread-safe.
+class UploadHistories {
+ public:
+  static constexpr size_t kMaxHistories = 16;
+
+  explicit UploadHistories(size_t max_histories = kMaxHistories);
+
+  // The history for |key|, created on first use. Past |max_histories| keys
+  // every other history is dropped; a holder keeps using its own.
+  std::shared_ptr<UploadHistory> Get(const std::string& key);
+
+  size_t size();
+
+ private:
+  const size_t max_histories_;
+  std::mutex mutex_;
+  std::map<std::string, std::shared_ptr<UploadHistory>> histories_;
+};
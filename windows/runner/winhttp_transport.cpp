@@ -0,0 +1,199 @@
+#include "winhttp_transport.h"
+
+#include <chrono>
+
+#pragma comment(lib, "winhttp.lib")
+
+namespace {
+
+// WinHTTP's defaults let a dead host hold the handshake for minutes
+// (unbounded name resolution, 60 s connect). Receive keeps its 30 s default.
+constexpr int kResolveTimeoutMs = 5000;
+constexpr int kConnectTimeoutMs = 5000;
+constexpr int kSendTimeoutMs = 10000;
+constexpr int kReceiveTimeoutMs = 30000;
+
+constexpr size_t kReceiveBufferBytes = 16 * 1024;
+
+}  // namespace
+
+WinHttpTransport::~WinHttpTransport() {
+  std::lock_guard<std::mutex> lock(handles_mutex_);
+  CloseHandlesLocked();
+}
+
+bool WinHttpTransport::Open(const std::wstring& url, double& handshake_ms, std::string& error) {
+  // WinHttpCrackUrl only understands http(s); map ws(s) onto it.
+  std::wstring http_url = url;
+  bool secure = false;
+  if (http_url.rfind(L"wss://", 0) == 0) {
+    http_url = L"https://" + http_url.substr(6);
+    secure = true;
+  } else if (http_url.rfind(L"ws://", 0) == 0) {
+    http_url = L"http://" + http_url.substr(5);
+  } else {
+    error = "unsupported URL scheme";
+    return false;
+  }
+
+  URL_COMPONENTS parts{};
+  parts.dwStructSize = sizeof(parts);
+  parts.dwHostNameLength = static_cast<DWORD>(-1);
+  parts.dwUrlPathLength = static_cast<DWORD>(-1);
+  parts.dwExtraInfoLength = static_cast<DWORD>(-1);
+  if (!WinHttpCrackUrl(http_url.c_str(), 0, 0, &parts)) {
+    error = "invalid URL";
+    return false;
+  }
+  const std::wstring host(parts.lpszHostName, parts.dwHostNameLength);
+  std::wstring path(parts.lpszUrlPath, parts.dwUrlPathLength);
+  if (parts.lpszExtraInfo && parts.dwExtraInfoLength > 0) {
+    path.append(parts.lpszExtraInfo, parts.dwExtraInfoLength);
+  }
+  if (path.empty()) path = L"/";
+
+  // Each handle is used through a local copy: Abort may close the stored
+  // one from another thread to cancel a blocked call.
+  HINTERNET session = WinHttpOpen(L"FinalRound", WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+                                  WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
+  if (!KeepHandle(session_, session)) {
+    error = "WinHttpOpen failed";
+    return false;
+  }
+  WinHttpSetTimeouts(session, kResolveTimeoutMs, kConnectTimeoutMs, kSendTimeoutMs, kReceiveTimeoutMs);
+  HINTERNET connection = WinHttpConnect(session, host.c_str(), parts.nPort, 0);
+  if (!KeepHandle(connection_, connection)) {
+    error = "WinHttpConnect failed";
+    return false;
+  }
+  HINTERNET request = WinHttpOpenRequest(connection, L"GET", path.c_str(), nullptr,
+                                         WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES,
+                                         secure ? WINHTTP_FLAG_SECURE : 0);
+  if (!KeepHandle(request_, request)) {
+    error = "WinHttpOpenRequest failed";
+    return false;
+  }
+  if (!WinHttpSetOption(request, WINHTTP_OPTION_UPGRADE_TO_WEB_SOCKET, nullptr, 0)) {
+    error = "WebSocket upgrade option rejected";
+    return false;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  if (!WinHttpSendRequest(request, WINHTTP_NO_ADDITIONAL_HEADERS, 0, nullptr, 0, 0, 0) ||
+      !WinHttpReceiveResponse(request, nullptr)) {
+    error = "handshake failed (" + std::to_string(GetLastError()) + ")";
+    return false;
+  }
+  handshake_ms =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  DWORD status = 0;
+  DWORD status_size = sizeof(status);
+  WinHttpQueryHeaders(request, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                      WINHTTP_HEADER_NAME_BY_INDEX, &status, &status_size,
+                      WINHTTP_NO_HEADER_INDEX);
+  if (status != 101) {
+    error = "server refused upgrade (HTTP " + std::to_string(status) + ")";
+    return false;
+  }
+
+  HINTERNET socket = WinHttpWebSocketCompleteUpgrade(request, 0);
+  if (!KeepHandle(socket_, socket)) {
+    error = "WebSocket upgrade failed";
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(handles_mutex_);
+  if (request_) {
+    WinHttpCloseHandle(request_);
+    request_ = nullptr;
+  }
+  return true;
+}
+
+bool WinHttpTransport::SendText(const std::string& text, std::string& error) {
+  const DWORD err = WinHttpWebSocketSend(Socket(), WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE,
+                                         const_cast<char*>(text.data()),
+                                         static_cast<DWORD>(text.size()));
+  if (err != NO_ERROR) {
+    error = "send failed (" + std::to_string(err) + ")";
+    return false;
+  }
+  return true;
+}
+
+UplinkTransport::ReceiveStatus WinHttpTransport::Receive(std::string& message, std::string& error) {
+  buffer_.resize(kReceiveBufferBytes);
+  message.clear();
+  HINTERNET socket = Socket();
+  for (;;) {
+    DWORD read = 0;
+    WINHTTP_WEB_SOCKET_BUFFER_TYPE type = WINHTTP_WEB_SOCKET_BINARY_MESSAGE_BUFFER_TYPE;
+    const DWORD err = WinHttpWebSocketReceive(
+        socket, buffer_.data(), static_cast<DWORD>(buffer_.size()), &read, &type);
+    if (err != NO_ERROR) {
+      error = "receive failed (" + std::to_string(err) + ")";
+      return ReceiveStatus::kFailed;
+    }
+    if (type == WINHTTP_WEB_SOCKET_CLOSE_BUFFER_TYPE) {
+      return ReceiveStatus::kClosed;
+    }
+    if (type == WINHTTP_WEB_SOCKET_UTF8_FRAGMENT_BUFFER_TYPE) {
+      message.append(buffer_.data(), read);
+      continue;
+    }
+    if (type == WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE) {
+      message.append(buffer_.data(), read);
+      return ReceiveStatus::kMessage;
+    }
+    // The server protocol is JSON text only; ignore binary frames.
+    message.clear();
+  }
+}
+
+void WinHttpTransport::Close() {
+  // After an abort the handle is already closed and the shutdown just fails.
+  WinHttpWebSocketShutdown(Socket(), WINHTTP_WEB_SOCKET_SUCCESS_CLOSE_STATUS, nullptr, 0);
+  std::lock_guard<std::mutex> lock(handles_mutex_);
+  CloseHandlesLocked();
+}
+
+void WinHttpTransport::Abort() {
+  std::lock_guard<std::mutex> lock(handles_mutex_);
+  aborted_ = true;
+  CloseHandlesLocked();
+}
+
+bool WinHttpTransport::KeepHandle(HINTERNET& slot, HINTERNET handle) {
+  if (!handle) return false;
+  std::lock_guard<std::mutex> lock(handles_mutex_);
+  if (aborted_) {
+    WinHttpCloseHandle(handle);
+    return false;
+  }
+  slot = handle;
+  return true;
+}
+
+HINTERNET WinHttpTransport::Socket() {
+  std::lock_guard<std::mutex> lock(handles_mutex_);
+  return socket_;
+}
+
+void WinHttpTransport::CloseHandlesLocked() {
+  if (socket_) {
+    WinHttpCloseHandle(socket_);
+    socket_ = nullptr;
+  }
+  if (request_) {
+    WinHttpCloseHandle(request_);
+    request_ = nullptr;
+  }
+  if (connection_) {
+    WinHttpCloseHandle(connection_);
+    connection_ = nullptr;
+  }
+  if (session_) {
+    WinHttpCloseHandle(session_);
+    session_ = nullptr;
+  }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <windows.h>
+#include <winhttp.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "uplink_transport.h"
+
+// UplinkTransport over WinHTTP's WebSocket API.
+class WinHttpTransport : public UplinkTransport {
+ public:
+  WinHttpTransport() = default;
+  ~WinHttpTransport() override;
+
+  WinHttpTransport(const WinHttpTransport&) = delete;
+  WinHttpTransport& operator=(const WinHttpTransport&) = delete;
+
+  bool Open(const std::wstring& url, double& handshake_ms, std::string& error) override;
+  bool SendText(const std::string& text, std::string& error) override;
+  ReceiveStatus Receive(std::string& message, std::string& error) override;
+  void Close() override;
+  // Closes the handles, cancelling blocked WinHTTP calls.
+  void Abort() override;
+
+ private:
+  // Stores |handle| in |slot| unless the transport was aborted (then closes
+  // it); false for a null handle too.
+  bool KeepHandle(HINTERNET& slot, HINTERNET handle);
+  HINTERNET Socket();
+  void CloseHandlesLocked();
+
+  // Receive's read buffer.
+  std::vector<char> buffer_;
+
+  // Opened and normally closed by the uplink thread; Abort may close them
+  // from another thread, hence the lock.
+  std::mutex handles_mutex_;
+  bool aborted_ = false;
+  HINTERNET session_ = nullptr;
+  HINTERNET connection_ = nullptr;
+  HINTERNET request_ = nullptr;
+  HINTERNET socket_ = nullptr;
+};